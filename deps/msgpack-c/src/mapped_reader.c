@@ -0,0 +1,334 @@
+/*
+ * MessagePack for C memory-mapped reader
+ *
+ * Copyright (C) 2008-2009 FURUHASHI Sadayuki
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+#include "msgpack/mapped_reader.h"
+#include "msgpack/unpack.h"
+#include "msgpack/sysdep.h"
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+
+int msgpack_skip(const char* data, size_t len, size_t* off)
+{
+	if(*off >= len) { return 0; }
+
+	const unsigned char* p = (const unsigned char*)data + *off;
+	const unsigned char* const pe = (const unsigned char*)data + len;
+
+	/* containers only add to the number of objects left to skip,
+	 * so no stack is needed whatever the nesting */
+	uint64_t pending = 1;
+	while(pending > 0) {
+		if(p >= pe) { return 0; }
+
+		const unsigned int c = *p++;
+		uint64_t body = 0;
+
+		if(c <= 0x7f || c >= 0xe0) {
+			/* fixnum */
+		} else if(c >= 0xa0 && c <= 0xbf) {
+			body = c & 0x1f;
+		} else if(c >= 0x90 && c <= 0x9f) {
+			pending += c & 0x0f;
+		} else if(c >= 0x80 && c <= 0x8f) {
+			pending += (c & 0x0f) * 2;
+		} else {
+			size_t n = 0;  /* size of the length field */
+			switch(c) {
+			case 0xc0:  /* nil */
+			case 0xc2:  /* false */
+			case 0xc3:  /* true */
+				break;
+			case 0xca:  /* float */
+			case 0xcb:  /* double */
+			case 0xcc: case 0xcd: case 0xce: case 0xcf:  /* unsigned int */
+			case 0xd0: case 0xd1: case 0xd2: case 0xd3:  /* signed int */
+				body = 1 << (c & 0x03);
+				break;
+			case 0xd4: case 0xd5: case 0xd6: case 0xd7: case 0xd8:  /* fixext */
+				body = (1 << (c - 0xd4)) + 1;
+				break;
+			case 0xc7:  /* ext 8 */
+				n = 1;
+				break;
+			case 0xc8:  /* ext 16 */
+			case 0xda:  /* raw 16 */
+			case 0xdc:  /* array 16 */
+			case 0xde:  /* map 16 */
+				n = 2;
+				break;
+			case 0xc9:  /* ext 32 */
+			case 0xdb:  /* raw 32 */
+			case 0xdd:  /* array 32 */
+			case 0xdf:  /* map 32 */
+				n = 4;
+				break;
+			default:
+				return -1;
+			}
+
+			if(n > 0) {
+				if((size_t)(pe - p) < n) { return 0; }
+				uint64_t l = n == 1 ? *p :
+					n == 2 ? _msgpack_load16(uint16_t, p) : _msgpack_load32(uint32_t, p);
+				p += n;
+
+				if(c == 0xdc || c == 0xdd) {
+					pending += l;
+				} else if(c == 0xde || c == 0xdf) {
+					pending += l * 2;
+				} else if(c <= 0xc9) {
+					body = l + 1;  /* type byte */
+				} else {
+					body = l;
+				}
+			}
+		}
+
+		if((uint64_t)(pe - p) < body) { return 0; }
+		p += body;
+		--pending;
+	}
+
+	*off = (const char*)p - data;
+	return 1;
+}
+
+
+static bool init_reader(msgpack_mapped_reader* mr, size_t index_interval)
+{
+	mr->off = 0;
+	mr->count = 0;
+	mr->interval = index_interval ? index_interval : MSGPACK_MAPPED_READER_INDEX_INTERVAL;
+	mr->released = 0;
+	mr->page_size = 4096;
+	mr->fd = -1;
+
+	mr->index = (size_t*)malloc(sizeof(size_t) * 64);
+	if(mr->index == NULL) {
+		return false;
+	}
+	mr->index[0] = 0;
+	mr->index_size = 1;
+	mr->index_capacity = 64;
+
+	if(!msgpack_zone_init(&mr->z, MSGPACK_ZONE_CHUNK_SIZE)) {
+		free(mr->index);
+		return false;
+	}
+	return true;
+}
+
+bool msgpack_mapped_reader_init(msgpack_mapped_reader* mr, const char* data, size_t size, size_t index_interval)
+{
+	if(!init_reader(mr, index_interval)) {
+		return false;
+	}
+	mr->data = data;
+	mr->size = size;
+	return true;
+}
+
+#ifndef _WIN32
+static bool map_file(msgpack_mapped_reader* mr)
+{
+	struct stat st;
+	if(fstat(mr->fd, &st) != 0) {
+		return false;
+	}
+
+	mr->data = NULL;
+	mr->size = (size_t)st.st_size;
+	if(mr->size == 0) {
+		return true;
+	}
+
+	void* mapping = mmap(NULL, mr->size, PROT_READ, MAP_PRIVATE, mr->fd, 0);
+	if(mapping == MAP_FAILED) {
+		mr->size = 0;
+		return false;
+	}
+
+	/* read ahead aggressively, the pages behind are released by hand */
+	madvise(mapping, mr->size, MADV_SEQUENTIAL);
+
+	mr->data = (const char*)mapping;
+	mr->released = mr->off & ~(mr->page_size - 1);
+	return true;
+}
+
+static void unmap_file(msgpack_mapped_reader* mr)
+{
+	if(mr->data != NULL) {
+		munmap((void*)mr->data, mr->size);
+	}
+	mr->data = NULL;
+	mr->size = 0;
+}
+#endif
+
+bool msgpack_mapped_reader_open(msgpack_mapped_reader* mr, const char* path, size_t index_interval)
+{
+#ifndef _WIN32
+	if(!init_reader(mr, index_interval)) {
+		return false;
+	}
+	mr->data = NULL;
+	mr->size = 0;
+	mr->page_size = (size_t)sysconf(_SC_PAGESIZE);
+
+	mr->fd = open(path, O_RDONLY);
+	if(mr->fd < 0 || !map_file(mr)) {
+		msgpack_mapped_reader_destroy(mr);
+		return false;
+	}
+	return true;
+#else
+	return false;
+#endif
+}
+
+void msgpack_mapped_reader_destroy(msgpack_mapped_reader* mr)
+{
+#ifndef _WIN32
+	if(mr->fd >= 0) {
+		unmap_file(mr);
+		close(mr->fd);
+		mr->fd = -1;
+	}
+#endif
+	msgpack_zone_destroy(&mr->z);
+	free(mr->index);
+	mr->index = NULL;
+}
+
+bool msgpack_mapped_reader_refresh(msgpack_mapped_reader* mr)
+{
+#ifndef _WIN32
+	struct stat st;
+	if(mr->fd < 0 || fstat(mr->fd, &st) != 0 || (size_t)st.st_size <= mr->size) {
+		return false;
+	}
+
+	/* the objects read before may be referenced by the zone, drop them too */
+	msgpack_zone_reset(&mr->z);
+	unmap_file(mr);
+
+	/* on failure the position is kept past the (empty) data, a later
+	 * refresh maps the file again */
+	return map_file(mr);
+#else
+	return false;
+#endif
+}
+
+static void release_pages(msgpack_mapped_reader* mr)
+{
+#ifndef _WIN32
+	/* only the pages entirely before the next object, the objects
+	 * handed out before it are not valid anymore */
+	size_t end = mr->off & ~(mr->page_size - 1);
+	if(mr->fd < 0 || mr->data == NULL || end < mr->released + MSGPACK_MAPPED_READER_RELEASE_SIZE) {
+		return;
+	}
+	madvise((void*)(mr->data + mr->released), end - mr->released, MADV_DONTNEED);
+	mr->released = end;
+#else
+	(void)mr;
+#endif
+}
+
+static void record_position(msgpack_mapped_reader* mr)
+{
+	if(mr->count % mr->interval != 0 || mr->count / mr->interval != mr->index_size) {
+		return;
+	}
+
+	if(mr->index_size == mr->index_capacity) {
+		size_t nsize = mr->index_capacity * 2;
+		size_t* tmp = (size_t*)realloc(mr->index, sizeof(size_t) * nsize);
+		if(tmp == NULL) {
+			return;  /* seeking goes on from the last entry */
+		}
+		mr->index = tmp;
+		mr->index_capacity = nsize;
+	}
+
+	mr->index[mr->index_size++] = mr->off;
+}
+
+bool msgpack_mapped_reader_next(msgpack_mapped_reader* mr, msgpack_object* result)
+{
+	release_pages(mr);
+	msgpack_zone_reset(&mr->z);
+
+	size_t noff = mr->off;
+	msgpack_unpack_return ret = msgpack_unpack(mr->data, mr->size, &noff, &mr->z, result);
+	if(ret != MSGPACK_UNPACK_SUCCESS && ret != MSGPACK_UNPACK_EXTRA_BYTES) {
+		return false;
+	}
+
+	mr->off = noff;
+	++mr->count;
+	record_position(mr);
+	return true;
+}
+
+bool msgpack_mapped_reader_skip(msgpack_mapped_reader* mr)
+{
+	release_pages(mr);
+
+	size_t noff = mr->off;
+	if(msgpack_skip(mr->data, mr->size, &noff) <= 0) {
+		return false;
+	}
+
+	mr->off = noff;
+	++mr->count;
+	record_position(mr);
+	return true;
+}
+
+bool msgpack_mapped_reader_seek(msgpack_mapped_reader* mr, uint64_t n)
+{
+	/* closest recorded position, unless the reader is already between it and n */
+	uint64_t entry = n / mr->interval;
+	if(entry >= mr->index_size) {
+		entry = mr->index_size - 1;
+	}
+	uint64_t start = entry * mr->interval;
+	if(mr->count < start || mr->count > n) {
+		mr->off = mr->index[entry];
+		mr->count = start;
+		mr->released = mr->off & ~(mr->page_size - 1);
+	}
+
+	while(mr->count < n) {
+		if(!msgpack_mapped_reader_skip(mr)) {
+			return false;
+		}
+	}
+	return true;
+}
+
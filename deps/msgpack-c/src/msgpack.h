@@ -24,6 +24,7 @@
 #include "msgpack/zone.h"
 #include "msgpack/pack.h"
 #include "msgpack/unpack.h"
+#include "msgpack/mapped_reader.h"
 #include "msgpack/sbuffer.h"
 #include "msgpack/vrefbuffer.h"
 #include "msgpack/version.h"
@@ -0,0 +1,150 @@
+/*
+ * MessagePack for C memory-mapped reader
+ *
+ * Copyright (C) 2008-2009 FURUHASHI Sadayuki
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+#ifndef MSGPACK_MAPPED_READER_H__
+#define MSGPACK_MAPPED_READER_H__
+
+#include "zone.h"
+#include "object.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/**
+ * @defgroup msgpack_mapped_reader Memory-mapped reader
+ * @ingroup msgpack
+ * @{
+ */
+
+/**
+ * Iterates the objects of a file (or of any memory range) in place.
+ * Unlike msgpack_unpacker, nothing is copied: raw and ext objects point
+ * into the mapping and the arrays and maps are built in one zone that is
+ * reset by each call, so an object is valid until the next call on the
+ * reader. The pages already read are handed back to the system as the
+ * reader moves forward, so scanning a file larger than the memory is
+ * bounded by the disk.
+ *
+ * Every index_interval objects the reader records the offset it passed,
+ * seeking to an object starts from the closest recorded one and skips
+ * the rest without building them.
+ */
+typedef struct msgpack_mapped_reader {
+	const char* data;
+	size_t size;
+	size_t off;       /* offset of the next object */
+	uint64_t count;   /* number of the next object */
+	msgpack_zone z;
+	size_t* index;    /* index[i]: offset of object i * interval */
+	size_t index_size;
+	size_t index_capacity;
+	size_t interval;
+	size_t released;  /* pages before this offset were given back */
+	size_t page_size;
+	int fd;           /* -1 when the reader doesn't own the mapping */
+} msgpack_mapped_reader;
+
+#ifndef MSGPACK_MAPPED_READER_INDEX_INTERVAL
+#define MSGPACK_MAPPED_READER_INDEX_INTERVAL 256
+#endif
+
+#ifndef MSGPACK_MAPPED_READER_RELEASE_SIZE
+#define MSGPACK_MAPPED_READER_RELEASE_SIZE (64*1024*1024)
+#endif
+
+/**
+ * Maps a file read only and positions the reader on its first object.
+ * Not available on Windows. The reader must be destroyed by
+ * msgpack_mapped_reader_destroy(msgpack_mapped_reader*).
+ * @param index_interval  objects between two index entries, 0 for MSGPACK_MAPPED_READER_INDEX_INTERVAL
+ */
+bool msgpack_mapped_reader_open(msgpack_mapped_reader* mr, const char* path, size_t index_interval);
+
+/**
+ * Reads objects from memory the caller keeps valid while the reader is used.
+ */
+bool msgpack_mapped_reader_init(msgpack_mapped_reader* mr, const char* data, size_t size, size_t index_interval);
+
+void msgpack_mapped_reader_destroy(msgpack_mapped_reader* mr);
+
+/**
+ * Maps again a file that has grown, the objects appended since can then be
+ * read. Returns true if the file is larger than it was. The objects read
+ * before are not valid anymore, the position and the index are kept.
+ * If the file can't be mapped again nothing can be read, and nothing
+ * remains, until a later refresh succeeds.
+ */
+bool msgpack_mapped_reader_refresh(msgpack_mapped_reader* mr);
+
+/**
+ * Reads the next object.
+ * Returns false at the end of the data, on an object cut by the end of the
+ * data (an append in progress) and on a parse error. The position doesn't
+ * move then, see msgpack_mapped_reader_remaining(const msgpack_mapped_reader*).
+ */
+bool msgpack_mapped_reader_next(msgpack_mapped_reader* mr, msgpack_object* result);
+
+/**
+ * Moves past the next object without building it.
+ */
+bool msgpack_mapped_reader_skip(msgpack_mapped_reader* mr);
+
+/**
+ * Positions the reader on object n (counting from 0).
+ * Returns false if the data has fewer objects, the reader is left after the
+ * last complete one.
+ */
+bool msgpack_mapped_reader_seek(msgpack_mapped_reader* mr, uint64_t n);
+
+/**
+ * Skips one complete object at *off without allocating anything.
+ * Returns 1 and moves *off past the object, 0 if the object is cut by the
+ * end of the data, -1 on a parse error.
+ */
+int msgpack_skip(const char* data, size_t len, size_t* off);
+
+static inline uint64_t msgpack_mapped_reader_tell(const msgpack_mapped_reader* mr);
+static inline size_t msgpack_mapped_reader_offset(const msgpack_mapped_reader* mr);
+static inline size_t msgpack_mapped_reader_remaining(const msgpack_mapped_reader* mr);
+
+/** @} */
+
+
+uint64_t msgpack_mapped_reader_tell(const msgpack_mapped_reader* mr)
+{
+	return mr->count;
+}
+
+size_t msgpack_mapped_reader_offset(const msgpack_mapped_reader* mr)
+{
+	return mr->off;
+}
+
+size_t msgpack_mapped_reader_remaining(const msgpack_mapped_reader* mr)
+{
+	return mr->off < mr->size ? mr->size - mr->off : 0;
+}
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* msgpack/mapped_reader.h */
+
@@ -41,6 +41,7 @@ typedef enum {
 	MSGPACK_OBJECT_RAW					= 0x05,
 	MSGPACK_OBJECT_ARRAY				= 0x06,
 	MSGPACK_OBJECT_MAP					= 0x07,
+	MSGPACK_OBJECT_EXT					= 0x08,
 } msgpack_object_type;
 
 
@@ -62,6 +63,12 @@ typedef struct {
 	const char* ptr;
 } msgpack_object_raw;
 
+typedef struct {
+	int8_t type;
+	uint32_t size;
+	const char* ptr;
+} msgpack_object_ext;
+
 typedef union {
 	bool boolean;
 	uint64_t u64;
@@ -70,6 +77,7 @@ typedef union {
 	msgpack_object_array array;
 	msgpack_object_map map;
 	msgpack_object_raw raw;
+	msgpack_object_ext ext;
 } msgpack_object_union;
 
 typedef struct msgpack_object {
@@ -90,6 +98,73 @@ bool msgpack_object_equal(const msgpack_object x, const msgpack_object y);
 /** @} */
 
 
+/**
+ * @defgroup msgpack_typed_array Typed arrays
+ * @ingroup msgpack
+ *
+ * Homogeneous arrays of numbers, packed as one ext holding the elements
+ * in little endian order instead of one tagged value per element. The
+ * unpacked view points into the unpacked buffer: there is no copy on
+ * little endian hosts, but the elements are not aligned.
+ * @{
+ */
+
+typedef enum {
+	MSGPACK_TYPED_ARRAY_INT8			= 0x20,
+	MSGPACK_TYPED_ARRAY_UINT8			= 0x21,
+	MSGPACK_TYPED_ARRAY_INT16			= 0x22,
+	MSGPACK_TYPED_ARRAY_UINT16			= 0x23,
+	MSGPACK_TYPED_ARRAY_INT32			= 0x24,
+	MSGPACK_TYPED_ARRAY_UINT32			= 0x25,
+	MSGPACK_TYPED_ARRAY_INT64			= 0x26,
+	MSGPACK_TYPED_ARRAY_UINT64			= 0x27,
+	MSGPACK_TYPED_ARRAY_FLOAT			= 0x28,
+	MSGPACK_TYPED_ARRAY_DOUBLE			= 0x29,
+} msgpack_typed_array_type;
+
+typedef struct {
+	msgpack_typed_array_type type;
+	uint32_t size;  /* elements */
+	const char* ptr;
+} msgpack_typed_array;
+
+static inline size_t msgpack_typed_array_element_size(int type);
+
+/* false if the object is not a typed array */
+bool msgpack_object_typed_array(const msgpack_object o, msgpack_typed_array* a);
+
+/* the elements in native order to an aligned array of a.size elements */
+void msgpack_typed_array_copy(const msgpack_typed_array* a, void* out);
+
+/* reverses the bytes of each element of l bytes of elements */
+void msgpack_typed_array_swap(void* dst, const void* src, size_t l, size_t element_size);
+
+/** @} */
+
+
+size_t msgpack_typed_array_element_size(int type)
+{
+	switch(type) {
+	case MSGPACK_TYPED_ARRAY_INT8:
+	case MSGPACK_TYPED_ARRAY_UINT8:
+		return 1;
+	case MSGPACK_TYPED_ARRAY_INT16:
+	case MSGPACK_TYPED_ARRAY_UINT16:
+		return 2;
+	case MSGPACK_TYPED_ARRAY_INT32:
+	case MSGPACK_TYPED_ARRAY_UINT32:
+	case MSGPACK_TYPED_ARRAY_FLOAT:
+		return 4;
+	case MSGPACK_TYPED_ARRAY_INT64:
+	case MSGPACK_TYPED_ARRAY_UINT64:
+	case MSGPACK_TYPED_ARRAY_DOUBLE:
+		return 8;
+	default:
+		return 0;
+	}
+}
+
+
 #ifdef __cplusplus
 }
 #endif
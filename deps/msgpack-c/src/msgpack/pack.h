@@ -93,6 +93,12 @@ static int msgpack_pack_map(msgpack_packer* pk, unsigned int n);
 static int msgpack_pack_raw(msgpack_packer* pk, size_t l);
 static int msgpack_pack_raw_body(msgpack_packer* pk, const void* b, size_t l);
 
+static int msgpack_pack_ext(msgpack_packer* pk, int8_t type, size_t l);
+static int msgpack_pack_ext_body(msgpack_packer* pk, const void* b, size_t l);
+
+/* n elements of the type, see msgpack_typed_array */
+static int msgpack_pack_typed_array(msgpack_packer* pk, msgpack_typed_array_type type, const void* p, size_t n);
+
 int msgpack_pack_object(msgpack_packer* pk, msgpack_object d);
 
 
@@ -134,6 +140,32 @@ inline void msgpack_packer_free(msgpack_packer* pk)
 	free(pk);
 }
 
+inline int msgpack_pack_typed_array(msgpack_packer* pk, msgpack_typed_array_type type, const void* p, size_t n)
+{
+	const size_t size = msgpack_typed_array_element_size(type);
+	if(size == 0 || n > 0xffffffff / size) { return -1; }
+
+	int ret = msgpack_pack_ext(pk, type, n * size);
+	if(ret < 0 || n == 0) { return ret; }
+
+#ifdef __LITTLE_ENDIAN__
+	return msgpack_pack_ext_body(pk, p, n * size);
+#else
+	char buf[512];
+	const char* s = (const char*)p;
+	size_t left = n * size;
+	while(left > 0) {
+		const size_t l = left < sizeof(buf) ? left : sizeof(buf);
+		msgpack_typed_array_swap(buf, s, l, size);
+		ret = msgpack_pack_ext_body(pk, buf, l);
+		if(ret < 0) { return ret; }
+		s += l;
+		left -= l;
+	}
+	return 0;
+#endif
+}
+
 
 #ifdef __cplusplus
 }
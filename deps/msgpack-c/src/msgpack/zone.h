@@ -79,6 +79,25 @@ bool msgpack_zone_is_empty(msgpack_zone* zone);
 
 void msgpack_zone_clear(msgpack_zone* zone);
 
+/**
+ * Like msgpack_zone_clear, for a zone reused in a loop: if the zone had
+ * to grow, its chunks are replaced by one chunk large enough for all
+ * they held, so the next round of the same size allocates nothing.
+ */
+void msgpack_zone_reset(msgpack_zone* zone);
+
+/**
+ * Thread-local pool of the chunks and zones freed by the current thread.
+ * With a limit (in bytes), freed chunks are kept and reused by the next
+ * zones of that thread instead of going through malloc and free. The
+ * pool is off by default. A thread with a pool must turn it off (limit 0)
+ * or trim it before exiting, or the cached chunks are lost.
+ */
+void msgpack_zone_pool_set_limit(size_t limit);
+size_t msgpack_zone_pool_get_limit(void);
+size_t msgpack_zone_pool_size(void);
+void msgpack_zone_pool_trim(void);
+
 /** @} */
 
 
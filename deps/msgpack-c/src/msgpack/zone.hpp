@@ -42,6 +42,7 @@ public:
 	void push_finalizer(std::auto_ptr<T> obj);
 
 	void clear();
+	void reset();
 
 	void swap(zone& o);
 
@@ -158,6 +159,11 @@ inline void zone::clear()
 	msgpack_zone_clear(this);
 }
 
+inline void zone::reset()
+{
+	msgpack_zone_reset(this);
+}
+
 inline void zone::swap(zone& o)
 {
 	msgpack_zone_swap(this, &o);
@@ -47,6 +47,10 @@ std::ostream& operator<< (std::ostream& s, const object o)
 		(s << '"').write(o.via.raw.ptr, o.via.raw.size) << '"';
 		break;
 
+	case type::EXT:
+		s << "#<EXT " << (int)o.via.ext.type << " " << o.via.ext.size << ">";
+		break;
+
 	case type::ARRAY:
 		s << "[";
 		if(o.via.array.size != 0) {
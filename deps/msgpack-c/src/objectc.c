@@ -61,6 +61,13 @@ int msgpack_pack_object(msgpack_packer* pk, msgpack_object d)
 			return msgpack_pack_raw_body(pk, d.via.raw.ptr, d.via.raw.size);
 		}
 
+	case MSGPACK_OBJECT_EXT:
+		{
+			int ret = msgpack_pack_ext(pk, d.via.ext.type, d.via.ext.size);
+			if(ret < 0) { return ret; }
+			return msgpack_pack_ext_body(pk, d.via.ext.ptr, d.via.ext.size);
+		}
+
 	case MSGPACK_OBJECT_ARRAY:
 		{
 			int ret = msgpack_pack_array(pk, d.via.array.size);
@@ -128,6 +135,10 @@ void msgpack_object_print(FILE* out, msgpack_object o)
 		fprintf(out, "\"");
 		break;
 
+	case MSGPACK_OBJECT_EXT:
+		fprintf(out, "#<EXT %i %"PRIu32">", o.via.ext.type, o.via.ext.size);
+		break;
+
 	case MSGPACK_OBJECT_ARRAY:
 		fprintf(out, "[");
 		if(o.via.array.size != 0) {
@@ -192,6 +203,11 @@ bool msgpack_object_equal(const msgpack_object x, const msgpack_object y)
 		return x.via.raw.size == y.via.raw.size &&
 			memcmp(x.via.raw.ptr, y.via.raw.ptr, x.via.raw.size) == 0;
 
+	case MSGPACK_OBJECT_EXT:
+		return x.via.ext.type == y.via.ext.type &&
+			x.via.ext.size == y.via.ext.size &&
+			memcmp(x.via.ext.ptr, y.via.ext.ptr, x.via.ext.size) == 0;
+
 	case MSGPACK_OBJECT_ARRAY:
 		if(x.via.array.size != y.via.array.size) {
 			return false;
@@ -235,3 +251,63 @@ bool msgpack_object_equal(const msgpack_object x, const msgpack_object y)
 	}
 }
 
+
+bool msgpack_object_typed_array(const msgpack_object o, msgpack_typed_array* a)
+{
+	if(o.type != MSGPACK_OBJECT_EXT) { return false; }
+
+	const size_t size = msgpack_typed_array_element_size(o.via.ext.type);
+	if(size == 0 || o.via.ext.size % size != 0) { return false; }
+
+	a->type = (msgpack_typed_array_type)o.via.ext.type;
+	a->size = o.via.ext.size / size;
+	a->ptr  = o.via.ext.ptr;
+	return true;
+}
+
+void msgpack_typed_array_copy(const msgpack_typed_array* a, void* out)
+{
+	const size_t size = msgpack_typed_array_element_size(a->type);
+#ifdef __LITTLE_ENDIAN__
+	memcpy(out, a->ptr, a->size * size);
+#else
+	msgpack_typed_array_swap(out, a->ptr, a->size * size, size);
+#endif
+}
+
+void msgpack_typed_array_swap(void* dst, const void* src, size_t l, size_t element_size)
+{
+	/* plain loops over copies, that the compiler turns into vector shuffles */
+	const char* s = (const char*)src;
+	char* d = (char*)dst;
+	size_t i;
+	switch(element_size) {
+	case 2:
+		for(i = 0; i + 2 <= l; i += 2) {
+			uint16_t v; memcpy(&v, s + i, 2);
+			v = (uint16_t)((v >> 8) | (v << 8));
+			memcpy(d + i, &v, 2);
+		}
+		break;
+	case 4:
+		for(i = 0; i + 4 <= l; i += 4) {
+			uint32_t v; memcpy(&v, s + i, 4);
+			v = (v >> 24) | ((v >> 8) & 0xff00) | ((v << 8) & 0xff0000) | (v << 24);
+			memcpy(d + i, &v, 4);
+		}
+		break;
+	case 8:
+		for(i = 0; i + 8 <= l; i += 8) {
+			uint64_t v; memcpy(&v, s + i, 8);
+			v = ((v & 0x00000000ffffffffULL) << 32) | ((v & 0xffffffff00000000ULL) >> 32);
+			v = ((v & 0x0000ffff0000ffffULL) << 16) | ((v & 0xffff0000ffff0000ULL) >> 16);
+			v = ((v & 0x00ff00ff00ff00ffULL) << 8)  | ((v & 0xff00ff00ff00ff00ULL) >> 8);
+			memcpy(d + i, &v, 8);
+		}
+		break;
+	default:
+		if(d != s) { memcpy(d, s, l); }
+		break;
+	}
+}
+
@@ -21,20 +21,97 @@
 
 struct msgpack_zone_chunk {
 	struct msgpack_zone_chunk* next;
+	size_t size;
 	/* data ... */
 };
 
+#define CHUNK_DATA(chunk) (((char*)(chunk)) + sizeof(msgpack_zone_chunk))
+
+
+/*
+ * Thread-local pool of free chunks and zones. It is off until
+ * msgpack_zone_pool_set_limit gives it a budget: the chunks freed by a
+ * thread are then kept on that thread's free lists and handed out again
+ * instead of going back to malloc. Free list n holds the chunks of at
+ * least 2^n bytes, any chunk size can be recycled.
+ */
+#if defined(_MSC_VER)
+#define MSGPACK_ZONE_THREAD_LOCAL __declspec(thread)
+#else
+#define MSGPACK_ZONE_THREAD_LOCAL __thread
+#endif
+
+#define MSGPACK_ZONE_POOL_CLASSES (sizeof(size_t) * 8)
+
+typedef struct msgpack_zone_pool {
+	msgpack_zone_chunk* chunks[MSGPACK_ZONE_POOL_CLASSES];
+	msgpack_zone* zones;  /* linked through their first word */
+	size_t size;          /* bytes held by the free lists */
+	size_t limit;
+} msgpack_zone_pool;
+
+static MSGPACK_ZONE_THREAD_LOCAL msgpack_zone_pool zone_pool;
+
+static inline unsigned int floor_log2(size_t size)
+{
+	unsigned int n = 0;
+	while(size >>= 1) {
+		++n;
+	}
+	return n;
+}
+
+static inline unsigned int ceil_log2(size_t size)
+{
+	return size <= 1 ? 0 : floor_log2(size - 1) + 1;
+}
+
+static inline msgpack_zone_chunk* alloc_chunk(size_t size)
+{
+	msgpack_zone_pool* const pool = &zone_pool;
+	const unsigned int n = ceil_log2(size);
+
+	msgpack_zone_chunk* chunk;
+	if(n < MSGPACK_ZONE_POOL_CLASSES && pool->chunks[n] != NULL) {
+		chunk = pool->chunks[n];
+		pool->chunks[n] = chunk->next;
+		pool->size -= chunk->size;
+		return chunk;
+	}
+
+	chunk = (msgpack_zone_chunk*)malloc(sizeof(msgpack_zone_chunk) + size);
+	if(chunk == NULL) {
+		return NULL;
+	}
+	chunk->size = size;
+	return chunk;
+}
+
+static inline void free_chunk(msgpack_zone_chunk* chunk)
+{
+	msgpack_zone_pool* const pool = &zone_pool;
+
+	if(pool->size + chunk->size > pool->limit) {
+		free(chunk);
+		return;
+	}
+
+	const unsigned int n = floor_log2(chunk->size);
+	chunk->next = pool->chunks[n];
+	pool->chunks[n] = chunk;
+	pool->size += chunk->size;
+}
+
 static inline bool init_chunk_list(msgpack_zone_chunk_list* cl, size_t chunk_size)
 {
-	msgpack_zone_chunk* chunk = (msgpack_zone_chunk*)malloc(
-			sizeof(msgpack_zone_chunk) + chunk_size);
+	msgpack_zone_chunk* chunk = alloc_chunk(chunk_size);
 	if(chunk == NULL) {
 		return false;
 	}
 
 	cl->head = chunk;
-	cl->free = chunk_size;
-	cl->ptr  = ((char*)chunk) + sizeof(msgpack_zone_chunk);
+	cl->free = chunk->size;
+	cl->ptr  = CHUNK_DATA(chunk);
 	chunk->next = NULL;
 
 	return true;
@@ -45,7 +122,7 @@ static inline void destroy_chunk_list(msgpack_zone_chunk_list* cl)
 	msgpack_zone_chunk* c = cl->head;
 	while(true) {
 		msgpack_zone_chunk* n = c->next;
-		free(c);
+		free_chunk(c);
 		if(n != NULL) {
 			c = n;
 		} else {
@@ -54,21 +131,49 @@ static inline void destroy_chunk_list(msgpack_zone_chunk_list* cl)
 	}
 }
 
-static inline void clear_chunk_list(msgpack_zone_chunk_list* cl, size_t chunk_size)
+static inline void clear_chunk_list(msgpack_zone_chunk_list* cl)
 {
 	msgpack_zone_chunk* c = cl->head;
 	while(true) {
 		msgpack_zone_chunk* n = c->next;
 		if(n != NULL) {
-			free(c);
+			free_chunk(c);
 			c = n;
 		} else {
 			break;
 		}
 	}
-	cl->head->next = NULL;
-	cl->free = chunk_size;
-	cl->ptr  = ((char*)cl->head) + sizeof(msgpack_zone_chunk);
+	cl->head = c;
+	cl->free = c->size;
+	cl->ptr  = CHUNK_DATA(c);
+}
+
+static inline void reset_chunk_list(msgpack_zone_chunk_list* cl)
+{
+	msgpack_zone_chunk* c = cl->head;
+	if(c->next != NULL) {
+		/* the next round gets one chunk as large as all of this round's */
+		size_t total = 0;
+		for(; c != NULL; c = c->next) {
+			total += c->size;
+		}
+		size_t sz = 1;
+		while(sz < total) {
+			sz *= 2;
+		}
+
+		msgpack_zone_chunk* chunk = alloc_chunk(sz);
+		if(chunk == NULL) {
+			clear_chunk_list(cl);
+			return;
+		}
+		destroy_chunk_list(cl);
+		chunk->next = NULL;
+		cl->head = chunk;
+	}
+
+	cl->free = cl->head->size;
+	cl->ptr  = CHUNK_DATA(cl->head);
 }
 
 void* msgpack_zone_malloc_expand(msgpack_zone* zone, size_t size)
@@ -81,14 +186,16 @@ void* msgpack_zone_malloc_expand(msgpack_zone* zone, size_t size)
 		sz *= 2;
 	}
 
-	msgpack_zone_chunk* chunk = (msgpack_zone_chunk*)malloc(
-			sizeof(msgpack_zone_chunk) + sz);
+	msgpack_zone_chunk* chunk = alloc_chunk(sz);
+	if(chunk == NULL) {
+		return NULL;
+	}
 
-	char* ptr = ((char*)chunk) + sizeof(msgpack_zone_chunk);
+	char* ptr = CHUNK_DATA(chunk);
 
 	chunk->next = cl->head;
 	cl->head = chunk;
-	cl->free = sz - size;
+	cl->free = chunk->size - size;
 	cl->ptr  = ptr + size;
 
 	return ptr;
@@ -162,7 +269,7 @@ bool msgpack_zone_is_empty(msgpack_zone* zone)
 {
 	msgpack_zone_chunk_list* const cl = &zone->chunk_list;
 	msgpack_zone_finalizer_array* const fa = &zone->finalizer_array;
-	return cl->free == zone->chunk_size && cl->head->next == NULL &&
+	return cl->free == cl->head->size && cl->head->next == NULL &&
 		fa->tail == fa->array;
 }
 
@@ -176,7 +283,13 @@ void msgpack_zone_destroy(msgpack_zone* zone)
 void msgpack_zone_clear(msgpack_zone* zone)
 {
 	clear_finalizer_array(&zone->finalizer_array);
-	clear_chunk_list(&zone->chunk_list, zone->chunk_size);
+	clear_chunk_list(&zone->chunk_list);
+}
+
+void msgpack_zone_reset(msgpack_zone* zone)
+{
+	clear_finalizer_array(&zone->finalizer_array);
+	reset_chunk_list(&zone->chunk_list);
 }
 
 bool msgpack_zone_init(msgpack_zone* zone, size_t chunk_size)
@@ -194,21 +307,24 @@ bool msgpack_zone_init(msgpack_zone* zone, size_t chunk_size)
 
 msgpack_zone* msgpack_zone_new(size_t chunk_size)
 {
-	msgpack_zone* zone = (msgpack_zone*)malloc(
-			sizeof(msgpack_zone) + chunk_size);
-	if(zone == NULL) {
-		return NULL;
-	}
+	msgpack_zone_pool* const pool = &zone_pool;
 
-	zone->chunk_size = chunk_size;
+	msgpack_zone* zone = pool->zones;
+	if(zone != NULL) {
+		pool->zones = *(msgpack_zone**)zone;
+		pool->size -= sizeof(msgpack_zone);
+	} else {
+		zone = (msgpack_zone*)malloc(sizeof(msgpack_zone));
+		if(zone == NULL) {
+			return NULL;
+		}
+	}
 
-	if(!init_chunk_list(&zone->chunk_list, chunk_size)) {
+	if(!msgpack_zone_init(zone, chunk_size)) {
 		free(zone);
 		return NULL;
 	}
 
-	init_finalizer_array(&zone->finalizer_array);
-
 	return zone;
 }
 
@@ -216,6 +332,56 @@ void msgpack_zone_free(msgpack_zone* zone)
 {
 	if(zone == NULL) { return; }
 	msgpack_zone_destroy(zone);
-	free(zone);
+
+	msgpack_zone_pool* const pool = &zone_pool;
+	if(pool->size + sizeof(msgpack_zone) > pool->limit) {
+		free(zone);
+		return;
+	}
+
+	*(msgpack_zone**)zone = pool->zones;
+	pool->zones = zone;
+	pool->size += sizeof(msgpack_zone);
+}
+
+
+void msgpack_zone_pool_set_limit(size_t limit)
+{
+	zone_pool.limit = limit;
+	if(zone_pool.size > limit) {
+		msgpack_zone_pool_trim();
+	}
+}
+
+size_t msgpack_zone_pool_get_limit(void)
+{
+	return zone_pool.limit;
+}
+
+size_t msgpack_zone_pool_size(void)
+{
+	return zone_pool.size;
+}
+
+void msgpack_zone_pool_trim(void)
+{
+	msgpack_zone_pool* const pool = &zone_pool;
+
+	unsigned int n;
+	for(n = 0; n < MSGPACK_ZONE_POOL_CLASSES; ++n) {
+		while(pool->chunks[n] != NULL) {
+			msgpack_zone_chunk* c = pool->chunks[n];
+			pool->chunks[n] = c->next;
+			free(c);
+		}
+	}
+
+	while(pool->zones != NULL) {
+		msgpack_zone* z = pool->zones;
+		pool->zones = *(msgpack_zone**)z;
+		free(z);
+	}
+
+	pool->size = 0;
 }
 
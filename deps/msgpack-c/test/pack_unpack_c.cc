@@ -68,3 +68,199 @@ TEST(unpack, sequence)
 	msgpack_unpacked_destroy(&msg);
 }
 
+
+TEST(unpack, ext)
+{
+	static const size_t sizes[] = {0, 1, 2, 3, 4, 8, 16, 17, 255, 256, 65535, 65536};
+	char data[65536];
+	for(size_t i = 0; i < sizeof(data); ++i) {
+		data[i] = (char)i;
+	}
+
+	for(size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); ++s) {
+		msgpack_sbuffer sbuf;
+		msgpack_sbuffer_init(&sbuf);
+		msgpack_packer pk;
+		msgpack_packer_init(&pk, &sbuf, msgpack_sbuffer_write);
+
+		EXPECT_EQ(0, msgpack_pack_ext(&pk, 42, sizes[s]));
+		EXPECT_EQ(0, msgpack_pack_ext_body(&pk, data, sizes[s]));
+
+		msgpack_unpacked msg;
+		msgpack_unpacked_init(&msg);
+		size_t offset = 0;
+		EXPECT_TRUE(msgpack_unpack_next(&msg, sbuf.data, sbuf.size, &offset));
+		EXPECT_EQ(sbuf.size, offset);
+		EXPECT_EQ(MSGPACK_OBJECT_EXT, msg.data.type);
+		EXPECT_EQ(42, msg.data.via.ext.type);
+		EXPECT_EQ(sizes[s], msg.data.via.ext.size);
+		EXPECT_EQ(0, memcmp(data, msg.data.via.ext.ptr, sizes[s]));
+
+		// packing the object again gives the same bytes
+		msgpack_sbuffer sbuf2;
+		msgpack_sbuffer_init(&sbuf2);
+		msgpack_packer_init(&pk, &sbuf2, msgpack_sbuffer_write);
+		EXPECT_EQ(0, msgpack_pack_object(&pk, msg.data));
+		EXPECT_EQ(sbuf.size, sbuf2.size);
+		EXPECT_EQ(0, memcmp(sbuf.data, sbuf2.data, sbuf.size));
+
+		msgpack_unpacked_destroy(&msg);
+		msgpack_sbuffer_destroy(&sbuf2);
+		msgpack_sbuffer_destroy(&sbuf);
+	}
+}
+
+
+TEST(unpack, typed_array)
+{
+	float floats[1000];
+	int16_t shorts[1000];
+	double doubles[1000];
+	for(int i = 0; i < 1000; ++i) {
+		floats[i] = i * 0.5f;
+		shorts[i] = (int16_t)(i - 500);
+		doubles[i] = i * 1e10;
+	}
+
+	msgpack_sbuffer* sbuf = msgpack_sbuffer_new();
+	msgpack_packer* pk = msgpack_packer_new(sbuf, msgpack_sbuffer_write);
+	EXPECT_EQ(0, msgpack_pack_array(pk, 4));
+	EXPECT_EQ(0, msgpack_pack_typed_array(pk, MSGPACK_TYPED_ARRAY_FLOAT, floats, 1000));
+	EXPECT_EQ(0, msgpack_pack_typed_array(pk, MSGPACK_TYPED_ARRAY_INT16, shorts, 1000));
+	EXPECT_EQ(0, msgpack_pack_typed_array(pk, MSGPACK_TYPED_ARRAY_DOUBLE, doubles, 1000));
+	EXPECT_EQ(0, msgpack_pack_typed_array(pk, MSGPACK_TYPED_ARRAY_UINT8, NULL, 0));
+	EXPECT_EQ(-1, msgpack_pack_typed_array(pk, (msgpack_typed_array_type)1, floats, 1));
+	msgpack_packer_free(pk);
+
+	msgpack_unpacked msg;
+	msgpack_unpacked_init(&msg);
+	size_t offset = 0;
+	EXPECT_TRUE(msgpack_unpack_next(&msg, sbuf->data, sbuf->size, &offset));
+	EXPECT_EQ(MSGPACK_OBJECT_ARRAY, msg.data.type);
+	msgpack_object* items = msg.data.via.array.ptr;
+
+	msgpack_typed_array a;
+	EXPECT_TRUE(msgpack_object_typed_array(items[0], &a));
+	EXPECT_EQ(MSGPACK_TYPED_ARRAY_FLOAT, a.type);
+	EXPECT_EQ(1000u, a.size);
+	// a view into the buffer, not a copy
+	EXPECT_TRUE(a.ptr > sbuf->data && a.ptr < sbuf->data + sbuf->size);
+	float f[1000];
+	msgpack_typed_array_copy(&a, f);
+	EXPECT_EQ(0, memcmp(floats, f, sizeof(f)));
+
+	EXPECT_TRUE(msgpack_object_typed_array(items[1], &a));
+	EXPECT_EQ(MSGPACK_TYPED_ARRAY_INT16, a.type);
+	int16_t s[1000];
+	msgpack_typed_array_copy(&a, s);
+	EXPECT_EQ(0, memcmp(shorts, s, sizeof(s)));
+
+	EXPECT_TRUE(msgpack_object_typed_array(items[2], &a));
+	double d[1000];
+	msgpack_typed_array_copy(&a, d);
+	EXPECT_EQ(0, memcmp(doubles, d, sizeof(d)));
+
+	EXPECT_TRUE(msgpack_object_typed_array(items[3], &a));
+	EXPECT_EQ(0u, a.size);
+
+	// an ext of another type is not a typed array
+	EXPECT_FALSE(msgpack_object_typed_array(msg.data, &a));
+
+	msgpack_unpacked_destroy(&msg);
+	msgpack_sbuffer_free(sbuf);
+}
+
+
+TEST(unpack, typed_array_swap)
+{
+	uint32_t v[3] = {0x01020304, 0xa0b0c0d0, 0};
+	uint32_t w[3];
+	msgpack_typed_array_swap(w, v, sizeof(v), 4);
+	EXPECT_EQ(0x04030201u, w[0]);
+	EXPECT_EQ(0xd0c0b0a0u, w[1]);
+
+	uint64_t x = 0x0102030405060708ULL;
+	uint64_t y;
+	msgpack_typed_array_swap(&y, &x, 8, 8);
+	EXPECT_EQ(0x0807060504030201ULL, y);
+}
+
+
+#define THROUGHPUT_ELEMENTS (1 << 20)
+#define THROUGHPUT_ROUNDS 8
+
+static double now()
+{
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+TEST(throughput, float_array)
+{
+	float* floats = (float*)malloc(THROUGHPUT_ELEMENTS * sizeof(float));
+	float* out = (float*)malloc(THROUGHPUT_ELEMENTS * sizeof(float));
+	for(int i = 0; i < THROUGHPUT_ELEMENTS; ++i) {
+		floats[i] = i * 0.25f;
+	}
+
+	msgpack_sbuffer sbuf;
+	msgpack_sbuffer_init(&sbuf);
+	msgpack_packer pk;
+	msgpack_packer_init(&pk, &sbuf, msgpack_sbuffer_write);
+
+	// one tagged value per element
+	double pack = 0, unpack = 0;
+	for(int r = 0; r < THROUGHPUT_ROUNDS; ++r) {
+		sbuf.size = 0;
+		double start = now();
+		msgpack_pack_array(&pk, THROUGHPUT_ELEMENTS);
+		for(int i = 0; i < THROUGHPUT_ELEMENTS; ++i) {
+			msgpack_pack_float(&pk, floats[i]);
+		}
+		pack += now() - start;
+
+		start = now();
+		msgpack_unpacked msg;
+		msgpack_unpacked_init(&msg);
+		size_t offset = 0;
+		EXPECT_TRUE(msgpack_unpack_next(&msg, sbuf.data, sbuf.size, &offset));
+		for(int i = 0; i < THROUGHPUT_ELEMENTS; ++i) {
+			out[i] = (float)msg.data.via.array.ptr[i].via.dec;
+		}
+		unpack += now() - start;
+		msgpack_unpacked_destroy(&msg);
+	}
+	EXPECT_EQ(0, memcmp(floats, out, THROUGHPUT_ELEMENTS * sizeof(float)));
+
+	// one typed array
+	double typed_pack = 0, typed_unpack = 0;
+	memset(out, 0, THROUGHPUT_ELEMENTS * sizeof(float));
+	for(int r = 0; r < THROUGHPUT_ROUNDS; ++r) {
+		sbuf.size = 0;
+		double start = now();
+		msgpack_pack_typed_array(&pk, MSGPACK_TYPED_ARRAY_FLOAT, floats, THROUGHPUT_ELEMENTS);
+		typed_pack += now() - start;
+
+		start = now();
+		msgpack_unpacked msg;
+		msgpack_unpacked_init(&msg);
+		size_t offset = 0;
+		EXPECT_TRUE(msgpack_unpack_next(&msg, sbuf.data, sbuf.size, &offset));
+		msgpack_typed_array a;
+		EXPECT_TRUE(msgpack_object_typed_array(msg.data, &a));
+		msgpack_typed_array_copy(&a, out);
+		typed_unpack += now() - start;
+		msgpack_unpacked_destroy(&msg);
+	}
+	EXPECT_EQ(0, memcmp(floats, out, THROUGHPUT_ELEMENTS * sizeof(float)));
+
+	const double mb = THROUGHPUT_ROUNDS * THROUGHPUT_ELEMENTS * sizeof(float) / 1e6;
+	printf("float array:  pack %.0f MB/s, unpack %.0f MB/s\n", mb / pack, mb / unpack);
+	printf("typed array:  pack %.0f MB/s, unpack %.0f MB/s\n", mb / typed_pack, mb / typed_unpack);
+
+	msgpack_sbuffer_destroy(&sbuf);
+	free(out);
+	free(floats);
+}
+
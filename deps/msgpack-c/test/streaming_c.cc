@@ -96,3 +96,208 @@ TEST(streaming, basic)
 	msgpack_unpacked_destroy(&result);
 }
 
+
+
+TEST(streaming, typed_array)
+{
+	// the elements arrive a few bytes at a time
+	int32_t ints[300];
+	for(int i = 0; i < 300; ++i) {
+		ints[i] = i * 1000 - 7;
+	}
+
+	msgpack_sbuffer* buffer = msgpack_sbuffer_new();
+	msgpack_packer* pk = msgpack_packer_new(buffer, msgpack_sbuffer_write);
+	EXPECT_EQ(0, msgpack_pack_typed_array(pk, MSGPACK_TYPED_ARRAY_INT32, ints, 300));
+	EXPECT_EQ(0, msgpack_pack_ext(pk, 7, 4));
+	EXPECT_EQ(0, msgpack_pack_ext_body(pk, "abcd", 4));
+	msgpack_packer_free(pk);
+
+	msgpack_unpacker pac;
+	msgpack_unpacker_init(&pac, MSGPACK_UNPACKER_INIT_BUFFER_SIZE);
+	msgpack_unpacked result;
+	msgpack_unpacked_init(&result);
+
+	int count = 0;
+	const char* input = buffer->data;
+	const char* const eof = input + buffer->size;
+	while(input < eof) {
+		size_t len = eof - input < 5 ? eof - input : 5;
+		msgpack_unpacker_reserve_buffer(&pac, len);
+		memcpy(msgpack_unpacker_buffer(&pac), input, len);
+		msgpack_unpacker_buffer_consumed(&pac, len);
+		input += len;
+
+		while(msgpack_unpacker_next(&pac, &result)) {
+			msgpack_typed_array a;
+			if(count == 0) {
+				EXPECT_TRUE(msgpack_object_typed_array(result.data, &a));
+				EXPECT_EQ(300u, a.size);
+				int32_t out[300];
+				msgpack_typed_array_copy(&a, out);
+				EXPECT_EQ(0, memcmp(ints, out, sizeof(out)));
+			} else {
+				EXPECT_EQ(MSGPACK_OBJECT_EXT, result.data.type);
+				EXPECT_EQ(7, result.data.via.ext.type);
+				EXPECT_EQ(0, memcmp("abcd", result.data.via.ext.ptr, 4));
+			}
+			++count;
+		}
+	}
+	EXPECT_EQ(2, count);
+
+	msgpack_unpacker_destroy(&pac);
+	msgpack_unpacked_destroy(&result);
+	msgpack_sbuffer_free(buffer);
+}
+
+
+static void pack_record(msgpack_packer* pk, int i)
+{
+	// [i, "record <i>", {"nested": [i]}, ext]
+	char text[32];
+	int len = sprintf(text, "record %d", i);
+	msgpack_pack_array(pk, 4);
+	msgpack_pack_int(pk, i);
+	msgpack_pack_raw(pk, len);
+	msgpack_pack_raw_body(pk, text, len);
+	msgpack_pack_map(pk, 1);
+	msgpack_pack_raw(pk, 6);
+	msgpack_pack_raw_body(pk, "nested", 6);
+	msgpack_pack_array(pk, 1);
+	msgpack_pack_int(pk, i);
+	msgpack_pack_ext(pk, 1, 2);
+	msgpack_pack_ext_body(pk, "xy", 2);
+}
+
+static std::string write_records(int first, int count, const char* mode)
+{
+	msgpack_sbuffer sbuf;
+	msgpack_sbuffer_init(&sbuf);
+	msgpack_packer pk;
+	msgpack_packer_init(&pk, &sbuf, msgpack_sbuffer_write);
+	for(int i = first; i < first + count; ++i) {
+		pack_record(&pk, i);
+	}
+
+	std::string path = "/tmp/msgpack_mapped_reader_test";
+	FILE* f = fopen(path.c_str(), mode);
+	fwrite(sbuf.data, 1, sbuf.size, f);
+	fclose(f);
+	msgpack_sbuffer_destroy(&sbuf);
+	return path;
+}
+
+TEST(streaming, skip)
+{
+	msgpack_sbuffer sbuf;
+	msgpack_sbuffer_init(&sbuf);
+	msgpack_packer pk;
+	msgpack_packer_init(&pk, &sbuf, msgpack_sbuffer_write);
+	pack_record(&pk, 1000000);
+	msgpack_pack_double(&pk, 0.5);
+
+	size_t off = 0;
+	EXPECT_EQ(1, msgpack_skip(sbuf.data, sbuf.size, &off));
+	EXPECT_EQ(1, msgpack_skip(sbuf.data, sbuf.size, &off));
+	EXPECT_EQ(sbuf.size, off);
+
+	// every cut of the first object is incomplete
+	for(size_t len = 0; len < sbuf.size - 9; ++len) {
+		off = 0;
+		EXPECT_EQ(0, msgpack_skip(sbuf.data, len, &off));
+		EXPECT_EQ(0u, off);
+	}
+
+	const char bad[] = "\x92\x01\xc1";
+	off = 0;
+	EXPECT_EQ(-1, msgpack_skip(bad, 3, &off));
+
+	msgpack_sbuffer_destroy(&sbuf);
+}
+
+TEST(streaming, mapped_reader)
+{
+	std::string path = write_records(0, 1000, "wb");
+
+	msgpack_mapped_reader mr;
+	ASSERT_TRUE(msgpack_mapped_reader_open(&mr, path.c_str(), 16));
+
+	msgpack_object obj;
+	int count = 0;
+	while(msgpack_mapped_reader_next(&mr, &obj)) {
+		EXPECT_EQ(MSGPACK_OBJECT_ARRAY, obj.type);
+		EXPECT_EQ(4u, obj.via.array.size);
+		EXPECT_EQ((uint64_t)count, obj.via.array.ptr[0].via.u64);
+
+		// read in place
+		const msgpack_object_raw& text = obj.via.array.ptr[1].via.raw;
+		EXPECT_TRUE(text.ptr > mr.data && text.ptr < mr.data + mr.size);
+		char expected[32];
+		sprintf(expected, "record %d", count);
+		EXPECT_EQ(std::string(expected), std::string(text.ptr, text.size));
+		EXPECT_EQ(MSGPACK_OBJECT_EXT, obj.via.array.ptr[3].type);
+		++count;
+	}
+	EXPECT_EQ(1000, count);
+	EXPECT_EQ(1000u, msgpack_mapped_reader_tell(&mr));
+	EXPECT_EQ(0u, msgpack_mapped_reader_remaining(&mr));
+
+	// back and forth through the index
+	const uint64_t targets[] = { 0, 517, 15, 16, 999, 998, 300 };
+	for(size_t i = 0; i < sizeof(targets) / sizeof(targets[0]); ++i) {
+		EXPECT_TRUE(msgpack_mapped_reader_seek(&mr, targets[i]));
+		EXPECT_EQ(targets[i], msgpack_mapped_reader_tell(&mr));
+		EXPECT_TRUE(msgpack_mapped_reader_next(&mr, &obj));
+		EXPECT_EQ(targets[i], obj.via.array.ptr[0].via.u64);
+	}
+	EXPECT_FALSE(msgpack_mapped_reader_seek(&mr, 1001));
+	EXPECT_EQ(1000u, msgpack_mapped_reader_tell(&mr));
+
+	msgpack_mapped_reader_destroy(&mr);
+	remove(path.c_str());
+}
+
+TEST(streaming, mapped_reader_append)
+{
+	std::string path = write_records(0, 10, "wb");
+
+	// half of a record, as if the writer was in the middle of it
+	msgpack_sbuffer sbuf;
+	msgpack_sbuffer_init(&sbuf);
+	msgpack_packer pk;
+	msgpack_packer_init(&pk, &sbuf, msgpack_sbuffer_write);
+	pack_record(&pk, 10);
+	FILE* f = fopen(path.c_str(), "ab");
+	fwrite(sbuf.data, 1, sbuf.size / 2, f);
+	fclose(f);
+
+	msgpack_mapped_reader mr;
+	ASSERT_TRUE(msgpack_mapped_reader_open(&mr, path.c_str(), 4));
+	msgpack_object obj;
+	while(msgpack_mapped_reader_next(&mr, &obj)) { }
+	EXPECT_EQ(10u, msgpack_mapped_reader_tell(&mr));
+	EXPECT_EQ(sbuf.size / 2, msgpack_mapped_reader_remaining(&mr));
+	EXPECT_FALSE(msgpack_mapped_reader_refresh(&mr));
+
+	f = fopen(path.c_str(), "ab");
+	fwrite(sbuf.data + sbuf.size / 2, 1, sbuf.size - sbuf.size / 2, f);
+	fclose(f);
+	write_records(11, 5, "ab");
+	msgpack_sbuffer_destroy(&sbuf);
+
+	EXPECT_TRUE(msgpack_mapped_reader_refresh(&mr));
+	int count = 10;
+	while(msgpack_mapped_reader_next(&mr, &obj)) {
+		EXPECT_EQ((uint64_t)count, obj.via.array.ptr[0].via.u64);
+		++count;
+	}
+	EXPECT_EQ(16, count);
+
+	EXPECT_TRUE(msgpack_mapped_reader_seek(&mr, 13));
+	EXPECT_TRUE(msgpack_mapped_reader_next(&mr, &obj));
+	EXPECT_EQ(13u, obj.via.array.ptr[0].via.u64);
+
+	msgpack_mapped_reader_destroy(&mr);
+	remove(path.c_str());
+}
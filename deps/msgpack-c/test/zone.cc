@@ -76,3 +76,52 @@ TEST(zone, malloc_no_align)
 	EXPECT_EQ(buf1+4, buf2);
 }
 
+
+TEST(zone, reset)
+{
+	msgpack::zone z(64);
+	for(int i=0; i < 16; ++i) {
+		z.malloc_no_align(32);
+	}
+	z.reset();
+	EXPECT_TRUE(msgpack_zone_is_empty(&z));
+
+	// the 512 bytes of the first round now fit in one chunk
+	char* buf1 = (char*)z.malloc_no_align(256);
+	char* buf2 = (char*)z.malloc_no_align(256);
+	EXPECT_EQ(buf1+256, buf2);
+}
+
+
+TEST(zone, pool)
+{
+	msgpack_zone_pool_set_limit(1024 * 1024);
+	EXPECT_EQ(0u, msgpack_zone_pool_size());
+
+	msgpack_zone* z = msgpack_zone_new(MSGPACK_ZONE_CHUNK_SIZE);
+	msgpack_zone_malloc(z, MSGPACK_ZONE_CHUNK_SIZE * 2);
+	msgpack_zone_free(z);
+	size_t pooled = msgpack_zone_pool_size();
+	EXPECT_LT((size_t)MSGPACK_ZONE_CHUNK_SIZE * 3, pooled);
+
+	// the next zone is made of the cached chunks
+	z = msgpack_zone_new(MSGPACK_ZONE_CHUNK_SIZE);
+	EXPECT_GT(pooled, msgpack_zone_pool_size());
+	msgpack_zone_free(z);
+	EXPECT_EQ(pooled, msgpack_zone_pool_size());
+
+	msgpack_zone_pool_set_limit(0);
+	EXPECT_EQ(0u, msgpack_zone_pool_size());
+}
+
+
+TEST(zone, pool_limit)
+{
+	msgpack_zone_pool_set_limit(MSGPACK_ZONE_CHUNK_SIZE);
+	msgpack_zone* z = msgpack_zone_new(MSGPACK_ZONE_CHUNK_SIZE);
+	msgpack_zone_malloc(z, MSGPACK_ZONE_CHUNK_SIZE * 4);
+	msgpack_zone_free(z);
+	EXPECT_GE((size_t)MSGPACK_ZONE_CHUNK_SIZE, msgpack_zone_pool_size());
+	msgpack_zone_pool_set_limit(0);
+}
+
@@ -44,10 +44,10 @@ typedef enum {
 	//CS_                = 0x04,
 	//CS_                = 0x05,
 	//CS_                = 0x06,
-	//CS_                = 0x07,
+	CS_EXT_8             = 0x07,
 
-	//CS_                = 0x08,
-	//CS_                = 0x09,
+	CS_EXT_16            = 0x08,
+	CS_EXT_32            = 0x09,
 	CS_FLOAT             = 0x0a,
 	CS_DOUBLE            = 0x0b,
 	CS_UINT_8            = 0x0c,
@@ -75,6 +75,7 @@ typedef enum {
 	//ACS_BIG_INT_VALUE,
 	//ACS_BIG_FLOAT_VALUE,
 	ACS_RAW_VALUE,
+	ACS_EXT_VALUE,
 } msgpack_unpack_state;
 
 
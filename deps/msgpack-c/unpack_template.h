@@ -204,9 +204,10 @@ msgpack_unpack_func(int, _execute)(msgpack_unpack_struct(_context)* ctx, const c
 				//case 0xc4:
 				//case 0xc5:
 				//case 0xc6:
-				//case 0xc7:
-				//case 0xc8:
-				//case 0xc9:
+				case 0xc7:  // ext 8
+				case 0xc8:  // ext 16
+				case 0xc9:  // ext 32
+					again_fixed_trail(NEXT_CS(p), 1 << ((((unsigned int)*p) + 1) & 0x03));
 				case 0xca:  // float
 				case 0xcb:  // double
 				case 0xcc:  // unsigned int  8
@@ -218,12 +219,14 @@ msgpack_unpack_func(int, _execute)(msgpack_unpack_struct(_context)* ctx, const c
 				case 0xd2:  // signed int 32
 				case 0xd3:  // signed int 64
 					again_fixed_trail(NEXT_CS(p), 1 << (((unsigned int)*p) & 0x03));
-				//case 0xd4:
-				//case 0xd5:
-				//case 0xd6:  // big integer 16
-				//case 0xd7:  // big integer 32
-				//case 0xd8:  // big float 16
-				//case 0xd9:  // big float 32
+				case 0xd4:  // fixext 1
+				case 0xd5:  // fixext 2
+				case 0xd6:  // fixext 4
+				case 0xd7:  // fixext 8
+				case 0xd8:  // fixext 16
+					/* the type byte is read with the data */
+					again_fixed_trail(ACS_EXT_VALUE, (1 << (((unsigned int)*p) - 0xd4)) + 1);
+				//case 0xd9:
 				case 0xda:  // raw 16
 				case 0xdb:  // raw 32
 				case 0xdc:  // array 16
@@ -314,6 +317,16 @@ msgpack_unpack_func(int, _execute)(msgpack_unpack_struct(_context)* ctx, const c
 			_raw_zero:
 				push_variable_value(_raw, data, n, trail);
 
+			case CS_EXT_8:
+				again_fixed_trail(ACS_EXT_VALUE, *(uint8_t*)n + 1);
+			case CS_EXT_16:
+				again_fixed_trail(ACS_EXT_VALUE, _msgpack_load16(uint16_t,n) + 1);
+			case CS_EXT_32:
+				if(_msgpack_load32(uint32_t,n) == 0xffffffff) { goto _failed; }
+				again_fixed_trail(ACS_EXT_VALUE, _msgpack_load32(uint32_t,n) + 1);
+			case ACS_EXT_VALUE:
+				push_variable_value(_ext, data, n, trail);
+
 			case CS_ARRAY_16:
 				start_container(_array, _msgpack_load16(uint16_t,n), CT_ARRAY_ITEM);
 			case CS_ARRAY_32:
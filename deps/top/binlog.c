@@ -0,0 +1,517 @@
+/*
+ * Copyright (c) 2008, 2009 Apple Computer, Inc.  All rights reserved.
+ *
+ * @APPLE_LICENSE_HEADER_START@
+ * 
+ * The contents of this file constitute Original Code as defined in and
+ * are subject to the Apple Public Source License Version 1.1 (the
+ * "License").  You may not use this file except in compliance with the
+ * License.  Please obtain a copy of the License at
+ * http://www.apple.com/publicsource and read it before using this file.
+ * 
+ * This Original Code and all software distributed under the License are
+ * distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY KIND, EITHER
+ * EXPRESS OR IMPLIED, AND APPLE HEREBY DISCLAIMS ALL SUCH WARRANTIES,
+ * INCLUDING WITHOUT LIMITATION, ANY WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE OR NON-INFRINGEMENT.  Please see the
+ * License for the specific language governing rights and limitations
+ * under the License.
+ * 
+ * @APPLE_LICENSE_HEADER_END@
+ */
+
+/*
+ * Binary logging mode.  At short intervals with many processes the text
+ * logging mode spends most of its time formatting cells, and its output is
+ * mostly the same rows printed again.  This mode writes the libtop samples
+ * instead, in msgpack, as a stream of objects:
+ *
+ *  - A header map:
+ *      {"format": "top-binlog", "version": 1,
+ *       "start": <time of the first sample, in microseconds since the epoch>,
+ *       "interval": <requested delay between samples, in microseconds>,
+ *       "columns": [[<header>, <kind>, <unit>], ...]}
+ *    The columns are the statistics selected with -stats and -ncols, less
+ *    the PID which keys the rows.  The kind is "delta" or "string".
+ *
+ *  - Then an array for each sample:
+ *      [<microseconds since the previous sample>,
+ *       [[<pid>, <value>, ...], ...]]
+ *    A "delta" value is the difference with the value of the same pid in
+ *    the previous sample, or the value itself when the pid was not in it.
+ *    A "string" value is nil when it did not change.
+ *
+ * The event counters and TIME are logged as totals, so their deltas are the
+ * events of each interval.  %CPU is in hundredths of a percent.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/time.h>
+
+#include <msgpack/pack.h>
+#include <msgpack/sbuffer.h>
+
+#include "libtop.h"
+#include "statistic.h"
+#include "preferences.h"
+#include "top.h"
+#include "binlog.h"
+
+extern const libtop_tsamp_t *tsamp;
+
+enum {
+    BINLOG_DELTA = 1,
+    BINLOG_STRING
+};
+
+static const struct {
+    int kind;
+    const char *unit;
+} binlog_types[STATISTIC_TOTAL] = {
+    [STATISTIC_PID] = {BINLOG_DELTA, "id"},
+    [STATISTIC_COMMAND] = {BINLOG_STRING, "text"},
+    [STATISTIC_CPU] = {BINLOG_DELTA, "0.01%"},
+    [STATISTIC_TIME] = {BINLOG_DELTA, "us"},
+    [STATISTIC_THREADS] = {BINLOG_DELTA, "count"},
+    [STATISTIC_PORTS] = {BINLOG_DELTA, "count"},
+    [STATISTIC_MREGION] = {BINLOG_DELTA, "count"},
+    [STATISTIC_RPRVT] = {BINLOG_DELTA, "bytes"},
+    [STATISTIC_RSHRD] = {BINLOG_DELTA, "bytes"},
+    [STATISTIC_RSIZE] = {BINLOG_DELTA, "bytes"},
+    [STATISTIC_VSIZE] = {BINLOG_DELTA, "bytes"},
+    [STATISTIC_VPRVT] = {BINLOG_DELTA, "bytes"},
+    [STATISTIC_PGRP] = {BINLOG_DELTA, "id"},
+    [STATISTIC_PPID] = {BINLOG_DELTA, "id"},
+    [STATISTIC_PSTATE] = {BINLOG_STRING, "text"},
+    [STATISTIC_UID] = {BINLOG_DELTA, "id"},
+    [STATISTIC_WORKQUEUE] = {BINLOG_DELTA, "count"},
+    [STATISTIC_FAULTS] = {BINLOG_DELTA, "total"},
+    [STATISTIC_COW_FAULTS] = {BINLOG_DELTA, "total"},
+    [STATISTIC_MESSAGES_SENT] = {BINLOG_DELTA, "total"},
+    [STATISTIC_MESSAGES_RECEIVED] = {BINLOG_DELTA, "total"},
+    [STATISTIC_SYSBSD] = {BINLOG_DELTA, "total"},
+    [STATISTIC_SYSMACH] = {BINLOG_DELTA, "total"},
+    [STATISTIC_CSW] = {BINLOG_DELTA, "total"},
+    [STATISTIC_PAGEINS] = {BINLOG_DELTA, "total"},
+    [STATISTIC_KPRVT] = {BINLOG_DELTA, "bytes"},
+    [STATISTIC_KSHRD] = {BINLOG_DELTA, "bytes"},
+    [STATISTIC_USER] = {BINLOG_STRING, "text"}
+};
+
+struct binlog_key {
+    pid_t pid;
+    size_t row;
+};
+
+/* The values of a sample, kept to encode the next one. */
+struct binlog_rows {
+    size_t length, capacity;
+    int64_t *values; /* length * ncolumns, for the delta columns */
+    char **strings; /* length * ncolumns, for the string columns */
+    struct binlog_key *keys; /* Sorted by pid once the sample is complete. */
+};
+
+struct binlog {
+    int fd;
+    bool started;
+    bool error;
+    struct timeval last;
+
+    int ncolumns;
+    int types[STATISTIC_TOTAL];
+    const char *headers[STATISTIC_TOTAL];
+
+    struct binlog_rows rows[2];
+    struct binlog_rows *current, *previous;
+
+    msgpack_sbuffer buffer; /* The sample, after the header if any. */
+    msgpack_packer packer;
+    msgpack_sbuffer row_buffer; /* The rows, packed while they are counted. */
+    msgpack_packer row_packer;
+};
+
+static int64_t binlog_usec(const struct timeval *tv) {
+    return (int64_t)tv->tv_sec * 1000000 + tv->tv_usec;
+}
+
+/* Hundredths of a percent, computed like the %CPU statistic does. */
+static int64_t binlog_cpu(const libtop_psamp_t *psamp) {
+    struct timeval elapsed, used;
+
+    if(0 == psamp->p_seq)
+	return 0;
+
+    if(STATMODE_ACCUM == top_prefs_get_mode()) {
+	timersub(&tsamp->time, &tsamp->b_time, &elapsed);
+	timersub(&psamp->total_time, &psamp->b_total_time, &used);
+    } else {
+	timersub(&tsamp->time, &tsamp->p_time, &elapsed);
+	timersub(&psamp->total_time, &psamp->p_total_time, &used);
+    }
+
+    if(binlog_usec(&elapsed) <= 0)
+	return 0;
+
+    return binlog_usec(&used) * 10000 / binlog_usec(&elapsed);
+}
+
+static int64_t binlog_value(int type, const libtop_psamp_t *psamp) {
+    switch(type) {
+    case STATISTIC_PID: return psamp->pid;
+    case STATISTIC_CPU: return binlog_cpu(psamp);
+    case STATISTIC_TIME: return binlog_usec(&psamp->total_time);
+    case STATISTIC_THREADS: return psamp->th;
+    case STATISTIC_PORTS: return psamp->prt;
+    case STATISTIC_MREGION: return psamp->reg;
+    case STATISTIC_RPRVT: return psamp->rprvt;
+    case STATISTIC_RSHRD: return psamp->rshrd;
+    case STATISTIC_RSIZE: return psamp->rsize;
+    case STATISTIC_VSIZE: return psamp->vsize;
+    case STATISTIC_VPRVT: return psamp->vprvt;
+    case STATISTIC_PGRP: return psamp->pgrp;
+    case STATISTIC_PPID: return psamp->ppid;
+    case STATISTIC_UID: return psamp->uid;
+    case STATISTIC_WORKQUEUE: return psamp->wq_nthreads;
+    case STATISTIC_FAULTS: return psamp->faults.now;
+    case STATISTIC_COW_FAULTS: return psamp->cow_faults.now;
+    case STATISTIC_MESSAGES_SENT: return psamp->messages_sent.now;
+    case STATISTIC_MESSAGES_RECEIVED: return psamp->messages_recv.now;
+    case STATISTIC_SYSBSD: return psamp->syscalls_bsd.now;
+    case STATISTIC_SYSMACH: return psamp->syscalls_mach.now;
+    case STATISTIC_CSW: return psamp->csw.now;
+    case STATISTIC_PAGEINS: return psamp->pageins.now;
+    case STATISTIC_KPRVT: return psamp->palloc - psamp->pfree;
+    case STATISTIC_KSHRD: return psamp->salloc - psamp->sfree;
+    }
+
+    return 0;
+}
+
+static const char *binlog_string(int type, const libtop_psamp_t *psamp) {
+    const char *s = NULL;
+
+    switch(type) {
+    case STATISTIC_COMMAND:
+	s = psamp->command;
+	break;
+
+    case STATISTIC_PSTATE:
+	s = libtop_state_str(psamp->state);
+	break;
+
+    case STATISTIC_USER:
+	s = libtop_username(psamp->uid);
+	break;
+    }
+
+    return s ? s : "";
+}
+
+static void binlog_pack_string(msgpack_packer *pk, const char *s) {
+    size_t length = strlen(s);
+
+    msgpack_pack_raw(pk, length);
+    msgpack_pack_raw_body(pk, s, length);
+}
+
+static int binlog_key_compare(const void *a, const void *b) {
+    const struct binlog_key *ka = a, *kb = b;
+
+    return (ka->pid > kb->pid) - (ka->pid < kb->pid);
+}
+
+/* Return true if an error occurred. */
+static bool binlog_rows_grow(struct binlog_rows *rows, int ncolumns) {
+    size_t capacity = rows->capacity ? rows->capacity * 2 : 256;
+    int64_t *values;
+    char **strings;
+    struct binlog_key *keys;
+
+    values = realloc(rows->values, capacity * ncolumns * sizeof(*values));
+    if(NULL == values)
+	return true;
+    rows->values = values;
+
+    strings = realloc(rows->strings, capacity * ncolumns * sizeof(*strings));
+    if(NULL == strings)
+	return true;
+    rows->strings = strings;
+
+    keys = realloc(rows->keys, capacity * sizeof(*keys));
+    if(NULL == keys)
+	return true;
+    rows->keys = keys;
+
+    rows->capacity = capacity;
+
+    return false;
+}
+
+static void binlog_rows_clear(struct binlog_rows *rows, int ncolumns) {
+    size_t i;
+
+    for(i = 0; i < rows->length * ncolumns; ++i)
+	free(rows->strings[i]);
+
+    rows->length = 0;
+}
+
+static void binlog_rows_destroy(struct binlog_rows *rows, int ncolumns) {
+    binlog_rows_clear(rows, ncolumns);
+    free(rows->values);
+    free(rows->strings);
+    free(rows->keys);
+}
+
+struct binlog_column_data {
+    struct binlog *log;
+    bool have_limit;
+    int ncols;
+    int column;
+};
+
+static bool binlog_column_iter(struct statistic *s, void *ptr) {
+    struct binlog_column_data *data = ptr;
+    struct binlog *log = data->log;
+
+    if(STATISTIC_PID != s->type && s->type < STATISTIC_TOTAL) {
+	log->types[log->ncolumns] = s->type;
+	log->headers[log->ncolumns] = s->header;
+	log->ncolumns++;
+    }
+
+    data->column++;
+
+    /* The same columns as the text logging mode. */
+    if(data->have_limit && data->column >= data->ncols)
+	return false;
+
+    return true;
+}
+
+struct binlog *top_binlog_create(const char *path, void *tinst) {
+    struct statistics_controller *c = tinst;
+    struct binlog_column_data data;
+    struct binlog *log;
+
+    log = calloc(1, sizeof(*log));
+    if(NULL == log)
+	return NULL;
+
+    if(!strcmp(path, "-")) {
+	log->fd = STDOUT_FILENO;
+    } else {
+	log->fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+
+	if(-1 == log->fd) {
+	    free(log);
+	    return NULL;
+	}
+    }
+
+    data.log = log;
+    data.have_limit = top_prefs_get_ncols(&data.ncols);
+    data.column = 0;
+
+    c->iterate(c, binlog_column_iter, &data);
+
+    log->current = &log->rows[0];
+    log->previous = &log->rows[1];
+
+    msgpack_sbuffer_init(&log->buffer);
+    msgpack_packer_init(&log->packer, &log->buffer, msgpack_sbuffer_write);
+    msgpack_sbuffer_init(&log->row_buffer);
+    msgpack_packer_init(&log->row_packer, &log->row_buffer,
+			msgpack_sbuffer_write);
+
+    return log;
+}
+
+static void binlog_pack_header(struct binlog *log) {
+    msgpack_packer *pk = &log->packer;
+    int i;
+
+    msgpack_pack_map(pk, 5);
+
+    binlog_pack_string(pk, "format");
+    binlog_pack_string(pk, "top-binlog");
+
+    binlog_pack_string(pk, "version");
+    msgpack_pack_int(pk, 1);
+
+    binlog_pack_string(pk, "start");
+    msgpack_pack_int64(pk, binlog_usec(&tsamp->time));
+
+    binlog_pack_string(pk, "interval");
+    msgpack_pack_int64(pk, top_prefs_get_sleep_usec());
+
+    binlog_pack_string(pk, "columns");
+    msgpack_pack_array(pk, log->ncolumns);
+
+    for(i = 0; i < log->ncolumns; ++i) {
+	msgpack_pack_array(pk, 3);
+	binlog_pack_string(pk, log->headers[i]);
+	binlog_pack_string(pk, BINLOG_STRING == binlog_types[log->types[i]].kind
+			   ? "string" : "delta");
+	binlog_pack_string(pk, binlog_types[log->types[i]].unit);
+    }
+}
+
+/* Pack a row, and keep its values for the next sample. */
+static void binlog_insert_row(const void *sample, void *ptr) {
+    const libtop_psamp_t *psamp = sample;
+    struct binlog *log = ptr;
+    struct binlog_rows *current = log->current, *previous = log->previous;
+    msgpack_packer *pk = &log->row_packer;
+    struct binlog_key key, *found;
+    int64_t *values, *pvalues = NULL;
+    char **strings, **pstrings = NULL;
+    size_t row;
+    int i;
+
+    if(log->error)
+	return;
+
+    if(current->length == current->capacity
+       && binlog_rows_grow(current, log->ncolumns)) {
+	log->error = true;
+	return;
+    }
+
+    row = current->length;
+    values = current->values + row * log->ncolumns;
+    strings = current->strings + row * log->ncolumns;
+
+    key.pid = psamp->pid;
+    key.row = row;
+    current->keys[row] = key;
+
+    found = previous->length ? bsearch(&key, previous->keys, previous->length,
+				       sizeof(key), binlog_key_compare) : NULL;
+
+    if(found) {
+	pvalues = previous->values + found->row * log->ncolumns;
+	pstrings = previous->strings + found->row * log->ncolumns;
+    }
+
+    msgpack_pack_array(pk, 1 + log->ncolumns);
+    msgpack_pack_int64(pk, psamp->pid);
+
+    for(i = 0; i < log->ncolumns; ++i) {
+	int type = log->types[i];
+
+	if(BINLOG_STRING == binlog_types[type].kind) {
+	    const char *s = binlog_string(type, psamp);
+
+	    if(pstrings && pstrings[i] && !strcmp(pstrings[i], s)) {
+		/* Unchanged, the copy moves to this sample. */
+		strings[i] = pstrings[i];
+		pstrings[i] = NULL;
+		msgpack_pack_nil(pk);
+	    } else {
+		strings[i] = strdup(s);
+
+		if(NULL == strings[i]) {
+		    /* The row is dropped, free the strings it already took. */
+		    while(i-- > 0) {
+			free(strings[i]);
+			strings[i] = NULL;
+		    }
+
+		    log->error = true;
+		    return;
+		}
+
+		binlog_pack_string(pk, s);
+	    }
+	} else {
+	    strings[i] = NULL;
+	    values[i] = binlog_value(type, psamp);
+	    msgpack_pack_int64(pk, values[i] - (pvalues ? pvalues[i] : 0));
+	}
+    }
+
+    current->length++;
+}
+
+/* Return true if an error occurred. */
+static bool binlog_write_all(int fd, const char *buf, size_t length) {
+    while(length > 0) {
+	ssize_t written = write(fd, buf, length);
+
+	if(-1 == written) {
+	    if(EINTR == errno)
+		continue;
+
+	    return true;
+	}
+
+	buf += written;
+	length -= written;
+    }
+
+    return false;
+}
+
+bool top_binlog_write(struct binlog *log) {
+    struct binlog_rows *swap;
+    int64_t elapsed = 0;
+
+    top_sample_sorted();
+
+    msgpack_sbuffer_clear(&log->buffer);
+    msgpack_sbuffer_clear(&log->row_buffer);
+
+    if(!log->started) {
+	binlog_pack_header(log);
+	log->started = true;
+    } else {
+	elapsed = binlog_usec(&tsamp->time) - binlog_usec(&log->last);
+    }
+
+    log->last = tsamp->time;
+
+    top_iterate_samples(binlog_insert_row, log);
+
+    if(log->error)
+	return true;
+
+    /* The strings left did not carry over to this sample. */
+    binlog_rows_clear(log->previous, log->ncolumns);
+
+    qsort(log->current->keys, log->current->length,
+	  sizeof(*log->current->keys), binlog_key_compare);
+
+    swap = log->previous;
+    log->previous = log->current;
+    log->current = swap;
+
+    msgpack_pack_array(&log->packer, 2);
+    msgpack_pack_int64(&log->packer, elapsed);
+    msgpack_pack_array(&log->packer, (unsigned int)log->previous->length);
+
+    if(binlog_write_all(log->fd, log->buffer.data, log->buffer.size)
+       || binlog_write_all(log->fd, log->row_buffer.data, log->row_buffer.size))
+	return true;
+
+    return false;
+}
+
+void top_binlog_destroy(struct binlog *log) {
+    binlog_rows_destroy(&log->rows[0], log->ncolumns);
+    binlog_rows_destroy(&log->rows[1], log->ncolumns);
+
+    msgpack_sbuffer_destroy(&log->buffer);
+    msgpack_sbuffer_destroy(&log->row_buffer);
+
+    if(STDOUT_FILENO != log->fd)
+	close(log->fd);
+
+    free(log);
+}
@@ -0,0 +1,42 @@
+/*
+ * Copyright (c) 2008, 2009 Apple Computer, Inc.  All rights reserved.
+ *
+ * @APPLE_LICENSE_HEADER_START@
+ * 
+ * The contents of this file constitute Original Code as defined in and
+ * are subject to the Apple Public Source License Version 1.1 (the
+ * "License").  You may not use this file except in compliance with the
+ * License.  Please obtain a copy of the License at
+ * http://www.apple.com/publicsource and read it before using this file.
+ * 
+ * This Original Code and all software distributed under the License are
+ * distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY KIND, EITHER
+ * EXPRESS OR IMPLIED, AND APPLE HEREBY DISCLAIMS ALL SUCH WARRANTIES,
+ * INCLUDING WITHOUT LIMITATION, ANY WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE OR NON-INFRINGEMENT.  Please see the
+ * License for the specific language governing rights and limitations
+ * under the License.
+ * 
+ * @APPLE_LICENSE_HEADER_END@
+ */
+
+#ifndef BINLOG_H
+#define BINLOG_H
+
+#include <stdbool.h>
+
+/*
+ * The binary logging mode writes the samples in msgpack, see binlog.c for
+ * the format and toplog2csv.c for a reader.
+ */
+struct binlog;
+
+/* The path "-" is stdout.  This returns NULL when an error occurs. */
+struct binlog *top_binlog_create(const char *path, void *tinst);
+
+/* Take a sample and append it.  This returns true when an error occurs. */
+bool top_binlog_write(struct binlog *log);
+
+void top_binlog_destroy(struct binlog *log);
+
+#endif /*BINLOG_H*/
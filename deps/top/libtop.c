@@ -20,6 +20,9 @@
  * @APPLE_LICENSE_HEADER_END@
  */
 
+/* The /proc backend for Linux is in libtop_linux.c. */
+#ifdef __APPLE__
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <limits.h>
@@ -70,6 +73,7 @@
 #include <assert.h>
 
 #include "libtop.h"
+#include "libtop_internal.h"
 #include "rb.h"
 
 /*
@@ -594,21 +598,13 @@ libtop_state_str(uint32_t state)
 {
 	const char *strings[] = {
 		"zombie",
-#define LIBTOP_STATE_ZOMBIE	0
 		"running",
-#define LIBTOP_STATE_RUN	1
 		"stuck",
-#define LIBTOP_STATE_STUCK	2
 		"sleeping",
-#define LIBTOP_STATE_SLEEP	3
 		"idle",
-#define LIBTOP_STATE_IDLE	4
 		"stopped",
-#define LIBTOP_STATE_STOP	5
 		"halted",
-#define LIBTOP_STATE_HALT	6
 		"unknown"
-#define LIBTOP_STATE_UNKNOWN	7
 	};
 
 	assert(LIBTOP_NSTATES == sizeof(strings) / sizeof(char *));
@@ -2313,68 +2309,6 @@ libtop_p_wq_update(libtop_pinfo_t *pinfo) {
 	return 0;
 }
 
-libtop_i64_t
-libtop_i64_init(uint64_t acc, int last_value) {
-	libtop_i64_t r;
-
-	r.accumulator = acc;
-	r.last_value = last_value;
-
-	if(0 == acc) {
-		if(last_value >= 0) {
-			r.accumulator += last_value;
-		} else {
-			/* The initial value has already overflowed. */
-			r.accumulator += INT_MAX;
-			r.accumulator += abs(INT_MIN - last_value) + 1;
-		}
-	}
-
-	return r;
-}
-
-void
-libtop_i64_update(struct libtop_i64 *i, int value) {
-	int delta = 0;
-
-	if(value >= 0) {
-		if(i->last_value >= 0) {
-			delta = value - i->last_value;
-		} else {
-			delta = value + (-i->last_value);
-		}
-	} else {
-		if(i->last_value >= 0) {
-			delta = abs(INT_MIN - value) + 1;
-			delta += INT_MAX - i->last_value;
-		} else {
-			delta = value - i->last_value;
-		}
-	} 
-	
-	i->accumulator += delta;
-
-#ifdef LIBTOP_I64_DEBUG
-	if(delta == 0)
-		assert((value - i->last_value) == 0);
-
-	fprintf(stderr, "%s: delta %u  :: value %d  :: i->last_value %d\n", __func__,
-		delta, value, i->last_value);
-	fprintf(stderr, "%s: accumulator > INT_MAX %s\n", __func__,
-		(i->accumulator > INT_MAX) ? "YES" : "NO");
-	
-	fprintf(stderr, "%s: value %x value unsigned %u > UINT_MAX %s\n", __func__,
-		value, value, (i->accumulator > UINT_MAX) ? "YES" : "NO");
-#endif
-
-	i->last_value = value;
-}
-
-uint64_t 
-libtop_i64_value(libtop_i64_t *i) {
-	return i->accumulator;
-}
-
 /* This tests every branch in libtop_i64_update(). */
 static void
 libtop_i64_test(void) {
@@ -2398,3 +2332,5 @@ libtop_i64_test(void) {
 	}
 	
 }
+
+#endif /* __APPLE__ */
@@ -20,13 +20,81 @@
  * @APPLE_LICENSE_HEADER_END@
  */
 
+#include <stdarg.h>
+#include <sys/time.h>
+
+#ifdef __APPLE__
 #include <mach/boolean.h>
 #include <mach/host_info.h>
 #include <mach/task_info.h>
 #include <mach/vm_types.h>
-#include <stdarg.h>
-#include <sys/time.h>
 #include <sys/sysctl.h>
+#else
+/*
+ * The Mach types the samples are made of, for the /proc backend
+ * (libtop_linux.c).  Only the fields that backend fills are meaningful.
+ */
+#include <stdint.h>
+#include <sys/types.h>
+
+typedef int		boolean_t;
+#ifndef TRUE
+#define TRUE		1
+#define FALSE		0
+#endif
+
+typedef unsigned int	natural_t;
+typedef int		integer_t;
+typedef uintptr_t	vm_size_t;
+typedef integer_t	cpu_type_t;
+
+#define CPU_STATE_USER		0
+#define CPU_STATE_SYSTEM	1
+#define CPU_STATE_IDLE		2
+#define CPU_STATE_NICE		3
+#define CPU_STATE_MAX		4
+
+typedef struct host_cpu_load_info {
+	natural_t	cpu_ticks[CPU_STATE_MAX];
+} host_cpu_load_info_data_t;
+
+typedef struct vm_statistics {
+	natural_t	free_count;
+	natural_t	active_count;
+	natural_t	inactive_count;
+	natural_t	wire_count;
+	natural_t	zero_fill_count;
+	natural_t	reactivations;
+	natural_t	pageins;
+	natural_t	pageouts;
+	natural_t	faults;
+	natural_t	cow_faults;
+	natural_t	lookups;
+	natural_t	hits;
+	natural_t	purgeable_count;
+	natural_t	purges;
+	natural_t	speculative_count;
+} vm_statistics_data_t;
+
+typedef struct task_events_info {
+	integer_t	faults;
+	integer_t	pageins;
+	integer_t	cow_faults;
+	integer_t	messages_sent;
+	integer_t	messages_received;
+	integer_t	syscalls_mach;
+	integer_t	syscalls_unix;
+	integer_t	csw;
+} task_events_info_data_t;
+
+struct xsw_usage {
+	uint64_t	xsu_total;
+	uint64_t	xsu_avail;
+	uint64_t	xsu_used;
+	uint32_t	xsu_pagesize;
+	boolean_t	xsu_encrypted;
+};
+#endif
 
 /*
  * Flags for determining whether to collect memory region information on a
@@ -140,6 +208,14 @@ typedef struct {
 	/* Linkedit size of frameworks. */
 	uint64_t		fw_linkedit;
 
+#define LIBTOP_STATE_ZOMBIE	0
+#define LIBTOP_STATE_RUN	1
+#define LIBTOP_STATE_STUCK	2
+#define LIBTOP_STATE_SLEEP	3
+#define LIBTOP_STATE_IDLE	4
+#define LIBTOP_STATE_STOP	5
+#define LIBTOP_STATE_HALT	6
+#define LIBTOP_STATE_UNKNOWN	7
 #define LIBTOP_STATE_MAX	7
 #define LIBTOP_NSTATES		(LIBTOP_STATE_MAX + 1)
 #define LIBTOP_STATE_MAXLEN	8
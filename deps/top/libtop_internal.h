@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) 2008, 2009 Apple Inc.  All rights reserved.
+ *
+ * @APPLE_LICENSE_HEADER_START@
+ *
+ * The contents of this file constitute Original Code as defined in and
+ * are subject to the Apple Public Source License Version 1.1 (the
+ * "License").  You may not use this file except in compliance with the
+ * License.  Please obtain a copy of the License at
+ * http://www.apple.com/publicsource and read it before using this file.
+ *
+ * This Original Code and all software distributed under the License are
+ * distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY KIND, EITHER
+ * EXPRESS OR IMPLIED, AND APPLE HEREBY DISCLAIMS ALL SUCH WARRANTIES,
+ * INCLUDING WITHOUT LIMITATION, ANY WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE OR NON-INFRINGEMENT.  Please see the
+ * License for the specific language governing rights and limitations
+ * under the License.
+ *
+ * @APPLE_LICENSE_HEADER_END@
+ */
+
+/*
+ * Internal to libtop: code shared by the platform backends, libtop.c and
+ * libtop_linux.c.  Each backend is only compiled on its own platform, so
+ * this file is included by a single translation unit, after libtop.h (which
+ * has no include guard).
+ */
+
+#ifndef LIBTOP_INTERNAL_H
+#define LIBTOP_INTERNAL_H
+
+#include <limits.h>
+#include <stdlib.h>
+
+libtop_i64_t
+libtop_i64_init(uint64_t acc, int last_value) {
+	libtop_i64_t r;
+
+	r.accumulator = acc;
+	r.last_value = last_value;
+
+	if(0 == acc) {
+		if(last_value >= 0) {
+			r.accumulator += last_value;
+		} else {
+			/* The initial value has already overflowed. */
+			r.accumulator += INT_MAX;
+			r.accumulator += abs(INT_MIN - last_value) + 1;
+		}
+	}
+
+	return r;
+}
+
+void
+libtop_i64_update(struct libtop_i64 *i, int value) {
+	int delta = 0;
+
+	if(value >= 0) {
+		if(i->last_value >= 0) {
+			delta = value - i->last_value;
+		} else {
+			delta = value + (-i->last_value);
+		}
+	} else {
+		if(i->last_value >= 0) {
+			delta = abs(INT_MIN - value) + 1;
+			delta += INT_MAX - i->last_value;
+		} else {
+			delta = value - i->last_value;
+		}
+	} 
+	
+	i->accumulator += delta;
+
+#ifdef LIBTOP_I64_DEBUG
+	if(delta == 0)
+		assert((value - i->last_value) == 0);
+
+	fprintf(stderr, "%s: delta %u  :: value %d  :: i->last_value %d\n", __func__,
+		delta, value, i->last_value);
+	fprintf(stderr, "%s: accumulator > INT_MAX %s\n", __func__,
+		(i->accumulator > INT_MAX) ? "YES" : "NO");
+	
+	fprintf(stderr, "%s: value %x value unsigned %u > UINT_MAX %s\n", __func__,
+		value, value, (i->accumulator > UINT_MAX) ? "YES" : "NO");
+#endif
+
+	i->last_value = value;
+}
+
+uint64_t 
+libtop_i64_value(libtop_i64_t *i) {
+	return i->accumulator;
+}
+
+#endif /* LIBTOP_INTERNAL_H */
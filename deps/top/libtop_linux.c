@@ -0,0 +1,1371 @@
+/*
+ * Copyright (c) 2002-2004, 2008, 2009 Apple Inc.  All rights reserved.
+ *
+ * @APPLE_LICENSE_HEADER_START@
+ *
+ * The contents of this file constitute Original Code as defined in and
+ * are subject to the Apple Public Source License Version 1.1 (the
+ * "License").  You may not use this file except in compliance with the
+ * License.  Please obtain a copy of the License at
+ * http://www.apple.com/publicsource and read it before using this file.
+ *
+ * This Original Code and all software distributed under the License are
+ * distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY KIND, EITHER
+ * EXPRESS OR IMPLIED, AND APPLE HEREBY DISCLAIMS ALL SUCH WARRANTIES,
+ * INCLUDING WITHOUT LIMITATION, ANY WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE OR NON-INFRINGEMENT.  Please see the
+ * License for the specific language governing rights and limitations
+ * under the License.
+ *
+ * @APPLE_LICENSE_HEADER_END@
+ */
+
+/*
+ * Linux backend of libtop, sampling through /proc instead of the Mach task
+ * and host calls of libtop.c.
+ *
+ * Sampling many processes is kept cheap in two ways:
+ *
+ *  - The /proc/<pid> files of a process are opened once and read again with
+ *    pread() from offset 0 at every sample (procfs generates the contents
+ *    again for each read), so a sample costs one read per file rather than
+ *    an open, a read and a close.  Half of the RLIMIT_NOFILE soft limit is
+ *    used for these descriptors, past that the files are opened for each
+ *    read.  Raise the limit before libtop_init() to keep the files of every
+ *    process open.
+ *
+ *  - /proc/<pid>/stat is read for every process, but it is only parsed, and
+ *    statm, status and task/ only read, when its contents changed since the
+ *    previous sample.  The stat line of a process that did not run is
+ *    identical, so idle processes cost a single pread().
+ */
+
+#ifdef __linux__
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <inttypes.h>
+#include <pwd.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/resource.h>
+
+#define LIBTOP_DBG
+#ifndef LIBTOP_DBG
+/* Disable assertions. */
+#ifndef NDEBUG
+#define NDEBUG
+#endif
+#endif
+#include <assert.h>
+
+#include "libtop.h"
+#include "libtop_internal.h"
+#include "rb.h"
+
+/*
+ * Process info.
+ */
+typedef struct libtop_pinfo_s libtop_pinfo_t;
+struct libtop_pinfo_s {
+	/* Sample data that are exposed to the library user. */
+	libtop_psamp_t		psamp;
+
+	/* Linkage for pid-ordered tree. */
+	rb_node(libtop_pinfo_t)	pnode;
+
+	/* Linkage for sorted tree. */
+	rb_node(libtop_pinfo_t)	snode;
+
+	/* Manual override for memory region reporting. */
+	libtop_preg_t		preg;
+
+	/* /proc/<pid> files kept open between samples, -1 if closed. */
+	int			stat_fd;
+	int			statm_fd;
+	int			status_fd;
+
+	/* Hash of the previous contents of /proc/<pid>/stat. */
+	uint64_t		stat_hash;
+
+	/*
+	 * Start time in clock ticks since boot, tells a new process that
+	 * reused the pid from the one that was sampled before.
+	 */
+	unsigned long long	starttime;
+};
+
+/* Cached uid->username translation. */
+typedef struct libtop_uinfo_s {
+	uid_t	uid;
+	char	*name;
+} libtop_uinfo_t;
+
+/* Sample data that are exposed to the library user. */
+static libtop_tsamp_t tsamp;
+
+/* Function pointer that points to an abstract printing function. */
+static libtop_print_t *libtop_print;
+static void *libtop_user_data;
+
+/* Temporary storage for sorting function and opaque data pointer. */
+static libtop_sort_t *libtop_sort;
+static void *libtop_sort_data;
+
+static uint32_t interval;
+
+/* Tree of all pinfo's, always ordered by -pid. */
+static rb_tree(libtop_pinfo_t) libtop_ptree;
+/*
+ * Transient tree of all pinfo's, created for each sample according to a
+ * sorting function.
+ */
+static rb_tree(libtop_pinfo_t) libtop_stree;
+
+/* TRUE if the most recent sample is sorted. */
+static boolean_t libtop_sorted;
+
+/* Pointer to the most recently seen pinfo structure in libtop_piterate(). */
+static libtop_pinfo_t *libtop_piter;
+
+/* Cache of uid->username translations. */
+static libtop_uinfo_t *libtop_uinfo;
+static int libtop_nuinfo;
+
+/* Buffer the /proc files are read into, grown as needed. */
+static char *libtop_buf;
+static size_t libtop_bufsize;
+
+/* System wide /proc files, kept open. */
+static int libtop_stat_fd = -1;
+static int libtop_meminfo_fd = -1;
+static int libtop_vmstat_fd = -1;
+static int libtop_netdev_fd = -1;
+static int libtop_diskstats_fd = -1;
+static DIR *libtop_proc_dir;
+
+/* Descriptors kept open for the processes, and how many may be. */
+static int libtop_nfds;
+static int libtop_maxfds;
+
+/* Clock ticks per second and boot time, to convert the times of stat. */
+static long libtop_hz;
+static time_t libtop_btime;
+
+#define LIBTOP_BUFSIZE		4096
+#define LIBTOP_SECTOR_SIZE	512
+
+enum libtop_status {
+	LIBTOP_NO_ERR = 0,
+	LIBTOP_ERR_INVALID = 1, /* An invalid process. */
+	LIBTOP_ERR_ALLOC  /* An allocation error. */
+};
+
+typedef enum libtop_status libtop_status_t;
+
+/* Function prototypes. */
+static boolean_t libtop_p_print(void *user_data, const char *format, ...);
+static ssize_t libtop_p_read(int *fd, const char *path, boolean_t keep);
+static void libtop_p_close(int *fd);
+static const char *libtop_p_field(const char *buf, const char *name);
+static int libtop_p_state_order(char state);
+static int libtop_p_load_get(host_cpu_load_info_data_t *r_load);
+static int libtop_p_loadavg_update(void);
+static int libtop_p_vm_sample(void);
+static void libtop_p_networks_sample(void);
+static int libtop_p_disks_sample(void);
+static int libtop_p_proc_table_read(boolean_t reg);
+static libtop_status_t libtop_p_proc_update(pid_t pid, boolean_t reg);
+static boolean_t libtop_p_stat_parse(libtop_pinfo_t *pinfo, size_t len);
+static void libtop_p_statm_update(libtop_pinfo_t *pinfo);
+static void libtop_p_status_update(libtop_pinfo_t *pinfo);
+static void libtop_p_threads_update(libtop_pinfo_t *pinfo);
+static void libtop_p_events_update(libtop_pinfo_t *pinfo);
+static void libtop_p_pinsert(libtop_pinfo_t *pinfo);
+static void libtop_p_premove(libtop_pinfo_t *pinfo);
+static void libtop_p_destroy_pinfo(libtop_pinfo_t *pinfo);
+static libtop_pinfo_t* libtop_p_psearch(pid_t pid);
+static int libtop_p_pinfo_pid_comp(libtop_pinfo_t *a, libtop_pinfo_t *b);
+static int libtop_p_pinfo_comp(libtop_pinfo_t *a, libtop_pinfo_t *b);
+
+int
+libtop_init(libtop_print_t *print, void *user_data)
+{
+	struct rlimit rl;
+	const char *field;
+
+	if (print != NULL) {
+		libtop_print = print;
+		libtop_user_data = user_data;
+	} else {
+		/* Use a noop printing function. */
+		libtop_print = libtop_p_print;
+		libtop_user_data = NULL;
+	}
+
+	tsamp.seq = 0;
+	interval = 1;
+	tsamp.pagesize = sysconf(_SC_PAGESIZE);
+	tsamp.memsize = (uint64_t)sysconf(_SC_PHYS_PAGES) * tsamp.pagesize;
+	libtop_hz = sysconf(_SC_CLK_TCK);
+
+	libtop_bufsize = LIBTOP_BUFSIZE;
+	libtop_buf = (char *)malloc(libtop_bufsize);
+	if (libtop_buf == NULL) return -1;
+
+	/* Leave half of the descriptors to the application. */
+	libtop_nfds = 0;
+	libtop_maxfds = 0;
+	if (getrlimit(RLIMIT_NOFILE, &rl) == 0) {
+		libtop_maxfds = (rl.rlim_cur == RLIM_INFINITY) ? INT_MAX / 2
+		    : (int)(rl.rlim_cur / 2);
+	}
+
+	libtop_proc_dir = opendir("/proc");
+	if (libtop_proc_dir == NULL) {
+		libtop_print(libtop_user_data, "%s(): Error in opendir(): %s",
+		    __FUNCTION__, strerror(errno));
+		return -1;
+	}
+
+	/* Get the boot time, the process start times are relative to it. */
+	if (libtop_p_read(&libtop_stat_fd, "/proc/stat", TRUE) < 0) {
+		libtop_print(libtop_user_data, "%s(): Error reading /proc/stat: %s",
+		    __FUNCTION__, strerror(errno));
+		return -1;
+	}
+	field = libtop_p_field(libtop_buf, "btime");
+	libtop_btime = (field != NULL) ? (time_t)strtoll(field, NULL, 10) : 0;
+
+	/* Initialize the pinfo tree. */
+	rb_tree_new(&libtop_ptree, pnode);
+
+	libtop_uinfo = NULL;
+	libtop_nuinfo = 0;
+
+	/* Initialize the load statistics. */
+	if (libtop_p_load_get(&tsamp.b_cpu)) return -1;
+
+	tsamp.p_cpu = tsamp.b_cpu;
+	tsamp.cpu = tsamp.b_cpu;
+
+	/* Initialize the time. */
+	gettimeofday(&tsamp.b_time, NULL);
+	tsamp.p_time = tsamp.b_time;
+	tsamp.time = tsamp.b_time;
+
+	return 0;
+}
+
+void
+libtop_fini(void)
+{
+	libtop_pinfo_t *pinfo, *ppinfo;
+	int i;
+
+	/* Clean up the pinfo structures, closing their files. */
+	rb_first(&libtop_ptree, pnode, pinfo);
+	for (;
+	     pinfo != rb_tree_nil(&libtop_ptree);
+	     pinfo = ppinfo) {
+		rb_next(&libtop_ptree, pinfo, libtop_pinfo_t, pnode, ppinfo);
+
+		/* This removes the pinfo from the tree, and frees pinfo and its data. */
+		libtop_p_destroy_pinfo(pinfo);
+	}
+
+	libtop_p_close(&libtop_stat_fd);
+	libtop_p_close(&libtop_meminfo_fd);
+	libtop_p_close(&libtop_vmstat_fd);
+	libtop_p_close(&libtop_netdev_fd);
+	libtop_p_close(&libtop_diskstats_fd);
+	if (libtop_proc_dir != NULL) {
+		closedir(libtop_proc_dir);
+		libtop_proc_dir = NULL;
+	}
+
+	free(libtop_buf);
+	libtop_buf = NULL;
+
+	/* Clean up the uid->username translation cache. */
+	for (i = 0; i < libtop_nuinfo; i++) {
+		free(libtop_uinfo[i].name);
+	}
+	free(libtop_uinfo);
+	libtop_uinfo = NULL;
+	libtop_nuinfo = 0;
+}
+
+/*
+ * Set the interval between framework updates.
+ */
+int
+libtop_set_interval(uint32_t ival)
+{
+	if (ival > LIBTOP_MAX_INTERVAL) {
+		return -1;
+	}
+	interval = ival;
+	return 0;
+}
+
+/*
+ * Take a sample.  There are no frameworks on Linux, fw is ignored.
+ */
+int
+libtop_sample(boolean_t reg, boolean_t fw)
+{
+	int res = 0;
+
+	(void)fw;
+
+	/* Increment the sample sequence number. */
+	tsamp.seq++;
+
+	/*
+	 * Make a note that the results haven't been sorted (reset by
+	 * libtop_psort()).
+	 */
+	libtop_sorted = FALSE;
+	libtop_piter = NULL;
+
+	/* Clear state breakdown. */
+	memset(tsamp.state_breakdown, 0, sizeof(tsamp.state_breakdown));
+
+	/* Get time. */
+	if (tsamp.seq != 1) {
+		tsamp.p_time = tsamp.time;
+		res = gettimeofday(&tsamp.time, NULL);
+	}
+
+	if (res == 0) res = libtop_p_proc_table_read(reg);
+	if (res == 0) res = libtop_p_loadavg_update();
+
+	/* Get CPU usage counters. */
+	tsamp.p_cpu = tsamp.cpu;
+	if (res == 0) libtop_p_load_get(&tsamp.cpu);
+
+	if (res == 0) libtop_p_vm_sample();
+	if (res == 0) libtop_p_networks_sample();
+	if (res == 0) libtop_p_disks_sample();
+
+	return res;
+}
+
+/* Return a pointer to the structure that contains libtop-wide data. */
+const libtop_tsamp_t *
+libtop_tsamp(void)
+{
+	return &tsamp;
+}
+
+/*
+ * Given a tree of pinfo structures, create another tree that is sorted
+ * according to sort().
+ */
+void
+libtop_psort(libtop_sort_t *sort, void *data)
+{
+	libtop_pinfo_t	*pinfo, *ppinfo;
+
+	assert(tsamp.seq != 0);
+
+	/* Reset the iteration pointer. */
+	libtop_piter = NULL;
+
+	/* Initialize the sorted tree. */
+	rb_tree_new(&libtop_stree, snode);
+
+	/* Note that the results are sorted. */
+	libtop_sorted = TRUE;
+
+	/*
+	 * Set the sorting function and opaque data in preparation for building
+	 * the sorted tree.
+	 */
+	libtop_sort = sort;
+	libtop_sort_data = data;
+
+	/*
+	 * Iterate through ptree and insert the pinfo's into a sorted tree.
+	 * At the same time, prune pinfo's that were associated with processes
+	 * that were not found during the most recent sample.
+	 */
+	tsamp.nprocs = 0;
+	rb_first(&libtop_ptree, pnode, pinfo);
+	for (;
+	     pinfo != rb_tree_nil(&libtop_ptree);
+	     pinfo = ppinfo) {
+		/*
+		 * Get the next pinfo before potentially removing this one from
+		 * the tree.
+		 */
+		rb_next(&libtop_ptree, pinfo, libtop_pinfo_t, pnode, ppinfo);
+
+		if (pinfo->psamp.seq == tsamp.seq) {
+			/* Insert the pinfo into the sorted tree. */
+			rb_node_new(&libtop_stree, pinfo, snode);
+			rb_insert(&libtop_stree, pinfo, libtop_p_pinfo_comp,
+			    libtop_pinfo_t, snode);
+
+			tsamp.nprocs++;
+		} else {
+			/* The associated process has gone away. */
+			libtop_p_destroy_pinfo(pinfo);
+		}
+	}
+}
+
+/*
+ * Iteratively return a pointer to each process that was in the most recent
+ * sample.  The order depends on if/how libtop_psort() was called.
+ */
+const libtop_psamp_t *
+libtop_piterate(void)
+{
+	assert(tsamp.seq != 0);
+
+	if (libtop_sorted) {
+		/* Use the order set by libtop_psort(). */
+		if (libtop_piter == NULL) {
+			rb_first(&libtop_stree, snode, libtop_piter);
+		} else {
+			rb_next(&libtop_stree, libtop_piter, libtop_pinfo_t,
+			    snode, libtop_piter);
+		}
+		if (libtop_piter == rb_tree_nil(&libtop_stree)) {
+			libtop_piter = NULL;
+		}
+	} else {
+		boolean_t	dead;
+
+		/*
+		 * Return results in ascending pid order.  Since dead processes
+		 * weren't cleaned out by libtop_psamp(), take care to do so
+		 * here on the fly.
+		 */
+		if (libtop_piter == NULL) {
+			rb_first(&libtop_ptree, pnode, libtop_piter);
+		} else {
+			rb_next(&libtop_ptree, libtop_piter, libtop_pinfo_t,
+			    pnode, libtop_piter);
+		}
+
+		do {
+			dead = FALSE;
+
+			if (libtop_piter == rb_tree_nil(&libtop_ptree)) {
+				/* No more tree nodes. */
+				libtop_piter = NULL;
+				break;
+			}
+			if (libtop_piter->psamp.seq != tsamp.seq) {
+				libtop_pinfo_t	*pinfo;
+
+				/*
+				 * Dead process.  Get the next pinfo tree node
+				 * before removing this one.
+				 */
+				pinfo = libtop_piter;
+				rb_next(&libtop_ptree, libtop_piter,
+				    libtop_pinfo_t, pnode, libtop_piter);
+
+				libtop_p_destroy_pinfo(pinfo);
+
+				dead = TRUE;
+			}
+		} while (dead);
+	}
+
+	return (libtop_piter != NULL) ? &libtop_piter->psamp : NULL;
+}
+
+/*
+ * Set whether to collect memory region information for the process with pid
+ * pid.
+ */
+int
+libtop_preg(pid_t pid, libtop_preg_t preg)
+{
+	libtop_pinfo_t	*pinfo;
+
+	pinfo = libtop_p_psearch(pid);
+	if (pinfo == NULL) return -1;
+	pinfo->preg = preg;
+
+	return 0;
+}
+
+/* Return a pointer to the username string associated with uid. */
+const char *
+libtop_username(uid_t uid)
+{
+	libtop_uinfo_t *uinfo;
+	struct passwd *pwd;
+	int i;
+
+	for (i = 0; i < libtop_nuinfo; i++) {
+		if (libtop_uinfo[i].uid == uid) {
+			return libtop_uinfo[i].name;
+		}
+	}
+
+	pwd = getpwuid(uid);
+	if (pwd == NULL)
+		return NULL;
+
+	uinfo = (libtop_uinfo_t *)realloc(libtop_uinfo,
+	    (libtop_nuinfo + 1) * sizeof(libtop_uinfo_t));
+	if (uinfo == NULL)
+		return NULL;
+	libtop_uinfo = uinfo;
+
+	uinfo = &libtop_uinfo[libtop_nuinfo];
+	uinfo->uid = uid;
+	uinfo->name = strdup(pwd->pw_name);
+	if (uinfo->name == NULL)
+		return NULL;
+	libtop_nuinfo++;
+
+	return uinfo->name;
+}
+
+/* Return a pointer to a string representation of a process state. */
+const char *
+libtop_state_str(uint32_t state)
+{
+	const char *strings[] = {
+		"zombie",
+		"running",
+		"stuck",
+		"sleeping",
+		"idle",
+		"stopped",
+		"halted",
+		"unknown"
+	};
+
+	assert(LIBTOP_NSTATES == sizeof(strings) / sizeof(char *));
+	assert(state <= LIBTOP_STATE_MAX);
+	assert(LIBTOP_STATE_MAXLEN >= 8); /* "sleeping" */
+
+	return strings[state];
+}
+
+/*
+ * Noop printing function, used when the user doesn't supply a printing
+ * function.
+ */
+static boolean_t
+libtop_p_print(void *user_data, const char *format, ...)
+{
+	/* Do nothing. */
+	(void)user_data;
+	(void)format;
+	return 0;
+}
+
+/*
+ * Read a /proc file into libtop_buf, '\0'-terminated.  If *fd is open it is
+ * read again from offset 0, otherwise the file is opened, and kept open in
+ * *fd if keep is TRUE and the descriptor budget allows it.
+ *
+ * procfs generates the whole file for a read that starts at offset 0, so a
+ * read shorter than the buffer got all of it.
+ *
+ * Returns the length read, -1 if the file could not be read (for a process,
+ * that it is gone).
+ */
+static ssize_t
+libtop_p_read(int *fd, const char *path, boolean_t keep)
+{
+	ssize_t len, res;
+
+	if (*fd < 0) {
+		*fd = open(path, O_RDONLY | O_CLOEXEC);
+		if (*fd < 0) return -1;
+
+		if (keep && libtop_nfds < libtop_maxfds) {
+			libtop_nfds++;
+		} else {
+			keep = FALSE;
+		}
+	} else {
+		keep = TRUE;
+	}
+
+	len = 0;
+	for (;;) {
+		res = pread(*fd, libtop_buf + len, libtop_bufsize - len - 1, len);
+		if (res < 0) {
+			if (errno == EINTR) continue;
+			len = -1;
+			break;
+		}
+
+		len += res;
+		if ((size_t)len < libtop_bufsize - 1) break;
+
+		/* The buffer was filled, there may be more. */
+		char *buf = (char *)realloc(libtop_buf, libtop_bufsize * 2);
+		if (buf == NULL) {
+			len = -1;
+			break;
+		}
+		libtop_buf = buf;
+		libtop_bufsize *= 2;
+	}
+
+	if (len >= 0) {
+		libtop_buf[len] = '\0';
+	}
+
+	if (!keep) {
+		close(*fd);
+		*fd = -1;
+	} else if (len < 0) {
+		libtop_p_close(fd);
+	}
+
+	return len;
+}
+
+/* Close a descriptor kept open by libtop_p_read(). */
+static void
+libtop_p_close(int *fd)
+{
+	if (*fd >= 0) {
+		close(*fd);
+		*fd = -1;
+		libtop_nfds--;
+	}
+}
+
+/*
+ * Find a "name: value" or "name value" line in buf and return a pointer to
+ * the value, NULL if there is none.
+ */
+static const char *
+libtop_p_field(const char *buf, const char *name)
+{
+	size_t len = strlen(name);
+	const char *p = buf;
+
+	while (p != NULL && *p != '\0') {
+		if (strncmp(p, name, len) == 0
+		    && (p[len] == ':' || p[len] == ' ' || p[len] == '\t')) {
+			p += len;
+			while (*p == ':' || *p == ' ' || *p == '\t') p++;
+			return p;
+		}
+		p = strchr(p, '\n');
+		if (p != NULL) p++;
+	}
+
+	return NULL;
+}
+
+static uint64_t
+libtop_p_field_u64(const char *buf, const char *name)
+{
+	const char *p = libtop_p_field(buf, name);
+	return (p != NULL) ? strtoull(p, NULL, 10) : 0;
+}
+
+/* Translate the state letter of stat to a state in the state breakdown array. */
+static int
+libtop_p_state_order(char state)
+{
+	switch (state) {
+		case 'R':
+			return LIBTOP_STATE_RUN;
+		case 'D':
+		case 'W':
+			return LIBTOP_STATE_STUCK;
+		case 'S':
+			return LIBTOP_STATE_SLEEP;
+		case 'I':
+			return LIBTOP_STATE_IDLE;
+		case 'T':
+		case 't':
+			return LIBTOP_STATE_STOP;
+		case 'Z':
+			return LIBTOP_STATE_ZOMBIE;
+		case 'X':
+		case 'x':
+			return LIBTOP_STATE_HALT;
+		default:
+			return LIBTOP_STATE_UNKNOWN;
+	}
+}
+
+/* Get CPU load from the first line of /proc/stat. */
+static int
+libtop_p_load_get(host_cpu_load_info_data_t *r_load)
+{
+	unsigned long long user, nice, system, idle, iowait, irq, softirq;
+
+	if (libtop_p_read(&libtop_stat_fd, "/proc/stat", TRUE) < 0) {
+		libtop_print(libtop_user_data, "Error reading /proc/stat: %s",
+		    strerror(errno));
+		return -1;
+	}
+
+	iowait = irq = softirq = 0;
+	if (sscanf(libtop_buf, "cpu %llu %llu %llu %llu %llu %llu %llu",
+	    &user, &nice, &system, &idle, &iowait, &irq, &softirq) < 4) {
+		libtop_print(libtop_user_data, "Unexpected /proc/stat format");
+		return -1;
+	}
+
+	/* The counters wrap like the Mach ones, only differences are used. */
+	r_load->cpu_ticks[CPU_STATE_USER] = (natural_t)user;
+	r_load->cpu_ticks[CPU_STATE_NICE] = (natural_t)nice;
+	r_load->cpu_ticks[CPU_STATE_SYSTEM] = (natural_t)(system + irq + softirq);
+	r_load->cpu_ticks[CPU_STATE_IDLE] = (natural_t)(idle + iowait);
+
+	return 0;
+}
+
+/* Update load averages. */
+static int
+libtop_p_loadavg_update(void)
+{
+	double avg[3];
+
+	if (getloadavg(avg, sizeof(avg) / sizeof(avg[0])) < 0) {
+		libtop_print(libtop_user_data,  "Error in getloadavg(): %s",
+			strerror(errno));
+		return -1;
+	}
+
+	tsamp.loadavg[0] = avg[0];
+	tsamp.loadavg[1] = avg[1];
+	tsamp.loadavg[2] = avg[2];
+
+	return 0;
+}
+
+/* Sample general VM statistics from /proc/meminfo and /proc/vmstat. */
+static int
+libtop_p_vm_sample(void)
+{
+	uint64_t pagesize = tsamp.pagesize;
+	uint64_t reg = 0;
+	uint64_t rprvt = 0;
+	uint64_t vsize = 0;
+
+	tsamp.p_vm_stat = tsamp.vm_stat;
+
+	/* meminfo is in kB. */
+	if (libtop_p_read(&libtop_meminfo_fd, "/proc/meminfo", TRUE) >= 0) {
+		uint64_t swap_total, swap_free;
+
+		tsamp.vm_stat.free_count = libtop_p_field_u64(libtop_buf, "MemFree") * 1024 / pagesize;
+		tsamp.vm_stat.active_count = libtop_p_field_u64(libtop_buf, "Active") * 1024 / pagesize;
+		tsamp.vm_stat.inactive_count = libtop_p_field_u64(libtop_buf, "Inactive") * 1024 / pagesize;
+		tsamp.vm_stat.wire_count = libtop_p_field_u64(libtop_buf, "Unevictable") * 1024 / pagesize;
+		tsamp.rshrd = libtop_p_field_u64(libtop_buf, "Mapped") * 1024;
+
+		swap_total = libtop_p_field_u64(libtop_buf, "SwapTotal") * 1024;
+		swap_free = libtop_p_field_u64(libtop_buf, "SwapFree") * 1024;
+		tsamp.xsu.xsu_total = swap_total;
+		tsamp.xsu.xsu_avail = swap_free;
+		tsamp.xsu.xsu_used = swap_total - swap_free;
+		tsamp.xsu.xsu_pagesize = pagesize;
+		tsamp.xsu.xsu_encrypted = FALSE;
+		tsamp.xsu_is_valid = TRUE;
+	} else {
+		tsamp.xsu_is_valid = FALSE;
+	}
+
+	if (libtop_p_read(&libtop_vmstat_fd, "/proc/vmstat", TRUE) >= 0) {
+		tsamp.vm_stat.faults = libtop_p_field_u64(libtop_buf, "pgfault");
+		tsamp.vm_stat.pageins = libtop_p_field_u64(libtop_buf, "pswpin");
+		tsamp.vm_stat.pageouts = libtop_p_field_u64(libtop_buf, "pswpout");
+	}
+
+	/* No purgeable memory on Linux. */
+	tsamp.purgeable_is_valid = FALSE;
+	tsamp.vm_stat.purgeable_count = 0;
+	tsamp.vm_stat.purges = 0;
+
+	if (tsamp.seq == 1) {
+		tsamp.p_vm_stat = tsamp.vm_stat;
+		tsamp.b_vm_stat = tsamp.vm_stat;
+	}
+
+	/* Iterate through all processes, collecting their individual vm stats */
+	libtop_piter = NULL;
+	while (libtop_piterate()) {
+		reg += libtop_piter->psamp.reg;
+		rprvt += libtop_piter->psamp.rprvt;
+		vsize += libtop_piter->psamp.vsize;
+	}
+
+	tsamp.reg = reg;
+	tsamp.rprvt = rprvt;
+	tsamp.vsize = vsize;
+
+	return 0;
+}
+
+/*
+ * Sample network usage from /proc/net/dev.  Like the Mach backend, every
+ * interface is counted, and an interface that goes away takes its counts
+ * with it.
+ */
+static void
+libtop_p_networks_sample(void)
+{
+	const char *p;
+
+	tsamp.p_net_ipackets = tsamp.net_ipackets;
+	tsamp.p_net_opackets = tsamp.net_opackets;
+	tsamp.p_net_ibytes = tsamp.net_ibytes;
+	tsamp.p_net_obytes = tsamp.net_obytes;
+
+	tsamp.net_ipackets = 0;
+	tsamp.net_opackets = 0;
+	tsamp.net_ibytes = 0;
+	tsamp.net_obytes = 0;
+
+	if (libtop_p_read(&libtop_netdev_fd, "/proc/net/dev", TRUE) < 0) return;
+
+	/* Two header lines, then "name: rx bytes packets ... tx bytes packets ...". */
+	for (p = strchr(libtop_buf, ':'); p != NULL; p = strchr(p, ':')) {
+		unsigned long long v[10];
+
+		if (sscanf(p + 1, "%llu %llu %llu %llu %llu %llu %llu %llu %llu %llu",
+		    &v[0], &v[1], &v[2], &v[3], &v[4], &v[5], &v[6], &v[7],
+		    &v[8], &v[9]) == 10) {
+			tsamp.net_ibytes += v[0];
+			tsamp.net_ipackets += v[1];
+			tsamp.net_obytes += v[8];
+			tsamp.net_opackets += v[9];
+		}
+
+		p = strchr(p, '\n');
+		if (p == NULL) break;
+	}
+
+	if (tsamp.seq == 1) {
+		tsamp.b_net_ipackets = tsamp.net_ipackets;
+		tsamp.p_net_ipackets = tsamp.net_ipackets;
+
+		tsamp.b_net_opackets = tsamp.net_opackets;
+		tsamp.p_net_opackets = tsamp.net_opackets;
+
+		tsamp.b_net_ibytes = tsamp.net_ibytes;
+		tsamp.p_net_ibytes = tsamp.net_ibytes;
+
+		tsamp.b_net_obytes = tsamp.net_obytes;
+		tsamp.p_net_obytes = tsamp.net_obytes;
+	}
+}
+
+/*
+ * Sample disk usage from /proc/diskstats.  Only the whole physical disks
+ * are counted (those with a device in /sys/block), not their partitions or
+ * the loop and device-mapper devices stacked on them.
+ */
+static int
+libtop_p_disks_sample(void)
+{
+	const char *p;
+
+	tsamp.p_disk_rops = tsamp.disk_rops;
+	tsamp.p_disk_wops = tsamp.disk_wops;
+	tsamp.p_disk_rbytes = tsamp.disk_rbytes;
+	tsamp.p_disk_wbytes = tsamp.disk_wbytes;
+
+	tsamp.disk_rops = 0;
+	tsamp.disk_wops = 0;
+	tsamp.disk_rbytes = 0;
+	tsamp.disk_wbytes = 0;
+
+	if (libtop_p_read(&libtop_diskstats_fd, "/proc/diskstats", TRUE) < 0) {
+		return -1;
+	}
+
+	for (p = libtop_buf; p != NULL && *p != '\0'; ) {
+		unsigned int major, minor;
+		char name[64], path[128];
+		unsigned long long rops, rmerged, rsectors, rticks;
+		unsigned long long wops, wmerged, wsectors;
+
+		if (sscanf(p, "%u %u %63s %llu %llu %llu %llu %llu %llu %llu",
+		    &major, &minor, name, &rops, &rmerged, &rsectors, &rticks,
+		    &wops, &wmerged, &wsectors) == 10) {
+			snprintf(path, sizeof(path), "/sys/block/%s/device", name);
+			if (access(path, F_OK) == 0) {
+				tsamp.disk_rops += rops;
+				tsamp.disk_rbytes += rsectors * LIBTOP_SECTOR_SIZE;
+				tsamp.disk_wops += wops;
+				tsamp.disk_wbytes += wsectors * LIBTOP_SECTOR_SIZE;
+			}
+		}
+
+		p = strchr(p, '\n');
+		if (p != NULL) p++;
+	}
+
+	if (tsamp.seq == 1) {
+		tsamp.b_disk_rops = tsamp.disk_rops;
+		tsamp.p_disk_rops = tsamp.disk_rops;
+
+		tsamp.b_disk_wops = tsamp.disk_wops;
+		tsamp.p_disk_wops = tsamp.disk_wops;
+
+		tsamp.b_disk_rbytes = tsamp.disk_rbytes;
+		tsamp.p_disk_rbytes = tsamp.disk_rbytes;
+
+		tsamp.b_disk_wbytes = tsamp.disk_wbytes;
+		tsamp.p_disk_wbytes = tsamp.disk_wbytes;
+	}
+
+	return 0;
+}
+
+/* Iterate through all processes and update their statistics. */
+static int
+libtop_p_proc_table_read(boolean_t reg)
+{
+	struct dirent *entry;
+	bool fatal_error_occurred = false;
+
+	tsamp.reg = 0;
+	tsamp.rprvt = 0;
+	tsamp.vsize = 0;
+	tsamp.threads = 0;
+
+	rewinddir(libtop_proc_dir);
+	while ((entry = readdir(libtop_proc_dir)) != NULL) {
+		char *end;
+		long pid;
+
+		if (entry->d_name[0] < '0' || entry->d_name[0] > '9') continue;
+		pid = strtol(entry->d_name, &end, 10);
+		if (*end != '\0') continue;
+
+		switch (libtop_p_proc_update((pid_t)pid, reg)) {
+			case LIBTOP_ERR_INVALID:
+				/*
+				 * The process went away.
+				 * The called function takes care of destroying the pinfo in the tree, if needed.
+				 */
+				break;
+
+			case LIBTOP_ERR_ALLOC:
+				fatal_error_occurred = true;
+				break;
+
+			default:
+				break;
+		}
+	}
+
+	return fatal_error_occurred ? -1 : 0;
+}
+
+static uint64_t
+libtop_p_hash(const char *buf, size_t len)
+{
+	/* FNV-1a */
+	uint64_t hash = 14695981039346656037ULL;
+	size_t i;
+
+	for (i = 0; i < len; i++) {
+		hash ^= (unsigned char)buf[i];
+		hash *= 1099511628211ULL;
+	}
+
+	return hash;
+}
+
+static libtop_status_t
+libtop_p_proc_update(pid_t pid, boolean_t reg)
+{
+	libtop_pinfo_t	*pinfo;
+	char		path[64];
+	ssize_t		len;
+	uint64_t	hash;
+
+	/*
+	 * Search for the process.  If we haven't seen it before, allocate and
+	 * insert a new pinfo structure.
+	 */
+	pinfo = libtop_p_psearch(pid);
+	if (pinfo == NULL) {
+		pinfo = (libtop_pinfo_t *)calloc(1, sizeof(libtop_pinfo_t));
+		if (pinfo == NULL) {
+			return LIBTOP_ERR_ALLOC;
+		}
+		pinfo->psamp.pid = pid;
+		pinfo->stat_fd = -1;
+		pinfo->statm_fd = -1;
+		pinfo->status_fd = -1;
+		libtop_p_pinsert(pinfo);
+	}
+
+	snprintf(path, sizeof(path), "/proc/%d/stat", (int)pid);
+	len = libtop_p_read(&pinfo->stat_fd, path, TRUE);
+	if (len < 0) {
+		/*
+		 * The file kept open belonged to a process that exited, the
+		 * pid listed now may be a new process.
+		 */
+		libtop_p_close(&pinfo->statm_fd);
+		libtop_p_close(&pinfo->status_fd);
+		len = libtop_p_read(&pinfo->stat_fd, path, TRUE);
+	}
+	if (len < 0) {
+		libtop_p_destroy_pinfo(pinfo);
+		return LIBTOP_ERR_INVALID;
+	}
+
+	pinfo->psamp.p_seq = pinfo->psamp.seq;
+	pinfo->psamp.seq = tsamp.seq;
+
+	/* Make copies of previous sample values. */
+	pinfo->psamp.p_rsize = pinfo->psamp.rsize;
+	pinfo->psamp.p_vsize = pinfo->psamp.vsize;
+	pinfo->psamp.p_rprvt = pinfo->psamp.rprvt;
+	pinfo->psamp.p_vprvt = pinfo->psamp.vprvt;
+	pinfo->psamp.p_rshrd = pinfo->psamp.rshrd;
+	pinfo->psamp.p_empty = pinfo->psamp.empty;
+	pinfo->psamp.p_reg = pinfo->psamp.reg;
+	pinfo->psamp.p_total_time = pinfo->psamp.total_time;
+	pinfo->psamp.p_prt = pinfo->psamp.prt;
+	pinfo->psamp.p_events = pinfo->psamp.events;
+	if (tsamp.seq > 1) {
+		pinfo->psamp.p_th = pinfo->psamp.th;
+		pinfo->psamp.p_running_th = pinfo->psamp.running_th;
+	}
+
+	pinfo->psamp.faults.previous = pinfo->psamp.faults.now;
+	pinfo->psamp.pageins.previous = pinfo->psamp.pageins.now;
+	pinfo->psamp.cow_faults.previous = pinfo->psamp.cow_faults.now;
+	pinfo->psamp.messages_sent.previous = pinfo->psamp.messages_sent.now;
+	pinfo->psamp.messages_recv.previous = pinfo->psamp.messages_recv.now;
+	pinfo->psamp.syscalls_mach.previous = pinfo->psamp.syscalls_mach.now;
+	pinfo->psamp.syscalls_bsd.previous = pinfo->psamp.syscalls_bsd.now;
+	pinfo->psamp.csw.previous = pinfo->psamp.csw.now;
+
+	/* Identical contents: the process did not run, nothing else changed. */
+	hash = libtop_p_hash(libtop_buf, len);
+	if (hash != pinfo->stat_hash || pinfo->psamp.p_seq == 0) {
+		pinfo->stat_hash = hash;
+
+		switch (libtop_p_stat_parse(pinfo, len)) {
+			case TRUE:
+				break;
+			default:
+				libtop_p_destroy_pinfo(pinfo);
+				return LIBTOP_ERR_INVALID;
+		}
+
+		/* Same test as the Mach backend for the costly VM region walk. */
+		if ((reg && pinfo->preg != LIBTOP_PREG_off)
+		    || pinfo->preg == LIBTOP_PREG_on
+		    || pinfo->psamp.p_seq == 0) {
+			libtop_p_statm_update(pinfo);
+			libtop_p_threads_update(pinfo);
+		} else {
+			pinfo->psamp.running_th = (pinfo->psamp.state == LIBTOP_STATE_RUN) ? 1 : 0;
+		}
+
+		libtop_p_status_update(pinfo);
+		libtop_p_events_update(pinfo);
+	}
+
+	if (pinfo->psamp.p_seq == 0) {
+		/* Set initial values. */
+		pinfo->psamp.b_total_time = pinfo->psamp.total_time;
+		pinfo->psamp.p_total_time = pinfo->psamp.total_time;
+		pinfo->psamp.p_th = 0;
+		pinfo->psamp.p_running_th = 0;
+	}
+
+	tsamp.threads += pinfo->psamp.th;
+	tsamp.state_breakdown[pinfo->psamp.state]++;
+
+	return LIBTOP_NO_ERR;
+}
+
+/*
+ * Parse /proc/<pid>/stat, in libtop_buf.  A pid reused by a new process is
+ * detected by its start time, the pinfo is then reset as if the process was
+ * seen for the first time.
+ */
+static boolean_t
+libtop_p_stat_parse(libtop_pinfo_t *pinfo, size_t len)
+{
+	char *comm, *p;
+	char state;
+	int i;
+	unsigned long long v[22];
+	struct timeval tv;
+
+	/* "pid (comm) state ...", comm can hold spaces and parentheses. */
+	comm = strchr(libtop_buf, '(');
+	p = strrchr(libtop_buf, ')');
+	if (comm == NULL || p == NULL || p < comm || p + 2 >= libtop_buf + len) {
+		return FALSE;
+	}
+	*p = '\0';
+	comm++;
+	p += 2;
+
+	state = *p++;
+	for (i = 0; i < 22; i++) {
+		v[i] = strtoull(p, &p, 10);
+	}
+	/*
+	 * v[0] ppid, v[1] pgrp, v[6] minflt, v[8] majflt, v[10] utime,
+	 * v[11] stime, v[16] num_threads, v[18] starttime, v[19] vsize,
+	 * v[20] rss.
+	 */
+
+	if (pinfo->psamp.seq != 0 && pinfo->psamp.p_seq != 0
+	    && v[18] != pinfo->starttime) {
+		pid_t pid = pinfo->psamp.pid;
+		uint32_t seq = pinfo->psamp.seq;
+
+		free(pinfo->psamp.command);
+		memset(&pinfo->psamp, 0, sizeof(pinfo->psamp));
+		pinfo->psamp.pid = pid;
+		pinfo->psamp.seq = seq;
+		pinfo->preg = LIBTOP_PREG_default;
+		libtop_p_close(&pinfo->statm_fd);
+		libtop_p_close(&pinfo->status_fd);
+	}
+	pinfo->starttime = v[18];
+
+	if (pinfo->psamp.command == NULL || strcmp(pinfo->psamp.command, comm) != 0) {
+		free(pinfo->psamp.command);
+		pinfo->psamp.command = strdup(comm);
+	}
+
+	pinfo->psamp.ppid = (pid_t)v[0];
+	pinfo->psamp.pgrp = (gid_t)v[1];
+	pinfo->psamp.state = libtop_p_state_order(state);
+	pinfo->psamp.th = (uint32_t)v[16];
+	pinfo->psamp.vsize = v[19];
+	pinfo->psamp.rsize = v[20] * tsamp.pagesize;
+
+	pinfo->psamp.events.faults = (integer_t)(v[6] + v[8]);
+	pinfo->psamp.events.pageins = (integer_t)v[8];
+
+	pinfo->psamp.total_time.tv_sec = (v[10] + v[11]) / libtop_hz;
+	pinfo->psamp.total_time.tv_usec = ((v[10] + v[11]) % libtop_hz) * 1000000 / libtop_hz;
+
+	tv.tv_sec = v[18] / libtop_hz;
+	tv.tv_usec = (v[18] % libtop_hz) * 1000000 / libtop_hz;
+	pinfo->psamp.started.tv_sec = libtop_btime + tv.tv_sec;
+	pinfo->psamp.started.tv_usec = tv.tv_usec;
+
+	return TRUE;
+}
+
+/* Private and shared memory from /proc/<pid>/statm, in pages. */
+static void
+libtop_p_statm_update(libtop_pinfo_t *pinfo)
+{
+	char path[64];
+	unsigned long long size, resident, shared, text, lib, data;
+
+	snprintf(path, sizeof(path), "/proc/%d/statm", (int)pinfo->psamp.pid);
+	if (libtop_p_read(&pinfo->statm_fd, path, TRUE) < 0) return;
+
+	if (sscanf(libtop_buf, "%llu %llu %llu %llu %llu %llu",
+	    &size, &resident, &shared, &text, &lib, &data) != 6) {
+		return;
+	}
+
+	pinfo->psamp.rshrd = shared * tsamp.pagesize;
+	pinfo->psamp.rprvt = (resident - shared) * tsamp.pagesize;
+	pinfo->psamp.vprvt = data * tsamp.pagesize;
+}
+
+/* Owner and context switches from /proc/<pid>/status. */
+static void
+libtop_p_status_update(libtop_pinfo_t *pinfo)
+{
+	char path[64];
+	const char *p;
+	unsigned int ruid, euid;
+
+	snprintf(path, sizeof(path), "/proc/%d/status", (int)pinfo->psamp.pid);
+	if (libtop_p_read(&pinfo->status_fd, path, TRUE) < 0) return;
+
+	/* Real, effective, saved and filesystem uids: top shows the effective one. */
+	p = libtop_p_field(libtop_buf, "Uid");
+	if (p != NULL && sscanf(p, "%u %u", &ruid, &euid) == 2) {
+		pinfo->psamp.uid = (uid_t)euid;
+	}
+
+	pinfo->psamp.events.csw = (integer_t)(libtop_p_field_u64(libtop_buf, "voluntary_ctxt_switches")
+	    + libtop_p_field_u64(libtop_buf, "nonvoluntary_ctxt_switches"));
+}
+
+/*
+ * Thread states from /proc/<pid>/task/<tid>/stat.  The process takes the
+ * state of its most active thread, as with the Mach backend.
+ */
+static void
+libtop_p_threads_update(libtop_pinfo_t *pinfo)
+{
+	char path[PATH_MAX];
+	DIR *dir;
+	struct dirent *entry;
+	int state = LIBTOP_STATE_MAX;
+
+	snprintf(path, sizeof(path), "/proc/%d/task", (int)pinfo->psamp.pid);
+	dir = opendir(path);
+	if (dir == NULL) return;
+
+	pinfo->psamp.running_th = 0;
+	while ((entry = readdir(dir)) != NULL) {
+		int fd = -1;
+		const char *p;
+		int tstate;
+
+		if (entry->d_name[0] < '0' || entry->d_name[0] > '9') continue;
+
+		snprintf(path, sizeof(path), "/proc/%d/task/%s/stat",
+		    (int)pinfo->psamp.pid, entry->d_name);
+		if (libtop_p_read(&fd, path, FALSE) < 0) continue;
+
+		p = strrchr(libtop_buf, ')');
+		if (p == NULL || p[1] == '\0') continue;
+
+		tstate = libtop_p_state_order(p[2]);
+		if (tstate == LIBTOP_STATE_RUN) {
+			pinfo->psamp.running_th++;
+		}
+		if (tstate < state) {
+			state = tstate;
+		}
+	}
+	closedir(dir);
+
+	if (state != LIBTOP_STATE_MAX) {
+		pinfo->psamp.state = state;
+	}
+}
+
+/* Accumulate the event counters, see libtop_i64_update(). */
+static void
+libtop_p_events_update(libtop_pinfo_t *pinfo)
+{
+	if (pinfo->psamp.p_seq == 0) {
+		pinfo->psamp.b_events = pinfo->psamp.events;
+		pinfo->psamp.p_events = pinfo->psamp.events;
+
+		pinfo->psamp.faults.i64 = libtop_i64_init(0, pinfo->psamp.events.faults);
+		pinfo->psamp.pageins.i64 = libtop_i64_init(0, pinfo->psamp.events.pageins);
+		pinfo->psamp.cow_faults.i64 = libtop_i64_init(0, pinfo->psamp.events.cow_faults);
+		pinfo->psamp.messages_sent.i64 = libtop_i64_init(0, pinfo->psamp.events.messages_sent);
+		pinfo->psamp.messages_recv.i64 = libtop_i64_init(0, pinfo->psamp.events.messages_received);
+		pinfo->psamp.syscalls_mach.i64 = libtop_i64_init(0, pinfo->psamp.events.syscalls_mach);
+		pinfo->psamp.syscalls_bsd.i64 = libtop_i64_init(0, pinfo->psamp.events.syscalls_unix);
+		pinfo->psamp.csw.i64 = libtop_i64_init(0, pinfo->psamp.events.csw);
+	}
+
+	libtop_i64_update(&pinfo->psamp.faults.i64, pinfo->psamp.events.faults);
+	libtop_i64_update(&pinfo->psamp.pageins.i64, pinfo->psamp.events.pageins);
+	libtop_i64_update(&pinfo->psamp.cow_faults.i64, pinfo->psamp.events.cow_faults);
+	libtop_i64_update(&pinfo->psamp.messages_sent.i64, pinfo->psamp.events.messages_sent);
+	libtop_i64_update(&pinfo->psamp.messages_recv.i64, pinfo->psamp.events.messages_received);
+	libtop_i64_update(&pinfo->psamp.syscalls_mach.i64, pinfo->psamp.events.syscalls_mach);
+	libtop_i64_update(&pinfo->psamp.syscalls_bsd.i64, pinfo->psamp.events.syscalls_unix);
+	libtop_i64_update(&pinfo->psamp.csw.i64, pinfo->psamp.events.csw);
+
+	pinfo->psamp.faults.now = libtop_i64_value(&pinfo->psamp.faults.i64);
+	pinfo->psamp.pageins.now = libtop_i64_value(&pinfo->psamp.pageins.i64);
+	pinfo->psamp.cow_faults.now = libtop_i64_value(&pinfo->psamp.cow_faults.i64);
+	pinfo->psamp.messages_sent.now = libtop_i64_value(&pinfo->psamp.messages_sent.i64);
+	pinfo->psamp.messages_recv.now = libtop_i64_value(&pinfo->psamp.messages_recv.i64);
+	pinfo->psamp.syscalls_mach.now = libtop_i64_value(&pinfo->psamp.syscalls_mach.i64);
+	pinfo->psamp.syscalls_bsd.now = libtop_i64_value(&pinfo->psamp.syscalls_bsd.i64);
+	pinfo->psamp.csw.now = libtop_i64_value(&pinfo->psamp.csw.i64);
+}
+
+/* Insert a pinfo structure into the pid-ordered tree. */
+static void
+libtop_p_pinsert(libtop_pinfo_t *pinfo)
+{
+	rb_node_new(&libtop_ptree, pinfo, pnode);
+	rb_insert(&libtop_ptree, pinfo, libtop_p_pinfo_pid_comp,
+	    libtop_pinfo_t, pnode);
+}
+
+/* Remove a pinfo structure from the pid-ordered tree. */
+static void
+libtop_p_premove(libtop_pinfo_t *pinfo)
+{
+	rb_remove(&libtop_ptree, pinfo, libtop_pinfo_t, pnode);
+}
+
+/* Search for a pinfo structure with pid pid. */
+static libtop_pinfo_t *
+libtop_p_psearch(pid_t pid)
+{
+	libtop_pinfo_t	*retval, key;
+
+	key.psamp.pid = pid;
+	rb_search(&libtop_ptree, &key, libtop_p_pinfo_pid_comp, pnode, retval);
+	if (retval == rb_tree_nil(&libtop_ptree)) {
+		retval = NULL;
+	}
+
+	return retval;
+}
+
+/*
+ * Compare two pinfo structures according to pid.  This function is used for
+ * operations on the pid-sorted tree of pinfo structures.
+ */
+static int
+libtop_p_pinfo_pid_comp(libtop_pinfo_t *a, libtop_pinfo_t *b)
+{
+	assert(a != NULL);
+	assert(b != NULL);
+	if (a->psamp.pid < b->psamp.pid) return -1;
+	if (a->psamp.pid > b->psamp.pid) return 1;
+	return 0;
+}
+
+/* Process comparison wrapper function, used by the red-black tree code. */
+static int
+libtop_p_pinfo_comp(libtop_pinfo_t *a, libtop_pinfo_t *b)
+{
+	return libtop_sort(libtop_sort_data, &a->psamp, &b->psamp);
+}
+
+static void
+libtop_p_destroy_pinfo(libtop_pinfo_t *pinfo) {
+	libtop_p_premove(pinfo);
+
+	libtop_p_close(&pinfo->stat_fd);
+	libtop_p_close(&pinfo->statm_fd);
+	libtop_p_close(&pinfo->status_fd);
+
+	if(pinfo->psamp.command) {
+		free(pinfo->psamp.command);
+		/* Guard against reuse even though we are freeing. */
+		pinfo->psamp.command = NULL;
+	}
+
+	free(pinfo);
+}
+
+#endif /* __linux__ */
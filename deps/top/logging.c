@@ -24,7 +24,11 @@
 #include <stdlib.h>
 #include <string.h>
 #include <assert.h>
+#include <errno.h>
+#include <stdint.h>
+#include <time.h>
 #include <unistd.h>
+#include <sys/time.h>
 
 #include "statistic.h"
 #include "generic.h"
@@ -32,6 +36,7 @@
 #include "globalstats.h"
 #include "top.h"
 #include "sig.h"
+#include "binlog.h"
 
 struct log_get_total_data {
     int total;
@@ -213,20 +218,101 @@ static void log_print_all(void *tinst) {
     }
 }
 
+static void log_sleep_usec(int64_t usec) {
+    struct timespec ts;
+
+    if(usec <= 0)
+	return;
+
+    ts.tv_sec = usec / 1000000;
+    ts.tv_nsec = (usec % 1000000) * 1000;
+
+    /* A signal ends the sleep early, the callers check for the exit. */
+    nanosleep(&ts, NULL);
+}
+
+static int64_t log_now_usec(void) {
+    struct timeval now;
+
+    if(-1 == gettimeofday(&now, NULL))
+	perror("gettimeofday");
+
+    return (int64_t)now.tv_sec * 1000000 + now.tv_usec;
+}
+
 void top_logging_loop_body(void *tinst) {
     top_insert(tinst);
     log_print_all(tinst);
     fflush(stdout);
-    sleep(top_prefs_get_sleep());
+    log_sleep_usec(top_prefs_get_sleep_usec());
     
     if(top_signal_is_exit_set())
 	exit(EXIT_SUCCESS);
 }
 
+static void top_logging_binary_loop(void *tinst, const char *path) {
+    struct binlog *log;
+    int samples;
+    bool forever = false;
+    int64_t interval, next, now;
+
+    log = top_binlog_create(path, tinst);
+
+    if(NULL == log) {
+	fprintf(stderr, "unable to create the binary log %s: %s\n", path,
+		strerror(errno));
+	exit(EXIT_FAILURE);
+    }
+
+    /* Without -l the binary log goes on until it is interrupted. */
+    samples = top_prefs_get_samples();
+
+    if(samples <= 0)
+	forever = true;
+
+    interval = top_prefs_get_sleep_usec();
+    next = log_now_usec();
+
+    while(forever || samples-- > 0) {
+	if(top_binlog_write(log)) {
+	    fprintf(stderr, "error: writing the binary log %s: %s\n", path,
+		    strerror(errno));
+	    top_binlog_destroy(log);
+	    exit(EXIT_FAILURE);
+	}
+
+	if(top_signal_is_exit_set() || (!forever && 0 == samples))
+	    break;
+
+	/* 
+	 * Sample on a fixed schedule, the time taken by a sample is not
+	 * added to the delay.  The deadlines missed are skipped rather than
+	 * sampled in a burst.
+	 */
+	next += interval;
+	now = log_now_usec();
+
+	if(next < now)
+	    next = interval > 0 ? next + ((now - next) / interval + 1) * interval
+		: now;
+
+	log_sleep_usec(next - now);
+
+	if(top_signal_is_exit_set())
+	    break;
+    }
+
+    top_binlog_destroy(log);
+    exit(EXIT_SUCCESS);
+}
+
 void top_logging_loop(void *tinst) {
     int samples;
     bool forever = false;
 
+    if(top_prefs_get_binary_log())
+	top_logging_binary_loop(tinst, top_prefs_get_binary_log());
+
     if(0 == top_prefs_get_samples())
 	forever = true;
     
@@ -80,15 +80,16 @@ static void event_loop(void *tinst) {
 	FD_ZERO(&fset);
 	FD_SET(STDIN_FILENO, &fset);
 	
-	tlimit.tv_sec = top_prefs_get_sleep();
-	tlimit.tv_usec = 0;
+	tlimit.tv_sec = top_prefs_get_sleep_usec() / MICROSECONDS;
+	tlimit.tv_usec = top_prefs_get_sleep_usec() % MICROSECONDS;
 
 	ready = select(STDIN_FILENO + 1, &fset, NULL, NULL, &tlimit);
 
 	if(-1 == gettimeofday(&now, NULL))
 	    perror("gettimeofday");
 
-	if(now.tv_sec >= (before.tv_sec + tlimit.tv_sec)) {
+	if((now.tv_sec - before.tv_sec) * (long)MICROSECONDS
+	   + (now.tv_usec - before.tv_usec) >= top_prefs_get_sleep_usec()) {
 	    /*
 	     * The sleep has expired, so we should insert new
 	     * data for all stats.  This is different than just
@@ -187,7 +188,7 @@ int main(int argc, char *argv[]) {
 	return EXIT_FAILURE;
     }
 
-    if(top_prefs_get_samples() > -1)
+    if(top_prefs_get_samples() > -1 || top_prefs_get_binary_log())
 	top_prefs_set_logging_mode(true);
     
     if(!top_prefs_get_logging_mode())
@@ -51,6 +51,7 @@ enum {
     OPT_SWAP,
     OPT_MMR_OFF,
     OPT_MMR_ON,
+    OPT_BINARY,
     /*compat/deprecated options*/
     OPT_ACCUM,
     OPT_DELTA,
@@ -118,6 +119,7 @@ bool top_option_get(int argc, char *argv[], struct top_option *opts, int *offset
 /* Note: it's important that options with the same prefix have the long option in this struct first. */
 static struct top_option opts[] = {
     {"-stats", TOP_OPTION_REQUIRED, OPT_STATS},
+    {"-binary", TOP_OPTION_REQUIRED, OPT_BINARY},
     {"-ncols", TOP_OPTION_REQUIRED, OPT_NCOLS},
     {"-pid", TOP_OPTION_REQUIRED, OPT_PID},
     {"-user", TOP_OPTION_REQUIRED, OPT_USER},
@@ -151,6 +153,7 @@ void top_options_usage(FILE *fp, char *argv0) {
     fprintf(fp, 
 	    "%s usage: %s\n"
 	    "\t\t[-a | -d | -e | -c <mode>]\n"
+	    "\t\t[-binary <file>]\n"
 	    "\t\t[-F | -f]\n"
 	    "\t\t[-h]\n"
 	    "\t\t[-i <interval>]\n"
@@ -343,26 +346,32 @@ bool top_options_parse(int argc, char *argv[]) {
 	    break;
 	    
 	case OPT_SLEEP: {
-	    int s;
+	    double s;
+	    char *end;
 
-	    if(!string_is_integer(optarg)) {
+	    /* Fractions of a second are allowed, for the logging modes. */
+	    s = strtod(optarg, &end);
+
+	    if(end == optarg || '\0' != *end) {
 		fprintf(stderr, 
-			"invalid argument for sleep interval (not an integer):"
+			"invalid argument for sleep interval (not a number):"
 			" %s\n",
 			optarg);
 		return true;
 	    }
 
-	    s = atoi(optarg);
-
-	    if(s < 0) {
+	    if(s < 0 || s > 86400) {
 		fprintf(stderr, "invalid argument for -s: %s\n", optarg);
 		return true;
 	    }
 
-	    top_prefs_set_sleep(s);
+	    top_prefs_set_sleep_usec((long)(s * 1000000.0 + 0.5));
 	}
 	    break;
+
+	case OPT_BINARY:
+	    top_prefs_set_binary_log(optarg);
+	    break;
 	    	    
 	case OPT_STATS:
 	    if(top_prefs_set_stats(optarg)) {
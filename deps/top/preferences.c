@@ -38,7 +38,7 @@ static struct {
     int secondary_sort;
     bool sort_ascending;
     bool secondary_sort_ascending;
-    int sleep_seconds;
+    long sleep_usec;
     bool frameworks;
     int frameworks_interval;
     char *user;
@@ -48,6 +48,7 @@ static struct {
     bool have_pid;
     pid_t pid;
     bool logging_mode;
+    const char *binary_log;
     bool have_ncols;
     int ncols;
     bool show_swap;
@@ -68,7 +69,7 @@ static struct {
     .secondary_sort = STATISTIC_PID,
     .sort_ascending = false,
     .secondary_sort_ascending = false,
-    .sleep_seconds = 1,
+    .sleep_usec = 1000000,
     .frameworks = true,
     .frameworks_interval = 10,
     .user = NULL,
@@ -78,6 +79,7 @@ static struct {
     .have_pid = false,
     .pid = 0,
     .logging_mode = false,
+    .binary_log = NULL,
     .have_ncols = false,
     .ncols = -1,
     .show_swap = false,
@@ -299,11 +301,19 @@ const char *top_prefs_get_mode_string(void) {
 
 /* SLEEP */
 void top_prefs_set_sleep(int seconds) {
-    prefs.sleep_seconds = seconds;
+    prefs.sleep_usec = seconds * 1000000L;
 }
 
 int top_prefs_get_sleep(void) {
-    return prefs.sleep_seconds;
+    return (int)(prefs.sleep_usec / 1000000L);
+}
+
+void top_prefs_set_sleep_usec(long usec) {
+    prefs.sleep_usec = usec;
+}
+
+long top_prefs_get_sleep_usec(void) {
+    return prefs.sleep_usec;
 }
 
 /* Specify NULL for ascending if the sort shouldn't allow a + or - prefix. */
@@ -608,6 +618,14 @@ bool top_prefs_get_logging_mode(void) {
     return prefs.logging_mode;
 }
 
+void top_prefs_set_binary_log(const char *path) {
+    prefs.binary_log = path;
+}
+
+const char *top_prefs_get_binary_log(void) {
+    return prefs.binary_log;
+}
+
 void top_prefs_set_ncols(int limit) {
     prefs.have_ncols = true;
     prefs.ncols = limit;
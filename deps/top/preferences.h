@@ -48,6 +48,10 @@ const char *top_prefs_get_mode_string(void);
 void top_prefs_set_sleep(int seconds);
 int top_prefs_get_sleep(void);
 
+/* The same delay with sub-second precision, for the logging modes. */
+void top_prefs_set_sleep_usec(long usec);
+long top_prefs_get_sleep_usec(void);
+
 /* Take a symbolic string such as "cpu" */ 
 bool top_prefs_set_sort(const char *sort);
 /* Return one of the TOP_SORT enum values from above. */
@@ -97,6 +101,10 @@ int top_prefs_get_signal(const char **sptr);
 void top_prefs_set_logging_mode(bool mode);
 bool top_prefs_get_logging_mode(void);
 
+/* The path of the binary log, "-" for stdout; NULL when not logging in binary. */
+void top_prefs_set_binary_log(const char *path);
+const char *top_prefs_get_binary_log(void);
+
 void top_prefs_set_ncols(int limit);
 /* Returns true if the ncols has been set. */
 bool top_prefs_get_ncols(int *limit);
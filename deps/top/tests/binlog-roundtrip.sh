@@ -0,0 +1,15 @@
+#!/bin/sh
+# Build binlog_roundtrip.c against binlog.c and toplog2csv, then run it.
+set -e
+
+top=$(cd "$(dirname "$0")/.." && pwd)
+msgpack="$top/../msgpack-c/src"
+out=$(mktemp -d)
+trap 'rm -rf "$out"' EXIT
+
+${CC:-cc} -std=gnu99 -I"$msgpack" -o "$out/toplog2csv" \
+	"$top/toplog2csv.c" "$msgpack"/*.c
+${CC:-cc} -std=gnu99 -I"$top" -I"$msgpack" -o "$out/binlog_roundtrip" \
+	"$top/tests/binlog_roundtrip.c" "$top/binlog.c" "$msgpack"/*.c
+
+"$out/binlog_roundtrip" "$out/toplog2csv" "$out/test.binlog"
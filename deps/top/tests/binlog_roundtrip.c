@@ -0,0 +1,257 @@
+/*
+ * Round trip of the binary logging mode: binlog.c logs a few hand made
+ * samples, toplog2csv reads the log back and its CSV is compared with the
+ * values that were logged.  The samples make binlog.c write nil strings
+ * (unchanged commands and states) and negative deltas (shrinking sizes).
+ *
+ * usage: binlog_roundtrip <toplog2csv> <log file>
+ * See binlog-roundtrip.sh to build and run it.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include <msgpack/mapped_reader.h>
+
+#include "libtop.h"
+#include "statistic.h"
+#include "preferences.h"
+#include "top.h"
+#include "binlog.h"
+
+/* The parts of top and libtop that binlog.c uses. */
+
+static libtop_tsamp_t test_tsamp;
+const libtop_tsamp_t *tsamp = &test_tsamp;
+
+static libtop_psamp_t *test_samples;
+static int test_nsamples;
+
+int top_prefs_get_mode(void) {
+    return STATMODE_ACCUM;
+}
+
+bool top_prefs_get_ncols(int *limit) {
+    *limit = 0;
+    return false;
+}
+
+long top_prefs_get_sleep_usec(void) {
+    return 1000000;
+}
+
+void top_sample_sorted(void) {
+}
+
+void top_iterate_samples(void (*func)(const void *sample, void *ptr),
+			 void *ptr) {
+    int i;
+
+    for(i = 0; i < test_nsamples; ++i)
+	func(&test_samples[i], ptr);
+}
+
+const char *libtop_username(uid_t a_uid) {
+    return "root";
+}
+
+const char *libtop_state_str(uint32_t a_state) {
+    return a_state ? "sleeping" : "running";
+}
+
+static struct statistic test_statistics[] = {
+    {.type = STATISTIC_PID, .header = "PID"},
+    {.type = STATISTIC_COMMAND, .header = "COMMAND"},
+    {.type = STATISTIC_PSTATE, .header = "STATE"},
+    {.type = STATISTIC_VSIZE, .header = "VSIZE"},
+    {.type = STATISTIC_TIME, .header = "TIME"}
+};
+
+static void test_iterate(struct statistics_controller *c,
+			 bool (*func)(struct statistic *, void *), void *ptr) {
+    size_t i;
+
+    for(i = 0; i < sizeof(test_statistics) / sizeof(test_statistics[0]); ++i)
+	if(!func(&test_statistics[i], ptr))
+	    break;
+}
+
+/* The samples, and the CSV they must come back as. */
+
+struct test_row {
+    pid_t pid;
+    char *command;
+    int state;
+    uint64_t vsize;
+    long time_usec;
+};
+
+struct test_sample {
+    long time_usec; /* Since the epoch. */
+    int nrows;
+    struct test_row rows[3];
+};
+
+static const struct test_sample samples[] = {
+    {1000000000, 2, {
+	{30, "sh", 0, 5000, 2000000},
+	{10, "init", 1, 9000, 1250000}}},
+    /* pid 30 is gone, 10 is unchanged but for a smaller size, 20 is new. */
+    {1001500000, 2, {
+	{10, "init", 1, 4000, 1500000},
+	{20, "new", 0, 100, 0}}},
+    /* A command that needs quoting in the CSV, and 20 shrinks again. */
+    {1002500000, 2, {
+	{10, "init, again", 0, 4000, 1500000},
+	{20, "new", 0, 50, 250000}}}
+};
+
+static const char expected[] =
+    "TIMESTAMP,PID,COMMAND,STATE,VSIZE,TIME\n"
+    "1000.000000,30,sh,running,5000,2000000\n"
+    "1000.000000,10,init,sleeping,9000,1250000\n"
+    "1001.500000,10,init,sleeping,4000,1500000\n"
+    "1001.500000,20,new,running,100,0\n"
+    "1002.500000,10,\"init, again\",running,4000,1500000\n"
+    "1002.500000,20,new,running,50,250000\n";
+
+static void set_timeval(struct timeval *tv, long usec) {
+    tv->tv_sec = usec / 1000000;
+    tv->tv_usec = usec % 1000000;
+}
+
+/* Return true if an error occurred. */
+static bool write_log(const char *path) {
+    struct statistics_controller controller;
+    libtop_psamp_t rows[3];
+    struct binlog *log;
+    size_t s;
+    int r;
+
+    memset(&controller, 0, sizeof(controller));
+    controller.iterate = test_iterate;
+
+    log = top_binlog_create(path, &controller);
+
+    if(NULL == log) {
+	perror(path);
+	return true;
+    }
+
+    for(s = 0; s < sizeof(samples) / sizeof(samples[0]); ++s) {
+	memset(rows, 0, sizeof(rows));
+
+	for(r = 0; r < samples[s].nrows; ++r) {
+	    rows[r].pid = samples[s].rows[r].pid;
+	    rows[r].command = samples[s].rows[r].command;
+	    rows[r].state = samples[s].rows[r].state;
+	    rows[r].vsize = samples[s].rows[r].vsize;
+	    set_timeval(&rows[r].total_time, samples[s].rows[r].time_usec);
+	}
+
+	test_samples = rows;
+	test_nsamples = samples[s].nrows;
+	set_timeval(&test_tsamp.time, samples[s].time_usec);
+
+	if(top_binlog_write(log)) {
+	    fprintf(stderr, "%s: unable to write sample %zu\n", path, s);
+	    top_binlog_destroy(log);
+	    return true;
+	}
+    }
+
+    top_binlog_destroy(log);
+
+    return false;
+}
+
+/* Count the nil strings and negative deltas of the rows, they must be there. */
+static bool check_encoding(const char *path) {
+    msgpack_mapped_reader reader;
+    msgpack_object o;
+    int nils = 0, negatives = 0;
+    uint32_t i, j;
+
+    if(!msgpack_mapped_reader_open(&reader, path, 0)) {
+	perror(path);
+	return true;
+    }
+
+    /* Skip the header. */
+    msgpack_mapped_reader_next(&reader, &o);
+
+    while(msgpack_mapped_reader_next(&reader, &o)) {
+	const msgpack_object *list = &o.via.array.ptr[1];
+
+	for(i = 0; i < list->via.array.size; ++i) {
+	    const msgpack_object *row = &list->via.array.ptr[i];
+
+	    for(j = 1; j < row->via.array.size; ++j) {
+		if(MSGPACK_OBJECT_NIL == row->via.array.ptr[j].type)
+		    nils++;
+		else if(MSGPACK_OBJECT_NEGATIVE_INTEGER
+			== row->via.array.ptr[j].type)
+		    negatives++;
+	    }
+	}
+    }
+
+    msgpack_mapped_reader_destroy(&reader);
+
+    if(0 == nils || 0 == negatives) {
+	fprintf(stderr, "%s: expected nil strings and negative deltas, "
+		"found %d and %d\n", path, nils, negatives);
+	return true;
+    }
+
+    return false;
+}
+
+/* Return true if an error occurred. */
+static bool check_csv(const char *converter, const char *path) {
+    char command[4096], output[4096];
+    size_t length;
+    FILE *pipe;
+
+    snprintf(command, sizeof(command), "'%s' '%s'", converter, path);
+    pipe = popen(command, "r");
+
+    if(NULL == pipe) {
+	perror(converter);
+	return true;
+    }
+
+    length = fread(output, 1, sizeof(output) - 1, pipe);
+    output[length] = '\0';
+
+    if(0 != pclose(pipe)) {
+	fprintf(stderr, "%s failed\n", converter);
+	return true;
+    }
+
+    if(strcmp(output, expected)) {
+	fprintf(stderr, "expected:\n%sgot:\n%s", expected, output);
+	return true;
+    }
+
+    return false;
+}
+
+int main(int argc, char *argv[]) {
+    if(3 != argc) {
+	fprintf(stderr, "%s usage: %s <toplog2csv> <log file>\n", argv[0],
+		argv[0]);
+	return EXIT_FAILURE;
+    }
+
+    if(write_log(argv[2]) || check_encoding(argv[2])
+       || check_csv(argv[1], argv[2]))
+	return EXIT_FAILURE;
+
+    puts("binlog round trip: OK");
+
+    return EXIT_SUCCESS;
+}
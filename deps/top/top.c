@@ -214,17 +214,8 @@ void top_sample(void) {
 }
 
 
-void top_insert(void *ptr) {
-    struct statistics_controller *c = ptr;
-    const libtop_psamp_t *psample;
-    char *user;
-    unsigned long uid = 0;
-    int nprocs;
-    pid_t pid;
-    bool have_pid = false;
-    
-    c->reset_insertion(c);
-
+/* Sample and sort the processes, this sets tsamp. */
+void top_sample_sorted(void) {
     top_sample();
 
     /* 
@@ -234,10 +225,21 @@ void top_insert(void *ptr) {
     libtop_psort(top_sort, NULL);
 
     tsamp = libtop_tsamp();
+}
 
-    if(top_globalstats_update(c->globalstats, tsamp))
-	top_log("An error occurred while updating global stats.\n");
-  
+/* 
+ * Call func with the libtop_psamp_t of each process of the last sample
+ * selected by the user, pid and nprocs preferences, in the sorted order.
+ */
+void top_iterate_samples(void (*func)(const void *sample, void *ptr),
+			 void *ptr) {
+    const libtop_psamp_t *psample;
+    char *user;
+    unsigned long uid = 0;
+    int nprocs;
+    pid_t pid;
+    bool have_pid = false;
+    
     /* The user has requested only displaying processes owned by user. */
     user = top_prefs_get_user();
 
@@ -260,7 +262,7 @@ void top_insert(void *ptr) {
 		continue;
 	}
 
-	c->insert_sample(c, psample);
+	func(psample, ptr);
 
 	/*
 	 * If nprocs is -1 (the default), or otherwise negative, 
@@ -275,6 +277,25 @@ void top_insert(void *ptr) {
     }
 }
 
+static void top_insert_iter(const void *sample, void *ptr) {
+    struct statistics_controller *c = ptr;
+
+    c->insert_sample(c, sample);
+}
+
+void top_insert(void *ptr) {
+    struct statistics_controller *c = ptr;
+    
+    c->reset_insertion(c);
+
+    top_sample_sorted();
+
+    if(top_globalstats_update(c->globalstats, tsamp))
+	top_log("An error occurred while updating global stats.\n");
+  
+    top_iterate_samples(top_insert_iter, c);
+}
+
 
 /* Return true if a non-fatal error occurred. */
 bool top_layout(void *ptr) {
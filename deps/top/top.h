@@ -32,6 +32,9 @@ void top_relayout(struct statistics_controller *c, int type, int maxwidth);
 bool top_need_relayout(void);
 void *top_create(WINDOW *wmain);
 void top_sample(void);
+void top_sample_sorted(void);
+void top_iterate_samples(void (*func)(const void *sample, void *ptr),
+			 void *ptr);
 void top_insert(void *ptr);
 bool top_layout(void *ptr);
 void top_draw(void *ptr);
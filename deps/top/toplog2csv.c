@@ -0,0 +1,346 @@
+/*
+ * Copyright (c) 2008, 2009 Apple Computer, Inc.  All rights reserved.
+ *
+ * @APPLE_LICENSE_HEADER_START@
+ * 
+ * The contents of this file constitute Original Code as defined in and
+ * are subject to the Apple Public Source License Version 1.1 (the
+ * "License").  You may not use this file except in compliance with the
+ * License.  Please obtain a copy of the License at
+ * http://www.apple.com/publicsource and read it before using this file.
+ * 
+ * This Original Code and all software distributed under the License are
+ * distributed on an "AS IS" basis, WITHOUT WARRANTY OF ANY KIND, EITHER
+ * EXPRESS OR IMPLIED, AND APPLE HEREBY DISCLAIMS ALL SUCH WARRANTIES,
+ * INCLUDING WITHOUT LIMITATION, ANY WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE OR NON-INFRINGEMENT.  Please see the
+ * License for the specific language governing rights and limitations
+ * under the License.
+ * 
+ * @APPLE_LICENSE_HEADER_END@
+ */
+
+/*
+ * Convert a binary log of top (top -binary <file>) to CSV on stdout.  See
+ * binlog.c for the format.  Each row is the time of the sample in seconds
+ * since the epoch, the pid and the logged columns.  The values are the
+ * ones logged: %CPU in percent, TIME in microseconds, the memory in bytes
+ * and the event counters as totals.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <inttypes.h>
+
+#include <msgpack/mapped_reader.h>
+
+struct column {
+    char *header;
+    bool string;
+    bool centipercent;
+};
+
+struct row {
+    int64_t pid;
+    int64_t *values;
+    char **strings;
+};
+
+/* The rows of a sample, sorted by pid once it is complete. */
+struct rows {
+    size_t length, capacity;
+    struct row *array;
+};
+
+static struct column *columns;
+static int ncolumns;
+
+static bool object_is_integer(const msgpack_object *o) {
+    return MSGPACK_OBJECT_POSITIVE_INTEGER == o->type
+	|| MSGPACK_OBJECT_NEGATIVE_INTEGER == o->type;
+}
+
+static int64_t object_integer(const msgpack_object *o) {
+    if(MSGPACK_OBJECT_POSITIVE_INTEGER == o->type)
+	return (int64_t)o->via.u64;
+
+    return o->via.i64;
+}
+
+static bool object_is(const msgpack_object *o, const char *s) {
+    return MSGPACK_OBJECT_RAW == o->type && strlen(s) == o->via.raw.size
+	&& !memcmp(o->via.raw.ptr, s, o->via.raw.size);
+}
+
+static char *object_strdup(const msgpack_object *o) {
+    char *s;
+
+    if(MSGPACK_OBJECT_RAW != o->type)
+	return strdup("");
+
+    s = malloc(o->via.raw.size + 1);
+
+    if(NULL == s)
+	return NULL;
+
+    memcpy(s, o->via.raw.ptr, o->via.raw.size);
+    s[o->via.raw.size] = '\0';
+
+    return s;
+}
+
+static void print_string(const char *s) {
+    const char *p;
+
+    if(NULL == strpbrk(s, ",\"\n")) {
+	fputs(s, stdout);
+	return;
+    }
+
+    putchar('"');
+
+    for(p = s; *p; ++p) {
+	if('"' == *p)
+	    putchar('"');
+
+	putchar(*p);
+    }
+
+    putchar('"');
+}
+
+/* Return true if an error occurred. */
+static bool read_header(const msgpack_object *header, int64_t *start) {
+    const msgpack_object *list = NULL;
+    bool format = false;
+    uint32_t i;
+
+    if(MSGPACK_OBJECT_MAP != header->type)
+	return true;
+
+    for(i = 0; i < header->via.map.size; ++i) {
+	const msgpack_object *key = &header->via.map.ptr[i].key;
+	const msgpack_object *val = &header->via.map.ptr[i].val;
+
+	if(object_is(key, "format")) {
+	    format = object_is(val, "top-binlog");
+	} else if(object_is(key, "version")) {
+	    if(!object_is_integer(val) || 1 != object_integer(val))
+		return true;
+	} else if(object_is(key, "start") && object_is_integer(val)) {
+	    *start = object_integer(val);
+	} else if(object_is(key, "columns")
+		  && MSGPACK_OBJECT_ARRAY == val->type) {
+	    list = val;
+	}
+    }
+
+    if(!format || NULL == list)
+	return true;
+
+    ncolumns = (int)list->via.array.size;
+    columns = calloc(ncolumns ? ncolumns : 1, sizeof(*columns));
+
+    if(NULL == columns)
+	return true;
+
+    for(i = 0; i < list->via.array.size; ++i) {
+	const msgpack_object *column = &list->via.array.ptr[i];
+
+	if(MSGPACK_OBJECT_ARRAY != column->type || column->via.array.size < 3)
+	    return true;
+
+	columns[i].header = object_strdup(&column->via.array.ptr[0]);
+	columns[i].string = object_is(&column->via.array.ptr[1], "string");
+	columns[i].centipercent = object_is(&column->via.array.ptr[2], "0.01%");
+
+	if(NULL == columns[i].header)
+	    return true;
+    }
+
+    return false;
+}
+
+static int row_compare(const void *a, const void *b) {
+    const struct row *ra = a, *rb = b;
+
+    return (ra->pid > rb->pid) - (ra->pid < rb->pid);
+}
+
+static void rows_clear(struct rows *rows) {
+    size_t i;
+    int c;
+
+    for(i = 0; i < rows->length; ++i) {
+	for(c = 0; c < ncolumns; ++c)
+	    free(rows->array[i].strings[c]);
+
+	free(rows->array[i].values);
+	free(rows->array[i].strings);
+    }
+
+    rows->length = 0;
+}
+
+/* Return true if an error occurred. */
+static bool read_row(const msgpack_object *o, double time,
+		     struct rows *previous, struct rows *current) {
+    struct row key, *found, *row;
+    int c;
+
+    if(MSGPACK_OBJECT_ARRAY != o->type
+       || o->via.array.size != (uint32_t)ncolumns + 1
+       || !object_is_integer(&o->via.array.ptr[0]))
+	return true;
+
+    if(current->length == current->capacity) {
+	size_t capacity = current->capacity ? current->capacity * 2 : 256;
+	struct row *array = realloc(current->array, capacity * sizeof(*array));
+
+	if(NULL == array)
+	    return true;
+
+	current->array = array;
+	current->capacity = capacity;
+    }
+
+    key.pid = object_integer(&o->via.array.ptr[0]);
+    found = previous->length ? bsearch(&key, previous->array, previous->length,
+				       sizeof(key), row_compare) : NULL;
+
+    row = &current->array[current->length];
+    row->pid = key.pid;
+    row->values = calloc(ncolumns ? ncolumns : 1, sizeof(*row->values));
+    row->strings = calloc(ncolumns ? ncolumns : 1, sizeof(*row->strings));
+
+    if(NULL == row->values || NULL == row->strings) {
+	free(row->values);
+	free(row->strings);
+	return true;
+    }
+
+    current->length++;
+
+    printf("%.6f,%" PRId64, time, row->pid);
+
+    for(c = 0; c < ncolumns; ++c) {
+	const msgpack_object *v = &o->via.array.ptr[c + 1];
+
+	putchar(',');
+
+	if(columns[c].string) {
+	    if(MSGPACK_OBJECT_NIL == v->type && found) {
+		/* Unchanged, take the string of the previous sample. */
+		row->strings[c] = found->strings[c];
+		found->strings[c] = NULL;
+	    } else {
+		row->strings[c] = object_strdup(v);
+	    }
+
+	    if(NULL == row->strings[c])
+		return true;
+
+	    print_string(row->strings[c]);
+	} else {
+	    if(!object_is_integer(v))
+		return true;
+
+	    row->values[c] = object_integer(v) + (found ? found->values[c] : 0);
+
+	    if(columns[c].centipercent)
+		printf("%" PRId64 ".%02" PRId64, row->values[c] / 100,
+		       row->values[c] % 100);
+	    else
+		printf("%" PRId64, row->values[c]);
+	}
+    }
+
+    putchar('\n');
+
+    return false;
+}
+
+int main(int argc, char *argv[]) {
+    msgpack_mapped_reader reader;
+    msgpack_object o;
+    struct rows rows[2], *previous = &rows[0], *current = &rows[1], *swap;
+    int64_t start = 0, elapsed = 0;
+    uint64_t samples = 0;
+    uint32_t i;
+    int c;
+
+    if(2 != argc) {
+	fprintf(stderr, "%s usage: %s <file>\n", argv[0], argv[0]);
+	return EXIT_FAILURE;
+    }
+
+    if(!msgpack_mapped_reader_open(&reader, argv[1], 0)) {
+	perror(argv[1]);
+	return EXIT_FAILURE;
+    }
+
+    if(!msgpack_mapped_reader_next(&reader, &o) || read_header(&o, &start)) {
+	fprintf(stderr, "%s: not a binary log of top\n", argv[1]);
+	return EXIT_FAILURE;
+    }
+
+    memset(rows, 0, sizeof(rows));
+
+    printf("TIMESTAMP,PID");
+
+    for(c = 0; c < ncolumns; ++c) {
+	putchar(',');
+	print_string(columns[c].header);
+    }
+
+    putchar('\n');
+
+    while(msgpack_mapped_reader_next(&reader, &o)) {
+	const msgpack_object *list;
+
+	if(MSGPACK_OBJECT_ARRAY != o.type || 2 != o.via.array.size
+	   || !object_is_integer(&o.via.array.ptr[0])
+	   || MSGPACK_OBJECT_ARRAY != o.via.array.ptr[1].type) {
+	    fprintf(stderr, "%s: invalid sample %" PRIu64 "\n", argv[1],
+		    samples);
+	    return EXIT_FAILURE;
+	}
+
+	elapsed += object_integer(&o.via.array.ptr[0]);
+	list = &o.via.array.ptr[1];
+
+	for(i = 0; i < list->via.array.size; ++i) {
+	    if(read_row(&list->via.array.ptr[i], (start + elapsed) / 1e6,
+			previous, current)) {
+		fprintf(stderr, "%s: invalid row in sample %" PRIu64 "\n",
+			argv[1], samples);
+		return EXIT_FAILURE;
+	    }
+	}
+
+	rows_clear(previous);
+	qsort(current->array, current->length, sizeof(*current->array),
+	      row_compare);
+
+	swap = previous;
+	previous = current;
+	current = swap;
+
+	samples++;
+    }
+
+    /* A log cut by an interruption may end with a partial sample. */
+    if(reader.off < reader.size)
+	fprintf(stderr, "%s: ignored %zu trailing bytes\n", argv[1],
+		reader.size - reader.off);
+
+    rows_clear(previous);
+    free(rows[0].array);
+    free(rows[1].array);
+    msgpack_mapped_reader_destroy(&reader);
+
+    return EXIT_SUCCESS;
+}
@@ -20,18 +20,34 @@ NGL_APP_CREATE(Application);
 Application::Application()
 {
   mpMainWindow = NULL;
+  mpRpcServer = NULL;
   lldb::SBDebugger::Initialize();
   mpDebuggerContext = new Xspray::DebuggerContext();
 }
 
 Application::~Application()
 {
-  delete mpDebuggerContext;
+  // With the targets added during the session:
+  while (Xspray::DebuggerContext::GetContextCount())
+    delete Xspray::DebuggerContext::GetContext(0);
   lldb::SBDebugger::Terminate();
 }
 
 void Application::OnExit (int Code)
 {
+  // Arguments and environments edited during the session:
+  Xspray::AppDescription::SaveCatalog();
+
+  if (Xspray::Tracer::IsEnabled())
+  {
+    Xspray::Tracer::Enable(false);
+    Xspray::Tracer::Export(nglPath(getenv("XSPRAY_TRACE")));
+  }
+
+  // Its targets go with it, before the ones of the session:
+  delete mpRpcServer;
+  mpRpcServer = NULL;
+
   if (mpMainWindow)
     mpMainWindow->Release();
 }
@@ -54,6 +70,15 @@ void Application::OnInit()
   ParseDefaultArgs();
 
   GetLog().UseConsole(true);
+
+  Xspray::AppDescription::LoadCatalog();
+
+  // XSPRAY_TRACE=<file.json> records spans for the whole session and writes them in the Chrome trace format on exit:
+  if (getenv("XSPRAY_TRACE"))
+  {
+    Xspray::Tracer::SetThreadName("Main");
+    Xspray::Tracer::Enable(true);
+  }
   //GetLog().SetLevel(_T("fps"), 100);
   //GetLog().SetLevel(_T("all"), 100);
 
@@ -100,7 +125,35 @@ void Application::OnInit()
       // Get the path to the application from the args:
       arg = GetArg(i+1);
       int index = Xspray::AppDescription::AddApp(arg);
-      mpDebuggerContext->mpAppDescription = Xspray::AppDescription::GetApp(index);
+
+      // Each application after the first one is another target of the session:
+      Xspray::DebuggerContext* pContext = mpDebuggerContext;
+      if (pContext->mpAppDescription)
+        pContext = new Xspray::DebuggerContext();
+      pContext->mpAppDescription = Xspray::AppDescription::GetApp(index);
+      i++;
+    }
+    else if (!arg.Compare(_T("--record")) && ((i+1) < GetArgCount()))
+    {
+      mRecordPath = GetArg(i+1);
+      i++;
+    }
+    else if (!arg.Compare(_T("--replay")) && ((i+1) < GetArgCount()))
+    {
+      mReplayPath = GetArg(i+1);
+      i++;
+    }
+    else if (!arg.Compare(_T("--core")) && ((i+1) < GetArgCount()))
+    {
+      mCorePath = GetArg(i+1);
+      i++;
+    }
+    else if (!arg.Compare(_T("--serve")) && ((i+1) < GetArgCount()))
+    {
+      // msgpack-RPC clients drive the targets of the session from that socket:
+      mpRpcServer = new Xspray::RpcServer();
+      if (!mpRpcServer->Start(nglPath(GetArg(i+1))))
+        NGL_OUT(_T("Error: unable to listen on %s\n"), GetArg(i+1).GetChars());
       i++;
     }
     i++;
@@ -175,7 +228,22 @@ MainWindow* Application::GetMainWindow()
 
 Xspray::DebuggerContext& Application::GetDebuggerContext()
 {
-  return *mpDebuggerContext;
+  return Xspray::GetDebuggerContext();
+}
+
+const nglPath& Application::GetRecordPath() const
+{
+  return mRecordPath;
+}
+
+const nglPath& Application::GetReplayPath() const
+{
+  return mReplayPath;
+}
+
+const nglPath& Application::GetCorePath() const
+{
+  return mCorePath;
 }
 
 
@@ -23,10 +23,18 @@ public:
   MainWindow* GetMainWindow();
 
   Xspray::DebuggerContext& GetDebuggerContext();
+
+  const nglPath& GetRecordPath() const; // Session log to record the stops to, empty if none
+  const nglPath& GetReplayPath() const; // Session log to browse instead of debugging, empty if none
+  const nglPath& GetCorePath() const; // Core file to open instead of launching, empty if none
 private:
   
   MainWindow* mpMainWindow;
   Xspray::DebuggerContext* mpDebuggerContext;
+  nglPath mRecordPath;
+  nglPath mReplayPath;
+  nglPath mCorePath;
+  Xspray::RpcServer* mpRpcServer; // With --serve <socket>
 };
 
 
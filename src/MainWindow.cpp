@@ -32,6 +32,9 @@ MainWindow::MainWindow(const nglContextInfo& rContextInfo, const nglWindowInfo&
   NUI_ADD_WIDGET_CREATOR(HomeView, "Container");
   NUI_ADD_WIDGET_CREATOR(DebugView, "Container");
   NUI_ADD_WIDGET_CREATOR(GraphView, "Container");
+  NUI_ADD_WIDGET_CREATOR(FlameGraphView, "Container");
+  NUI_ADD_WIDGET_CREATOR(WatchTimelineView, "Container");
+  NUI_ADD_WIDGET_CREATOR(RowView, "Container");
 
 #ifdef _DEBUG_
   nglString t = "DEBUG";
@@ -55,6 +58,11 @@ MainWindow::MainWindow(const nglContextInfo& rContextInfo, const nglWindowInfo&
   mpController->PushViewController(pView);
 
   mSlotSink.Connect(pHome->Launch, nuiMakeDelegate(this, &MainWindow::OnLaunch));
+
+  if (!GetApp()->GetReplayPath().IsEmpty())
+    OnReplay(GetApp()->GetReplayPath());
+  else if (!GetApp()->GetCorePath().IsEmpty())
+    OnOpenCore(GetApp()->GetCorePath());
 }
 
 MainWindow::~MainWindow()
@@ -107,8 +115,21 @@ bool MainWindow::LoadCSS(const nglPath& rPath)
 
 void MainWindow::OnLaunch(const nglPath& rPath)
 {
-  if (GetDebuggerContext().LoadApp())
+  DebuggerContext& rContext(GetDebuggerContext());
+  if (rContext.LoadApp())
   {
+    const nglPath& rRecordPath(GetApp()->GetRecordPath());
+    if (!rRecordPath.IsEmpty() && !rContext.mRecorder.Open(rRecordPath, rContext.mpAppDescription->GetLocalPath()))
+      NGL_OUT("Unable to open session log %s\n", rRecordPath.GetChars());
+
+    // The other applications given on the command line are targets of the same session:
+    for (int32 i = 0; i < DebuggerContext::GetContextCount(); i++)
+    {
+      DebuggerContext* pContext = DebuggerContext::GetContext(i);
+      if (pContext != &rContext && pContext->mpAppDescription && !pContext->mTarget.IsValid() && !pContext->LoadApp())
+        NGL_OUT("Unable to load %s\n", pContext->mpAppDescription->GetName().GetChars());
+    }
+
     nuiViewController* pView = new nuiViewController();
     DebugView* pDebugger = (DebugView*)nuiBuilder::Get().CreateWidget("Debugger");
     NGL_ASSERT(pDebugger);
@@ -122,6 +143,33 @@ void MainWindow::OnLaunch(const nglPath& rPath)
   }
 }
 
+void MainWindow::OnReplay(const nglPath& rPath)
+{
+  nuiViewController* pView = new nuiViewController();
+  DebugView* pDebugger = (DebugView*)nuiBuilder::Get().CreateWidget("Debugger");
+  NGL_ASSERT(pDebugger);
+  pView->AddChild(pDebugger);
+  mpController->PushViewController(pView);
+  mSlotSink.Connect(pDebugger->GoHome, nuiMakeDelegate(this, &MainWindow::OnGoHome));
+
+  if (!pDebugger->Replay(rPath))
+    NGL_OUT("Unable to replay session log %s\n", rPath.GetChars());
+}
+
+void MainWindow::OnOpenCore(const nglPath& rPath)
+{
+  nuiViewController* pView = new nuiViewController();
+  DebugView* pDebugger = (DebugView*)nuiBuilder::Get().CreateWidget("Debugger");
+  NGL_ASSERT(pDebugger);
+  pView->AddChild(pDebugger);
+  mpController->PushViewController(pView);
+  mSlotSink.Connect(pDebugger->GoHome, nuiMakeDelegate(this, &MainWindow::OnGoHome));
+
+  // With the application given with -a, if any:
+  if (!pDebugger->OpenCore(rPath))
+    NGL_OUT("Unable to open core file %s\n", rPath.GetChars());
+}
+
 void MainWindow::OnGoHome()
 {
   mpController->PopToRootViewControllerAnimated();
@@ -27,6 +27,8 @@ protected:
   nuiNavigationController* mpController;
 
   void OnLaunch(const nglPath& rPath);
+  void OnReplay(const nglPath& rPath);
+  void OnOpenCore(const nglPath& rPath);
   void OnGoHome();
 };
 
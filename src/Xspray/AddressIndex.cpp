@@ -0,0 +1,317 @@
+//
+//  AddressIndex.cpp
+//  Xspray
+//
+
+#include "Xspray.h"
+
+using namespace Xspray;
+
+template <class T>
+static bool CompareStart(lldb::addr_t address, const T& rItem)
+{
+  return address < rItem.mStart;
+}
+
+template <class T>
+static bool CompareAddress(lldb::addr_t address, const T& rItem)
+{
+  return address < rItem.mAddress;
+}
+
+template <class T>
+static bool SortByStart(const T& rA, const T& rB)
+{
+  return rA.mStart < rB.mStart;
+}
+
+template <class T>
+static bool SortByAddress(const T& rA, const T& rB)
+{
+  return rA.mAddress < rB.mAddress;
+}
+
+//////// AddressIndex::Location
+AddressIndex::Location::Location()
+: mLine(0)
+{
+}
+
+//////// AddressIndex::Frame
+AddressIndex::Frame::Frame()
+: mPC(0), mLine(0), mColumn(0)
+{
+}
+
+//////// AddressIndex
+AddressIndex::AddressIndex()
+: mProcessID(0)
+{
+}
+
+AddressIndex::~AddressIndex()
+{
+  Clear();
+}
+
+void AddressIndex::AddModule(const SymbolIndex::Module* pSymbols, const ModuleCache* pCache)
+{
+  Module* pModule = new Module();
+  pModule->mpSymbols = pSymbols;
+  pModule->mpCache = pCache;
+  pModule->mRebased = false;
+  pModule->mSlide = 0;
+
+  // Source lines ordered by address, from the raw line entries of every file of the module:
+  uint32 files = pCache->GetFileCount();
+  for (uint32 i = 0; i < files; i++)
+  {
+    const ModuleCache::File& rFile(pCache->GetFile(i));
+    const LineTable::Entry* pEntries = pCache->GetLineEntries(rFile);
+    for (uint32 j = 0; j < rFile.mEntryCount; j++)
+    {
+      Line line;
+      line.mAddress = pEntries[j].mAddress;
+      line.mFile = i;
+      line.mLine = pEntries[j].mLine;
+      pModule->mLines.push_back(line);
+    }
+  }
+  std::sort(pModule->mLines.begin(), pModule->mLines.end(), SortByAddress<Line>);
+
+  // Each code symbol covers its own extent, symbols LLDB gave no end are left to the LLDB fallback:
+  const std::vector<SymbolIndex::Symbol>& rSymbols(pSymbols->mSymbols);
+  for (uint32 i = 0; i < rSymbols.size(); i++)
+  {
+    const SymbolIndex::Symbol& rSymbol(rSymbols[i]);
+    if (rSymbol.mType != lldb::eSymbolTypeCode || rSymbol.mAddress == LLDB_INVALID_ADDRESS || !rSymbol.mSize)
+      continue;
+
+    Function function;
+    function.mStart = rSymbol.mAddress;
+    function.mEnd = rSymbol.mAddress + rSymbol.mSize;
+    function.mSymbol = i;
+    pModule->mFunctions.push_back(function);
+  }
+
+  std::vector<Function>& rFunctions(pModule->mFunctions);
+  std::stable_sort(rFunctions.begin(), rFunctions.end(), SortByStart<Function>);
+  int32 count = 0;
+  for (uint32 i = 0; i < rFunctions.size(); i++)
+  {
+    // Aliases share a start address, keep the first one:
+    if (count && rFunctions[count - 1].mStart == rFunctions[i].mStart)
+      continue;
+    rFunctions[count++] = rFunctions[i];
+  }
+  rFunctions.resize(count);
+
+  // Lookups only look at the closest start so overlapping symbols must not reach into the next one:
+  for (int32 i = 0; i + 1 < count; i++)
+    rFunctions[i].mEnd = MIN(rFunctions[i].mEnd, rFunctions[i + 1].mStart);
+
+  nglCriticalSectionGuard guard(mCS);
+  mModules.push_back(pModule);
+}
+
+void AddressIndex::RemoveModule(const ModuleCache* pCache)
+{
+  nglCriticalSectionGuard guard(mCS);
+  for (int32 i = 0; i < mModules.size(); i++)
+  {
+    if (mModules[i]->mpCache != pCache)
+      continue;
+
+    bool rebased = mModules[i]->mRebased;
+    delete mModules[i];
+    mModules.erase(mModules.begin() + i);
+    if (rebased)
+      UpdateRanges();
+    return;
+  }
+}
+
+void AddressIndex::Clear()
+{
+  nglCriticalSectionGuard guard(mCS);
+  for (int32 i = 0; i < mModules.size(); i++)
+    delete mModules[i];
+  mModules.clear();
+  mRanges.clear();
+  mProcessID = 0;
+}
+
+void AddressIndex::Rebase(lldb::SBTarget target)
+{
+  // The lock is held while LLDB is queried so RemoveModule cannot delete a module under us:
+  nglCriticalSectionGuard guard(mCS);
+  bool changed = false;
+
+  // A relaunched or newly attached process has its own ASLR slides, and there is nothing to rebase once it is gone:
+  lldb::SBProcess process(target.GetProcess());
+  lldb::StateType state = process.IsValid() ? process.GetState() : lldb::eStateInvalid;
+  bool alive = process.IsValid() && state != lldb::eStateExited && state != lldb::eStateDetached;
+  uint32 id = alive ? process.GetUniqueID() : 0;
+  if (id != mProcessID)
+  {
+    for (int32 i = 0; i < mModules.size(); i++)
+    {
+      mModules[i]->mRebased = false;
+      mModules[i]->mSlide = 0;
+    }
+    mProcessID = id;
+    changed = true;
+  }
+
+  for (int32 i = 0; id && i < mModules.size(); i++)
+  {
+    Module* pModule = mModules[i];
+    if (pModule->mRebased)
+      continue;
+
+    lldb::SBModule module(pModule->mpSymbols->mModule);
+    lldb::SBAddress header = module.GetObjectFileHeaderAddress();
+    if (!header.IsValid())
+      continue;
+
+    lldb::addr_t load = header.GetLoadAddress(target);
+    if (load == LLDB_INVALID_ADDRESS)
+      continue;
+
+    pModule->mSlide = load - header.GetFileAddress();
+    pModule->mRebased = true;
+    changed = true;
+  }
+
+  if (changed)
+    UpdateRanges();
+}
+
+void AddressIndex::UpdateRanges()
+{
+  mRanges.clear();
+  for (int32 i = 0; i < mModules.size(); i++)
+  {
+    const Module* pModule = mModules[i];
+    if (!pModule->mRebased || pModule->mFunctions.empty())
+      continue;
+
+    Range range;
+    range.mStart = pModule->mFunctions.front().mStart + pModule->mSlide;
+    range.mEnd = pModule->mFunctions.back().mEnd + pModule->mSlide;
+    range.mpModule = pModule;
+    mRanges.push_back(range);
+  }
+  std::sort(mRanges.begin(), mRanges.end(), SortByStart<Range>);
+}
+
+bool AddressIndex::LookupLocked(lldb::addr_t address, Location& rLocation) const
+{
+  auto range = std::upper_bound(mRanges.begin(), mRanges.end(), address, CompareStart<Range>);
+  if (range == mRanges.begin())
+    return false;
+  --range;
+  if (address >= range->mEnd)
+    return false;
+
+  const Module& rModule(*range->mpModule);
+  lldb::addr_t file = address - rModule.mSlide;
+
+  auto function = std::upper_bound(rModule.mFunctions.begin(), rModule.mFunctions.end(), file, CompareStart<Function>);
+  if (function == rModule.mFunctions.begin())
+    return false;
+  --function;
+  if (file >= function->mEnd)
+    return false;
+
+  const SymbolIndex::Module& rSymbols(*rModule.mpSymbols);
+  rLocation.mFunction = rSymbols.mNames.Get(rSymbols.mSymbols[function->mSymbol].mName);
+
+  // Last line entry at or before the address, as long as it belongs to the same function:
+  auto line = std::upper_bound(rModule.mLines.begin(), rModule.mLines.end(), file, CompareAddress<Line>);
+  if (line != rModule.mLines.begin())
+  {
+    --line;
+    if (line->mAddress >= function->mStart)
+    {
+      const ModuleCache& rCache(*rModule.mpCache);
+      rLocation.mPath = rCache.GetString(rCache.GetFile(line->mFile).mPath);
+      rLocation.mLine = line->mLine;
+    }
+  }
+
+  return true;
+}
+
+bool AddressIndex::Lookup(lldb::addr_t address, Location& rLocation) const
+{
+  nglCriticalSectionGuard guard(mCS);
+  return LookupLocked(address, rLocation);
+}
+
+void AddressIndex::Lookup(const std::vector<lldb::addr_t>& rAddresses, std::vector<Location>& rLocations) const
+{
+  rLocations.resize(rAddresses.size());
+
+  nglCriticalSectionGuard guard(mCS);
+  for (int32 i = 0; i < rAddresses.size(); i++)
+  {
+    rLocations[i] = Location();
+    LookupLocked(rAddresses[i], rLocations[i]);
+  }
+}
+
+void AddressIndex::Symbolicate(lldb::SBProcess process, lldb::SBThread thread, std::vector<Frame>& rFrames, int32 max)
+{
+  Rebase(process.GetTarget());
+
+  int32 frames = thread.GetNumFrames();
+  if (max > 0 && frames > max)
+    frames = max;
+
+  rFrames.resize(frames);
+  std::vector<lldb::addr_t> pcs(frames);
+  {
+    XSPRAY_TRACE("SBThread::GetFrameAtIndex");
+    for (int32 i = 0; i < frames; i++)
+    {
+      rFrames[i] = Frame();
+      rFrames[i].mFrame = thread.GetFrameAtIndex(i);
+      rFrames[i].mPC = rFrames[i].mFrame.GetPC();
+      pcs[i] = rFrames[i].mPC;
+      if (i && pcs[i])
+        pcs[i]--;
+    }
+  }
+
+  std::vector<Location> locations;
+  {
+    XSPRAY_TRACE("AddressIndex::Lookup");
+    Lookup(pcs, locations);
+  }
+
+  for (int32 i = 0; i < frames; i++)
+  {
+    Frame& rFrame(rFrames[i]);
+    const Location& rLocation(locations[i]);
+    rFrame.mFunction = rLocation.mFunction;
+    if (rFrame.mFunction.IsEmpty() && rFrame.mFrame.GetFunctionName())
+      rFrame.mFunction = rFrame.mFrame.GetFunctionName();
+    rFrame.mPath = rLocation.mPath;
+    rFrame.mLine = rLocation.mLine;
+    if (!rFrame.mPath.IsEmpty())
+      continue;
+
+    // Not covered by the index, ask LLDB:
+    lldb::SBLineEntry entry = rFrame.mFrame.GetLineEntry();
+    lldb::SBFileSpec file = entry.GetFileSpec();
+    if (file.IsValid() && file.GetFilename())
+    {
+      nglPath p(file.GetDirectory());
+      p += nglString(file.GetFilename());
+      rFrame.mPath = p.GetPathName();
+      rFrame.mLine = entry.GetLine();
+      rFrame.mColumn = entry.GetColumn();
+    }
+  }
+}
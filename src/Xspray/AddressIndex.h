@@ -0,0 +1,88 @@
+//
+//  AddressIndex.h
+//  Xspray
+//
+
+#pragma once
+
+// Load address -> function and source line, through sorted interval tables built once per module and rebased by the
+// module's load slide. Lookups that miss are expected to fall back to LLDB.
+class AddressIndex
+{
+public:
+  struct Location
+  {
+    Location();
+
+    nglString mFunction; // Empty if the address is not covered by the index
+    nglString mPath;     // Empty if there is no line information
+    int32 mLine;
+  };
+
+  struct Frame
+  {
+    Frame();
+
+    lldb::SBFrame mFrame;
+    lldb::addr_t mPC;
+    nglString mFunction; // From the index, or from LLDB for the addresses it doesn't cover
+    nglString mPath;     // Empty if there is no line information
+    int32 mLine;
+    int32 mColumn;       // Only known when LLDB gave the line
+  };
+
+  AddressIndex();
+  ~AddressIndex();
+
+  void AddModule(const SymbolIndex::Module* pSymbols, const ModuleCache* pCache); // May be called from any thread
+  void RemoveModule(const ModuleCache* pCache); // Must happen before the module is removed from the symbol index
+  void Clear();
+  void Rebase(lldb::SBTarget target); // Compute the slide of the modules that were not loaded so far, starts over when the target runs another process. May be called from any thread
+
+  bool Lookup(lldb::addr_t address, Location& rLocation) const;
+  void Lookup(const std::vector<lldb::addr_t>& rAddresses, std::vector<Location>& rLocations) const;
+
+  // The first max frames of the thread (all of them if max is 0), looked up together. Caller frames are looked up by
+  // their call instruction and LLDB resolves what the index misses.
+  void Symbolicate(lldb::SBProcess process, lldb::SBThread thread, std::vector<Frame>& rFrames, int32 max = 0);
+
+private:
+  struct Function
+  {
+    lldb::addr_t mStart; // File addresses, the addresses between two functions are not covered
+    lldb::addr_t mEnd;
+    uint32 mSymbol;
+  };
+
+  struct Line
+  {
+    lldb::addr_t mAddress; // File address
+    uint32 mFile;          // Index in the module cache files
+    int32 mLine;
+  };
+
+  struct Module
+  {
+    const SymbolIndex::Module* mpSymbols;
+    const ModuleCache* mpCache;
+    std::vector<Function> mFunctions;
+    std::vector<Line> mLines;
+    bool mRebased;
+    lldb::addr_t mSlide;
+  };
+
+  struct Range
+  {
+    lldb::addr_t mStart; // Load addresses
+    lldb::addr_t mEnd;
+    const Module* mpModule;
+  };
+
+  bool LookupLocked(lldb::addr_t address, Location& rLocation) const;
+  void UpdateRanges(); // Must be called with mCS held
+
+  mutable nglCriticalSection mCS;
+  std::vector<Module*> mModules;
+  std::vector<Range> mRanges; // Rebased modules ordered by load address
+  uint32 mProcessID;          // Unique id of the process the slides were computed for, 0 if none
+};
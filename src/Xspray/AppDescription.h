@@ -16,6 +16,10 @@ public:
   static AppDescription* GetApp(int index);
   static void RemoveApp(int index);
 
+  // The registered apps are kept in a catalog on disk so that they don't have to be probed again on the next launch:
+  static bool LoadCatalog();
+  static bool SaveCatalog();
+
   bool IsValid() const;
 
   const nglString& GetName() const;
@@ -45,8 +49,15 @@ public:
 
 protected:
   AppDescription(const nglPath& rPath);
+  AppDescription(const nglPath& rPath, const msgpack_object& rEntry); // From the catalog
   virtual ~AppDescription();
 
+  void Init();
+  void Pack(msgpack_packer* pPacker) const;
+  static nglPath GetCatalogPath();
+  static nglPath GetExecutablePath(const nglPath& rPath); // The bundle's executable, or rPath if it is not a bundle
+  static double GetModificationTime(const nglPath& rPath); // Of the executable, rebuilding a bundle doesn't always touch its folder
+
   nglString mName;
   nglPath mLocalPath;
   nglPath mRemotePath;
@@ -63,7 +74,11 @@ protected:
   std::vector<nglString> mArguments;
   std::map<nglString, nglString> mEnvironement;
 
-  nuiTexture* mpIcon;
+  double mModificationTime; // Of the executable when it was probed
+  mutable nuiTexture* mpIcon;   // Created from the icon pixels on first use
+  int32 mIconWidth;
+  int32 mIconHeight;
+  std::vector<uint8> mIconPixels; // RGBA, already scaled for display
 
   bool LoadBundleIcon(const nglPath& rBundlePath);
 
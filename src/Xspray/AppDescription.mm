@@ -8,15 +8,45 @@
 
 #include "Xspray.h"
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
 using namespace Xspray;
 using namespace lldb;
 
+#define APP_CATALOG_VERSION 2
+#define APP_ICON_MAX_SIZE 1024
+
+// Catalog entry: [path, modification time, name, [[arch, vendor, os]], [arguments], {environment}, icon width, icon height, icon pixels]
+// Version 1 stored the triples as "arch-vendor-os" strings and the time of the bundle, its entries are probed again.
+enum
+{
+  eEntryPath,
+  eEntryModificationTime,
+  eEntryName,
+  eEntryTriples,
+  eEntryArguments,
+  eEntryEnvironment,
+  eEntryIconWidth,
+  eEntryIconHeight,
+  eEntryIconPixels,
+  eEntryCount
+};
+
 std::vector<AppDescription*> AppDescription::mApplications;
 
 int AppDescription::AddApp(const nglPath& rPath)
 {
+  for (int i = 0; i < mApplications.size(); i++)
+  {
+    if (mApplications[i]->GetLocalPath() == rPath)
+      return i;
+  }
+
   AppDescription* pApp = new AppDescription(rPath);
   mApplications.push_back(pApp);
+  SaveCatalog();
   return mApplications.size() - 1;
 }
 
@@ -35,36 +65,199 @@ void AppDescription::RemoveApp(int index)
 {
   NGL_ASSERT(index < mApplications.size());
   mApplications.erase(mApplications.begin() + index);
+  SaveCatalog();
 }
 
-bool AppDescription::IsValid() const
+nglPath AppDescription::GetCatalogPath()
 {
-  return !mArchitectures.empty() && mLocalPath.Exists();
+  nglPath p(ePathUserAppSettings);
+  p += nglString("Xspray");
+  p += nglString("Apps.msgpack");
+  return p;
 }
 
-AppDescription::AppDescription(const nglPath& rPath)
-: mLocalPath(rPath), mpIcon(NULL)
+nglPath AppDescription::GetExecutablePath(const nglPath& rPath)
 {
-  if (SetObjectClass("AppDescription"))
+  CFStringRef string = rPath.GetPathName().ToCFString();
+  NSBundle* bundle = [NSBundle bundleWithPath:(NSString*)string];
+  NSString* executable = bundle ? [bundle executablePath] : nil;
+  nglPath path(executable ? nglPath(nglString([executable UTF8String])) : rPath);
+  CFRelease(string);
+  return path;
+}
+
+double AppDescription::GetModificationTime(const nglPath& rPath)
+{
+  struct stat st;
+  if (stat(GetExecutablePath(rPath).GetChars(), &st))
+    return 0;
+  return (double)st.st_mtime;
+}
+
+bool AppDescription::LoadCatalog()
+{
+  nglPath path(GetCatalogPath());
+  int fd = open(path.GetChars(), O_RDONLY);
+  if (fd < 0)
+    return false;
+
+  struct stat st;
+  if (fstat(fd, &st) || !st.st_size)
   {
-    AddAttribute(new nuiAttribute<const nglString&>
-                 (nglString(_T("AppName")), nuiUnitNone,
-                  nuiMakeDelegate(this, &AppDescription::GetName)));
-    
-    AddAttribute(new nuiAttribute<const nglPath&>
-                 (nglString(_T("LocalPath")), nuiUnitNone,
-                  nuiMakeDelegate(this, &AppDescription::GetLocalPath)));
+    close(fd);
+    return false;
+  }
 
-    AddAttribute(new nuiAttribute<const nglPath&>
-                 (nglString(_T("RemotePath")), nuiUnitNone,
-                  nuiMakeDelegate(this, &AppDescription::GetRemotePath)));
+  void* pMapping = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (pMapping == MAP_FAILED)
+    return false;
+
+  msgpack_unpacked unpacked;
+  msgpack_unpacked_init(&unpacked);
+  bool res = msgpack_unpack_next(&unpacked, (const char*)pMapping, st.st_size, NULL);
+  const msgpack_object& rRoot(unpacked.data);
+  res = res && rRoot.type == MSGPACK_OBJECT_ARRAY && rRoot.via.array.size == 2
+    && rRoot.via.array.ptr[0].type == MSGPACK_OBJECT_POSITIVE_INTEGER && rRoot.via.array.ptr[0].via.u64 >= 1
+    && rRoot.via.array.ptr[0].via.u64 <= APP_CATALOG_VERSION && rRoot.via.array.ptr[1].type == MSGPACK_OBJECT_ARRAY;
+
+  // The entries of an older catalog only give back the user's settings:
+  bool stale = res && rRoot.via.array.ptr[0].via.u64 != APP_CATALOG_VERSION;
+  bool changed = stale;
+  if (res)
+  {
+    const msgpack_object_array& rEntries(rRoot.via.array.ptr[1].via.array);
+    for (uint32 i = 0; i < rEntries.size; i++)
+    {
+      const msgpack_object& rEntry(rEntries.ptr[i]);
+      if (rEntry.type != MSGPACK_OBJECT_ARRAY || rEntry.via.array.size != eEntryCount)
+        continue;
 
-    AddAttribute(new nuiAttribute<const nglString&>
-                 (nglString(_T("Architecture")), nuiUnitNone,
-                  nuiMakeDelegate(this, &AppDescription::GetArchitecture)));
+      nglPath app(UnpackString(rEntry.via.array.ptr[eEntryPath]));
+      double time = GetModificationTime(app);
+      if (time == 0)
+      {
+        // Gone since the last session:
+        changed = true;
+        continue;
+      }
+
+      AppDescription* pApp = NULL;
+      const msgpack_object& rTime(rEntry.via.array.ptr[eEntryModificationTime]);
+      if (!stale && rTime.type == MSGPACK_OBJECT_DOUBLE && rTime.via.dec == time)
+      {
+        pApp = new AppDescription(app, rEntry);
+      }
+      else
+      {
+        // Rebuilt since the last session, probe it again but keep the user's settings:
+        pApp = new AppDescription(app);
+        AppDescription* pCached = new AppDescription(app, rEntry);
+        pApp->mArguments = pCached->mArguments;
+        pApp->mEnvironement = pCached->mEnvironement;
+        delete pCached;
+        changed = true;
+      }
+      mApplications.push_back(pApp);
+    }
+  }
+
+  msgpack_unpacked_destroy(&unpacked);
+  munmap(pMapping, st.st_size);
+
+  if (changed)
+    SaveCatalog();
+  return res;
+}
+
+bool AppDescription::SaveCatalog()
+{
+  msgpack_sbuffer buffer;
+  msgpack_sbuffer_init(&buffer);
+  msgpack_packer packer;
+  msgpack_packer_init(&packer, &buffer, msgpack_sbuffer_write);
+
+  msgpack_pack_array(&packer, 2);
+  msgpack_pack_uint32(&packer, APP_CATALOG_VERSION);
+  msgpack_pack_array(&packer, mApplications.size());
+  for (int i = 0; i < mApplications.size(); i++)
+    mApplications[i]->Pack(&packer);
+
+  nglPath path(GetCatalogPath());
+  nglPath folder(path.GetParent());
+  folder.Create(true);
+
+  nglString tmp(path.GetPathName());
+  tmp.Add(".tmp");
+
+  size_t written = 0;
+  int fd = open(tmp.GetChars(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd >= 0)
+  {
+    while (written < buffer.size)
+    {
+      ssize_t res = write(fd, buffer.data + written, buffer.size - written);
+      if (res <= 0)
+        break;
+      written += res;
+    }
+    close(fd);
+  }
+
+  bool res = fd >= 0 && written == buffer.size && !rename(tmp.GetChars(), path.GetChars());
+  if (!res)
+  {
+    NGL_OUT("Unable to save the application catalog to %s\n", path.GetChars());
+    unlink(tmp.GetChars());
+  }
+
+  msgpack_sbuffer_destroy(&buffer);
+  return res;
+}
+
+void AppDescription::Pack(msgpack_packer* pPacker) const
+{
+  msgpack_pack_array(pPacker, eEntryCount);
+  PackString(*pPacker, mLocalPath.GetPathName());
+  msgpack_pack_double(pPacker, mModificationTime);
+  PackString(*pPacker, mName);
+
+  msgpack_pack_array(pPacker, mArchitectures.size());
+  for (int32 i = 0; i < mArchitectures.size(); i++)
+  {
+    msgpack_pack_array(pPacker, 3);
+    PackString(*pPacker, mArchitectures[i]);
+    PackString(*pPacker, mVendors[i]);
+    PackString(*pPacker, mTargetOSes[i]);
   }
 
-  DebuggerContext& rContext(GetDebuggerContext());
+  msgpack_pack_array(pPacker, mArguments.size());
+  for (int32 i = 0; i < mArguments.size(); i++)
+    PackString(*pPacker, mArguments[i]);
+
+  msgpack_pack_map(pPacker, mEnvironement.size());
+  for (auto it = mEnvironement.begin(); it != mEnvironement.end(); ++it)
+  {
+    PackString(*pPacker, it->first);
+    PackString(*pPacker, it->second);
+  }
+
+  msgpack_pack_int32(pPacker, mIconWidth);
+  msgpack_pack_int32(pPacker, mIconHeight);
+  msgpack_pack_raw(pPacker, mIconPixels.size());
+  if (!mIconPixels.empty())
+    msgpack_pack_raw_body(pPacker, &mIconPixels[0], mIconPixels.size());
+}
+
+bool AppDescription::IsValid() const
+{
+  return !mArchitectures.empty() && mLocalPath.Exists();
+}
+
+AppDescription::AppDescription(const nglPath& rPath)
+: mLocalPath(rPath), mModificationTime(GetModificationTime(rPath)), mpIcon(NULL), mIconWidth(0), mIconHeight(0)
+{
+  Init();
 
   nglPath p = rPath.GetNodeName();
   mName = p.GetRemovedExtension();
@@ -80,6 +273,8 @@ AppDescription::AppDescription(const nglPath& rPath)
     std::vector<nglString> tokens;
     nglString triplestr = triple;
     triplestr.Tokenize(tokens, '-');
+    if (tokens.size() < 3)
+      continue;
     NGL_OUT("%s -> '%s' '%s' '%s'\n", triple, tokens[0].GetChars(), tokens[1].GetChars(), tokens[2].GetChars());
     mArchitectures.push_back(tokens[0]);
     mVendors.push_back(tokens[1]);
@@ -96,6 +291,87 @@ AppDescription::AppDescription(const nglPath& rPath)
   LoadBundleIcon(rPath);
 }
 
+AppDescription::AppDescription(const nglPath& rPath, const msgpack_object& rEntry)
+: mLocalPath(rPath), mModificationTime(0), mpIcon(NULL), mIconWidth(0), mIconHeight(0)
+{
+  Init();
+
+  const msgpack_object* pFields = rEntry.via.array.ptr;
+  if (pFields[eEntryModificationTime].type == MSGPACK_OBJECT_DOUBLE)
+    mModificationTime = pFields[eEntryModificationTime].via.dec;
+  mName = UnpackString(pFields[eEntryName]);
+
+  if (pFields[eEntryTriples].type == MSGPACK_OBJECT_ARRAY)
+  {
+    const msgpack_object_array& rTriples(pFields[eEntryTriples].via.array);
+    for (uint32 i = 0; i < rTriples.size; i++)
+    {
+      const msgpack_object& rTriple(rTriples.ptr[i]);
+      if (rTriple.type != MSGPACK_OBJECT_ARRAY || rTriple.via.array.size != 3)
+        continue;
+      mArchitectures.push_back(UnpackString(rTriple.via.array.ptr[0]));
+      mVendors.push_back(UnpackString(rTriple.via.array.ptr[1]));
+      mTargetOSes.push_back(UnpackString(rTriple.via.array.ptr[2]));
+    }
+  }
+
+  if (!mArchitectures.empty())
+  {
+    mArchitecture = mArchitectures.front();
+    mVendor = mVendors.front();
+    mTargetOS = mTargetOSes.front();
+  }
+
+  if (pFields[eEntryArguments].type == MSGPACK_OBJECT_ARRAY)
+  {
+    const msgpack_object_array& rArguments(pFields[eEntryArguments].via.array);
+    for (uint32 i = 0; i < rArguments.size; i++)
+      mArguments.push_back(UnpackString(rArguments.ptr[i]));
+  }
+
+  if (pFields[eEntryEnvironment].type == MSGPACK_OBJECT_MAP)
+  {
+    const msgpack_object_map& rEnvironment(pFields[eEntryEnvironment].via.map);
+    for (uint32 i = 0; i < rEnvironment.size; i++)
+      mEnvironement[UnpackString(rEnvironment.ptr[i].key)] = UnpackString(rEnvironment.ptr[i].val);
+  }
+
+  const msgpack_object& rPixels(pFields[eEntryIconPixels]);
+  const msgpack_object& rWidth(pFields[eEntryIconWidth]);
+  const msgpack_object& rHeight(pFields[eEntryIconHeight]);
+  if (rPixels.type == MSGPACK_OBJECT_RAW && rWidth.type == MSGPACK_OBJECT_POSITIVE_INTEGER && rHeight.type == MSGPACK_OBJECT_POSITIVE_INTEGER
+      && rWidth.via.u64 > 0 && rWidth.via.u64 <= APP_ICON_MAX_SIZE && rHeight.via.u64 > 0 && rHeight.via.u64 <= APP_ICON_MAX_SIZE
+      && rPixels.via.raw.size == (size_t)rWidth.via.u64 * (size_t)rHeight.via.u64 * 4)
+  {
+    mIconWidth = (int32)rWidth.via.u64;
+    mIconHeight = (int32)rHeight.via.u64;
+    mIconPixels.assign((const uint8*)rPixels.via.raw.ptr, (const uint8*)rPixels.via.raw.ptr + rPixels.via.raw.size);
+  }
+}
+
+void AppDescription::Init()
+{
+  if (SetObjectClass("AppDescription"))
+  {
+    AddAttribute(new nuiAttribute<const nglString&>
+                 (nglString(_T("AppName")), nuiUnitNone,
+                  nuiMakeDelegate(this, &AppDescription::GetName)));
+    
+    AddAttribute(new nuiAttribute<const nglPath&>
+                 (nglString(_T("LocalPath")), nuiUnitNone,
+                  nuiMakeDelegate(this, &AppDescription::GetLocalPath)));
+
+    AddAttribute(new nuiAttribute<const nglPath&>
+                 (nglString(_T("RemotePath")), nuiUnitNone,
+                  nuiMakeDelegate(this, &AppDescription::GetRemotePath)));
+
+    AddAttribute(new nuiAttribute<const nglString&>
+                 (nglString(_T("Architecture")), nuiUnitNone,
+                  nuiMakeDelegate(this, &AppDescription::GetArchitecture)));
+  }
+
+}
+
 AppDescription::~AppDescription()
 {
   if (mpIcon)
@@ -119,6 +395,20 @@ const std::vector<nglString>& AppDescription::GetTargetOSes() const
 
 nuiTexture* AppDescription::GetIcon() const
 {
+  if (!mpIcon && !mIconPixels.empty())
+  {
+    nglImageInfo info;
+    info.mBufferFormat = eImageFormatRaw;
+    info.mPixelFormat = nglImagePixelFormat::eImagePixelRGBA;
+    info.mBitDepth = 32;
+    info.mBytesPerPixel = 4;
+    info.mBytesPerLine = mIconWidth * 4;
+    info.mWidth = mIconWidth;
+    info.mHeight = mIconHeight;
+    info.mpBuffer = (char*)&mIconPixels[0];
+    mpIcon = nuiTexture::GetTexture(info);
+    mpIcon->SetScale(nuiGetScaleFactor());
+  }
   return mpIcon;
 }
 
@@ -286,12 +576,18 @@ bool AppDescription::LoadBundleIcon(const nglPath& rBundlePath)
   {
     nglImageInfo info;
     ConvertNSImage(image, info);
-    mpIcon = nuiTexture::GetTexture(info);
-    mpIcon->SetScale(nuiGetScaleFactor());
+
+    // Keep the pixels tightly packed for the catalog, the texture is created from them when needed:
+    mIconWidth = info.mWidth;
+    mIconHeight = info.mHeight;
+    size_t line = (size_t)mIconWidth * 4;
+    mIconPixels.resize(line * mIconHeight);
+    for (int32 y = 0; y < mIconHeight; y++)
+      memcpy(&mIconPixels[y * line], info.mpBuffer + y * info.mBytesPerLine, line);
 
 //    [image release];
   }
   //CFRelease(string);
-  return mpIcon != NULL;
+  return !mIconPixels.empty();
 }
 
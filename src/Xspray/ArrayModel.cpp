@@ -90,11 +90,59 @@ MemoryArray::MemoryArray(float* pData, int32 length)
     mArray[i] = (float)pData[i];
 }
 
+MemoryArray::MemoryArray(const uint8* pData, int32 length, uint32 stride, const TypeLayout::Field& rField)
+{
+  mArray.resize(length);
+  for (int32 i = 0; i < length; ++i)
+    mArray[i] = (float)TypeLayout::Decode(rField, pData + i * stride);
+}
+
 MemoryArray::MemoryArray(lldb::SBValue value)
 {
 }
 
 
+/////////////////////////
+RingArray::RingArray(int32 capacity)
+: mCount(0)
+{
+  mArray.resize(MAX(capacity, 1));
+}
+
+RingArray::~RingArray()
+{
+}
+
+int32 RingArray::GetNumValues() const
+{
+  return MIN(mCount, (int64)mArray.size());
+}
+
+void RingArray::GetValues(std::vector<float>& rValues, int32 index, int32 length) const
+{
+  rValues.resize(length);
+  for (int32 i = 0; i < length; ++i)
+    rValues[i] = GetValue(index + i);
+}
+
+float RingArray::GetValue(int32 index) const
+{
+  int64 first = mCount - GetNumValues();
+  return mArray[(first + index) % mArray.size()];
+}
+
+void RingArray::Push(float value)
+{
+  mArray[mCount % mArray.size()] = value;
+  mCount++;
+}
+
+void RingArray::Clear()
+{
+  mCount = 0;
+}
+
+
 // class ValueArray : public ArrayModel
 
 
@@ -71,6 +71,7 @@ public:
   MemoryArray(const int32* pData, int32 length);
   MemoryArray(const int64* pData, int32 length);
   MemoryArray(float* pData, int32 length);
+  MemoryArray(const uint8* pData, int32 length, uint32 stride, const TypeLayout::Field& rField); // One member of an array of structs
 
   MemoryArray(lldb::SBValue value);
 
@@ -98,3 +99,22 @@ protected:
 
 };
 
+
+// The last values pushed, oldest first. Written and read on the same thread.
+class RingArray : public ArrayModel<float>
+{
+public:
+  RingArray(int32 capacity);
+  virtual ~RingArray();
+
+  virtual int32 GetNumValues() const;
+  virtual void GetValues(std::vector<float>& rValues, int32 index, int32 length) const;
+  virtual float GetValue(int32 index) const;
+
+  void Push(float value); // Drops the oldest value once full
+  void Clear();
+
+protected:
+  std::vector<float> mArray;
+  int64 mCount; // Values pushed since the last Clear
+};
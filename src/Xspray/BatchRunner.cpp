@@ -0,0 +1,668 @@
+//
+//  BatchRunner.cpp
+//  Xspray
+//
+
+#include "Xspray.h"
+
+#include <unistd.h>
+
+using namespace Xspray;
+using namespace lldb;
+
+nglString Xspray::JSONQuote(const nglString& rString)
+{
+  std::string str(rString.GetStdString());
+  std::string quoted("\"");
+  for (size_t i = 0; i < str.size(); i++)
+  {
+    unsigned char c = str[i];
+    switch (c)
+    {
+      case '"': quoted += "\\\""; break;
+      case '\\': quoted += "\\\\"; break;
+      case '\n': quoted += "\\n"; break;
+      case '\r': quoted += "\\r"; break;
+      case '\t': quoted += "\\t"; break;
+      default:
+        if (c < 0x20)
+        {
+          char escape[8];
+          snprintf(escape, sizeof(escape), "\\u%04x", c);
+          quoted += escape;
+        }
+        else
+        {
+          quoted += c;
+        }
+        break;
+    }
+  }
+  quoted += '"';
+  return nglString(quoted.c_str());
+}
+
+static nglString JSONQuote(const char* pString)
+{
+  return JSONQuote(nglString(pString ? pString : ""));
+}
+
+//////// BatchRunner::Phase
+BatchRunner::Phase::Phase()
+: mCount(0), mTime(0)
+{
+}
+
+//////// BatchRunner
+BatchRunner::BatchRunner(DebuggerContext& rContext, FILE* pOutput)
+: mrContext(rContext), mpOutput(pOutput), mTimeout(30), mLine(0), mExecuted(0), mErrors(0)
+{
+  mStart = nglTime();
+
+  mCommands["load"] = &BatchRunner::Load;
+  mCommands["core"] = &BatchRunner::Core;
+  mCommands["break"] = &BatchRunner::Break;
+  mCommands["logpoint"] = &BatchRunner::Logpoint;
+  mCommands["log"] = &BatchRunner::Log;
+  mCommands["watch"] = &BatchRunner::Watch;
+  mCommands["watches"] = &BatchRunner::Watches;
+  mCommands["run"] = &BatchRunner::Run;
+  mCommands["continue"] = &BatchRunner::Continue;
+  mCommands["stack"] = &BatchRunner::Stack;
+  mCommands["vars"] = &BatchRunner::Vars;
+  mCommands["profile"] = &BatchRunner::Profile;
+  mCommands["kill"] = &BatchRunner::Kill;
+  mCommands["timeout"] = &BatchRunner::Timeout;
+  mCommands["trace"] = &BatchRunner::Trace;
+  mCommands["record"] = &BatchRunner::Record;
+}
+
+BatchRunner::~BatchRunner()
+{
+}
+
+int32 BatchRunner::GetErrorCount() const
+{
+  return mErrors;
+}
+
+bool BatchRunner::RunFile(const nglPath& rPath)
+{
+  nglIStream* pStream = rPath.OpenRead();
+  if (!pStream)
+  {
+    fprintf(mpOutput, "{\"error\":%s}\n", JSONQuote("Unable to read " + rPath.GetPathName()).GetChars());
+    mErrors++;
+    return false;
+  }
+
+  bool res = true;
+  nglString line;
+  while (pStream->ReadLine(line))
+    res = RunCommand(line) && res;
+
+  delete pStream;
+  return res;
+}
+
+bool BatchRunner::RunCommand(const nglString& rLine)
+{
+  mLine++;
+
+  nglString line(rLine);
+  line.Trim("\n\r");
+  line.Trim();
+  if (line.IsEmpty() || line[0] == '#')
+    return true;
+
+  std::vector<nglString> tokens;
+  line.Tokenize(tokens, ' ');
+  std::vector<nglString> args;
+  for (int32 i = 1; i < tokens.size(); i++)
+  {
+    if (!tokens[i].IsEmpty())
+      args.push_back(tokens[i]);
+  }
+
+  nglString result;
+  bool res = false;
+  mExecuted++;
+  double start = nglTime();
+  auto it = mCommands.find(tokens[0]);
+  if (it == mCommands.end())
+    result = "\"error\":" + JSONQuote("Unknown command");
+  else
+    res = (this->*(it->second))(args, result);
+  double time = (double)nglTime() - start;
+
+  Phase& rPhase(mPhases[tokens[0]]);
+  rPhase.mCount++;
+  rPhase.mTime += time;
+  if (!res)
+    mErrors++;
+
+  fprintf(mpOutput, "{\"line\":%d,\"command\":%s,\"ok\":%s,\"ms\":%.3f%s%s}\n", mLine, JSONQuote(tokens[0]).GetChars(),
+          res ? "true" : "false", time * 1000.0, result.IsEmpty() ? "" : ",", result.GetChars());
+  fflush(mpOutput);
+  return res;
+}
+
+void BatchRunner::WriteSummary()
+{
+  nglString phases;
+  for (auto it = mPhases.begin(); it != mPhases.end(); ++it)
+  {
+    nglString phase;
+    phase.CFormat("%s%s:{\"count\":%d,\"ms\":%.3f}", phases.IsEmpty() ? "" : ",", JSONQuote(it->first).GetChars(),
+                  it->second.mCount, it->second.mTime * 1000.0);
+    phases.Add(phase);
+  }
+
+  fprintf(mpOutput, "{\"summary\":{\"commands\":%d,\"errors\":%d,\"ms\":%.3f,\"phases\":{%s}}}\n", mExecuted, mErrors,
+          ((double)nglTime() - mStart) * 1000.0, phases.GetChars());
+  fflush(mpOutput);
+}
+
+bool BatchRunner::Load(const std::vector<nglString>& rArgs, nglString& rResult)
+{
+  if (rArgs.empty())
+  {
+    rResult = "\"error\":" + JSONQuote("Usage: load <path> [arch]");
+    return false;
+  }
+
+  nglString arch;
+  if (rArgs.size() > 1)
+    arch = rArgs[1];
+
+  if (!mrContext.LoadTarget(nglPath(rArgs[0]), arch))
+  {
+    rResult = "\"error\":" + JSONQuote("Unable to create the target");
+    return false;
+  }
+
+  rResult.CFormat("\"modules\":%d", mrContext.GetModuleSlotCount());
+  return true;
+}
+
+bool BatchRunner::Core(const std::vector<nglString>& rArgs, nglString& rResult)
+{
+  if (rArgs.empty())
+  {
+    rResult = "\"error\":" + JSONQuote("Usage: core <path> [executable]");
+    return false;
+  }
+
+  nglPath executable;
+  if (rArgs.size() > 1)
+    executable = nglPath(rArgs[1]);
+
+  if (!mrContext.LoadCore(nglPath(rArgs[0]), executable))
+  {
+    rResult = "\"error\":" + JSONQuote("Unable to load the core file");
+    return false;
+  }
+
+  const CoreFile& rCore(mrContext.mCore);
+  rResult.CFormat("\"modules\":%d,\"threads\":%d,\"mapped\":%llu,\"segments\":%d", mrContext.GetModuleSlotCount(),
+                  mrContext.mProcess.GetNumThreads(), rCore.GetSize(), rCore.GetSegmentCount());
+  return true;
+}
+
+bool BatchRunner::Break(const std::vector<nglString>& rArgs, nglString& rResult)
+{
+  if (rArgs.empty() || !mrContext.mTarget.IsValid())
+  {
+    rResult = "\"error\":" + JSONQuote("Usage: break <file>:<line> | break <symbol>, after load");
+    return false;
+  }
+
+  Breakpoint* pBreakpoint = CreateBreakpoint(rArgs[0]);
+  if (!pBreakpoint || !pBreakpoint->IsValid())
+  {
+    rResult = "\"error\":" + JSONQuote("Unable to create the breakpoint");
+    return false;
+  }
+
+  rResult.CFormat("\"id\":%d,\"locations\":%d", pBreakpoint->GetBreakpoint().GetID(), (int32)pBreakpoint->GetBreakpoint().GetNumLocations());
+  return true;
+}
+
+Breakpoint* BatchRunner::CreateBreakpoint(const nglString& rLocation)
+{
+  int32 pos = rLocation.FindLast(':');
+  if (pos > 0 && rLocation.Extract(pos + 1).GetCInt() > 0)
+    return mrContext.CreateBreakpointByLocation(nglPath(rLocation.GetLeft(pos)), rLocation.Extract(pos + 1).GetCInt(), 0);
+  return mrContext.CreateBreakpointByName(rLocation);
+}
+
+bool BatchRunner::Logpoint(const std::vector<nglString>& rArgs, nglString& rResult)
+{
+  if (rArgs.size() < 2 || !mrContext.mTarget.IsValid())
+  {
+    rResult = "\"error\":" + JSONQuote("Usage: logpoint <file>:<line> | <symbol> <expression>..., after load");
+    return false;
+  }
+
+  Breakpoint* pBreakpoint = CreateBreakpoint(rArgs[0]);
+  if (!pBreakpoint || !pBreakpoint->IsValid())
+  {
+    rResult = "\"error\":" + JSONQuote("Unable to create the logpoint");
+    return false;
+  }
+
+  pBreakpoint->SetLogExpressions(std::vector<nglString>(rArgs.begin() + 1, rArgs.end()));
+  rResult.CFormat("\"id\":%d,\"locations\":%d", pBreakpoint->GetBreakpoint().GetID(), (int32)pBreakpoint->GetBreakpoint().GetNumLocations());
+  return true;
+}
+
+bool BatchRunner::Log(const std::vector<nglString>& rArgs, nglString& rResult)
+{
+  uint32 max = rArgs.empty() ? UINT32_MAX : rArgs[0].GetCInt();
+  std::vector<LogBuffer::Entry> entries;
+  mrContext.mLogBuffer.Read(entries, max);
+
+  rResult.CFormat("\"written\":%llu,\"dropped\":%llu,\"lines\":[", mrContext.mLogBuffer.GetWritten(), mrContext.mLogBuffer.GetDropped());
+  for (int32 i = 0; i < entries.size(); i++)
+  {
+    const LogBuffer::Entry& rEntry(entries[i]);
+    nglString str;
+    str.CFormat("%s{\"breakpoint\":%d,\"thread\":%llu,\"text\":%s}", i ? "," : "", rEntry.mBreakpointID, rEntry.mThreadID,
+                JSONQuote(rEntry.mText).GetChars());
+    rResult.Add(str);
+  }
+  rResult.Add("]");
+  return true;
+}
+
+bool BatchRunner::Watch(const std::vector<nglString>& rArgs, nglString& rResult)
+{
+  if (rArgs.size() != 1)
+  {
+    rResult = "\"error\":" + JSONQuote("Usage: watch <expression>");
+    return false;
+  }
+
+  SBFrame frame = mrContext.mProcess.GetSelectedThread().GetSelectedFrame();
+  Breakpoint* pWatchpoint = mrContext.CreateWatchpoint(rArgs[0], frame);
+  if (!pWatchpoint)
+  {
+    rResult = "\"error\":" + JSONQuote("Unable to watch " + rArgs[0]);
+    return false;
+  }
+
+  rResult.CFormat("\"address\":%llu,\"size\":%u", pWatchpoint->GetWatchAddress(), pWatchpoint->GetWatchSize());
+  return true;
+}
+
+bool BatchRunner::Watches(const std::vector<nglString>& rArgs, nglString& rResult)
+{
+  std::vector<Breakpoint*> watchpoints;
+  mrContext.GetWatchpoints(watchpoints);
+
+  rResult = "\"watchpoints\":[";
+  for (int32 i = 0; i < watchpoints.size(); i++)
+  {
+    std::vector<Breakpoint::WatchHit> hits;
+    watchpoints[i]->GetWatchHits(hits);
+
+    nglString str;
+    str.CFormat("%s{\"expression\":%s,\"dropped\":%llu,\"hits\":[", i ? "," : "", JSONQuote(watchpoints[i]->GetSymbol()).GetChars(),
+                watchpoints[i]->GetDroppedWatchHits());
+    rResult.Add(str);
+    for (int32 h = 0; h < hits.size(); h++)
+    {
+      const Breakpoint::WatchHit& rHit(hits[h]);
+      str.CFormat("%s{\"thread\":%llu,\"pc\":%llu,\"old\":%llu,\"new\":%llu}", h ? "," : "", rHit.mThreadID, rHit.mPC,
+                  rHit.mOldValue, rHit.mNewValue);
+      rResult.Add(str);
+    }
+    rResult.Add("]}");
+  }
+  rResult.Add("]");
+  return true;
+}
+
+bool BatchRunner::Run(const std::vector<nglString>& rArgs, nglString& rResult)
+{
+  if (!mrContext.mTarget.IsValid())
+  {
+    rResult = "\"error\":" + JSONQuote("No target, use load first");
+    return false;
+  }
+
+  std::vector<std::string> strings;
+  for (int32 i = 0; i < rArgs.size(); i++)
+    strings.push_back(rArgs[i].GetStdString());
+  std::vector<const char*> argv;
+  for (int32 i = 0; i < strings.size(); i++)
+    argv.push_back(strings[i].c_str());
+  argv.push_back(NULL);
+
+  SBError error;
+  SBListener listener = mrContext.mDebugger.GetListener();
+  mrContext.mProcess = mrContext.mTarget.Launch(listener, &argv[0], NULL, NULL, NULL, NULL, NULL, 0, false, error);
+  if (!mrContext.mProcess.IsValid() || error.Fail())
+  {
+    rResult = "\"error\":" + JSONQuote(error.GetCString());
+    return false;
+  }
+
+  return WaitForStop(rResult);
+}
+
+bool BatchRunner::Continue(const std::vector<nglString>& rArgs, nglString& rResult)
+{
+  if (!mrContext.mProcess.IsValid())
+  {
+    rResult = "\"error\":" + JSONQuote("No process");
+    return false;
+  }
+
+  SBError error = mrContext.mProcess.Continue();
+  if (error.Fail())
+  {
+    rResult = "\"error\":" + JSONQuote(error.GetCString());
+    return false;
+  }
+
+  return WaitForStop(rResult);
+}
+
+bool BatchRunner::WaitForStop(nglString& rResult)
+{
+  StateType state = mrContext.WaitForStop(mTimeout);
+  switch (state)
+  {
+    case eStateStopped:
+    case eStateSuspended:
+    case eStateCrashed:
+      {
+        SBThread thread = mrContext.mProcess.GetSelectedThread();
+        char reason[256] = { 0 };
+        thread.GetStopDescription(reason, sizeof(reason));
+        rResult.CFormat("\"state\":\"stopped\",\"thread\":%llu,\"reason\":%s", (uint64)thread.GetThreadID(), JSONQuote(reason).GetChars());
+
+        if (mrContext.mRecorder.IsOpen() && !mrContext.mRecorder.RecordStop(mrContext.mProcess))
+        {
+          rResult = "\"error\":" + JSONQuote("Unable to record the stop");
+          return false;
+        }
+      }
+      return true;
+
+    case eStateExited:
+      rResult.CFormat("\"state\":\"exited\",\"status\":%d", mrContext.mProcess.GetExitStatus());
+      return true;
+
+    case eStateInvalid:
+      rResult = "\"error\":" + JSONQuote("Timeout");
+      return false;
+
+    default:
+      rResult = "\"state\":\"detached\"";
+      return true;
+  }
+}
+
+bool BatchRunner::Stack(const std::vector<nglString>& rArgs, nglString& rResult)
+{
+  SBProcess process = mrContext.mProcess;
+  if (!process.IsValid() || !SBDebugger::StateIsStoppedState(process.GetState()))
+  {
+    rResult = "\"error\":" + JSONQuote("The process is not stopped");
+    return false;
+  }
+
+  int32 maxframes = rArgs.empty() ? 0 : rArgs[0].GetCInt();
+
+  rResult = "\"threads\":[";
+  int32 threads = process.GetNumThreads();
+  for (int32 t = 0; t < threads; t++)
+  {
+    SBThread thread = process.GetThreadAtIndex(t);
+    std::vector<AddressIndex::Frame> frames;
+    mrContext.mAddressIndex.Symbolicate(process, thread, frames, maxframes);
+
+    nglString str;
+    str.CFormat("%s{\"id\":%llu,\"frames\":[", t ? "," : "", (uint64)thread.GetThreadID());
+    rResult.Add(str);
+    for (int32 i = 0; i < frames.size(); i++)
+    {
+      const AddressIndex::Frame& rFrame(frames[i]);
+      str.CFormat("%s{\"pc\":\"0x%llx\",\"function\":%s,\"file\":%s,\"line\":%d}", i ? "," : "", (uint64)rFrame.mPC,
+                  JSONQuote(rFrame.mFunction).GetChars(), JSONQuote(rFrame.mPath).GetChars(), rFrame.mLine);
+      rResult.Add(str);
+    }
+    rResult.Add("]}");
+  }
+  rResult.Add("]");
+  return true;
+}
+
+bool BatchRunner::Vars(const std::vector<nglString>& rArgs, nglString& rResult)
+{
+  SBProcess process = mrContext.mProcess;
+  if (!process.IsValid() || !SBDebugger::StateIsStoppedState(process.GetState()))
+  {
+    rResult = "\"error\":" + JSONQuote("The process is not stopped");
+    return false;
+  }
+
+  int32 depth = rArgs.empty() ? 1 : rArgs[0].GetCInt();
+  SBFrame frame = process.GetSelectedThread().GetSelectedFrame();
+  SBValueList values = frame.GetVariables(true, true, true, true);
+
+  rResult = "\"variables\":[";
+  for (uint32 i = 0; i < values.GetSize(); i++)
+  {
+    if (i)
+      rResult.Add(",");
+    AddValue(values.GetValueAtIndex(i), depth, rResult);
+  }
+  rResult.Add("]");
+  return true;
+}
+
+void BatchRunner::AddValue(SBValue value, int32 depth, nglString& rResult)
+{
+  nglString str;
+  str.CFormat("{\"name\":%s,\"type\":%s,\"value\":%s", JSONQuote(value.GetName()).GetChars(),
+              JSONQuote(value.GetTypeName()).GetChars(), JSONQuote(value.GetValue()).GetChars());
+  rResult.Add(str);
+
+  if (value.GetSummary())
+    rResult.Add(",\"summary\":" + JSONQuote(value.GetSummary()));
+
+  uint32 children = value.GetNumChildren();
+  if (children)
+  {
+    str.CFormat(",\"children\":%d", children);
+    rResult.Add(str);
+  }
+
+  if (children && depth > 0)
+  {
+    rResult.Add(",\"members\":[");
+    for (uint32 i = 0; i < children; i++)
+    {
+      if (i)
+        rResult.Add(",");
+      AddValue(value.GetChildAtIndex(i), depth - 1, rResult);
+    }
+    rResult.Add("]");
+  }
+
+  rResult.Add("}");
+}
+
+bool BatchRunner::Kill(const std::vector<nglString>& rArgs, nglString& rResult)
+{
+  if (!mrContext.mProcess.IsValid())
+    return true;
+
+  SBError error = mrContext.mProcess.Kill();
+  mrContext.mProcess.Clear();
+  if (error.Fail())
+  {
+    rResult = "\"error\":" + JSONQuote(error.GetCString());
+    return false;
+  }
+  return true;
+}
+
+bool BatchRunner::Timeout(const std::vector<nglString>& rArgs, nglString& rResult)
+{
+  if (rArgs.empty() || rArgs[0].GetCDouble() <= 0)
+  {
+    rResult = "\"error\":" + JSONQuote("Usage: timeout <seconds>");
+    return false;
+  }
+
+  mTimeout = rArgs[0].GetCDouble();
+  return true;
+}
+
+static void AddSelfSamples(const Profiler::Node& rNode, std::map<nglString, uint32>& rSelf)
+{
+  if (rNode.mSelf)
+    rSelf[rNode.mFunction] += rNode.mSelf;
+  for (auto it = rNode.mChildren.begin(); it != rNode.mChildren.end(); ++it)
+    AddSelfSamples(it->second, rSelf);
+}
+
+static bool HeavierSelf(const std::pair<nglString, uint32>& rA, const std::pair<nglString, uint32>& rB)
+{
+  return rA.second > rB.second;
+}
+
+bool BatchRunner::Profile(const std::vector<nglString>& rArgs, nglString& rResult)
+{
+  SBProcess process = mrContext.mProcess;
+  if (rArgs.empty() || !process.IsValid() || !SBDebugger::StateIsStoppedState(process.GetState()))
+  {
+    rResult = "\"error\":" + JSONQuote("Usage: profile <seconds> [hz] [depth] [folded path], on a stopped process");
+    return false;
+  }
+
+  Profiler& rProfiler(mrContext.mProfiler);
+  rProfiler.SetRate(rArgs.size() > 1 ? rArgs[1].GetCDouble() : 100);
+  rProfiler.SetMaxDepth(rArgs.size() > 2 ? rArgs[2].GetCInt() : 128);
+  rProfiler.Clear();
+
+  process.Continue();
+  double start = nglTime();
+  while (process.GetState() != eStateRunning && nglTime() - start < mTimeout)
+    usleep(1000);
+
+  if (!rProfiler.Start(process))
+  {
+    rResult = "\"error\":" + JSONQuote("The process did not resume");
+    return false;
+  }
+
+  double duration = rArgs[0].GetCDouble();
+  while (rProfiler.IsSampling() && nglTime() - start < duration)
+    usleep(10000);
+  rProfiler.Stop();
+
+  // Drop the events of the samples before waiting for our own stop:
+  mrContext.mDebugger.GetListener().Clear();
+  if (process.GetState() == eStateRunning)
+  {
+    process.Stop();
+    mrContext.WaitForStop(mTimeout);
+  }
+
+  if (rArgs.size() > 3 && !rProfiler.ExportFolded(nglPath(rArgs[3])))
+  {
+    rResult = "\"error\":" + JSONQuote("Unable to write " + rArgs[3]);
+    return false;
+  }
+
+  Profiler::Node root;
+  rProfiler.GetTree(root);
+  std::map<nglString, uint32> self;
+  AddSelfSamples(root, self);
+  std::vector<std::pair<nglString, uint32> > functions(self.begin(), self.end());
+  std::sort(functions.begin(), functions.end(), HeavierSelf);
+
+  rResult.CFormat("\"samples\":%u,\"overhead\":%.4f,\"functions\":[", root.mTotal, rProfiler.GetOverhead());
+  for (int32 i = 0; i < functions.size() && i < 20; i++)
+  {
+    nglString str;
+    str.CFormat("%s{\"name\":%s,\"self\":%u}", i ? "," : "", JSONQuote(functions[i].first).GetChars(), functions[i].second);
+    rResult.Add(str);
+  }
+  rResult.Add("]");
+  return true;
+}
+
+bool BatchRunner::Trace(const std::vector<nglString>& rArgs, nglString& rResult)
+{
+  if (rArgs.empty())
+  {
+    rResult = "\"error\":" + JSONQuote("Usage: trace on|off|clear | trace save <path>");
+    return false;
+  }
+
+  if (rArgs[0] == "on")
+  {
+    Tracer::SetThreadName("Batch");
+    Tracer::Enable(true);
+  }
+  else if (rArgs[0] == "off")
+  {
+    Tracer::Enable(false);
+  }
+  else if (rArgs[0] == "clear")
+  {
+    Tracer::Clear();
+  }
+  else if (rArgs[0] == "save" && rArgs.size() > 1)
+  {
+    if (!Tracer::Export(nglPath(rArgs[1])))
+    {
+      rResult = "\"error\":" + JSONQuote("Unable to write " + rArgs[1]);
+      return false;
+    }
+  }
+  else
+  {
+    rResult = "\"error\":" + JSONQuote("Usage: trace on|off|clear | trace save <path>");
+    return false;
+  }
+
+  return true;
+}
+
+bool BatchRunner::Record(const std::vector<nglString>& rArgs, nglString& rResult)
+{
+  if (rArgs.empty())
+  {
+    rResult = "\"error\":" + JSONQuote("Usage: record <path> [depth] [memory] | record off");
+    return false;
+  }
+
+  SessionRecorder& rRecorder(mrContext.mRecorder);
+  if (rArgs[0] == "off")
+  {
+    rResult.CFormat("\"stops\":%d,\"bytes\":%llu", rRecorder.GetStopCount(), rRecorder.GetBytesWritten());
+    rRecorder.Close();
+    return true;
+  }
+
+  rRecorder.SetVariableDepth(rArgs.size() > 1 ? rArgs[1].GetCInt() : 2);
+  rRecorder.SetMemoryLimit(rArgs.size() > 2 ? rArgs[2].GetCInt() : 0);
+
+  SBFileSpec executable = mrContext.mTarget.GetExecutable();
+  nglPath path(executable.GetDirectory() ? executable.GetDirectory() : "");
+  path += nglString(executable.GetFilename() ? executable.GetFilename() : "");
+  if (!rRecorder.Open(nglPath(rArgs[0]), path))
+  {
+    rResult = "\"error\":" + JSONQuote("Unable to open " + rArgs[0]);
+    return false;
+  }
+
+  return true;
+}
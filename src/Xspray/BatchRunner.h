@@ -0,0 +1,84 @@
+//
+//  BatchRunner.h
+//  Xspray
+//
+
+#pragma once
+
+// Drives a DebuggerContext from a list of commands, without any UI. One command per line, # starts a comment:
+//   load <path> [arch]     Create the target and index its modules
+//   core <path> [executable]  Open a core file, stack and vars then show the state it was dumped in
+//   break <file>:<line>    Breakpoint by location
+//   break <symbol>         Breakpoint by name
+//   logpoint <file>:<line>|<symbol> <expression>...  Log the expressions on each hit without stopping
+//   log [max]              Lines written by the logpoints since the last log
+//   watch <expression>     Record every write to a variable of the selected frame without stopping
+//   watches                Writes recorded by the watchpoints
+//   run [args...]          Launch the process and wait until it stops
+//   continue               Resume the process and wait until it stops again
+//   stack [frames]         Stacks of every thread
+//   vars [depth]           Variables of the selected frame, children are expanded down to depth
+//   profile <seconds> [hz] [depth] [folded path]  Sample the running process, the heaviest functions are listed
+//   kill
+//   timeout <seconds>      How long run and continue wait for a stop
+//   trace on|off|clear     Span tracing
+//   trace save <path>      Write the spans recorded so far in the Chrome trace format
+//   record <path> [depth] [memory]  Append every following stop to a session log, off stops recording
+// Each command writes one JSON object per line to the output, with the time it took. A summary with the time spent in
+// each kind of command is written last.
+class BatchRunner
+{
+public:
+  BatchRunner(DebuggerContext& rContext, FILE* pOutput);
+  ~BatchRunner();
+
+  bool RunFile(const nglPath& rPath); // False if the file could not be read or a command failed
+  bool RunCommand(const nglString& rLine);
+  void WriteSummary();
+
+  int32 GetErrorCount() const;
+
+private:
+  typedef bool (BatchRunner::*Command)(const std::vector<nglString>& rArgs, nglString& rResult);
+
+  bool Load(const std::vector<nglString>& rArgs, nglString& rResult);
+  bool Core(const std::vector<nglString>& rArgs, nglString& rResult);
+  bool Break(const std::vector<nglString>& rArgs, nglString& rResult);
+  bool Logpoint(const std::vector<nglString>& rArgs, nglString& rResult);
+  bool Log(const std::vector<nglString>& rArgs, nglString& rResult);
+  bool Watch(const std::vector<nglString>& rArgs, nglString& rResult);
+  bool Watches(const std::vector<nglString>& rArgs, nglString& rResult);
+  bool Run(const std::vector<nglString>& rArgs, nglString& rResult);
+  bool Continue(const std::vector<nglString>& rArgs, nglString& rResult);
+  bool Stack(const std::vector<nglString>& rArgs, nglString& rResult);
+  bool Vars(const std::vector<nglString>& rArgs, nglString& rResult);
+  bool Profile(const std::vector<nglString>& rArgs, nglString& rResult);
+  bool Kill(const std::vector<nglString>& rArgs, nglString& rResult);
+  bool Timeout(const std::vector<nglString>& rArgs, nglString& rResult);
+  bool Trace(const std::vector<nglString>& rArgs, nglString& rResult);
+  bool Record(const std::vector<nglString>& rArgs, nglString& rResult);
+
+  bool WaitForStop(nglString& rResult);
+  Breakpoint* CreateBreakpoint(const nglString& rLocation);
+  void AddValue(lldb::SBValue value, int32 depth, nglString& rResult);
+
+  struct Phase
+  {
+    Phase();
+
+    int32 mCount;
+    double mTime;
+  };
+
+  DebuggerContext& mrContext;
+  FILE* mpOutput;
+  double mTimeout;
+  double mStart;
+  int32 mLine;
+  int32 mExecuted; // Commands run, unlike mLine the blank and comment lines don't count
+  int32 mErrors;
+  std::map<nglString, Command> mCommands;
+  std::map<nglString, Phase> mPhases;
+};
+
+nglString JSONQuote(const nglString& rString); // "rString" with the JSON escapes
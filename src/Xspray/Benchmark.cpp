@@ -0,0 +1,499 @@
+//
+//  Benchmark.cpp
+//  Xspray
+//
+
+#include "Xspray.h"
+
+#include <algorithm>
+
+using namespace Xspray;
+using namespace lldb;
+
+#define BENCH_THREADS 256
+#define BENCH_STACK_DEPTH 4000
+#define BENCH_VECTOR_SIZE 1000000
+#define BENCH_STRUCT_COUNT 100000
+#define BENCH_SOURCE_FUNCTIONS 10000 // 6 lines each
+#define BENCH_ARRAY_READS 10000      // ValueArray goes through LLDB for every value
+#define BENCH_GRAPH_WIDTH 1920
+#define BENCH_GRAPH_HEIGHT 1080
+#define BENCH_TIMEOUT 120
+#define BENCH_STOP_THREADS 32     // Stop records packed and unpacked by MeasureZones
+#define BENCH_STOP_FRAMES 24
+#define BENCH_STOP_VARIABLES 6
+#define BENCH_STOP_MESSAGES 2000
+#define BENCH_ZONE_POOL (4 * 1024 * 1024)
+
+static const char* gpThreadsFixture =
+"#include <pthread.h>\n"
+"#include <unistd.h>\n"
+"extern \"C\" void bench_stop() {}\n"
+"static void* worker(void*) { while (true) pause(); return 0; }\n"
+"int main()\n"
+"{\n"
+"  for (int i = 0; i < BENCH_THREADS; i++)\n"
+"  {\n"
+"    pthread_t thread;\n"
+"    pthread_create(&thread, 0, worker, 0);\n"
+"  }\n"
+"  usleep(200000);\n"
+"  bench_stop();\n"
+"  return 0;\n"
+"}\n";
+
+static const char* gpStackFixture =
+"extern \"C\" void bench_stop() {}\n"
+"int recurse(int depth)\n"
+"{\n"
+"  volatile int local = depth;\n"
+"  if (!depth)\n"
+"  {\n"
+"    bench_stop();\n"
+"    return 0;\n"
+"  }\n"
+"  return recurse(depth - 1) + local;\n"
+"}\n"
+"int main() { return recurse(BENCH_STACK_DEPTH) ? 0 : 1; }\n";
+
+static const char* gpVectorsFixture =
+"#include <vector>\n"
+"#include <math.h>\n"
+"struct Sample { int id; float x, y, z; double weight; bool valid; };\n"
+"extern \"C\" void bench_stop() {}\n"
+"int main()\n"
+"{\n"
+"  std::vector<float> floats(BENCH_VECTOR_SIZE);\n"
+"  std::vector<int> ints(BENCH_VECTOR_SIZE);\n"
+"  std::vector<Sample> samples(BENCH_STRUCT_COUNT);\n"
+"  float array[4096];\n"
+"  for (int i = 0; i < BENCH_VECTOR_SIZE; i++)\n"
+"  {\n"
+"    floats[i] = sinf(i * 0.001f);\n"
+"    ints[i] = i;\n"
+"  }\n"
+"  for (int i = 0; i < BENCH_STRUCT_COUNT; i++)\n"
+"  {\n"
+"    Sample s = { i, i * 1.0f, i * 2.0f, i * 3.0f, i * 0.5, (i & 1) != 0 };\n"
+"    samples[i] = s;\n"
+"  }\n"
+"  for (int i = 0; i < 4096; i++)\n"
+"    array[i] = cosf(i * 0.01f);\n"
+"  bench_stop();\n"
+"  return (int)(floats[1] + ints[2] + samples[3].id + array[4]);\n"
+"}\n";
+
+static std::string GetDefines()
+{
+  char defines[512];
+  snprintf(defines, sizeof(defines),
+           "#define BENCH_THREADS %d\n#define BENCH_STACK_DEPTH %d\n#define BENCH_VECTOR_SIZE %d\n#define BENCH_STRUCT_COUNT %d\n",
+           BENCH_THREADS, BENCH_STACK_DEPTH, BENCH_VECTOR_SIZE, BENCH_STRUCT_COUNT);
+  return defines;
+}
+
+static std::string GetLargeSourceFixture()
+{
+  std::string source("extern \"C\" void bench_stop() {}\n");
+  char function[256];
+  for (int32 i = 0; i < BENCH_SOURCE_FUNCTIONS; i++)
+  {
+    snprintf(function, sizeof(function), "int function%d(int a, int b)\n{\n  int c = a * %d + b;\n  return c ^ (c >> 3);\n}\n\n", i, i);
+    source += function;
+  }
+
+  source += "int main()\n{\n  int sum = 0;\n";
+  for (int32 i = 0; i < BENCH_SOURCE_FUNCTIONS; i += 100)
+  {
+    snprintf(function, sizeof(function), "  sum += function%d(sum, %d);\n", i, i);
+    source += function;
+  }
+  source += "  bench_stop();\n  return sum & 1;\n}\n";
+  return source;
+}
+
+//////// Benchmark::Result
+Benchmark::Result::Result()
+: mItems(0)
+{
+}
+
+//////// Benchmark
+Benchmark::Benchmark(DebuggerContext& rContext, const nglPath& rFolder, int32 iterations)
+: mrContext(rContext), mFolder(rFolder), mIterations(MAX(1, iterations)), mpBreakpoint(NULL)
+{
+}
+
+Benchmark::~Benchmark()
+{
+  StopFixture();
+}
+
+Benchmark::Result& Benchmark::AddResult(const nglString& rName, const nglString& rFixture, int32 items)
+{
+  mResults.push_back(Result());
+  Result& rResult(mResults.back());
+  rResult.mName = rName;
+  rResult.mFixture = rFixture;
+  rResult.mItems = items;
+  return rResult;
+}
+
+bool Benchmark::BuildFixture(const nglString& rName, const std::string& rSource, nglPath& rExecutable)
+{
+  mFolder.Create(true);
+
+  nglPath source(mFolder);
+  source += rName + ".cpp";
+  rExecutable = mFolder;
+  rExecutable += rName;
+
+  FILE* pFile = fopen(source.GetChars(), "w");
+  if (!pFile)
+    return false;
+  fwrite(rSource.c_str(), 1, rSource.size(), pFile);
+  fclose(pFile);
+
+  const char* compiler = getenv("CXX");
+  nglString cmd;
+  cmd.CFormat("%s -g -O0 -pthread -o '%s' '%s'", compiler ? compiler : "c++", rExecutable.GetChars(), source.GetChars());
+  if (system(cmd.GetChars()))
+  {
+    NGL_OUT("Unable to build the %s fixture: %s\n", rName.GetChars(), cmd.GetChars());
+    return false;
+  }
+  return true;
+}
+
+bool Benchmark::StartFixture(const nglString& rName, const nglPath& rExecutable)
+{
+  StopFixture();
+
+  double start = nglTime();
+  if (!mrContext.LoadTarget(rExecutable, nglString::Null))
+    return false;
+  mrContext.mThreadPool.Wait(&mrContext); // The modules are indexed on the pool
+  AddResult("load_target", rName).mTimes.push_back((double)nglTime() - start);
+
+  mpBreakpoint = mrContext.CreateBreakpointByName("bench_stop");
+
+  start = nglTime();
+  SBError error;
+  SBListener listener = mrContext.mDebugger.GetListener();
+  mrContext.mProcess = mrContext.mTarget.Launch(listener, NULL, NULL, NULL, NULL, NULL, NULL, 0, false, error);
+  if (!mrContext.mProcess.IsValid() || error.Fail())
+  {
+    NGL_OUT("Unable to launch the %s fixture: %s\n", rName.GetChars(), error.GetCString());
+    return false;
+  }
+
+  if (mrContext.WaitForStop(BENCH_TIMEOUT) != eStateStopped)
+  {
+    NGL_OUT("The %s fixture did not stop at bench_stop\n", rName.GetChars());
+    return false;
+  }
+  AddResult("launch_to_stop", rName).mTimes.push_back((double)nglTime() - start);
+  return true;
+}
+
+void Benchmark::StopFixture()
+{
+  if (mrContext.mProcess.IsValid())
+  {
+    mrContext.mProcess.Kill();
+    mrContext.mProcess.Clear();
+  }
+
+  if (mpBreakpoint)
+  {
+    mrContext.DeleteBreakpoint(mpBreakpoint);
+    mpBreakpoint = NULL;
+  }
+
+  if (mrContext.mTarget.IsValid())
+  {
+    mrContext.mDebugger.DeleteTarget(mrContext.mTarget);
+    mrContext.mTarget.Clear();
+  }
+}
+
+SBFrame Benchmark::GetFixtureFrame()
+{
+  SBThread thread = mrContext.mProcess.GetSelectedThread();
+  return thread.GetFrameAtIndex(1);
+}
+
+bool Benchmark::Run()
+{
+  std::string defines(GetDefines());
+  nglPath executable;
+
+  // Many threads: the whole ProcessTree is built on each stop
+  if (!BuildFixture("threads", defines + gpThreadsFixture, executable) || !StartFixture("threads", executable))
+    return false;
+  MeasureProcessTree("threads");
+
+  // Deep stacks: one thread but thousands of frames to symbolicate
+  if (!BuildFixture("stack", defines + gpStackFixture, executable) || !StartFixture("stack", executable))
+    return false;
+  MeasureProcessTree("stack");
+
+  // Huge vectors: variables panel and graphs
+  if (!BuildFixture("vectors", defines + gpVectorsFixture, executable) || !StartFixture("vectors", executable))
+    return false;
+  MeasureVariables("vectors");
+  MeasureValueArray("vectors", "floats");
+  MeasureValueArray("vectors", "array");
+
+  // Large source file: index size and source view
+  nglPath source(mFolder);
+  source += "source.cpp";
+  if (!BuildFixture("source", GetLargeSourceFixture(), executable) || !StartFixture("source", executable))
+    return false;
+  MeasureSourceView("source", source);
+
+  StopFixture();
+  MeasureGraphView();
+  MeasureZones();
+  return true;
+}
+
+void Benchmark::MeasureProcessTree(const nglString& rFixture)
+{
+  Result& rResult(AddResult("stop_to_process_tree", rFixture, mrContext.mProcess.GetNumThreads()));
+  for (int32 i = 0; i < mIterations; i++)
+  {
+    // The same work as DebugView::OnProcessPaused for the threads panel:
+    double start = nglTime();
+    ProcessTree* pTree = new ProcessTree(mrContext.mProcess);
+    pTree->Acquire();
+    pTree->Open(true);
+    rResult.mTimes.push_back((double)nglTime() - start);
+    pTree->Release();
+  }
+}
+
+void Benchmark::MeasureVariables(const nglString& rFixture)
+{
+  SBFrame frame = GetFixtureFrame();
+  SBValueList values = frame.GetVariables(true, true, true, true);
+
+  for (uint32 v = 0; v < values.GetSize(); v++)
+  {
+    SBValue value = values.GetValueAtIndex(v);
+    nglString name;
+    name.CFormat("variable_node_open:%s", value.GetName());
+    Result& rResult(AddResult(name, rFixture, value.GetNumChildren()));
+
+    for (int32 i = 0; i < mIterations; i++)
+    {
+      double start = nglTime();
+      VariableNode* pNode = new VariableNode(value);
+      pNode->Acquire();
+      pNode->Open(true);
+      rResult.mTimes.push_back((double)nglTime() - start);
+      pNode->Release();
+    }
+  }
+}
+
+void Benchmark::MeasureValueArray(const nglString& rFixture, const nglString& rVariable)
+{
+  SBFrame frame = GetFixtureFrame();
+  SBValue value = frame.FindVariable(rVariable.GetChars());
+  if (!value.IsValid())
+    return;
+
+  ValueArray* pArray = new ValueArray(value);
+  pArray->Acquire();
+  int32 count = MIN(BENCH_ARRAY_READS, pArray->GetNumValues() - 1);
+
+  nglString name("value_array_read:");
+  name.Add(rVariable);
+  Result& rResult(AddResult(name, rFixture, count));
+  for (int32 i = 0; i < mIterations && count > 0; i++)
+  {
+    std::vector<float> values;
+    double start = nglTime();
+    pArray->GetValues(values, 0, count);
+    rResult.mTimes.push_back((double)nglTime() - start);
+  }
+  pArray->Release();
+}
+
+void Benchmark::MeasureSourceView(const nglString& rFixture, const nglPath& rSource)
+{
+  Result& rResult(AddResult("source_view_load", rFixture, BENCH_SOURCE_FUNCTIONS * 6));
+  for (int32 i = 0; i < mIterations; i++)
+  {
+    SourceView* pView = new SourceView();
+    pView->Acquire();
+    double start = nglTime();
+    pView->Load(rSource, rSource);
+    rResult.mTimes.push_back((double)nglTime() - start);
+    pView->Release();
+  }
+}
+
+void Benchmark::MeasureGraphView()
+{
+  std::vector<float> data(BENCH_VECTOR_SIZE);
+  for (int32 i = 0; i < data.size(); i++)
+    data[i] = sinf(i * 0.001f) + 0.1f * sinf(i * 0.37f);
+
+  GraphView* pGraph = new GraphView();
+  pGraph->Acquire();
+  pGraph->AddSource(new MemoryArray(&data[0], data.size()));
+  pGraph->SetLayout(nuiRect(0, 0, BENCH_GRAPH_WIDTH, BENCH_GRAPH_HEIGHT));
+
+  // Recorded by a meta painter, this measures the shape building and not the GPU:
+  nuiDrawContext context(nuiRect(0, 0, BENCH_GRAPH_WIDTH, BENCH_GRAPH_HEIGHT));
+
+  Result& rResult(AddResult("graph_view_draw", "memory", data.size()));
+  for (int32 i = 0; i < mIterations; i++)
+  {
+    nuiMetaPainter* pPainter = new nuiMetaPainter();
+    context.SetPainter(pPainter);
+    double start = nglTime();
+    pGraph->Draw(&context);
+    rResult.mTimes.push_back((double)nglTime() - start);
+    context.SetPainter(NULL);
+    delete pPainter;
+  }
+
+  pGraph->Release();
+}
+
+static void PackBenchString(msgpack_packer& rPacker, const char* pString)
+{
+  size_t size = strlen(pString);
+  msgpack_pack_raw(&rPacker, size);
+  msgpack_pack_raw_body(&rPacker, pString, size);
+}
+
+// The shape of a SessionRecorder stop: threads, frames and the variables of each frame.
+static void PackBenchStop(msgpack_packer& rPacker, int32 stop)
+{
+  char str[128];
+  msgpack_pack_array(&rPacker, BENCH_STOP_THREADS);
+  for (int32 t = 0; t < BENCH_STOP_THREADS; t++)
+  {
+    msgpack_pack_array(&rPacker, 4);
+    msgpack_pack_uint64(&rPacker, 0x1000 + t);
+    snprintf(str, sizeof(str), "worker %d", t);
+    PackBenchString(rPacker, str);
+    PackBenchString(rPacker, t ? "" : "breakpoint 1.1");
+    msgpack_pack_array(&rPacker, BENCH_STOP_FRAMES);
+    for (int32 f = 0; f < BENCH_STOP_FRAMES; f++)
+    {
+      msgpack_pack_array(&rPacker, 6);
+      msgpack_pack_uint64(&rPacker, 0x100000000ULL + stop * 64 + f * 16);
+      snprintf(str, sizeof(str), "Namespace::Class::Method%d(int, std::vector<float> const&)", f);
+      PackBenchString(rPacker, str);
+      snprintf(str, sizeof(str), "/Users/dev/project/src/module%d/File%d.cpp", t % 8, f);
+      PackBenchString(rPacker, str);
+      msgpack_pack_uint32(&rPacker, 100 + f);
+      msgpack_pack_uint32(&rPacker, 5);
+      msgpack_pack_array(&rPacker, BENCH_STOP_VARIABLES);
+      for (int32 v = 0; v < BENCH_STOP_VARIABLES; v++)
+      {
+        msgpack_pack_array(&rPacker, 6);
+        snprintf(str, sizeof(str), "variable%d", v);
+        PackBenchString(rPacker, str);
+        PackBenchString(rPacker, v & 1 ? "std::vector<float>" : "int");
+        snprintf(str, sizeof(str), "%d", stop + v);
+        PackBenchString(rPacker, str);
+        PackBenchString(rPacker, v & 1 ? "size=1000" : "");
+        msgpack_pack_uint64(&rPacker, 0x7fff0000ULL + v * 8);
+        msgpack_pack_array(&rPacker, 0);
+      }
+    }
+  }
+}
+
+void Benchmark::MeasureZones()
+{
+  msgpack_sbuffer buffer;
+  msgpack_sbuffer_init(&buffer);
+  msgpack_packer packer;
+  msgpack_packer_init(&packer, &buffer, msgpack_sbuffer_write);
+
+  // A new zone per message, as msgpack_unpack_next and the unpacker do, with malloc then with the pool:
+  size_t limit = msgpack_zone_pool_get_limit();
+  for (int32 pooled = 0; pooled < 2; pooled++)
+  {
+    msgpack_zone_pool_set_limit(pooled ? BENCH_ZONE_POOL : 0);
+    Result& rResult(AddResult("msgpack_stop_pack_unpack", pooled ? "zone_pool" : "zone_malloc", BENCH_STOP_MESSAGES));
+    for (int32 i = 0; i < mIterations; i++)
+    {
+      msgpack_unpacked unpacked;
+      msgpack_unpacked_init(&unpacked);
+      double start = nglTime();
+      for (int32 m = 0; m < BENCH_STOP_MESSAGES; m++)
+      {
+        buffer.size = 0;
+        PackBenchStop(packer, m);
+        size_t offset = 0;
+        msgpack_unpack_next(&unpacked, buffer.data, buffer.size, &offset);
+      }
+      msgpack_unpacked_destroy(&unpacked);
+      rResult.mTimes.push_back((double)nglTime() - start);
+    }
+  }
+  msgpack_zone_pool_set_limit(limit);
+
+  // One zone reset between the messages:
+  Result& rResult(AddResult("msgpack_stop_pack_unpack", "zone_reset", BENCH_STOP_MESSAGES));
+  for (int32 i = 0; i < mIterations; i++)
+  {
+    msgpack_zone zone;
+    msgpack_zone_init(&zone, MSGPACK_ZONE_CHUNK_SIZE);
+    double start = nglTime();
+    for (int32 m = 0; m < BENCH_STOP_MESSAGES; m++)
+    {
+      buffer.size = 0;
+      PackBenchStop(packer, m);
+      size_t offset = 0;
+      msgpack_object object;
+      msgpack_zone_reset(&zone);
+      msgpack_unpack(buffer.data, buffer.size, &offset, &zone, &object);
+    }
+    rResult.mTimes.push_back((double)nglTime() - start);
+    msgpack_zone_destroy(&zone);
+  }
+
+  msgpack_sbuffer_destroy(&buffer);
+}
+
+bool Benchmark::WriteResults(const nglPath& rPath) const
+{
+  FILE* pFile = fopen(rPath.GetChars(), "w");
+  if (!pFile)
+    return false;
+
+  fprintf(pFile, "{\"version\":1,\"iterations\":%d,\"results\":[\n", mIterations);
+  for (int32 i = 0; i < mResults.size(); i++)
+  {
+    const Result& rResult(mResults[i]);
+    std::vector<double> times(rResult.mTimes);
+    std::sort(times.begin(), times.end());
+
+    double total = 0;
+    for (int32 t = 0; t < times.size(); t++)
+      total += times[t];
+    double best = times.empty() ? 0 : times.front();
+    double median = times.empty() ? 0 : times[times.size() / 2];
+    double mean = times.empty() ? 0 : total / times.size();
+
+    fprintf(pFile, "  {\"name\":%s,\"fixture\":%s,\"runs\":%d,\"min_ms\":%.3f,\"median_ms\":%.3f,\"mean_ms\":%.3f",
+            JSONQuote(rResult.mName).GetChars(), JSONQuote(rResult.mFixture).GetChars(), (int32)times.size(),
+            best * 1000.0, median * 1000.0, mean * 1000.0);
+    if (rResult.mItems && median > 0)
+      fprintf(pFile, ",\"items\":%d,\"items_per_s\":%.1f", rResult.mItems, rResult.mItems / median);
+    fprintf(pFile, "}%s\n", i + 1 < mResults.size() ? "," : "");
+  }
+  fprintf(pFile, "]}\n");
+
+  fclose(pFile);
+  return true;
+}
@@ -0,0 +1,51 @@
+//
+//  Benchmark.h
+//  Xspray
+//
+
+#pragma once
+
+// Times the operations that slow debugging sessions down, on fixture programs that are generated and compiled in a
+// work folder: many threads, deep stacks, huge vectors and a large source file. Each measure is repeated and written
+// to a JSON file with its best, median and mean times so that runs can be compared over time. The serialization
+// measures need no fixture.
+class Benchmark
+{
+public:
+  Benchmark(DebuggerContext& rContext, const nglPath& rFolder, int32 iterations = 5);
+  ~Benchmark();
+
+  bool Run(); // False if a fixture could not be built or did not stop at its breakpoint
+  bool WriteResults(const nglPath& rPath) const;
+
+private:
+  struct Result
+  {
+    Result();
+
+    nglString mName;
+    nglString mFixture;
+    std::vector<double> mTimes; // Seconds, one per iteration
+    int32 mItems;               // Processed in each iteration, for the throughput
+  };
+
+  bool BuildFixture(const nglString& rName, const std::string& rSource, nglPath& rExecutable);
+  bool StartFixture(const nglString& rName, const nglPath& rExecutable); // Runs until bench_stop is hit
+  void StopFixture();
+  lldb::SBFrame GetFixtureFrame(); // The caller of bench_stop
+
+  void MeasureProcessTree(const nglString& rFixture);
+  void MeasureVariables(const nglString& rFixture);
+  void MeasureValueArray(const nglString& rFixture, const nglString& rVariable);
+  void MeasureSourceView(const nglString& rFixture, const nglPath& rSource);
+  void MeasureGraphView();
+  void MeasureZones(); // msgpack zones with malloc, the thread pool and reset, on stop records
+
+  Result& AddResult(const nglString& rName, const nglString& rFixture, int32 items = 0);
+
+  DebuggerContext& mrContext;
+  nglPath mFolder;
+  int32 mIterations;
+  Breakpoint* mpBreakpoint;
+  std::vector<Result> mResults;
+};
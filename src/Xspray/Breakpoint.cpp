@@ -8,35 +8,95 @@
 
 #include "Xspray.h"
 
+#include <unistd.h>
+
 using namespace Xspray;
+using namespace lldb;
+
+// The callback baton is an id looked up here rather than the breakpoint itself, so a hit racing with the deletion of the
+// breakpoint either finds nothing or holds a reference on it, the deletion then waits for the hit to be logged:
+static nglCriticalSection gLogpointsCS;
+static std::map<uint32, Breakpoint*> gLogpoints;
+static uint32 gLastLogpointID = 0;
+
+Breakpoint::Breakpoint(LogBuffer& rLogBuffer, lldb::SBBreakpoint breakpoint, const nglPath& rPath, int32 line, int32 column)
+: mrLogBuffer(rLogBuffer), mType(Location), mPath(rPath), mLine(line), mColumn(column), mBreakOnCatch(false), mBreakOnThrow(false), mIsRegex(false), mBreakpoint(breakpoint),
+  mLogID(0), mLogRefs(0), mWatchAddress(0), mWatchSize(0), mWatchValue(0), mWatchCount(0)
+{
+  UpdateResolved();
+}
 
-Breakpoint::Breakpoint(lldb::SBBreakpoint breakpoint, const nglPath& rPath, int32 line, int32 column)
-: mType(Location), mPath(rPath), mLine(line), mColumn(column), mBreakOnCatch(false), mBreakOnThrow(false), mIsRegex(false), mBreakpoint(breakpoint)
+Breakpoint::Breakpoint(LogBuffer& rLogBuffer, lldb::SBBreakpoint breakpoint, const nglString& rSymbol, bool IsRegex)
+: mrLogBuffer(rLogBuffer), mType(Symbolic), mLine(-1), mColumn(-1), mSymbol(rSymbol), mBreakOnCatch(false), mBreakOnThrow(false), mIsRegex(IsRegex), mBreakpoint(breakpoint),
+  mLogID(0), mLogRefs(0), mWatchAddress(0), mWatchSize(0), mWatchValue(0), mWatchCount(0)
 {
+  UpdateResolved();
 }
 
-Breakpoint::Breakpoint(lldb::SBBreakpoint breakpoint, const nglString& rSymbol, bool IsRegex)
-: mType(Symbolic), mLine(-1), mColumn(-1), mSymbol(rSymbol), mBreakOnCatch(false), mBreakOnThrow(false), mIsRegex(IsRegex), mBreakpoint(breakpoint)
+Breakpoint::Breakpoint(LogBuffer& rLogBuffer, lldb::SBBreakpoint breakpoint, lldb::LanguageType language, bool BreakOnCatch, bool BreakOnThrow)
+: mrLogBuffer(rLogBuffer), mType(Exception), mLine(-1), mColumn(-1), mLanguage(language), mBreakOnCatch(BreakOnCatch), mBreakOnThrow(BreakOnThrow), mIsRegex(false), mBreakpoint(breakpoint),
+  mLogID(0), mLogRefs(0), mWatchAddress(0), mWatchSize(0), mWatchValue(0), mWatchCount(0)
 {
+  UpdateResolved();
+}
 
+Breakpoint::Breakpoint(LogBuffer& rLogBuffer, lldb::SBWatchpoint watchpoint, const nglString& rExpression, uint64 address, uint32 size, uint64 value)
+: mrLogBuffer(rLogBuffer), mType(Watch), mLine(-1), mColumn(-1), mSymbol(rExpression), mBreakOnCatch(false), mBreakOnThrow(false), mIsRegex(false),
+  mLogID(0), mLogRefs(0), mWatchpoint(watchpoint), mWatchAddress(address), mWatchSize(size), mWatchValue(value), mWatchCount(0)
+{
+  UpdateResolved();
 }
 
-Breakpoint::Breakpoint(lldb::SBBreakpoint breakpoint, lldb::LanguageType language, bool BreakOnCatch, bool BreakOnThrow)
-: mType(Exception), mLine(-1), mColumn(-1), mLanguage(language), mBreakOnCatch(BreakOnCatch), mBreakOnThrow(BreakOnThrow), mIsRegex(false), mBreakpoint(breakpoint)
+Breakpoint::~Breakpoint()
 {
-  
+  if (!mLogID)
+    return;
+
+  if (mBreakpoint.IsValid())
+    mBreakpoint.SetCallback(NULL, NULL);
+
+  {
+    nglCriticalSectionGuard guard(gLogpointsCS);
+    gLogpoints.erase(mLogID);
+  }
+
+  // No new hit can find it now, wait for the ones being logged:
+  while (mLogRefs > 0)
+    usleep(1000);
 }
 
 bool Breakpoint::IsValid() const
 {
+  if (mType == Watch)
+    return const_cast<lldb::SBWatchpoint&>(mWatchpoint).IsValid();
   return mBreakpoint.IsValid();
 }
 
+bool Breakpoint::IsResolved() const
+{
+  return mResolved;
+}
+
+void Breakpoint::UpdateResolved()
+{
+  if (mType == Watch)
+  {
+    mResolved = mWatchpoint.IsValid();
+    return;
+  }
+  mResolved = mBreakpoint.IsValid() && mBreakpoint.GetNumResolvedLocations() > 0;
+}
+
 lldb::SBBreakpoint Breakpoint::GetBreakpoint() const
 {
   return mBreakpoint;
 }
 
+lldb::SBWatchpoint Breakpoint::GetWatchpoint() const
+{
+  return mWatchpoint;
+}
+
 Breakpoint::Type Breakpoint::GetType() const
 {
   return mType;
@@ -78,3 +138,153 @@ bool Breakpoint::GetBreakOnCatch() const
   return mBreakOnCatch;
 }
 
+void Breakpoint::SetLogExpressions(const std::vector<nglString>& rExpressions)
+{
+  {
+    nglCriticalSectionGuard guard(mLogCS);
+    mLogExpressions.clear();
+    for (int32 i = 0; i < rExpressions.size(); i++)
+      mLogExpressions.push_back(rExpressions[i].GetStdString());
+  }
+
+  if (rExpressions.empty())
+  {
+    mBreakpoint.SetCallback(NULL, NULL);
+    return;
+  }
+
+  if (!mLogID)
+  {
+    mrLogBuffer.Allocate();
+
+    nglCriticalSectionGuard guard(gLogpointsCS);
+    mLogID = ++gLastLogpointID;
+    gLogpoints[mLogID] = this;
+  }
+  mBreakpoint.SetCallback(&Breakpoint::OnHit, (void*)(uintptr_t)mLogID);
+}
+
+void Breakpoint::GetLogExpressions(std::vector<nglString>& rExpressions) const
+{
+  nglCriticalSectionGuard guard(mLogCS);
+  for (int32 i = 0; i < mLogExpressions.size(); i++)
+    rExpressions.push_back(nglString(mLogExpressions[i].c_str()));
+}
+
+bool Breakpoint::IsLogpoint() const
+{
+  nglCriticalSectionGuard guard(mLogCS);
+  return !mLogExpressions.empty();
+}
+
+// Called synchronously on the debugger thread, returning false resumes the process without broadcasting the stop:
+bool Breakpoint::OnHit(void* pBaton, SBProcess& rProcess, SBThread& rThread, SBBreakpointLocation& rLocation)
+{
+  // Only the lookup is done under the global lock, the hits of different logpoints are logged concurrently:
+  Breakpoint* pBP = NULL;
+  {
+    nglCriticalSectionGuard guard(gLogpointsCS);
+    auto it = gLogpoints.find((uint32)(uintptr_t)pBaton);
+    if (it == gLogpoints.end())
+      return false;
+    pBP = it->second;
+    pBP->mLogRefs++;
+  }
+
+  pBP->Log(rThread);
+  pBP->mLogRefs--;
+  return false;
+}
+
+void Breakpoint::Log(SBThread& rThread)
+{
+  XSPRAY_TRACE("Breakpoint::Log");
+  LogBuffer& rBuffer(mrLogBuffer);
+  LogBuffer::Entry* pEntry = rBuffer.BeginWrite();
+  if (!pEntry)
+    return;
+
+  pEntry->mTime = nglTime();
+  pEntry->mThreadID = rThread.GetThreadID();
+  pEntry->mBreakpointID = mBreakpoint.GetID();
+
+  // No allocation for the text, it goes straight to the entry:
+  SBFrame frame = rThread.GetFrameAtIndex(0);
+  char* pText = pEntry->mText;
+  size_t left = LOGBUFFER_TEXT_SIZE;
+  pText[0] = 0;
+
+  nglCriticalSectionGuard guard(mLogCS);
+  for (int32 i = 0; i < mLogExpressions.size() && left > 1; i++)
+  {
+    const char* pExpression = mLogExpressions[i].c_str();
+    SBValue value = frame.GetValueForVariablePath(pExpression);
+    const char* pValue = value.IsValid() ? value.GetValue() : NULL;
+    if (!pValue && value.IsValid())
+      pValue = value.GetSummary();
+
+    int written = snprintf(pText, left, "%s%s = %s", i ? ", " : "", pExpression, pValue ? pValue : "<unavailable>");
+    written = MIN(written, (int)left - 1);
+    pText += written;
+    left -= written;
+  }
+
+  rBuffer.EndWrite();
+}
+
+uint64 Breakpoint::GetWatchAddress() const
+{
+  return mWatchAddress;
+}
+
+uint32 Breakpoint::GetWatchSize() const
+{
+  return mWatchSize;
+}
+
+uint64 Breakpoint::GetWatchHits(std::vector<WatchHit>& rHits, uint64 since) const
+{
+  nglCriticalSectionGuard guard(mWatchCS);
+
+  // The oldest hits may have been overwritten already:
+  uint64 first = MAX(since, mWatchCount > BREAKPOINT_WATCH_HISTORY ? mWatchCount - BREAKPOINT_WATCH_HISTORY : 0);
+  for (uint64 i = first; i < mWatchCount; i++)
+    rHits.push_back(mWatchHits[i % BREAKPOINT_WATCH_HISTORY]);
+  return mWatchCount;
+}
+
+uint64 Breakpoint::GetDroppedWatchHits() const
+{
+  nglCriticalSectionGuard guard(mWatchCS);
+  return mWatchCount > BREAKPOINT_WATCH_HISTORY ? mWatchCount - BREAKPOINT_WATCH_HISTORY : 0;
+}
+
+void Breakpoint::ClearWatchHits()
+{
+  nglCriticalSectionGuard guard(mWatchCS);
+  mWatchHits.clear();
+  mWatchCount = 0;
+}
+
+// Called on the thread handling the debugger's events, the process is stopped right after the write:
+void Breakpoint::AddWatchHit(SBProcess& rProcess, SBThread& rThread)
+{
+  uint64 value = 0;
+  SBError error;
+  rProcess.ReadMemory(mWatchAddress, &value, mWatchSize, error);
+
+  WatchHit hit;
+  hit.mTime = nglTime();
+  hit.mThreadID = rThread.GetThreadID();
+  hit.mPC = rThread.GetFrameAtIndex(0).GetPC();
+  hit.mNewValue = value;
+
+  nglCriticalSectionGuard guard(mWatchCS);
+  hit.mOldValue = mWatchValue;
+  mWatchValue = value;
+  if (mWatchHits.size() < BREAKPOINT_WATCH_HISTORY)
+    mWatchHits.push_back(hit);
+  else
+    mWatchHits[mWatchCount % BREAKPOINT_WATCH_HISTORY] = hit;
+  mWatchCount++;
+}
@@ -8,6 +8,8 @@
 
 #pragma once
 
+#define BREAKPOINT_WATCH_HISTORY 4096 // Hits kept per watchpoint, the oldest ones are overwritten
+
 class Breakpoint
 {
 public:
@@ -15,27 +17,60 @@ public:
   {
     Location,
     Symbolic,
-    Exception
+    Exception,
+    Watch
+  };
+
+  struct WatchHit
+  {
+    double mTime;
+    uint64 mThreadID;
+    uint64 mPC;
+    uint64 mOldValue;
+    uint64 mNewValue;
   };
 
   lldb::SBBreakpoint GetBreakpoint() const;
+  lldb::SBWatchpoint GetWatchpoint() const;
   bool IsValid() const;
+  bool IsResolved() const; // At least one location was found in the loaded modules
   Type GetType() const;
   const nglPath& GetPath() const;
-  const nglString& GetSymbol() const;
+  const nglString& GetSymbol() const; // Or the watched expression
   bool IsRegex() const;
   int32 GetLine() const;
   int32 GetColumn() const;
   bool GetBreakOnThrow() const;
   bool GetBreakOnCatch() const;
 
+  // A breakpoint with log expressions is a logpoint: each hit formats the expressions into the context's log buffer on
+  // the debugger thread and the process continues right away, the UI never sees the stop. Expressions are variable
+  // paths (x, p->next->value, a[3]), evaluated without running code in the target.
+  void SetLogExpressions(const std::vector<nglString>& rExpressions); // Empty turns it back into a breakpoint
+  void GetLogExpressions(std::vector<nglString>& rExpressions) const;
+  bool IsLogpoint() const;
+
+  // Watchpoints never stop the UI: each write is appended to the history and the process continues.
+  uint64 GetWatchAddress() const;
+  uint32 GetWatchSize() const;
+  uint64 GetWatchHits(std::vector<WatchHit>& rHits, uint64 since = 0) const; // Appends the hits recorded since that count and still kept, returns the hit count
+  uint64 GetDroppedWatchHits() const; // Overwritten once the history was full
+  void ClearWatchHits();
+
 private:
   friend class DebuggerContext;
 
-  Breakpoint(lldb::SBBreakpoint, const nglPath& rPath, int32 line, int32 column);
-  Breakpoint(lldb::SBBreakpoint, const nglString& rSymbol, bool IsRegex);
-  Breakpoint(lldb::SBBreakpoint, lldb::LanguageType language, bool BreakOnCatch, bool BreakOnThrow);
+  Breakpoint(LogBuffer& rLogBuffer, lldb::SBBreakpoint, const nglPath& rPath, int32 line, int32 column);
+  Breakpoint(LogBuffer& rLogBuffer, lldb::SBBreakpoint, const nglString& rSymbol, bool IsRegex);
+  Breakpoint(LogBuffer& rLogBuffer, lldb::SBBreakpoint, lldb::LanguageType language, bool BreakOnCatch, bool BreakOnThrow);
+  Breakpoint(LogBuffer& rLogBuffer, lldb::SBWatchpoint, const nglString& rExpression, uint64 address, uint32 size, uint64 value);
+  ~Breakpoint();
+  void UpdateResolved();
+  static bool OnHit(void* pBaton, lldb::SBProcess& rProcess, lldb::SBThread& rThread, lldb::SBBreakpointLocation& rLocation);
+  void Log(lldb::SBThread& rThread);
+  void AddWatchHit(lldb::SBProcess& rProcess, lldb::SBThread& rThread);
 
+  LogBuffer& mrLogBuffer; // The one of the context the breakpoint belongs to
   Type mType;
   nglPath mPath;
   int32 mLine;
@@ -45,6 +80,20 @@ private:
   bool mBreakOnCatch;
   bool mBreakOnThrow;
   bool mIsRegex;
+  bool mResolved;
   lldb::SBBreakpoint mBreakpoint;
+
+  mutable nglCriticalSection mLogCS; // Protects the expressions against the debugger thread
+  std::vector<std::string> mLogExpressions;
+  uint32 mLogID; // Baton of the callback, 0 until the breakpoint first becomes a logpoint
+  std::atomic<int32> mLogRefs; // Hits being logged, the destructor waits for them
+
+  lldb::SBWatchpoint mWatchpoint;
+  uint64 mWatchAddress;
+  uint32 mWatchSize;
+  mutable nglCriticalSection mWatchCS; // Protects the value and the hits against the debugger thread
+  uint64 mWatchValue; // As of the last hit, the old value of the next one
+  std::vector<WatchHit> mWatchHits; // Ring of the last BREAKPOINT_WATCH_HISTORY hits
+  uint64 mWatchCount; // Hits recorded since the last clear
 };
 
@@ -0,0 +1,254 @@
+//
+//  CoreFile.cpp
+//  Xspray
+//
+
+#include "Xspray.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace Xspray;
+using namespace lldb;
+
+// The few bits of the ELF and Mach-O headers we need, the system headers are not there on every platform:
+#define ELF_HEADER_SIZE 64
+#define ELF_PHDR_SIZE 56
+#define ELF_CLASS_64 2
+#define ELF_DATA_LSB 1
+#define ELF_TYPE_CORE 4
+#define ELF_PT_LOAD 1
+
+#define MACHO_MAGIC_64 0xfeedfacf
+#define MACHO_HEADER_SIZE 32
+#define MACHO_TYPE_CORE 4
+#define MACHO_LC_SEGMENT_64 0x19
+#define MACHO_SEGMENT_SIZE 72
+
+static uint16 GetUInt16(const uint8* pData)
+{
+  uint16 value;
+  memcpy(&value, pData, sizeof(value));
+  return value;
+}
+
+static uint32 GetUInt32(const uint8* pData)
+{
+  uint32 value;
+  memcpy(&value, pData, sizeof(value));
+  return value;
+}
+
+static uint64 GetUInt64(const uint8* pData)
+{
+  uint64 value;
+  memcpy(&value, pData, sizeof(value));
+  return value;
+}
+
+nglCriticalSection CoreFile::mCoresCS;
+std::vector<CoreFile*> CoreFile::mCores;
+
+CoreFile::CoreFile()
+: mFile(-1), mpData(NULL), mSize(0)
+{
+}
+
+CoreFile::~CoreFile()
+{
+  Close();
+}
+
+bool CoreFile::Open(const nglPath& rPath, SBTarget target)
+{
+  Close();
+  XSPRAY_TRACE("CoreFile::Open");
+
+  mFile = open(rPath.GetChars(), O_RDONLY);
+  if (mFile < 0)
+    return false;
+
+  struct stat st;
+  if (fstat(mFile, &st) || st.st_size < ELF_HEADER_SIZE)
+  {
+    Close();
+    return false;
+  }
+
+  void* pMapping = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, mFile, 0);
+  if (pMapping == MAP_FAILED)
+  {
+    Close();
+    return false;
+  }
+
+  // Values are read here and there, reading ahead would only pull in pages nobody looks at:
+  madvise(pMapping, st.st_size, MADV_RANDOM);
+
+  mpData = (const uint8*)pMapping;
+  mSize = st.st_size;
+  mPath = rPath;
+  if (!IndexELF() && !IndexMachO())
+  {
+    Close();
+    return false;
+  }
+  std::sort(mSegments.begin(), mSegments.end(), CompareSegments);
+
+  mTarget = target;
+  nglCriticalSectionGuard guard(mCoresCS);
+  mCores.push_back(this);
+  return true;
+}
+
+void CoreFile::Close()
+{
+  {
+    nglCriticalSectionGuard guard(mCoresCS);
+    auto it = std::find(mCores.begin(), mCores.end(), this);
+    if (it != mCores.end())
+      mCores.erase(it);
+  }
+
+  if (mpData)
+    munmap((void*)mpData, mSize);
+  if (mFile >= 0)
+    close(mFile);
+
+  mFile = -1;
+  mpData = NULL;
+  mSize = 0;
+  mSegments.clear();
+  mTarget.Clear();
+  mPath = nglPath();
+}
+
+bool CoreFile::IsOpen() const
+{
+  return mpData != NULL;
+}
+
+const nglPath& CoreFile::GetPath() const
+{
+  return mPath;
+}
+
+uint64 CoreFile::GetSize() const
+{
+  return mSize;
+}
+
+int32 CoreFile::GetSegmentCount() const
+{
+  return mSegments.size();
+}
+
+bool CoreFile::CompareSegments(const Segment& rA, const Segment& rB)
+{
+  return rA.mAddress < rB.mAddress;
+}
+
+void CoreFile::AddSegment(uint64 address, uint64 size, uint64 offset)
+{
+  // Only what is really in the file, a truncated core keeps the segments it has:
+  if (!size || offset >= mSize)
+    return;
+
+  Segment segment;
+  segment.mAddress = address;
+  segment.mSize = MIN(size, mSize - offset);
+  segment.mOffset = offset;
+  mSegments.push_back(segment);
+}
+
+bool CoreFile::IndexELF()
+{
+  if (memcmp(mpData, "\x7f" "ELF", 4) || mpData[4] != ELF_CLASS_64 || mpData[5] != ELF_DATA_LSB)
+    return false;
+  if (GetUInt16(mpData + 16) != ELF_TYPE_CORE)
+    return false;
+
+  uint64 phoff = GetUInt64(mpData + 32);
+  uint16 phentsize = GetUInt16(mpData + 54);
+  uint16 phnum = GetUInt16(mpData + 56);
+  if (phentsize < ELF_PHDR_SIZE || phoff > mSize || (uint64)phnum * phentsize > mSize - phoff)
+    return false;
+
+  for (uint16 i = 0; i < phnum; i++)
+  {
+    const uint8* pHeader = mpData + phoff + (uint64)i * phentsize;
+    if (GetUInt32(pHeader) != ELF_PT_LOAD)
+      continue;
+
+    uint64 offset = GetUInt64(pHeader + 8);
+    uint64 address = GetUInt64(pHeader + 16);
+    uint64 filesize = GetUInt64(pHeader + 32);
+    AddSegment(address, filesize, offset);
+  }
+  return true;
+}
+
+bool CoreFile::IndexMachO()
+{
+  if (mSize < MACHO_HEADER_SIZE || GetUInt32(mpData) != MACHO_MAGIC_64 || GetUInt32(mpData + 12) != MACHO_TYPE_CORE)
+    return false;
+
+  uint32 ncmds = GetUInt32(mpData + 16);
+  uint64 offset = MACHO_HEADER_SIZE;
+  for (uint32 i = 0; i < ncmds && offset + 8 <= mSize; i++)
+  {
+    const uint8* pCommand = mpData + offset;
+    uint32 cmd = GetUInt32(pCommand);
+    uint32 cmdsize = GetUInt32(pCommand + 4);
+    if (cmdsize < 8 || cmdsize > mSize - offset)
+      break;
+
+    if (cmd == MACHO_LC_SEGMENT_64 && cmdsize >= MACHO_SEGMENT_SIZE)
+    {
+      uint64 address = GetUInt64(pCommand + 24);
+      uint64 fileoff = GetUInt64(pCommand + 40);
+      uint64 filesize = GetUInt64(pCommand + 48);
+      AddSegment(address, filesize, fileoff);
+    }
+    offset += cmdsize;
+  }
+  return true;
+}
+
+bool CoreFile::Read(uint64 address, uint8* pData, uint32 size) const
+{
+  // Last segment starting at or before the address:
+  int32 lo = 0;
+  int32 hi = mSegments.size();
+  while (lo < hi)
+  {
+    int32 mid = (lo + hi) / 2;
+    if (mSegments[mid].mAddress <= address)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  if (!lo)
+    return false;
+
+  const Segment& rSegment(mSegments[lo - 1]);
+  uint64 start = address - rSegment.mAddress;
+  if (start >= rSegment.mSize || size > rSegment.mSize - start)
+    return false;
+
+  memcpy(pData, mpData + rSegment.mOffset + start, size);
+  return true;
+}
+
+bool CoreFile::ReadTarget(SBTarget target, uint64 address, uint8* pData, uint32 size)
+{
+  nglCriticalSectionGuard guard(mCoresCS);
+  for (int32 i = 0; i < mCores.size(); i++)
+  {
+    if (mCores[i]->mTarget == target)
+      return mCores[i]->Read(address, pData, size);
+  }
+  return false;
+}
@@ -0,0 +1,54 @@
+//
+//  CoreFile.h
+//  Xspray
+//
+
+#pragma once
+
+// A core file mapped read only. Opening only walks the headers to index the memory segments, the pages are faulted in
+// when a value is read, so a core of several gigabytes opens in the time it takes to read its load commands. ELF and
+// Mach-O 64 bit little endian cores are understood.
+class CoreFile
+{
+public:
+  CoreFile();
+  ~CoreFile();
+
+  bool Open(const nglPath& rPath, lldb::SBTarget target); // The values of the target are then read from the mapping
+  void Close();
+  bool IsOpen() const;
+
+  const nglPath& GetPath() const;
+  uint64 GetSize() const;
+  int32 GetSegmentCount() const;
+
+  // True if the whole range was in the file. Memory the core left out (mapped files, zero pages) is not, LLDB knows
+  // where to find it.
+  bool Read(uint64 address, uint8* pData, uint32 size) const;
+
+  // Read from the core file opened for this target. False if there is none or the range is not in it.
+  static bool ReadTarget(lldb::SBTarget target, uint64 address, uint8* pData, uint32 size);
+
+private:
+  struct Segment
+  {
+    uint64 mAddress;
+    uint64 mSize; // Bytes present in the file
+    uint64 mOffset;
+  };
+
+  static bool CompareSegments(const Segment& rA, const Segment& rB);
+  bool IndexELF();
+  bool IndexMachO();
+  void AddSegment(uint64 address, uint64 size, uint64 offset);
+
+  nglPath mPath;
+  int mFile;
+  const uint8* mpData;
+  uint64 mSize;
+  std::vector<Segment> mSegments; // By address
+  lldb::SBTarget mTarget;
+
+  static nglCriticalSection mCoresCS; // Held while reading, Close waits for the readers
+  static std::vector<CoreFile*> mCores;
+};
@@ -11,10 +11,17 @@
 using namespace Xspray;
 using namespace lldb;
 
+#define PROFILE_UPDATE_INTERVAL 1.0 // Seconds between two refreshes of the profile views while sampling
+#define RESOURCE_HISTORY 1200 // Samples shown by the resource plots
+
 //class DebugView : public nuiSimpleContainer
 DebugView::DebugView()
 : nuiLayout(),
-  mEventSink(this)
+  mEventSink(this),
+  mReplayIndex(-1),
+  mLogDropped(0),
+  mProfileUpdate(0),
+  mResourceCount(0)
 {
   if (SetObjectClass("DebugView"))
   {
@@ -24,7 +31,9 @@ DebugView::DebugView()
 
 DebugView::~DebugView()
 {
-
+  // The contexts outlive the view:
+  for (int32 i = 0; i < DebuggerContext::GetContextCount(); i++)
+    DebuggerContext::GetContext(i)->StopEvents();
 }
 
 void DebugView::Built()
@@ -37,10 +46,22 @@ void DebugView::Built()
   mpVariables->SetSubElementWidth(0, 200);
   mpVariables->SetSubElementWidth(1, 200);
 
-  mpModulesFiles = (nuiTreeView*)SearchForChild("ModulesFiles", true);
+  mpModulesFiles = (RowView*)SearchForChild("ModulesFiles", true);
   NGL_ASSERT(mpModulesFiles);
-  mpModulesSymbols = (nuiTreeView*)SearchForChild("ModulesSymbols", true);
+  mpModulesSymbols = (RowView*)SearchForChild("ModulesSymbols", true);
   NGL_ASSERT(mpModulesSymbols);
+  mpSymbolSearch = (nuiEditLine*)SearchForChild("SymbolSearch", true);
+  NGL_ASSERT(mpSymbolSearch);
+  mpSymbolResults = (nuiList*)SearchForChild("SymbolResults", true);
+  NGL_ASSERT(mpSymbolResults);
+  mpSymbolBreak = (nuiButton*)SearchForChild("SymbolBreak", true);
+  NGL_ASSERT(mpSymbolBreak);
+  mpTargets = (nuiList*)SearchForChild("Targets", true);
+  NGL_ASSERT(mpTargets);
+  mpAddTarget = (nuiButton*)SearchForChild("AddTarget", true);
+  NGL_ASSERT(mpAddTarget);
+  mpCloseTarget = (nuiButton*)SearchForChild("CloseTarget", true);
+  NGL_ASSERT(mpCloseTarget);
 
   nuiScrollView* pScroller = (nuiScrollView*)SearchForChild("ThreadsScroller", true);
   pScroller->ActivateHotRect(false, true);
@@ -58,12 +79,34 @@ void DebugView::Built()
   mpStepIn = (nuiButton*)SearchForChild("StepIn", true);
   mpStepOver = (nuiButton*)SearchForChild("StepOver", true);
   mpStepOut = (nuiButton*)SearchForChild("StepOut", true);
+  mpPreviousStop = (nuiButton*)SearchForChild("PreviousStop", true);
+  mpNextStop = (nuiButton*)SearchForChild("NextStop", true);
+  mpOpenCore = (nuiButton*)SearchForChild("OpenCore", true);
   mpFilesTabView = (nuiTabView*)SearchForChild("FilesTabView", true);
 
   mpGraphView = (GraphView*)SearchForChild("SharedPlotter", true);
 
   mpOutput = (nuiText*)SearchForChild("STDOUT", true);
   mpErrors = (nuiText*)SearchForChild("STDERR", true);
+  mpLog = (nuiText*)SearchForChild("Logpoints", true);
+  mpLogExpressions = (nuiEditLine*)SearchForChild("LogExpressions", true);
+  mpProfile = (nuiButton*)SearchForChild("Profile", true);
+  mpProfileRate = (nuiEditLine*)SearchForChild("ProfileRate", true);
+  mpProfileDepth = (nuiEditLine*)SearchForChild("ProfileDepth", true);
+  mpProfileStatus = (nuiLabel*)SearchForChild("ProfileStatus", true);
+  mpProfileTree = (nuiTreeView*)SearchForChild("ProfileTree", true);
+  mpFlameGraph = (FlameGraphView*)SearchForChild("ProfileFlameGraph", true);
+  mpWatchExpression = (nuiEditLine*)SearchForChild("WatchExpression", true);
+  mpAddWatch = (nuiButton*)SearchForChild("AddWatch", true);
+  mpWatchpoints = (nuiList*)SearchForChild("Watchpoints", true);
+  mpWatchTimeline = (WatchTimelineView*)SearchForChild("WatchTimeline", true);
+  mpWatchHit = (nuiLabel*)SearchForChild("WatchHit", true);
+  mpResourceStops = (GraphView*)SearchForChild("ResourceStops", true);
+  mpResourceCPU = (GraphView*)SearchForChild("ResourceCPU", true);
+  mpResourceMemory = (GraphView*)SearchForChild("ResourceMemory", true);
+  mpResourceEvents = (GraphView*)SearchForChild("ResourceEvents", true);
+  mpResourceStatus = (nuiLabel*)SearchForChild("ResourceStatus", true);
+  ClearResources();
 
   mpDevices = new nuiTreeNode("Devices");
   mpDevicesCombo->SetTree(mpDevices);
@@ -79,10 +122,27 @@ void DebugView::Built()
   mEventSink.Connect(mpStepIn->Activated, &DebugView::OnStepIn);
   mEventSink.Connect(mpStepOver->Activated, &DebugView::OnStepOver);
   mEventSink.Connect(mpStepOut->Activated, &DebugView::OnStepOut);
+  mEventSink.Connect(mpPreviousStop->Activated, &DebugView::OnPreviousStop);
+  mEventSink.Connect(mpNextStop->Activated, &DebugView::OnNextStop);
+  mEventSink.Connect(mpOpenCore->Activated, &DebugView::OnOpenCore);
+  mEventSink.Connect(mpProfile->Activated, &DebugView::OnProfile);
+  mEventSink.Connect(mpAddWatch->Activated, &DebugView::OnAddWatch);
+  mEventSink.Connect(mpWatchpoints->SelectionChanged, &DebugView::OnWatchpointSelected);
+  mSlotSink.Connect(mpWatchTimeline->CursorMoved, nuiMakeDelegate(this, &DebugView::OnWatchCursorMoved));
+
+  // Only used to browse a session log:
+  mpPreviousStop->SetVisible(false);
+  mpNextStop->SetVisible(false);
 
   mEventSink.Connect(mpThreads->SelectionChanged, &DebugView::OnThreadSelectionChanged);
   mEventSink.Connect(mpModulesFiles->SelectionChanged, &DebugView::OnModuleFileSelectionChanged);
   mEventSink.Connect(mpModulesSymbols->SelectionChanged, &DebugView::OnModuleSymbolSelectionChanged);
+  mEventSink.Connect(mpSymbolSearch->TextChanged, &DebugView::OnSymbolSearchChanged);
+  mEventSink.Connect(mpSymbolResults->SelectionChanged, &DebugView::OnSymbolResultSelected);
+  mEventSink.Connect(mpSymbolBreak->Activated, &DebugView::OnSymbolBreak);
+  mEventSink.Connect(mpAddTarget->Activated, &DebugView::OnAddTarget);
+  mEventSink.Connect(mpCloseTarget->Activated, &DebugView::OnCloseTarget);
+  mEventSink.Connect(mpTargets->SelectionChanged, &DebugView::OnTargetSelected);
 
   mEventSink.Connect(mpVariables->SelectionChanged, &DebugView::OnVariableSelectionChanged);
 
@@ -90,19 +150,88 @@ void DebugView::Built()
 
   mSlotSink.Connect(iOSDevice::DeviceConnected, nuiMakeDelegate(this, &DebugView::OnDeviceConnected));
   mSlotSink.Connect(iOSDevice::DeviceDisconnected, nuiMakeDelegate(this, &DebugView::OnDeviceDisconnected));
+  mSlotSink.Connect(RpcServer::TargetAdded, nuiMakeDelegate(this, &DebugView::AddContext));
 
   // Load modules:
   DebuggerContext& rContext(GetDebuggerContext());
-  ModuleTree* pFilesTree = new ModuleTree(rContext.mTarget);
-  pFilesTree->Acquire();
-  pFilesTree->Open(true);
-  mpModulesFiles->SetTree(pFilesTree);
+  mContextSink.Connect(rContext.mSymbolIndex.Changed, nuiMakeDelegate(this, &DebugView::OnSymbolIndexChanged));
+  mContextSink.Connect(rContext.LinesChanged, nuiMakeDelegate(this, &DebugView::OnLinesChanged));
+  ResetModules();
+  UpdateTargets();
+}
 
-  SymbolTree* pSymbolsTree = new SymbolTree(rContext.mTarget);
-  pSymbolsTree->Acquire();
-  pSymbolsTree->Open(true);
-  mpModulesSymbols->SetTree(pSymbolsTree);
+void DebugView::ResetModules()
+{
+  DebuggerContext& rContext(GetDebuggerContext());
+  ModuleTree* pFilesTree = new ModuleTree(rContext);
+  mpModulesFiles->SetModel(pFilesTree);
+  pFilesTree->SetOpened(0, true);
 
+  SymbolTree* pSymbolsTree = new SymbolTree(rContext);
+  mpModulesSymbols->SetModel(pSymbolsTree);
+  pSymbolsTree->SetOpened(0, true);
+}
+
+bool DebugView::Replay(const nglPath& rPath)
+{
+  if (!mReplay.Open(rPath))
+    return false;
+
+  // The executable gives the stops their modules and sources when it is still around:
+  DebuggerContext& rContext(GetDebuggerContext());
+  if (!mReplay.GetExecutable().GetPathName().IsEmpty() && rContext.LoadTarget(mReplay.GetExecutable(), nglString::Null))
+    ResetModules();
+
+  mpStart->SetEnabled(false);
+  mpPause->SetEnabled(false);
+  mpContinue->SetEnabled(false);
+  mpStepIn->SetEnabled(false);
+  mpStepOver->SetEnabled(false);
+  mpStepOut->SetEnabled(false);
+  mpPreviousStop->SetVisible(true);
+  mpNextStop->SetVisible(true);
+
+  ShowRecordedStop(0);
+  return true;
+}
+
+void DebugView::ShowRecordedStop(int32 index)
+{
+  // Pick up the stops recorded since, the log may still be growing:
+  if (index >= mReplay.GetStopCount())
+    mReplay.Refresh();
+
+  index = MIN(index, mReplay.GetStopCount() - 1);
+  mpPreviousStop->SetEnabled(index > 0);
+  mpNextStop->SetEnabled(true);
+  if (index < 0)
+    return;
+
+  // The trees point into the stop, drop them before it changes:
+  mpThreads->SetTree(NULL);
+  mpVariables->SetTree(NULL);
+  mReplayStop = SessionStop();
+  if (!mReplay.LoadStop(index, mReplayStop))
+    return;
+  mReplayIndex = index;
+
+  ProcessTree* pTree = new ProcessTree(mReplayStop);
+  pTree->Acquire();
+  pTree->Open(true);
+  mpThreads->SetTree(pTree);
+  mpThreads->SetEnabled(true);
+  mpVariables->SetEnabled(true);
+  UpdateVariablesForCurrentFrame();
+}
+
+void DebugView::OnPreviousStop(const nuiEvent& rEvent)
+{
+  ShowRecordedStop(mReplayIndex - 1);
+}
+
+void DebugView::OnNextStop(const nuiEvent& rEvent)
+{
+  ShowRecordedStop(mReplayIndex + 1);
 }
 
 void DebugView::OnDeviceConnected(iOSDevice& device)
@@ -288,8 +417,7 @@ void DebugView::OnStartLOCAL()
   }
 
 
-  mpDebuggerEventLoop = new nglThreadDelegate(nuiMakeDelegate(this, &DebugView::Loop));
-  mpDebuggerEventLoop->Start();
+  rContext.StartEvents(nuiMakeDelegate(this, &DebugView::OnDebuggerEvent));
 
   if (rContext.mDebugger.IsValid())
   {
@@ -361,8 +489,7 @@ void DebugView::OnStartIOS()
     return;
   }
 
-  mpDebuggerEventLoop = new nglThreadDelegate(nuiMakeDelegate(this, &DebugView::Loop));
-  mpDebuggerEventLoop->Start();
+  rContext.StartEvents(nuiMakeDelegate(this, &DebugView::OnDebuggerEvent));
 
 
   if (rContext.mDebugger.IsValid())
@@ -372,6 +499,7 @@ void DebugView::OnStartIOS()
     rContext.mTarget = rContext.mDebugger.CreateTargetWithFileAndArch (p.GetChars(), rContext.mpAppDescription->GetArchitecture().GetChars());
     if (rContext.mTarget.IsValid())
     {
+      rContext.ListenForModules();
 
       {
         // Change the remote executable in the target before connecting:
@@ -441,6 +569,7 @@ void DebugView::OnStartIOS()
 void DebugView::OnPause(const nuiEvent& rEvent)
 {
   DebuggerContext& rContext(GetDebuggerContext());
+  rContext.mProfiler.Stop();
   SBError error;
   StateType state = rContext.mProcess.GetState();
   NGL_OUT("State on pause: %s\n", GetStateName(state));
@@ -477,101 +606,125 @@ void DebugView::OnStepOut(const nuiEvent& rEvent)
   thread.StepOut();
 }
 
-void DebugView::Loop()
+// Called on the event thread of each context:
+void DebugView::OnDebuggerEvent(DebuggerContext& rContext, SBEvent& rEvent)
 {
-  DebuggerContext& rContext(GetDebuggerContext());
-  while (true)
-	{
-    if (rContext.mProcess.IsValid())
+  if (rEvent.BroadcasterMatchesRef(rContext.mTarget.GetBroadcaster()))
+  {
+    HandleModulesEvent(rContext, rEvent);
+    return;
+  }
+
+  StateType state = SBProcess::GetStateFromEvent(rEvent);
+  NGL_OUT("%s: %s\n", rContext.GetName().GetChars(), GetStateName(state));
+  switch (state)
+  {
+    case eStateInvalid:
+    case eStateDetached:
+    case eStateUnloaded:
+    case eStateAttaching:
+    case eStateLaunching:
+    case eStateRunning:
+    case eStateStepping:
+      nuiAnimation::RunOnAnimationTick(nuiMakeTask(this, &DebugView::OnProcessRunning, &rContext));
+      break;
+    case eStateConnected:
+      nuiAnimation::RunOnAnimationTick(nuiMakeTask(this, &DebugView::OnProcessConnected, &rContext));
+      break;
+    case eStateCrashed:
+    case eStateStopped:
+    case eStateSuspended:
+      if (rContext.mRecorder.IsOpen() && !rContext.mRecorder.RecordStop(rContext.mProcess))
+        NGL_OUT("Unable to record the stop in the session log\n");
+      nuiAnimation::RunOnAnimationTick(nuiMakeTask(this, &DebugView::OnProcessPaused, &rContext));
+      break;
+    case eStateExited:
+      nuiAnimation::RunOnAnimationTick(nuiMakeTask(this, &DebugView::UpdateTargets));
+      break;
+  }
+}
+
+void DebugView::HandleModulesEvent(DebuggerContext& rContext, SBEvent& rEvent)
+{
+  std::vector<SBModule> modules;
+  uint32_t count = SBTarget::GetNumModulesFromEvent(rEvent);
+  for (uint32_t i = 0; i < count; i++)
+    modules.push_back(SBTarget::GetModuleAtIndexFromEvent(i, rEvent));
+
+  uint32_t type = rEvent.GetType();
+  if (type & SBTarget::eBroadcastBitModulesLoaded)
+    nuiAnimation::RunOnAnimationTick(nuiMakeTask(this, &DebugView::OnModulesLoaded, &rContext, modules));
+  else if (type & SBTarget::eBroadcastBitModulesUnloaded)
+    nuiAnimation::RunOnAnimationTick(nuiMakeTask(this, &DebugView::OnModulesUnloaded, &rContext, modules));
+}
+
+// Every context keeps its index up to date, only the current one is shown:
+void DebugView::OnModulesLoaded(DebuggerContext* pContext, std::vector<SBModule> modules)
+{
+  if (!DebuggerContext::HasContext(pContext))
+    return; // Closed since
+
+  std::vector<uint32> slots;
+  pContext->AddModules(modules, slots);
+  if (pContext == &GetDebuggerContext())
+    UpdateModules(slots, true, std::set<nglString>());
+}
+
+void DebugView::OnModulesUnloaded(DebuggerContext* pContext, std::vector<SBModule> modules)
+{
+  if (!DebuggerContext::HasContext(pContext))
+    return; // Closed since
+
+  std::vector<uint32> slots;
+  std::set<nglString> files;
+  pContext->RemoveModules(modules, slots, files);
+  if (pContext == &GetDebuggerContext())
+    UpdateModules(slots, false, files);
+}
+
+void DebugView::OnLinesChanged(const std::set<nglString>& rFiles)
+{
+  UpdateModules(std::vector<uint32>(), true, rFiles);
+}
+
+void DebugView::UpdateModules(const std::vector<uint32>& rSlots, bool loaded, const std::set<nglString>& rFiles)
+{
+  // Only the module rows change, the rest of the trees stays as it is:
+  ModuleTree* pFilesTree = (ModuleTree*)mpModulesFiles->GetModel();
+  SymbolTree* pSymbolsTree = (SymbolTree*)mpModulesSymbols->GetModel();
+  if (!rSlots.empty() && pFilesTree && pSymbolsTree)
+  {
+    if (loaded)
     {
-      SBEvent evt;
-      rContext.mDebugger.GetListener().WaitForEvent(UINT32_MAX, evt);
-      StateType state = SBProcess::GetStateFromEvent(evt);
+      pFilesTree->AddModules(rSlots);
+      pSymbolsTree->AddModules(rSlots);
+    }
+    else
+    {
+      pFilesTree->RemoveModules(rSlots);
+      pSymbolsTree->RemoveModules(rSlots);
+    }
+  }
 
-      if (0 && SBProcess::GetRestartedFromEvent (evt))
-      {
-        size_t num_reasons = SBProcess::GetNumRestartedReasonsFromEvent(evt);
-        if (num_reasons > 0)
-        {
-          // FIXME: Do we want to report this, or would that just be annoyingly chatty?
-          if (num_reasons == 1)
-          {
-            char message[1024];
-            const char *reason = SBProcess::GetRestartedReasonAtIndexFromEvent (evt, 0);
-            ::snprintf (message, sizeof(message), "Process %lld stopped and restarted: %s\n",
-                        rContext.mProcess.GetProcessID(), reason ? reason : "<UNKNOWN REASON>");
-            printf("%s", message);
-          }
-          else
-          {
-            char message[1024];
-            ::snprintf (message, sizeof(message), "Process %lld stopped and restarted, reasons:\n",
-                        rContext.mProcess.GetProcessID());
-            printf("%s", message);
-            for (size_t i = 0; i < num_reasons; i++)
-            {
-              const char *reason = SBProcess::GetRestartedReasonAtIndexFromEvent (evt, i);
-              ::snprintf(message, sizeof(message), "\t%s\n", reason ? reason : "<UNKNOWN REASON>");
-              printf("%s", message);
-            }
-          }
-        }
-      }
+  // The executable lines and the breakpoints of these files may have changed:
+  for (auto it = rFiles.begin(); it != rFiles.end(); ++it)
+  {
+    auto file = mFiles.find(*it);
+    if (file == mFiles.end())
+      continue;
 
-      if (SBProcess::GetRestartedFromEvent(evt))
-        continue;
-      switch (state)
-      {
-        case eStateInvalid:
-          printf("StateInvalid\n");
-          nuiAnimation::RunOnAnimationTick(nuiMakeTask(this, &DebugView::OnProcessRunning));
-          break;
-        case eStateDetached:
-          printf("StateDetached\n");
-          nuiAnimation::RunOnAnimationTick(nuiMakeTask(this, &DebugView::OnProcessRunning));
-          break;
-        case eStateCrashed:
-          printf("StateCrashed\n");
-          nuiAnimation::RunOnAnimationTick(nuiMakeTask(this, &DebugView::OnProcessPaused));
-          break;
-        case eStateUnloaded:
-          printf("StateUnloaded\n");
-          nuiAnimation::RunOnAnimationTick(nuiMakeTask(this, &DebugView::OnProcessRunning));
-          break;
-        case eStateExited:
-          printf("StateExited\n");
-          break;
-        case eStateConnected:
-          printf("StateConnected\n");
-          nuiAnimation::RunOnAnimationTick(nuiMakeTask(this, &DebugView::OnProcessConnected));
-          break;
-        case eStateAttaching:
-          printf("StateAttaching\n");
-          nuiAnimation::RunOnAnimationTick(nuiMakeTask(this, &DebugView::OnProcessRunning));
-          break;
-        case eStateLaunching:
-          printf("StateLaunching\n");
-          nuiAnimation::RunOnAnimationTick(nuiMakeTask(this, &DebugView::OnProcessRunning));
-          break;
-        case eStateRunning:
-          //printf("StateRunning\n"); break;
-        case eStateStepping:
-          printf("StateStepping\n");
-          nuiAnimation::RunOnAnimationTick(nuiMakeTask(this, &DebugView::OnProcessRunning));
-          break;
-        case eStateStopped:
-        case eStateSuspended:
-          printf("StateStopped or StateSuspended\n");
-          nuiAnimation::RunOnAnimationTick(nuiMakeTask(this, &DebugView::OnProcessPaused));
-          break;
-			}
-		}
-  }
-}
-
-void DebugView::OnProcessConnected()
+    nuiWidget* pView = file->second->SearchForChild("source", true);
+    if (pView)
+      pView->Invalidate();
+  }
+}
+
+void DebugView::OnProcessConnected(DebuggerContext* pContext)
 {
-  DebuggerContext& rContext(GetDebuggerContext());
+  if (!DebuggerContext::HasContext(pContext))
+    return; // Closed since
+
+  DebuggerContext& rContext(*pContext);
   StateType state = rContext.mProcess.GetState();
 
 
@@ -598,8 +751,13 @@ void DebugView::OnProcessConnected()
   NGL_OUT("Remote Launch result: %s\n", error.GetCString());
 }
 
-void DebugView::OnProcessPaused()
+void DebugView::OnProcessPaused(DebuggerContext* pContext)
 {
+  // The stops of the other targets wait for the user to switch to them:
+  UpdateTargets();
+  if (pContext != &GetDebuggerContext())
+    return;
+
   mpStart->SetEnabled(false);
   mpPause->SetEnabled(false);
   mpContinue->SetEnabled(true);
@@ -611,8 +769,12 @@ void DebugView::OnProcessPaused()
   UpdateProcess();
 }
 
-void DebugView::OnProcessRunning()
+void DebugView::OnProcessRunning(DebuggerContext* pContext)
 {
+  UpdateTargets();
+  if (pContext != &GetDebuggerContext())
+    return;
+
   mpStart->SetEnabled(false);
   mpPause->SetEnabled(true);
   mpContinue->SetEnabled(false);
@@ -623,8 +785,215 @@ void DebugView::OnProcessRunning()
   mpVariables->SetEnabled(false);
 }
 
+void DebugView::OnOpenCore(const nuiEvent& rEvent)
+{
+  nglWindow* pWindow = ((nuiMainWindow*)GetTopLevel())->GetNGLWindow();
+  NGL_ASSERT(pWindow);
+
+  ChooseFileParams params;
+  params.mCompletionDelegate = nuiMakeDelegate(this, &DebugView::OnCoreChosen);
+  ChooseFileDialog(pWindow, params);
+}
+
+void DebugView::OnCoreChosen(const ChooseFileParams& rParams)
+{
+  if (rParams.mFiles.empty())
+    return;
+
+  if (!OpenCore(rParams.mFiles[0]))
+    NGL_OUT("Unable to open core file %s\n", rParams.mFiles[0].GetChars());
+}
+
+bool DebugView::OpenCore(const nglPath& rPath)
+{
+  // A live process keeps its target, the core gets one of its own:
+  DebuggerContext* pContext = &GetDebuggerContext();
+  if (pContext->mProcess.IsValid())
+  {
+    DebuggerContext* pNew = new DebuggerContext();
+    pNew->mpAppDescription = pContext->mpAppDescription;
+    pContext = pNew;
+  }
+
+  nglPath executable;
+  if (pContext->mpAppDescription)
+    executable = pContext->mpAppDescription->GetLocalPath();
+  if (!pContext->LoadCore(rPath, executable))
+  {
+    if (pContext != &GetDebuggerContext())
+      delete pContext;
+    return false;
+  }
+
+  // Nothing to launch or resume, the core is a stop to browse:
+  if (pContext == &GetDebuggerContext())
+  {
+    ResetModules();
+    OnProcessPaused(pContext);
+  }
+  else
+  {
+    SelectContext(pContext);
+  }
+  mpContinue->SetEnabled(false);
+  mpStepIn->SetEnabled(false);
+  mpStepOver->SetEnabled(false);
+  mpStepOut->SetEnabled(false);
+  return true;
+}
+
+void DebugView::OnAddTarget(const nuiEvent& rEvent)
+{
+  nglWindow* pWindow = ((nuiMainWindow*)GetTopLevel())->GetNGLWindow();
+  NGL_ASSERT(pWindow);
+
+  ChooseFileParams params;
+  params.mCompletionDelegate = nuiMakeDelegate(this, &DebugView::OnTargetChosen);
+  ChooseFileDialog(pWindow, params);
+}
+
+void DebugView::OnTargetChosen(const ChooseFileParams& rParams)
+{
+  if (rParams.mFiles.empty())
+    return;
+
+  int index = AppDescription::AddApp(rParams.mFiles[0]);
+  AppDescription* pApp = AppDescription::GetApp(index);
+  if (!pApp || !pApp->IsValid())
+  {
+    NGL_OUT("Unable to add target %s\n", rParams.mFiles[0].GetChars());
+    return;
+  }
+
+  // Lives until the application quits, like the first one:
+  DebuggerContext* pContext = new DebuggerContext();
+  pContext->mpAppDescription = pApp;
+  if (!pContext->LoadApp())
+    NGL_OUT("Unable to load target %s\n", pApp->GetName().GetChars());
+
+  AddContext(pContext);
+  SelectContext(pContext);
+}
+
+void DebugView::AddContext(DebuggerContext* pContext)
+{
+  pContext->StartEvents(nuiMakeDelegate(this, &DebugView::OnDebuggerEvent));
+  UpdateTargets();
+}
+
+void DebugView::OnCloseTarget(const nuiEvent& rEvent)
+{
+  CloseContext(&GetDebuggerContext());
+}
+
+void DebugView::CloseContext(DebuggerContext* pContext)
+{
+  XSPRAY_TRACE("DebugView::CloseContext");
+
+  // The views always show a context, the trees of the closed one are dropped when switching away from it:
+  DebuggerContext* pNext = DebuggerContext::GetContext(DebuggerContext::GetContext(0) == pContext ? 1 : 0);
+  if (!pNext)
+    pNext = new DebuggerContext();
+  if (pContext == &GetDebuggerContext())
+    SelectContext(pNext);
+
+  pContext->Close();
+  UpdateTargets();
+  nuiAnimation::RunOnAnimationTick(nuiMakeTask(this, &DebugView::DeleteContext, pContext));
+}
+
+void DebugView::DeleteContext(DebuggerContext* pContext)
+{
+  delete pContext;
+}
+
+void DebugView::OnTargetSelected(const nuiEvent& rEvent)
+{
+  DebuggerContext* pContext = NULL;
+  nuiWidget* pLine = mpTargets->GetSelected();
+  if (pLine && nuiGetTokenValue<DebuggerContext*>(pLine->GetToken(), pContext))
+    SelectContext(pContext);
+}
+
+void DebugView::SelectContext(DebuggerContext* pContext)
+{
+  if (pContext == &GetDebuggerContext())
+    return;
+
+  XSPRAY_TRACE("DebugView::SelectContext");
+  DebuggerContext::SetCurrent(pContext);
+  mContextSink.DisconnectAll();
+  mContextSink.Connect(pContext->mSymbolIndex.Changed, nuiMakeDelegate(this, &DebugView::OnSymbolIndexChanged));
+  mContextSink.Connect(pContext->LinesChanged, nuiMakeDelegate(this, &DebugView::OnLinesChanged));
+
+  // Everything shown comes from the new context:
+  mpThreads->SetTree(NULL);
+  mpVariables->SetTree(NULL);
+  ResetModules();
+  UpdateSymbolResults();
+  mpWatchTimeline->SetWatchpoint(NULL);
+  UpdateWatchpoints();
+  UpdateProfile();
+  mResources.Stop();
+  ClearResources();
+  mLogDropped = pContext->mLogBuffer.GetDropped();
+
+  StateType state = pContext->mProcess.GetState();
+  if (state == eStateStopped || state == eStateSuspended || state == eStateCrashed)
+  {
+    OnProcessPaused(pContext);
+  }
+  else if (pContext->mProcess.IsValid() && state != eStateExited && state != eStateDetached)
+  {
+    OnProcessRunning(pContext);
+  }
+  else
+  {
+    mpStart->SetEnabled(true);
+    mpPause->SetEnabled(false);
+    mpContinue->SetEnabled(false);
+    mpStepIn->SetEnabled(false);
+    mpStepOver->SetEnabled(false);
+    mpStepOut->SetEnabled(false);
+    UpdateTargets();
+  }
+}
+
+void DebugView::UpdateTargets()
+{
+  int32 count = DebuggerContext::GetContextCount();
+  bool rebuild = mpTargets->GetChildrenCount() != count;
+  if (rebuild)
+    mpTargets->Clear();
+
+  for (int32 i = 0; i < count; i++)
+  {
+    DebuggerContext* pContext = DebuggerContext::GetContext(i);
+    nglString str(pContext->GetName());
+    if (pContext->mProcess.IsValid())
+    {
+      nglString state;
+      state.CFormat(" [%llu] %s", pContext->mProcess.GetProcessID(), GetStateName(pContext->mProcess.GetState()));
+      str.Add(state);
+    }
+
+    if (!rebuild)
+    {
+      ((nuiLabel*)mpTargets->GetChild(i))->SetText(str);
+      continue;
+    }
+
+    nuiLabel* pLabel = new nuiLabel(str);
+    pLabel->SetToken(new nuiToken<DebuggerContext*>(pContext));
+    mpTargets->AddChild(pLabel);
+    if (pContext == &GetDebuggerContext())
+      pLabel->SetSelected(true);
+  }
+}
+
 void DebugView::UpdateProcess()
 {
+  XSPRAY_TRACE("DebugView::UpdateProcess");
   DebuggerContext& rContext(GetDebuggerContext());
   //PrintDebugState(rContext.mProcess);
 
@@ -647,35 +1016,39 @@ void DebugView::SelectThread(SBThread thread)
 
 void DebugView::UpdateVariables(SBFrame frame)
 {
+  XSPRAY_TRACE("DebugView::UpdateVariables");
   nuiTreeNode* pTree = new nuiTreeNode("Variables");
 
   DynamicValueType dynamic = eDynamicCanRunTarget; // eNoDynamicValues, eDynamicCanRunTarget, eDynamicDontRunTarget
   SBValueList args;
-  args = frame.GetVariables(
-                            true, //bool arguments,
-                            false, //bool locals,
-                            false, //bool statics,
-                            false, //bool in_scope_only);
-                            dynamic
-                            );
-
   SBValueList locals;
-  locals = frame.GetVariables(
-                              false, //bool arguments,
-                              true, //bool locals,
+  SBValueList globals;
+  {
+    XSPRAY_TRACE("SBFrame::GetVariables");
+    args = frame.GetVariables(
+                              true, //bool arguments,
+                              false, //bool locals,
                               false, //bool statics,
                               false, //bool in_scope_only);
                               dynamic
                               );
 
-  SBValueList globals;
-  globals = frame.GetVariables(
-                               false, //bool arguments,
-                               false, //bool locals,
-                               true, //bool statics,
-                               false, //bool in_scope_only);
-                               dynamic
-                               );
+    locals = frame.GetVariables(
+                                false, //bool arguments,
+                                true, //bool locals,
+                                false, //bool statics,
+                                false, //bool in_scope_only);
+                                dynamic
+                                );
+
+    globals = frame.GetVariables(
+                                 false, //bool arguments,
+                                 false, //bool locals,
+                                 true, //bool statics,
+                                 false, //bool in_scope_only);
+                                 dynamic
+                                 );
+  }
 
   uint32_t count = 0;
   nuiTreeNode* pArgNode = new nuiTreeNode("Arguments");
@@ -748,12 +1121,25 @@ void DebugView::SelectFrame(SBFrame frame)
   ShowSource(p, line, col);
 }
 
+void DebugView::SelectRecordedFrame(const SessionStop::Frame& rFrame)
+{
+  nuiTreeNode* pTree = new nuiTreeNode("Variables");
+  for (int32 i = 0; i < rFrame.mVariables.size(); i++)
+    pTree->AddChild(new VariableNode(rFrame.mVariables[i]));
+  pTree->Open(true);
+  mpVariables->SetTree(pTree);
+
+  if (!rFrame.mPath.IsEmpty())
+    ShowSource(rFrame.mPath, rFrame.mLine, rFrame.mColumn);
+}
+
 void DebugView::ShowSource(const nglPath& rPath, int32 line, int32 col)
 {
   auto it = mFiles.find(rPath.GetPathName());
   if (it == mFiles.end())
   {
-    if (!rPath.Exists() || !rPath.IsLeaf())
+    nglPath file;
+    if (!GetDebuggerContext().mSourceResolver.Resolve(rPath, file))
       return;
 
     std::map<nglString, nglString> dico;
@@ -775,7 +1161,8 @@ void DebugView::ShowSource(const nglPath& rPath, int32 line, int32 col)
     NGL_ASSERT(pCloser != NULL);
     mEventSink.Connect(pCloser->Activated, &DebugView::OnCloseTab, pWidget);
 
-    pView->Load(rPath);
+    if (!pView->Load(rPath, file))
+      GetDebuggerContext().mSourceResolver.Invalidate(rPath);
     mpFilesTabView->SelectTab(tab);
     mpFilesTabView->UpdateLayout();
     pView->ShowText(line, col);
@@ -839,7 +1226,10 @@ void DebugView::UpdateVariablesForCurrentFrame()
       break;
     case ProcessTree::eFrame:
       // Select the frame
-      SelectFrame(pNode->GetFrame());
+      if (pNode->GetRecordedFrame())
+        SelectRecordedFrame(*pNode->GetRecordedFrame());
+      else
+        SelectFrame(pNode->GetFrame());
       break;
   }
 }
@@ -851,14 +1241,15 @@ void DebugView::OnThreadSelectionChanged(const nuiEvent& rEvent)
 
 void DebugView::OnModuleFileSelectionChanged(const nuiEvent& rEvent)
 {
-  ModuleTree* pNode = (ModuleTree*)mpModulesFiles->GetSelectedNode();
-  if (!pNode)
+  const RowModel::Row* pRow = mpModulesFiles->GetSelectedRow();
+  if (!pRow)
     return;
-  
-  if (pNode->GetType() != ModuleTree::eCompileUnit)
+
+  ModuleTree* pTree = (ModuleTree*)mpModulesFiles->GetModel();
+  if (pTree->GetType(*pRow) != ModuleTree::eCompileUnit)
     return;
-  
-  nglPath p = pNode->GetSourcePath();
+
+  nglPath p = pTree->GetSourcePath(*pRow);
   ShowSource(p, 0, 0);
 }
 
@@ -875,18 +1266,118 @@ void DebugView::OnModuleSymbolSelectionChanged(const nuiEvent& rEvent)
 //  ShowSource(p, 0, 0);
 }
 
+void DebugView::OnSymbolSearchChanged(const nuiEvent& rEvent)
+{
+  UpdateSymbolResults();
+}
+
+void DebugView::OnSymbolIndexChanged()
+{
+  // More modules became searchable, refresh the current query:
+  UpdateSymbolResults();
+}
+
+void DebugView::UpdateSymbolResults()
+{
+  mpSymbolResults->Clear();
+
+  nglString query(mpSymbolSearch->GetText());
+  query.Trim();
+  if (query.IsEmpty())
+    return;
+
+  const SymbolIndex& rIndex(GetDebuggerContext().mSymbolIndex);
+  std::vector<SymbolIndex::Match> matches;
+  rIndex.Search(query, matches, 200);
+
+  for (auto it = matches.begin(); it != matches.end(); ++it)
+  {
+    const SymbolIndex::Match& rMatch(*it);
+    nglString str(rIndex.GetName(rMatch));
+    str.Add("  (").Add(rIndex.GetModule(rMatch).GetFileSpec().GetFilename()).Add(")");
+    nuiLabel* pLabel = new nuiLabel(str);
+    pLabel->SetToken(new nuiToken<SymbolIndex::Match>(rMatch));
+    mpSymbolResults->AddChild(pLabel);
+  }
+}
+
+void DebugView::OnSymbolResultSelected(const nuiEvent& rEvent)
+{
+  nuiWidget* pLine = mpSymbolResults->GetSelected();
+  if (!pLine)
+    return;
+
+  SymbolIndex::Match match;
+  if (!nuiGetTokenValue<SymbolIndex::Match>(pLine->GetToken(), match))
+    return;
+
+  lldb::SBLineEntry entry = GetDebuggerContext().mSymbolIndex.GetAddress(match).GetLineEntry();
+  if (!entry.IsValid())
+    return;
+
+  lldb::SBFileSpec file = entry.GetFileSpec();
+  nglPath p(file.GetDirectory());
+  p += nglString(file.GetFilename());
+  ShowSource(p, entry.GetLine(), entry.GetColumn());
+}
+
+void DebugView::OnSymbolBreak(const nuiEvent& rEvent)
+{
+  nuiWidget* pLine = mpSymbolResults->GetSelected();
+  if (!pLine)
+    return;
+
+  SymbolIndex::Match match;
+  if (!nuiGetTokenValue<SymbolIndex::Match>(pLine->GetToken(), match))
+    return;
+
+  // The module of the symbol may have been unloaded since the search:
+  DebuggerContext& rContext(GetDebuggerContext());
+  nglString name(rContext.mSymbolIndex.GetName(match));
+  if (!name.IsEmpty())
+    rContext.CreateBreakpointByName(name);
+}
+
 
 void DebugView::OnLineSelected(const nglPath& rPath, float X, float Y, int32 line, bool ingutter)
 {
   printf("OnLineSelected: %f,%f -- %d (in gutter: %s)\n", X, Y, line + 1, YESNO(ingutter));
   if (ingutter)
   {
+    // A breakpoint on the clicked line is removed, even if the line has no code anymore:
     Breakpoint* pBP = GetDebuggerContext().GetBreakpointByLocation(rPath, line + 1, 0);
+    const LineTable* pLineTable = GetDebuggerContext().GetLineTable(rPath);
+    if (!pBP && pLineTable)
+    {
+      // Otherwise snap to the first line that actually generated code, without leaving the function that was clicked:
+      int32 executable = pLineTable->GetExecutableLine(line + 1);
+      if (executable < 0)
+        return;
+      if (executable != line + 1)
+      {
+        int32 first = pLineTable->GetFunctionLine(executable);
+        if (first < 0 || first > line + 1)
+          return;
+      }
+      line = executable - 1;
+      pBP = GetDebuggerContext().GetBreakpointByLocation(rPath, line + 1, 0);
+    }
+
     if (pBP)
       GetDebuggerContext().DeleteBreakpoint(pBP);
     else
     {
       pBP = GetDebuggerContext().CreateBreakpointByLocation(rPath, line + 1, 0);
+
+      // Alt turns it into a logpoint:
+      if (IsKeyDown(NK_ALT))
+      {
+        std::vector<nglString> expressions;
+        mpLogExpressions->GetText().Tokenize(expressions, ',');
+        for (int32 i = 0; i < expressions.size(); i++)
+          expressions[i].Trim();
+        pBP->SetLogExpressions(expressions);
+      }
     }
 
     auto it = mFiles.find(rPath.GetPathName());
@@ -909,30 +1400,400 @@ void DebugView::OnVariableSelectionChanged(const nuiEvent& rEvent)
     return;
 
   SBValue val = pNode->GetValue();
+  if (!val.IsValid())
+    return;
+
+  if (AddStructArraySources(val))
+    return;
+
   ValueArray* pVal = new ValueArray(val);
   mpGraphView->AddSource(pVal);
 }
 
+// Arrays of structs are read in one go and get one curve per scalar member:
+bool DebugView::AddStructArraySources(SBValue value)
+{
+  SBType type = value.GetType().GetCanonicalType();
+  if (type.GetTypeClass() != eTypeClassArray)
+    return false;
+
+  int32 count = value.GetNumChildren();
+  if (count <= 0)
+    return false;
+
+  const TypeLayout* pLayout = GetDebuggerContext().mTypeCatalog.GetLayout(value.GetChildAtIndex(0));
+  if (!pLayout)
+    return false;
+
+  uint32 stride = pLayout->GetByteSize();
+  std::vector<uint8> data;
+  if (!ReadValueMemory(value, stride * count, data))
+    return false;
+
+  static const char* colors[] = { "red", "blue", "green", "orange", "purple", "brown", "magenta", "cyan" };
+  int32 curves = 0;
+  for (int32 i = 0; i < pLayout->GetFieldCount(); i++)
+  {
+    const TypeLayout::Field& rField(pLayout->GetField(i));
+    if (!TypeLayout::IsDecoded(rField))
+      continue;
+
+    GraphOptions options;
+    options.mName = rField.mName;
+    options.mColor = nuiColor(colors[curves++ % (sizeof(colors) / sizeof(colors[0]))]);
+    mpGraphView->AddSource(new MemoryArray(&data[0], count, stride, rField), options);
+  }
+
+  return true;
+}
+
 void DebugView::OnHandleSTDIO(const nuiEvent& event)
 {
-  DebuggerContext& rContext(GetDebuggerContext());
-  lldb::SBProcess process(rContext.mProcess);
-  char buffer[10000];
-  memset(buffer, 0, sizeof(buffer));
-  size_t outcount = 0;
-  while ((outcount = process.GetSTDOUT(buffer, sizeof(buffer))))
-  {
-    mpOutput->AddText(nglString(buffer, outcount));
-    printf("OUT> %s", buffer);
+  UpdateLog();
+
+  mpWatchTimeline->Update();
+  UpdateResources();
+
+  // Refresh the profile while sampling and once more when it stops:
+  if (mProfileUpdate && nglTime() - mProfileUpdate >= PROFILE_UPDATE_INTERVAL)
+    UpdateProfile();
+
+  // Every target writes to the same panels, prefixed by its name when there are several:
+  int32 count = DebuggerContext::GetContextCount();
+  for (int32 i = 0; i < count; i++)
+  {
+    DebuggerContext* pContext = DebuggerContext::GetContext(i);
+    lldb::SBProcess process(pContext->mProcess);
+    if (!process.IsValid())
+      continue;
+
+    nglString prefix;
+    if (count > 1)
+      prefix = pContext->GetName() + "> ";
+
+    char buffer[10000];
     memset(buffer, 0, sizeof(buffer));
+    size_t outcount = 0;
+    while ((outcount = process.GetSTDOUT(buffer, sizeof(buffer))))
+    {
+      mpOutput->AddText(prefix + nglString(buffer, outcount));
+      printf("OUT> %s", buffer);
+      memset(buffer, 0, sizeof(buffer));
+    }
+
+    while ((outcount = process.GetSTDERR(buffer, sizeof(buffer))))
+    {
+      mpErrors->AddText(prefix + nglString(buffer, outcount));
+      printf("ERR> %s", buffer);
+      memset(buffer, 0, sizeof(buffer));
+    }
   }
+}
 
-  while ((outcount = process.GetSTDERR(buffer, sizeof(buffer))))
+#define LOG_BATCH_SIZE 4096 // Lines moved from the log buffer to the panel per tick
+
+void DebugView::UpdateLog()
+{
+  LogBuffer& rBuffer(GetDebuggerContext().mLogBuffer);
+  mLogEntries.clear();
+  if (!rBuffer.Read(mLogEntries, LOG_BATCH_SIZE))
+    return;
+
+  // One update of the text per batch:
+  XSPRAY_TRACE("DebugView::UpdateLog");
+  nglString text;
+  for (int32 i = 0; i < mLogEntries.size(); i++)
   {
-    mpErrors->AddText(nglString(buffer, outcount));
-    printf("ERR> %s", buffer);
-    memset(buffer, 0, sizeof(buffer));
+    const LogBuffer::Entry& rEntry(mLogEntries[i]);
+    nglString line;
+    line.CFormat("[%d] 0x%llx: %s\n", rEntry.mBreakpointID, rEntry.mThreadID, rEntry.mText);
+    text.Add(line);
   }
+
+  uint64 dropped = rBuffer.GetDropped();
+  if (dropped != mLogDropped)
+  {
+    nglString line;
+    line.CFormat("... %llu lines dropped\n", dropped - mLogDropped);
+    text.Add(line);
+    mLogDropped = dropped;
+  }
+
+  mpLog->AddText(text);
+}
+
+void DebugView::OnProfile(const nuiEvent& rEvent)
+{
+  DebuggerContext& rContext(GetDebuggerContext());
+  Profiler& rProfiler(rContext.mProfiler);
+  if (rProfiler.IsSampling())
+  {
+    rProfiler.Stop();
+    mProfileUpdate = 0;
+    UpdateProfile();
+    return;
+  }
+
+  rProfiler.SetRate(mpProfileRate->GetText().GetCDouble());
+  rProfiler.SetMaxDepth(mpProfileDepth->GetText().GetCInt());
+  rProfiler.Clear();
+  if (!rProfiler.Start(rContext.mProcess))
+    mpProfileStatus->SetText("The process must be running to be profiled");
+  mProfileUpdate = nglTime();
+}
+
+void DebugView::UpdateProfile()
+{
+  XSPRAY_TRACE("DebugView::UpdateProfile");
+  const Profiler& rProfiler(GetDebuggerContext().mProfiler);
+  mProfileUpdate = rProfiler.IsSampling() ? (double)nglTime() : 0;
+
+  Profiler::Node root;
+  rProfiler.GetTree(root);
+
+  nglString status;
+  status.CFormat("%u samples, %.1f%% overhead", root.mTotal, rProfiler.GetOverhead() * 100.0);
+  mpProfileStatus->SetText(status);
+
+  nuiTreeNode* pTree = CreateProfileNode(root, root.mTotal);
+  pTree->Open(true);
+  mpProfileTree->SetTree(pTree);
+  mpFlameGraph->SetTree(root);
+}
+
+#define PROFILE_MIN_SHARE 0.001 // Functions with less of the samples are left out of the call tree
+
+static bool HeavierProfileNode(const Profiler::Node* pA, const Profiler::Node* pB)
+{
+  return pA->mTotal > pB->mTotal;
+}
+
+nuiTreeNode* DebugView::CreateProfileNode(const Profiler::Node& rNode, uint32 samples)
+{
+  nglString str;
+  str.CFormat("%5.1f%% %5.1f%%  %s", 100.0 * rNode.mTotal / MAX(samples, 1u), 100.0 * rNode.mSelf / MAX(samples, 1u), rNode.mFunction.GetChars());
+  nuiTreeNode* pNode = new nuiTreeNode(new nuiLabel(str));
+
+  // Heaviest callees first:
+  std::vector<const Profiler::Node*> children;
+  for (auto it = rNode.mChildren.begin(); it != rNode.mChildren.end(); ++it)
+  {
+    if (it->second.mTotal >= samples * PROFILE_MIN_SHARE)
+      children.push_back(&it->second);
+  }
+  std::sort(children.begin(), children.end(), HeavierProfileNode);
+
+  for (int32 i = 0; i < children.size(); i++)
+    pNode->AddChild(CreateProfileNode(*children[i], samples));
+  return pNode;
+}
+
+void DebugView::OnAddWatch(const nuiEvent& rEvent)
+{
+  nglString expression(mpWatchExpression->GetText());
+  expression.Trim();
+  if (expression.IsEmpty())
+    return;
+
+  // Resolved in the frame selected in the threads view:
+  SBFrame frame;
+  ProcessTree* pNode = (ProcessTree*)mpThreads->GetSelectedNode();
+  if (pNode && pNode->GetType() == ProcessTree::eFrame)
+    frame = pNode->GetFrame();
+  else
+    frame = GetDebuggerContext().mProcess.GetSelectedThread().GetSelectedFrame();
+
+  Breakpoint* pWatchpoint = GetDebuggerContext().CreateWatchpoint(expression, frame);
+  if (!pWatchpoint)
+  {
+    mpWatchHit->SetText("Unable to watch " + expression);
+    return;
+  }
+
+  UpdateWatchpoints();
+}
+
+void DebugView::UpdateWatchpoints()
+{
+  const Breakpoint* pSelected = NULL;
+  nuiWidget* pLine = mpWatchpoints->GetSelected();
+  if (pLine)
+    nuiGetTokenValue<const Breakpoint*>(pLine->GetToken(), pSelected);
+
+  std::vector<Breakpoint*> watchpoints;
+  GetDebuggerContext().GetWatchpoints(watchpoints);
+  mpWatchpoints->Clear();
+  for (int32 i = 0; i < watchpoints.size(); i++)
+  {
+    nglString str;
+    str.CFormat("%s @ 0x%llx (%d bytes)", watchpoints[i]->GetSymbol().GetChars(), watchpoints[i]->GetWatchAddress(),
+                watchpoints[i]->GetWatchSize());
+    nuiLabel* pLabel = new nuiLabel(str);
+    pLabel->SetToken(new nuiToken<const Breakpoint*>(watchpoints[i]));
+    mpWatchpoints->AddChild(pLabel);
+
+    // Keep the selection, or select the new one:
+    if (watchpoints[i] == pSelected || (!pSelected && i == watchpoints.size() - 1))
+      pLabel->SetSelected(true);
+  }
+}
+
+void DebugView::OnWatchpointSelected(const nuiEvent& rEvent)
+{
+  const Breakpoint* pWatchpoint = NULL;
+  nuiWidget* pLine = mpWatchpoints->GetSelected();
+  if (pLine)
+    nuiGetTokenValue<const Breakpoint*>(pLine->GetToken(), pWatchpoint);
+  mpWatchTimeline->SetWatchpoint(pWatchpoint);
+}
+
+void DebugView::OnWatchCursorMoved(int32 index)
+{
+  const Breakpoint::WatchHit* pHit = mpWatchTimeline->GetHit(index);
+  if (!pHit)
+  {
+    mpWatchHit->SetText(nglString::Null);
+    return;
+  }
+
+  DebuggerContext& rContext(GetDebuggerContext());
+  AddressIndex::Location location;
+  rContext.mAddressIndex.Rebase(rContext.mTarget);
+  rContext.mAddressIndex.Lookup(pHit->mPC, location);
+
+  nglString str;
+  str.CFormat("Write %d: %lld -> %lld (0x%llx -> 0x%llx) by thread 0x%llx at 0x%llx %s", index + 1, pHit->mOldValue, pHit->mNewValue,
+              pHit->mOldValue, pHit->mNewValue, pHit->mThreadID, pHit->mPC, location.mFunction.GetChars());
+  mpWatchHit->SetText(str);
+
+  // Only follow the writes in the source when the user scrubs:
+  if (!location.mPath.IsEmpty() && mpWatchTimeline->HasGrab())
+    ShowSource(nglPath(location.mPath), location.mLine, 0);
+}
+
+static void AddResourceSeries(GraphView* pGraph, RingArray* pSeries, const char* pColor, const char* pName)
+{
+  GraphOptions options;
+  options.mColor = nuiColor(pColor);
+  options.mName = pName;
+  pGraph->AddSource(pSeries, options);
 }
 
+void DebugView::ClearResources()
+{
+  // The plots own the series:
+  mpResourceStops->DelAllSources();
+  mpResourceCPU->DelAllSources();
+  mpResourceMemory->DelAllSources();
+  mpResourceEvents->DelAllSources();
+  mThreadSeries.clear();
+  mResourceCount = 0;
+
+  mpStoppedSeries = new RingArray(RESOURCE_HISTORY);
+  mpCPUSeries = new RingArray(RESOURCE_HISTORY);
+  mpResidentSeries = new RingArray(RESOURCE_HISTORY);
+  mpVirtualSeries = new RingArray(RESOURCE_HISTORY);
+  mpFaultsSeries = new RingArray(RESOURCE_HISTORY);
+  mpSwitchesSeries = new RingArray(RESOURCE_HISTORY);
+  mpFilesSeries = new RingArray(RESOURCE_HISTORY);
+  AddResourceSeries(mpResourceStops, mpStoppedSeries, "red", "Stopped");
+  AddResourceSeries(mpResourceCPU, mpCPUSeries, "black", "CPU");
+  AddResourceSeries(mpResourceMemory, mpResidentSeries, "blue", "RSS");
+  AddResourceSeries(mpResourceMemory, mpVirtualSeries, "gray", "VSIZE");
+  AddResourceSeries(mpResourceEvents, mpFaultsSeries, "orange", "Faults");
+  AddResourceSeries(mpResourceEvents, mpSwitchesSeries, "purple", "Context switches");
+  AddResourceSeries(mpResourceEvents, mpFilesSeries, "green", "Files");
+
+  mpResourceStatus->SetText(nglString::Null);
+}
+
+void DebugView::UpdateResources()
+{
+  // Follow the process of the current target when it runs on this machine, a core has none:
+  DebuggerContext& rContext(GetDebuggerContext());
+  StateType state = rContext.mProcess.GetState();
+  ::pid_t pid = 0;
+  if (rContext.mProcess.IsValid() && !rContext.mCore.IsOpen() && state != eStateExited && state != eStateDetached
+      && !(rContext.mpAppDescription && rContext.mpAppDescription->GetTargetOS() == "ios"))
+    pid = rContext.mProcess.GetProcessID();
+
+  // The plots keep the history of a process that is gone until the next one starts:
+  if (!pid)
+  {
+    mResources.Stop();
+  }
+  else if (pid != mResources.GetPid())
+  {
+    ClearResources();
+    mResources.Start(pid);
+  }
+
+  std::vector<ResourceMonitor::Sample> samples;
+  mResourceCount = mResources.Read(samples, mResourceCount);
+  if (samples.empty())
+    return;
+
+  XSPRAY_TRACE("DebugView::UpdateResources");
+  for (int32 i = 0; i < samples.size(); i++)
+  {
+    const ResourceMonitor::Sample& rSample(samples[i]);
+    mpStoppedSeries->Push(rSample.mStopped ? 1 : 0);
+    mpCPUSeries->Push(rSample.mCPU);
+    mpResidentSeries->Push(rSample.mResident / (1024.0 * 1024.0));
+    mpVirtualSeries->Push(rSample.mVirtual / (1024.0 * 1024.0));
+    mpFaultsSeries->Push(rSample.mFaults);
+    mpSwitchesSeries->Push(rSample.mSwitches);
+    mpFilesSeries->Push(rSample.mFiles);
+
+    // A new thread starts at the current time, the series of a thread that is gone keeps its history:
+    std::set<uint64> seen;
+    for (int32 t = 0; t < rSample.mThreads.size(); t++)
+    {
+      uint64 thread = rSample.mThreads[t].first;
+      RingArray*& rpSeries(mThreadSeries[thread]);
+      if (!rpSeries)
+      {
+        rpSeries = new RingArray(RESOURCE_HISTORY);
+        for (int32 v = 1; v < mpCPUSeries->GetNumValues(); v++)
+          rpSeries->Push(0);
+
+        nglString name;
+        name.CFormat("Thread 0x%llx", thread);
+        GraphOptions options;
+        options.mColor = nuiColor("lightgray");
+        options.mWeight = 1;
+        options.mName = name;
+        mpResourceCPU->AddSource(rpSeries, options);
+      }
+      rpSeries->Push(rSample.mThreads[t].second);
+      seen.insert(thread);
+    }
+
+    for (auto it = mThreadSeries.begin(); it != mThreadSeries.end(); ++it)
+    {
+      if (seen.find(it->first) == seen.end())
+        it->second->Push(0);
+    }
+  }
+
+  int32 count = mpCPUSeries->GetNumValues();
+  ScrollResources(mpResourceStops, count);
+  ScrollResources(mpResourceCPU, count);
+  ScrollResources(mpResourceMemory, count);
+  ScrollResources(mpResourceEvents, count);
+
+  const ResourceMonitor::Sample& rLast(samples.back());
+  nglString status;
+  status.CFormat("%s  CPU %.1f%%  %d threads  RSS %.1f MB  VSIZE %.1f MB  %.0f faults/s  %.0f switches/s  %d files",
+                 rLast.mStopped ? "Stopped" : "Running", rLast.mCPU, (int32)rLast.mThreads.size(), rLast.mResident / (1024.0 * 1024.0),
+                 rLast.mVirtual / (1024.0 * 1024.0), rLast.mFaults, rLast.mSwitches, rLast.mFiles);
+  mpResourceStatus->SetText(status);
+}
 
+void DebugView::ScrollResources(GraphView* pGraph, int32 count)
+{
+  // One value per pixel, the most recent on the right edge:
+  int32 width = MAX((int32)pGraph->GetRect().GetWidth(), 1);
+  pGraph->SetRange(MAX(count - width, 0), width);
+  pGraph->Invalidate();
+}
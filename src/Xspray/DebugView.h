@@ -16,15 +16,30 @@ public:
 
   virtual void Built();
 
+  bool Replay(const nglPath& rPath); // Browse the stops of a session log instead of a live process
+  bool OpenCore(const nglPath& rPath); // In the current target, or a new one if it has a live process
+
   nuiSignal0<> GoHome;
 private:
   nuiEventSink<DebugView> mEventSink;
   nuiSlotsSink mSlotSink;
 
-  void OnProcessPaused();
-  void OnProcessRunning();
+  void OnProcessPaused(DebuggerContext* pContext);
+  void OnProcessRunning(DebuggerContext* pContext);
   void UpdateProcess();
 
+  void OnOpenCore(const nuiEvent& rEvent);
+  void OnCoreChosen(const ChooseFileParams& rParams);
+  void OnAddTarget(const nuiEvent& rEvent);
+  void OnTargetChosen(const ChooseFileParams& rParams);
+  void AddContext(DebuggerContext* pContext); // Handles its events and lists it, from the UI or from RpcServer
+  void OnCloseTarget(const nuiEvent& rEvent);
+  void OnTargetSelected(const nuiEvent& rEvent);
+  void SelectContext(DebuggerContext* pContext);
+  void CloseContext(DebuggerContext* pContext);
+  void DeleteContext(DebuggerContext* pContext); // Once the tasks posted before the close have run
+  void UpdateTargets();
+
   void OnChooseApplication(const nuiEvent& rEvent);
   void OnStart(const nuiEvent& rEvent);
   void OnStartLOCAL();
@@ -35,16 +50,31 @@ private:
   void OnStepIn(const nuiEvent& rEvent);
   void OnStepOver(const nuiEvent& rEvent);
   void OnStepOut(const nuiEvent& rEvent);
+  void OnPreviousStop(const nuiEvent& rEvent);
+  void OnNextStop(const nuiEvent& rEvent);
   void OnThreadSelectionChanged(const nuiEvent& rEvent);
-  void Loop();
+  void OnDebuggerEvent(DebuggerContext& rContext, lldb::SBEvent& rEvent);
+  void HandleModulesEvent(DebuggerContext& rContext, lldb::SBEvent& rEvent);
+  void OnModulesLoaded(DebuggerContext* pContext, std::vector<lldb::SBModule> modules);
+  void OnModulesUnloaded(DebuggerContext* pContext, std::vector<lldb::SBModule> modules);
+  void UpdateModules(const std::vector<uint32>& rSlots, bool loaded, const std::set<nglString>& rFiles);
   void UpdateVariablesForCurrentFrame();
+  void ResetModules();
+  void ShowRecordedStop(int32 index);
   void OnModuleFileSelectionChanged(const nuiEvent& rEvent);
   void OnModuleSymbolSelectionChanged(const nuiEvent& rEvent);
-  void OnProcessConnected();
+  void OnSymbolSearchChanged(const nuiEvent& rEvent);
+  void OnSymbolResultSelected(const nuiEvent& rEvent);
+  void OnSymbolBreak(const nuiEvent& rEvent);
+  void OnSymbolIndexChanged();
+  void OnLinesChanged(const std::set<nglString>& rFiles);
+  void UpdateSymbolResults();
+  void OnProcessConnected(DebuggerContext* pContext);
 
   void OnCloseTab(const nuiEvent& event);
   
   void OnVariableSelectionChanged(const nuiEvent& rEvent);
+  bool AddStructArraySources(lldb::SBValue value);
 
   void OnLineSelected(const nglPath& rPath, float X, float Y, int32 line, bool ingutter);
 
@@ -54,13 +84,30 @@ private:
   void OnDeviceDisconnected(Xspray::iOSDevice& device);
 
   void OnHandleSTDIO(const nuiEvent& event);
-
-  nglThreadDelegate* mpDebuggerEventLoop;
+  void UpdateLog();
+  void OnProfile(const nuiEvent& rEvent);
+  void UpdateProfile();
+  nuiTreeNode* CreateProfileNode(const Profiler::Node& rNode, uint32 samples);
+  void OnAddWatch(const nuiEvent& rEvent);
+  void OnWatchpointSelected(const nuiEvent& rEvent);
+  void OnWatchCursorMoved(int32 index);
+  void UpdateWatchpoints();
+  void UpdateResources();
+  void ClearResources();
+  void ScrollResources(GraphView* pGraph, int32 count);
+
+  nuiSlotsSink mContextSink; // Connections to the current context
 
   nuiTreeView* mpThreads;
-  nuiTreeView* mpModulesFiles;
-  nuiTreeView* mpModulesSymbols;
+  RowView* mpModulesFiles;
+  RowView* mpModulesSymbols;
   nuiTreeView* mpVariables;
+  nuiEditLine* mpSymbolSearch;
+  nuiList* mpSymbolResults;
+  nuiButton* mpSymbolBreak;
+  nuiList* mpTargets;
+  nuiButton* mpAddTarget;
+  nuiButton* mpCloseTarget;
   nuiWidget* mpTransport;
   nuiButton* mpChooseApplication;
   nuiComboBox* mpArchitecturesCombo;
@@ -71,9 +118,43 @@ private:
   nuiButton* mpStepIn;
   nuiButton* mpStepOver;
   nuiButton* mpStepOut;
+  nuiButton* mpPreviousStop;
+  nuiButton* mpNextStop;
+  nuiButton* mpOpenCore;
   nuiTabView* mpFilesTabView;
   nuiText* mpOutput;
   nuiText* mpErrors;
+  nuiText* mpLog;
+  nuiEditLine* mpLogExpressions;
+  std::vector<LogBuffer::Entry> mLogEntries; // Reused for each batch
+  uint64 mLogDropped;
+  nuiButton* mpProfile;
+  nuiEditLine* mpProfileRate;
+  nuiEditLine* mpProfileDepth;
+  nuiLabel* mpProfileStatus;
+  nuiTreeView* mpProfileTree;
+  FlameGraphView* mpFlameGraph;
+  double mProfileUpdate; // Time of the last refresh of the profile views
+  nuiEditLine* mpWatchExpression;
+  nuiButton* mpAddWatch;
+  nuiList* mpWatchpoints;
+  WatchTimelineView* mpWatchTimeline;
+  nuiLabel* mpWatchHit;
+  ResourceMonitor mResources; // Samples the process of the current target
+  uint64 mResourceCount; // Samples already moved to the plots
+  GraphView* mpResourceStops;
+  GraphView* mpResourceCPU;
+  GraphView* mpResourceMemory;
+  GraphView* mpResourceEvents;
+  nuiLabel* mpResourceStatus;
+  RingArray* mpStoppedSeries;
+  RingArray* mpCPUSeries;
+  RingArray* mpResidentSeries;
+  RingArray* mpVirtualSeries;
+  RingArray* mpFaultsSeries;
+  RingArray* mpSwitchesSeries;
+  RingArray* mpFilesSeries;
+  std::map<uint64, RingArray*> mThreadSeries; // CPU of each thread, by system thread id
 
   nuiTreeNodePtr mpArchitectures;
   nuiTreeNodePtr mpDevices;
@@ -84,9 +165,14 @@ private:
   void SelectThread(lldb::SBThread thread);
   void SelectFrame(lldb::SBFrame frame);
   void UpdateVariables(lldb::SBFrame frame);
+  void SelectRecordedFrame(const SessionStop::Frame& rFrame);
 
   void UpdateArchitectures(std::vector<nglString>& rArchis);
 
   std::map<nglString, nuiWidget*> mFiles;
+
+  SessionLog mReplay;
+  SessionStop mReplayStop; // Shown by the trees
+  int32 mReplayIndex;
 };
 
@@ -7,7 +7,6 @@
 //
 
 #include "Xspray.h"
-#include "Application.h"
 using namespace Xspray;
 
 void MyLogOutputCallback(const char * str, void *baton)
@@ -16,9 +15,37 @@ void MyLogOutputCallback(const char * str, void *baton)
 }
 
 
+#define EVENT_WAIT_TIMEOUT 1 // Seconds, how long StopEvents may have to wait for the event thread
+
+nglCriticalSection DebuggerContext::mContextsCS;
+std::vector<DebuggerContext*> DebuggerContext::mContexts;
+DebuggerContext* DebuggerContext::mpCurrent = NULL;
+
+// One set of workers for all the contexts, so that opening several targets doesn't start a thread per core for each:
+static ThreadPool& GetSharedPool()
+{
+  static ThreadPool pool;
+  return pool;
+}
+
 DebuggerContext::DebuggerContext()
-: mDebugger(lldb::SBDebugger::Create())
+: mDebugger(lldb::SBDebugger::Create()),
+  mpAppDescription(NULL),
+  mThreadPool(GetSharedPool()),
+  mTypeCatalog(*this),
+  mRecorder(mAddressIndex),
+  mProfiler(*this),
+  mGeneration(0),
+  mpEventThread(NULL),
+  mStopEvents(false)
 {
+  {
+    nglCriticalSectionGuard guard(mContextsCS);
+    mContexts.push_back(this);
+    if (!mpCurrent)
+      mpCurrent = this;
+  }
+
   // Create a debugger instance so we can create a target
   const char *channel = "lldb";
   const char *categories[] =
@@ -49,13 +76,104 @@ DebuggerContext::DebuggerContext()
   };
   mDebugger.SetLoggingCallback(MyLogOutputCallback, NULL);
   mDebugger.EnableLog(channel, categories);
+
+  mSourceResolver.LoadRules(SourceResolver::GetRulesPath());
+}
+
+DebuggerContext::~DebuggerContext()
+{
+  StopEvents();
+  mProfiler.Stop();
+  ClearIndex();
+
+  // Their logpoint callbacks must not outlive them:
+  for (auto it = mBreakpoints.begin(); it != mBreakpoints.end(); ++it)
+    delete *it;
+  mBreakpoints.clear();
+  lldb::SBDebugger::Destroy(mDebugger);
+
+  RemoveContext();
+}
+
+void DebuggerContext::Close()
+{
+  StopEvents();
+  mProfiler.Stop();
+
+  lldb::StateType state = mProcess.GetState();
+  if (mProcess.IsValid() && state != lldb::eStateExited && state != lldb::eStateDetached)
+    mProcess.Kill();
+
+  // Waits for the indexing tasks, the line table merges they posted then find nothing to do:
+  ClearIndex();
+  RemoveContext();
+}
+
+void DebuggerContext::RemoveContext()
+{
+  nglCriticalSectionGuard guard(mContextsCS);
+  auto it = std::find(mContexts.begin(), mContexts.end(), this);
+  if (it != mContexts.end())
+    mContexts.erase(it);
+  if (mpCurrent == this)
+    mpCurrent = mContexts.empty() ? NULL : mContexts.front();
+}
+
+int32 DebuggerContext::GetContextCount()
+{
+  nglCriticalSectionGuard guard(mContextsCS);
+  return mContexts.size();
+}
+
+DebuggerContext* DebuggerContext::GetContext(int32 index)
+{
+  nglCriticalSectionGuard guard(mContextsCS);
+  if (index < 0 || index >= mContexts.size())
+    return NULL;
+  return mContexts[index];
+}
+
+bool DebuggerContext::HasContext(const DebuggerContext* pContext)
+{
+  nglCriticalSectionGuard guard(mContextsCS);
+  return std::find(mContexts.begin(), mContexts.end(), pContext) != mContexts.end();
+}
+
+void DebuggerContext::SetCurrent(DebuggerContext* pContext)
+{
+  nglCriticalSectionGuard guard(mContextsCS);
+  NGL_ASSERT(std::find(mContexts.begin(), mContexts.end(), pContext) != mContexts.end());
+  mpCurrent = pContext;
+}
+
+nglString DebuggerContext::GetName() const
+{
+  lldb::SBFileSpec executable = const_cast<lldb::SBTarget&>(mTarget).GetExecutable();
+  if (executable.IsValid())
+    return executable.GetFilename();
+#ifndef XSPRAY_HEADLESS
+  if (mpAppDescription)
+    return mpAppDescription->GetName();
+#endif
+  return "No target";
+}
+
+static nglString GetModuleKey(lldb::SBModule module)
+{
+  lldb::SBFileSpec f = module.GetFileSpec();
+  nglPath p(f.GetDirectory());
+  p += nglString(f.GetFilename());
+  return p.GetPathName();
 }
 
 DebuggerContext& Xspray::GetDebuggerContext()
 {
-  return ((Application*)App)->GetDebuggerContext();
+  nglCriticalSectionGuard guard(DebuggerContext::mContextsCS);
+  NGL_ASSERT(DebuggerContext::mpCurrent != NULL);
+  return *DebuggerContext::mpCurrent;
 }
 
+#ifndef XSPRAY_HEADLESS
 bool DebuggerContext::LoadApp()
 {
   AppDescription* pApp = mpAppDescription;
@@ -66,19 +184,621 @@ bool DebuggerContext::LoadApp()
     return false;
   }
 
+  return LoadTarget(pApp->GetLocalPath(), pApp->GetArchitecture());
+}
+#endif
+
+bool DebuggerContext::LoadTarget(const nglPath& rPath, const nglString& rArchitecture)
+{
+  mCore.Close();
+
   // Create a target using the executable.
   //mTarget = mDebugger.CreateTarget(p.GetChars());
-  const char* apppath = pApp->GetLocalPath().GetChars();
-  const char* arch = pApp->GetArchitecture().GetChars();
-  mTarget = mDebugger.CreateTargetWithFileAndArch (apppath, arch);
+  const char* arch = rArchitecture.IsEmpty() ? NULL : rArchitecture.GetChars();
+  mTarget = mDebugger.CreateTargetWithFileAndArch (rPath.GetChars(), arch);
+
+  ClearIndex();
+  if (!mTarget.IsValid())
+    return false;
+
+  ListenForModules();
+
+  std::vector<lldb::SBModule> modules;
+  uint32_t count = mTarget.GetNumModules();
+  for (uint32_t i = 0; i < count; i++)
+    modules.push_back(mTarget.GetModuleAtIndex(i));
+
+  std::vector<uint32> slots;
+  AddModules(modules, slots);
+
+  return true;
+}
+
+bool DebuggerContext::LoadCore(const nglPath& rCore, const nglPath& rExecutable)
+{
+  XSPRAY_TRACE("DebuggerContext::LoadCore");
+  if (rExecutable.GetPathName().IsEmpty())
+  {
+    mCore.Close();
+    mTarget = mDebugger.CreateTarget("");
+    ClearIndex();
+    if (!mTarget.IsValid())
+      return false;
+    ListenForModules();
+  }
+  else if (!LoadTarget(rExecutable, nglString::Null))
+  {
+    return false;
+  }
+
+  mProcess = mTarget.LoadCore(rCore.GetChars());
+  if (!mProcess.IsValid())
+    return false;
+
+  // The values are read from our own mapping, LLDB is only asked for the threads and the modules:
+  if (!mCore.Open(rCore, mTarget))
+    NGL_OUT("Unable to map %s, its memory is read through LLDB\n", rCore.GetChars());
+
+  // The libraries found in the core:
+  std::vector<lldb::SBModule> modules;
+  uint32_t count = mTarget.GetNumModules();
+  for (uint32_t i = 0; i < count; i++)
+    modules.push_back(mTarget.GetModuleAtIndex(i));
+
+  std::vector<uint32> slots;
+  AddModules(modules, slots);
+  return true;
+}
 
-  return mTarget.IsValid();
+lldb::StateType DebuggerContext::WaitForStop(double timeout)
+{
+  lldb::SBListener listener = mDebugger.GetListener();
+  double deadline = (double)nglTime() + timeout;
+  while (true)
+  {
+    double left = deadline - (double)nglTime();
+    if (left <= 0)
+      return lldb::eStateInvalid;
+
+    lldb::SBEvent evt;
+    if (!listener.WaitForEvent((uint32)ceil(left), evt))
+      continue;
+
+    if (evt.BroadcasterMatchesRef(mTarget.GetBroadcaster()))
+    {
+      std::vector<lldb::SBModule> modules;
+      uint32_t count = lldb::SBTarget::GetNumModulesFromEvent(evt);
+      for (uint32_t i = 0; i < count; i++)
+        modules.push_back(lldb::SBTarget::GetModuleAtIndexFromEvent(i, evt));
+
+      std::vector<uint32> slots;
+      std::set<nglString> files;
+      if (evt.GetType() & lldb::SBTarget::eBroadcastBitModulesLoaded)
+        AddModules(modules, slots);
+      else if (evt.GetType() & lldb::SBTarget::eBroadcastBitModulesUnloaded)
+        RemoveModules(modules, slots, files);
+      continue;
+    }
+
+    if (!lldb::SBProcess::EventIsProcessEvent(evt) || lldb::SBProcess::GetRestartedFromEvent(evt))
+      continue;
+
+    // Late events of a process that was killed:
+    if (lldb::SBProcess::GetProcessFromEvent(evt).GetProcessID() != mProcess.GetProcessID())
+      continue;
+
+    lldb::StateType state = lldb::SBProcess::GetStateFromEvent(evt);
+    if (state == lldb::eStateStopped && ContinueAfterWatchpoints(mProcess))
+      continue;
+
+    switch (state)
+    {
+      case lldb::eStateStopped:
+      case lldb::eStateSuspended:
+      case lldb::eStateCrashed:
+      case lldb::eStateExited:
+      case lldb::eStateDetached:
+      case lldb::eStateUnloaded:
+        return state;
+
+      default:
+        break;
+    }
+  }
+}
+
+bool DebuggerContext::ContinueAfterWatchpoints(lldb::SBProcess process)
+{
+  // Held until the hits are recorded so that the main thread can't delete the watchpoints meanwhile:
+  nglCriticalSectionGuard guard(mBreakpointsCS);
+  std::vector<std::pair<Breakpoint*, lldb::SBThread> > hits;
+  int32 threads = process.GetNumThreads();
+  for (int32 i = 0; i < threads; i++)
+  {
+    lldb::SBThread thread = process.GetThreadAtIndex(i);
+    lldb::StopReason reason = thread.GetStopReason();
+    if (reason == lldb::eStopReasonNone)
+      continue;
+    if (reason != lldb::eStopReasonWatchpoint || !thread.GetStopReasonDataCount())
+      return false;
+
+    lldb::watch_id_t id = thread.GetStopReasonDataAtIndex(0);
+    Breakpoint* pWatchpoint = NULL;
+    for (auto it = mBreakpoints.begin(); it != mBreakpoints.end() && !pWatchpoint; ++it)
+    {
+      if ((*it)->GetType() == Breakpoint::Watch && (*it)->GetWatchpoint().GetID() == id)
+        pWatchpoint = *it;
+    }
+    if (!pWatchpoint)
+      return false; // Set by someone else, let it stop
+
+    hits.push_back(std::make_pair(pWatchpoint, thread));
+  }
+
+  if (hits.empty())
+    return false;
+
+  XSPRAY_TRACE("DebuggerContext::ContinueAfterWatchpoints");
+  for (int32 i = 0; i < hits.size(); i++)
+    hits[i].first->AddWatchHit(process, hits[i].second);
+  return process.Continue().Success();
+}
+
+void DebuggerContext::StartEvents(const EventDelegate& rHandler)
+{
+  {
+    nglCriticalSectionGuard guard(mEventCS);
+    mEventHandler = rHandler;
+  }
+
+  if (mpEventThread)
+    return;
+
+  mStopEvents = false;
+  mpEventThread = new nglThreadDelegate(nuiMakeDelegate(this, &DebuggerContext::HandleEvents));
+  mpEventThread->Start();
+}
+
+void DebuggerContext::StopEvents()
+{
+  if (!mpEventThread)
+    return;
+
+  mStopEvents = true;
+  mpEventThread->Join();
+  delete mpEventThread;
+  mpEventThread = NULL;
+}
+
+bool DebuggerContext::IsHandlingEvents() const
+{
+  return mpEventThread != NULL;
+}
+
+void DebuggerContext::HandleEvents()
+{
+  Tracer::SetThreadName("Debugger events");
+  lldb::SBListener listener = mDebugger.GetListener();
+  bool autoresumed = false; // The next running event is the one of a watchpoint we resumed
+  while (!mStopEvents)
+  {
+    lldb::SBEvent evt;
+    if (!listener.WaitForEvent(EVENT_WAIT_TIMEOUT, evt))
+      continue;
+    XSPRAY_TRACE("DebuggerContext::HandleEvents");
+
+    if (!evt.BroadcasterMatchesRef(mTarget.GetBroadcaster()))
+    {
+      // The profiler stops and resumes the process for each sample, only the other events go through:
+      if (mProfiler.IsSampling() && mProfiler.FilterEvent(evt))
+        continue;
+
+      if (!lldb::SBProcess::EventIsProcessEvent(evt) || lldb::SBProcess::GetRestartedFromEvent(evt))
+        continue;
+
+      // Writes to the watched values are recorded and resumed right here, the UI only sees the timeline grow:
+      lldb::StateType state = lldb::SBProcess::GetStateFromEvent(evt);
+      if (state == lldb::eStateStopped && ContinueAfterWatchpoints(lldb::SBProcess::GetProcessFromEvent(evt)))
+      {
+        autoresumed = true;
+        continue;
+      }
+      if (state == lldb::eStateRunning && autoresumed)
+      {
+        autoresumed = false;
+        continue;
+      }
+      autoresumed = false;
+    }
+
+    nglCriticalSectionGuard guard(mEventCS);
+    if (mEventHandler)
+      mEventHandler(*this, evt);
+  }
+}
+
+void DebuggerContext::ListenForModules()
+{
+  lldb::SBListener listener = mDebugger.GetListener();
+  listener.StartListeningForEvents(mTarget.GetBroadcaster(), lldb::SBTarget::eBroadcastBitModulesLoaded | lldb::SBTarget::eBroadcastBitModulesUnloaded);
+}
+
+void DebuggerContext::AddModules(const std::vector<lldb::SBModule>& rModules, std::vector<uint32>& rSlots)
+{
+  for (uint32 i = 0; i < rModules.size(); i++)
+  {
+    lldb::SBModule module(rModules[i]);
+    if (!module.IsValid())
+      continue;
+
+    // The modules of the target are announced again when the process launches:
+    nglString key(GetModuleKey(module));
+    {
+      nglCriticalSectionGuard guard(mModulesCS);
+      if (mModuleSlots.find(key) != mModuleSlots.end())
+        continue;
+
+      uint32 slot = mModules.size();
+      mModules.push_back(module);
+      mModuleSlots[key] = slot;
+      rSlots.push_back(slot);
+    }
+
+    mThreadPool.Post(nuiMakeTask(this, &DebuggerContext::IndexModule, new ModuleCache(module)), this);
+  }
+
+  // The breakpoints of these modules' files are refreshed when their line tables are merged:
+  UpdateBreakpoints(std::set<nglString>());
+}
+
+void DebuggerContext::RemoveModules(const std::vector<lldb::SBModule>& rModules, std::vector<uint32>& rSlots, std::set<nglString>& rFiles)
+{
+  bool removed = false;
+  for (uint32 i = 0; i < rModules.size(); i++)
+  {
+    nglString key(GetModuleKey(rModules[i]));
+    ModuleCache* pCache = NULL;
+    bool indexing = false;
+    {
+      nglCriticalSectionGuard guard(mModulesCS);
+      auto slot = mModuleSlots.find(key);
+      if (slot == mModuleSlots.end())
+        continue;
+
+      rSlots.push_back(slot->second);
+      mModules[slot->second] = lldb::SBModule();
+      mModuleSlots.erase(slot);
+
+      auto it = mModuleCaches.find(key);
+      if (it != mModuleCaches.end())
+      {
+        pCache = it->second;
+        mModuleCaches.erase(it);
+
+        // Its indexing task may still be running, the task then deletes it:
+        indexing = std::find(mIndexingCaches.begin(), mIndexingCaches.end(), pCache) != mIndexingCaches.end();
+        if (indexing)
+          mRetiredCaches.push_back(pCache);
+
+        // Its line entries may not have been merged yet:
+        auto unmerged = std::find(mUnmergedCaches.begin(), mUnmergedCaches.end(), pCache);
+        if (unmerged != mUnmergedCaches.end())
+          mUnmergedCaches.erase(unmerged);
+      }
+
+      // Done under the lock so that a module can't be published by its indexing task once it is gone:
+      if (pCache)
+      {
+        mAddressIndex.RemoveModule(pCache);
+        removed |= mSymbolIndex.RemoveModule(pCache->GetModule());
+
+        uint32 files = pCache->GetFileCount();
+        for (uint32 j = 0; j < files; j++)
+          rFiles.insert(pCache->GetString(pCache->GetFile(j).mPath));
+      }
+    }
+
+    if (!indexing)
+      delete pCache;
+  }
+
+  RebuildLineTables(rFiles);
+  UpdateBreakpoints(rFiles);
+
+  if (removed)
+    mSymbolIndex.Changed();
+}
+
+void DebuggerContext::RebuildLineTables(const std::set<nglString>& rFiles)
+{
+  if (rFiles.empty())
+    return;
+
+  for (auto it = rFiles.begin(); it != rFiles.end(); ++it)
+  {
+    auto table = mLineTables.find(*it);
+    if (table == mLineTables.end())
+      continue;
+    delete table->second;
+    mLineTables.erase(table);
+  }
+
+  // Merge back the entries that the remaining modules have for these files, except the ones still waiting for their merge:
+  nglCriticalSectionGuard guard(mModulesCS);
+  std::set<LineTable*> touched;
+  for (auto it = mModuleCaches.begin(); it != mModuleCaches.end(); ++it)
+  {
+    const ModuleCache* pCache = it->second;
+    if (std::find(mUnmergedCaches.begin(), mUnmergedCaches.end(), pCache) != mUnmergedCaches.end())
+      continue;
+
+    uint32 files = pCache->GetFileCount();
+    for (uint32 i = 0; i < files; i++)
+    {
+      const ModuleCache::File& rFile(pCache->GetFile(i));
+      nglString path(pCache->GetString(rFile.mPath));
+      if (rFiles.find(path) == rFiles.end())
+        continue;
+
+      LineTable*& rpTable(mLineTables[path]);
+      if (!rpTable)
+        rpTable = new LineTable(nglPath(path));
+      rpTable->AddEntries(pCache->GetLineEntries(rFile), rFile.mEntryCount);
+      touched.insert(rpTable);
+    }
+  }
+
+  for (auto it = touched.begin(); it != touched.end(); ++it)
+    (*it)->Finalize();
+}
+
+void DebuggerContext::UpdateBreakpoints(const std::set<nglString>& rFiles)
+{
+  // LLDB resolves the breakpoints by itself, only refresh the ones that may have gained or lost locations:
+  for (auto it = mBreakpoints.begin(); it != mBreakpoints.end(); ++it)
+  {
+    Breakpoint* pBP = *it;
+    if (pBP->GetType() != Breakpoint::Location || rFiles.find(pBP->GetPath().GetPathName()) != rFiles.end())
+      pBP->UpdateResolved();
+  }
+}
+
+uint32 DebuggerContext::GetModuleSlotCount() const
+{
+  nglCriticalSectionGuard guard(mModulesCS);
+  return mModules.size();
+}
+
+lldb::SBModule DebuggerContext::GetModuleAtSlot(uint32 slot) const
+{
+  nglCriticalSectionGuard guard(mModulesCS);
+  if (slot >= mModules.size())
+    return lldb::SBModule();
+  return mModules[slot];
+}
+
+// First line of the innermost function, inlined or not, that the address belongs to, or -1. The functions met so far
+// are remembered by start address:
+static int32 GetFunctionLine(lldb::SBAddress address, std::map<lldb::addr_t, int32>& rFunctionLines)
+{
+  lldb::SBBlock block = address.GetBlock().GetContainingInlinedBlock();
+  lldb::SBAddress start = block.IsValid() ? block.GetRangeStartAddress(0) : address.GetFunction().GetStartAddress();
+  if (!start.IsValid())
+    return -1;
+
+  auto it = rFunctionLines.find(start.GetFileAddress());
+  if (it != rFunctionLines.end())
+    return it->second;
+
+  lldb::SBLineEntry entry = start.GetLineEntry();
+  int32 line = entry.IsValid() && entry.GetLine() > 0 ? entry.GetLine() : -1;
+  rFunctionLines[start.GetFileAddress()] = line;
+  return line;
+}
+
+void DebuggerContext::IndexModule(ModuleCache* pCache)
+{
+  XSPRAY_TRACE("DebuggerContext::IndexModule");
+  lldb::SBModule module(pCache->GetModule());
+  if (!pCache->Map())
+  {
+    // Walk every line entry of the module once and group them by source file:
+    std::map<nglString, std::vector<LineTable::Entry> > files;
+    std::map<lldb::addr_t, int32> functionlines;
+    uint32_t compileunits = module.GetNumCompileUnits();
+    for (uint32_t i = 0; i < compileunits; i++)
+    {
+      lldb::SBCompileUnit unit = module.GetCompileUnitAtIndex(i);
+      lldb::SBFileSpec unitfile = unit.GetFileSpec();
+      nglPath unitpath(unitfile.GetDirectory());
+      unitpath += nglString(unitfile.GetFilename());
+      pCache->AddCompileUnit(unitpath);
+
+      uint32_t count = unit.GetNumLineEntries();
+      const char* lastdir = NULL;
+      const char* lastname = NULL;
+      std::vector<LineTable::Entry>* pEntries = NULL;
+      for (uint32_t j = 0; j < count; j++)
+      {
+        lldb::SBLineEntry entry = unit.GetLineEntryAtIndex(j);
+        int32 line = entry.GetLine();
+        if (line <= 0)
+          continue;
+
+        lldb::SBFileSpec file = entry.GetFileSpec();
+
+        // LLDB hands out uniqued strings so consecutive entries from the same file can skip the path lookup:
+        const char* dir = file.GetDirectory();
+        const char* name = file.GetFilename();
+        if (!name)
+          continue;
+
+        if (!pEntries || dir != lastdir || name != lastname)
+        {
+          lastdir = dir;
+          lastname = name;
+          nglPath p(dir);
+          p += name;
+          pEntries = &files[p.GetPathName()];
+        }
+
+        lldb::SBAddress address = entry.GetStartAddress();
+        LineTable::Entry e;
+        e.mLine = line;
+        e.mFunctionLine = GetFunctionLine(address, functionlines);
+        e.mAddress = address.GetFileAddress();
+        pEntries->push_back(e);
+      }
+    }
+
+    for (auto it = files.begin(); it != files.end(); ++it)
+      pCache->AddFile(nglPath(it->first), it->second);
+    pCache->AddTypes();
+  }
+
+  {
+    // The module may have been unloaded, or loaded again, while it was being indexed:
+    nglCriticalSectionGuard guard(mModulesCS);
+    nglString key(GetModuleKey(module));
+    if (mModuleSlots.find(key) == mModuleSlots.end() || mModuleCaches.find(key) != mModuleCaches.end())
+    {
+      delete pCache;
+      return;
+    }
+
+    mModuleCaches[key] = pCache;
+    mIndexingCaches.push_back(pCache);
+    mUnmergedCaches.push_back(pCache);
+    if (mUnmergedCaches.size() == 1)
+      nuiAnimation::RunOnAnimationTick(nuiMakeTask(this, &DebuggerContext::MergeLineTables, mGeneration));
+  }
+
+  IndexModuleSymbols(pCache);
+}
+
+void DebuggerContext::MergeLineTables(uint32 generation)
+{
+  XSPRAY_TRACE("DebuggerContext::MergeLineTables");
+  std::set<nglString> files;
+  std::set<LineTable*> touched;
+  {
+    // The caches can't go away while the lock is held, ClearIndex and RemoveModules take it too:
+    nglCriticalSectionGuard guard(mModulesCS);
+    if (generation != mGeneration)
+      return;
+
+    for (int32 c = 0; c < mUnmergedCaches.size(); c++)
+    {
+      const ModuleCache* pCache = mUnmergedCaches[c];
+      uint32 count = pCache->GetFileCount();
+      for (uint32 i = 0; i < count; i++)
+      {
+        const ModuleCache::File& rFile(pCache->GetFile(i));
+        nglString path(pCache->GetString(rFile.mPath));
+
+        LineTable*& rpTable(mLineTables[path]);
+        if (!rpTable)
+          rpTable = new LineTable(nglPath(path));
+        rpTable->AddEntries(pCache->GetLineEntries(rFile), rFile.mEntryCount);
+        touched.insert(rpTable);
+        files.insert(path);
+      }
+    }
+    mUnmergedCaches.clear();
+  }
+
+  // Once per table however many modules were merged:
+  for (auto it = touched.begin(); it != touched.end(); ++it)
+    (*it)->Finalize();
+
+  UpdateBreakpoints(files);
+  LinesChanged(files);
+}
+
+void DebuggerContext::IndexModuleSymbols(ModuleCache* pCache)
+{
+  XSPRAY_TRACE("DebuggerContext::IndexModuleSymbols");
+  SymbolIndex::Module* pModule = new SymbolIndex::Module(pCache->GetModule());
+  if (!pCache->IsMapped() || !pModule->Load(*pCache))
+  {
+    pModule->Build();
+    if (!pCache->IsMapped())
+    {
+      if (!pCache->Save(*pModule))
+        NGL_OUT("Unable to save the module cache for %s\n", pCache->GetUUID().GetChars());
+    }
+  }
+
+  {
+    nglCriticalSectionGuard guard(mModulesCS);
+    mIndexingCaches.erase(std::find(mIndexingCaches.begin(), mIndexingCaches.end(), pCache));
+    auto retired = std::find(mRetiredCaches.begin(), mRetiredCaches.end(), pCache);
+    if (retired == mRetiredCaches.end())
+    {
+      mAddressIndex.AddModule(pModule, pCache);
+      mSymbolIndex.AddModule(pModule);
+      return;
+    }
+    mRetiredCaches.erase(retired);
+  }
+
+  // The module was unloaded while it was being indexed, nothing else refers to its cache:
+  delete pModule;
+  delete pCache;
+}
+
+void DebuggerContext::ClearIndex()
+{
+  // Let the pending indexing tasks land before throwing their results away:
+  mThreadPool.Wait(this);
+  mAddressIndex.Clear();
+  mSymbolIndex.Clear();
+  mTypeCatalog.Clear();
+
+  for (auto it = mLineTables.begin(); it != mLineTables.end(); ++it)
+    delete it->second;
+  mLineTables.clear();
+
+  nglCriticalSectionGuard guard(mModulesCS);
+  for (auto it = mModuleCaches.begin(); it != mModuleCaches.end(); ++it)
+    delete it->second;
+  mModuleCaches.clear();
+
+  for (int32 i = 0; i < mRetiredCaches.size(); i++)
+    delete mRetiredCaches[i];
+  mRetiredCaches.clear();
+  mIndexingCaches.clear();
+  mUnmergedCaches.clear();
+  mGeneration++;
+
+  mModules.clear();
+  mModuleSlots.clear();
+}
+
+const ModuleCache* DebuggerContext::GetModuleCache(lldb::SBModule module) const
+{
+  nglString key(GetModuleKey(module));
+
+  nglCriticalSectionGuard guard(mModulesCS);
+  auto it = mModuleCaches.find(key);
+  if (it == mModuleCaches.end())
+    return NULL;
+  return it->second;
+}
+
+const LineTable* DebuggerContext::GetLineTable(const nglPath& rPath) const
+{
+  auto it = mLineTables.find(rPath.GetPathName());
+  if (it == mLineTables.end())
+    return NULL;
+  return it->second;
 }
 
 Breakpoint* DebuggerContext::CreateBreakpointByLocation(const nglPath& rPath, int32 line, int32 column)
 {
   lldb::SBBreakpoint bp = mTarget.BreakpointCreateByLocation(rPath.GetChars(), line);
-  Breakpoint* pBP = new Breakpoint(bp, rPath, line, column);
+  Breakpoint* pBP = new Breakpoint(mLogBuffer, bp, rPath, line, column);
+  nglCriticalSectionGuard guard(mBreakpointsCS);
   mBreakpoints.push_back(pBP);
   return pBP;
 }
@@ -86,7 +806,8 @@ Breakpoint* DebuggerContext::CreateBreakpointByLocation(const nglPath& rPath, in
 Breakpoint* DebuggerContext::CreateBreakpointByName(const nglString& rSymbol)
 {
   lldb::SBBreakpoint bp = mTarget.BreakpointCreateByName(rSymbol.GetChars());
-  Breakpoint* pBP = new Breakpoint(bp, rSymbol, false);
+  Breakpoint* pBP = new Breakpoint(mLogBuffer, bp, rSymbol, false);
+  nglCriticalSectionGuard guard(mBreakpointsCS);
   mBreakpoints.push_back(pBP);
   return pBP;
 }
@@ -94,7 +815,8 @@ Breakpoint* DebuggerContext::CreateBreakpointByName(const nglString& rSymbol)
 Breakpoint* DebuggerContext::CreateBreakpointByRegex(const nglString& rRegEx)
 {
   lldb::SBBreakpoint bp = mTarget.BreakpointCreateByRegex(rRegEx.GetChars());
-  Breakpoint* pBP = new Breakpoint(bp, rRegEx, true);
+  Breakpoint* pBP = new Breakpoint(mLogBuffer, bp, rRegEx, true);
+  nglCriticalSectionGuard guard(mBreakpointsCS);
   mBreakpoints.push_back(pBP);
   return pBP;
 }
@@ -102,7 +824,29 @@ Breakpoint* DebuggerContext::CreateBreakpointByRegex(const nglString& rRegEx)
 Breakpoint* DebuggerContext::CreateBreakpointForException(lldb::LanguageType language, bool BreakOnCatch, bool BreakOnThrow)
 {
   lldb::SBBreakpoint bp = mTarget.BreakpointCreateForException(language, BreakOnCatch, BreakOnThrow);
-  Breakpoint* pBP = new Breakpoint(bp, language, BreakOnCatch, BreakOnThrow);
+  Breakpoint* pBP = new Breakpoint(mLogBuffer, bp, language, BreakOnCatch, BreakOnThrow);
+  nglCriticalSectionGuard guard(mBreakpointsCS);
+  mBreakpoints.push_back(pBP);
+  return pBP;
+}
+
+Breakpoint* DebuggerContext::CreateWatchpoint(const nglString& rExpression, lldb::SBFrame frame)
+{
+  lldb::SBValue value = frame.GetValueForVariablePath(rExpression.GetChars());
+  lldb::addr_t address = value.IsValid() ? value.GetLoadAddress() : LLDB_INVALID_ADDRESS;
+  uint32 size = value.IsValid() ? value.GetByteSize() : 0;
+  if (address == LLDB_INVALID_ADDRESS || size == 0 || size > sizeof(uint64))
+    return NULL;
+
+  lldb::SBError error;
+  lldb::SBWatchpoint wp = mTarget.WatchAddress(address, size, false, true, error);
+  if (!wp.IsValid() || error.Fail())
+    return NULL;
+
+  uint64 current = 0;
+  mProcess.ReadMemory(address, &current, size, error);
+  Breakpoint* pBP = new Breakpoint(mLogBuffer, wp, rExpression, address, size, current);
+  nglCriticalSectionGuard guard(mBreakpointsCS);
   mBreakpoints.push_back(pBP);
   return pBP;
 }
@@ -176,6 +920,18 @@ void DebuggerContext::GetBreakpointsForSymbols(std::vector<Breakpoint*>& rBreakp
   }
 }
 
+void DebuggerContext::GetWatchpoints(std::vector<Breakpoint*>& rBreakpoints)
+{
+  auto it = mBreakpoints.begin();
+  while (it != mBreakpoints.end())
+  {
+    Breakpoint* pBP = *it;
+    if (pBP->GetType() == Breakpoint::Watch)
+      rBreakpoints.push_back(pBP);
+    ++it;
+  }
+}
+
 void DebuggerContext::DeleteBreakpoint(Breakpoint* pBreakpoint)
 {
   auto it = mBreakpoints.begin();
@@ -184,9 +940,15 @@ void DebuggerContext::DeleteBreakpoint(Breakpoint* pBreakpoint)
     Breakpoint* pBP = *it;
     if (pBP == pBreakpoint)
     {
-      mBreakpoints.erase(it);
-      lldb::SBBreakpoint bp = pBreakpoint->GetBreakpoint();
-      mTarget.BreakpointDelete(bp.GetID());
+      {
+        // Once out of the list the event thread can't be using it:
+        nglCriticalSectionGuard guard(mBreakpointsCS);
+        mBreakpoints.erase(it);
+      }
+      if (pBreakpoint->GetType() == Breakpoint::Watch)
+        mTarget.DeleteWatchpoint(pBreakpoint->GetWatchpoint().GetID());
+      else
+        mTarget.BreakpointDelete(pBreakpoint->GetBreakpoint().GetID());
       delete pBreakpoint;
       return;
     }
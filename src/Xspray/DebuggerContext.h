@@ -8,22 +8,76 @@
 
 #pragma once
 
+// One target, its process and everything indexed about them. A session can hold several contexts (a client and its
+// server, the stages of a pipeline), each with its own debugger, listener thread and breakpoints. The UI shows the
+// current one.
 class DebuggerContext
 {
 public:
   DebuggerContext();
+  ~DebuggerContext();
+
+  static int32 GetContextCount();
+  static DebuggerContext* GetContext(int32 index);
+  static bool HasContext(const DebuggerContext* pContext); // False once closed
+  static void SetCurrent(DebuggerContext* pContext); // The one GetDebuggerContext() returns, from the main thread only
+
+  // From the main thread: stop the event thread, the profiler and the indexing, kill the process and take the context
+  // out of the list. The main thread tasks posted before may still reference it, delete it from a later animation tick.
+  void Close();
+
+  nglString GetName() const; // Of the executable
+#ifndef XSPRAY_HEADLESS
   bool LoadApp();
+#endif
+  bool LoadTarget(const nglPath& rPath, const nglString& rArchitecture); // Create the target and index its modules
+  bool LoadCore(const nglPath& rCore, const nglPath& rExecutable); // The executable may be empty, LLDB then finds what it can
+
+  void ListenForModules(); // Have the debugger's listener receive the module loaded and unloaded events of the target
+
+  // Apply the modules loaded or unloaded since the last call. The slots of the modules that were added or removed and
+  // the source files whose line tables changed are returned. Added modules are indexed on mThreadPool, their line
+  // tables are merged later on the main thread and LinesChanged then gives their files.
+  void AddModules(const std::vector<lldb::SBModule>& rModules, std::vector<uint32>& rSlots);
+  void RemoveModules(const std::vector<lldb::SBModule>& rModules, std::vector<uint32>& rSlots, std::set<nglString>& rFiles);
+  void ClearIndex();
+
+  nuiSignal1<const std::set<nglString>&> LinesChanged;
+
+  // For the clients without an event loop: handle the debugger's events until the process stops or exits, applying the
+  // module events met on the way. Returns eStateInvalid after timeout seconds.
+  lldb::StateType WaitForStop(double timeout);
+
+  // For the thread handling the stop events: if only our watchpoints stopped the process, record their hits and resume
+  // it. The stop is then none of the UI's business.
+  bool ContinueAfterWatchpoints(lldb::SBProcess process);
+
+  // Handle the debugger's events on a thread of this context. The stops of the profiler and of the watchpoints are dealt
+  // with there, the module events and the other process events are given to the handler, on that thread.
+  typedef nuiFastDelegate2<DebuggerContext&, lldb::SBEvent&> EventDelegate;
+  void StartEvents(const EventDelegate& rHandler); // Replaces the handler if the thread is already running
+  void StopEvents();
+  bool IsHandlingEvents() const;
+
+  // Modules keep the slot they were given when they were added, unloaded ones leave an invalid module in theirs:
+  uint32 GetModuleSlotCount() const;
+  lldb::SBModule GetModuleAtSlot(uint32 slot) const;
+
+  const LineTable* GetLineTable(const nglPath& rPath) const;
+  const ModuleCache* GetModuleCache(lldb::SBModule module) const;
 
   Breakpoint* CreateBreakpointByLocation(const nglPath& rPath, int32 line, int32 column);
   Breakpoint* CreateBreakpointByName(const nglString& rSymbol);
   Breakpoint* CreateBreakpointByRegex(const nglString& rRegEx);
   Breakpoint* CreateBreakpointForException(lldb::LanguageType language, bool BreakOnCatch, bool BreakOnThrow);
+  Breakpoint* CreateWatchpoint(const nglString& rExpression, lldb::SBFrame frame); // Watches the writes, NULL if the value can't be watched
 
   void GetBreakpointsForFile(const nglPath& rPath, std::vector<Breakpoint*>& rBreakpoints);
   void GetBreakpointsLinesForFile(const nglPath& rPath, std::set<int32>& rLines);
   void GetBreakpointsForFiles(std::vector<Breakpoint*>& rBreakpoints);
   void GetBreakpointsForExceptions(std::vector<Breakpoint*>& rBreakpoints);
   void GetBreakpointsForSymbols(std::vector<Breakpoint*>& rBreakpoints);
+  void GetWatchpoints(std::vector<Breakpoint*>& rBreakpoints);
   Breakpoint* GetBreakpointByLocation(const nglPath& rPath, int32 line, int32 col) const;
 
   void DeleteBreakpoint(Breakpoint* pBreakpoint);
@@ -32,7 +86,47 @@ public:
   lldb::SBTarget mTarget;
   lldb::SBProcess mProcess;
   AppDescription* mpAppDescription;
-  std::list<Breakpoint*> mBreakpoints;
+  std::list<Breakpoint*> mBreakpoints; // Only changed by the main thread, under mBreakpointsCS
+  std::map<nglString, LineTable*> mLineTables;
+  std::map<nglString, ModuleCache*> mModuleCaches;
+  ThreadPool& mThreadPool; // Shared by every context, the tasks are posted with their context as owner
+  SymbolIndex mSymbolIndex;
+  AddressIndex mAddressIndex;
+  TypeCatalog mTypeCatalog;
+  SourceResolver mSourceResolver;
+  SessionRecorder mRecorder; // Records the stops when open
+  LogBuffer mLogBuffer; // Written by the logpoints
+  Profiler mProfiler; // Merges its samples on mThreadPool
+  CoreFile mCore; // Open when the process is a core file
+
+private:
+  friend DebuggerContext& GetDebuggerContext();
+
+  void IndexModule(ModuleCache* pCache); // On mThreadPool
+  void IndexModuleSymbols(ModuleCache* pCache);
+  void MergeLineTables(uint32 generation); // On the main thread, for every module indexed since the last call
+  void RebuildLineTables(const std::set<nglString>& rFiles);
+  void UpdateBreakpoints(const std::set<nglString>& rFiles);
+  void HandleEvents();
+  void RemoveContext(); // From the list, the current one moves to the first left
+
+  mutable nglCriticalSection mModulesCS; // Protects the slots and the caches against the worker threads
+  std::vector<lldb::SBModule> mModules;
+  std::map<nglString, uint32> mModuleSlots;
+  std::vector<ModuleCache*> mIndexingCaches; // Published caches whose symbols are still being indexed
+  std::vector<ModuleCache*> mRetiredCaches; // Caches of unloaded modules still being indexed, their task deletes them
+  std::vector<ModuleCache*> mUnmergedCaches; // Indexed caches whose line entries are not in the line tables yet
+  uint32 mGeneration; // Bumped by ClearIndex so that a pending merge forgets its caches
+
+  nglThreadDelegate* mpEventThread;
+  std::atomic<bool> mStopEvents;
+  nglCriticalSection mEventCS; // Protects the handler
+  nglCriticalSection mBreakpointsCS; // Taken by the main thread to change mBreakpoints, by the event thread to read it
+  EventDelegate mEventHandler;
+
+  static nglCriticalSection mContextsCS; // Protects the list and the current context, contexts may be created on any thread
+  static std::vector<DebuggerContext*> mContexts; // In creation order
+  static DebuggerContext* mpCurrent; // The one GetDebuggerContext() returns
 };
 
 DebuggerContext& GetDebuggerContext();
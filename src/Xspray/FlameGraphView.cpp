@@ -0,0 +1,147 @@
+//
+//  FlameGraphView.cpp
+//  Xspray
+//
+
+#include "Xspray.h"
+
+using namespace Xspray;
+
+#define FLAMEGRAPH_ROW_HEIGHT 16
+#define FLAMEGRAPH_MIN_WIDTH 1.0f // Narrower functions are not drawn
+#define FLAMEGRAPH_CHAR_WIDTH 7 // Rough, only used to cut the labels
+
+FlameGraphView::FlameGraphView()
+{
+  if (SetObjectClass("FlameGraphView"))
+  {
+    // Add Attributes
+  }
+}
+
+FlameGraphView::~FlameGraphView()
+{
+}
+
+void FlameGraphView::SetTree(const Profiler::Node& rRoot)
+{
+  mRoot = rRoot;
+  mBoxes.clear(); // They point into the previous tree
+  InvalidateLayout();
+}
+
+int32 FlameGraphView::GetDepth(const Profiler::Node& rNode)
+{
+  int32 depth = 0;
+  for (auto it = rNode.mChildren.begin(); it != rNode.mChildren.end(); ++it)
+    depth = MAX(depth, GetDepth(it->second));
+  return depth + 1;
+}
+
+nuiRect FlameGraphView::CalcIdealSize()
+{
+  return nuiRect(200.0f, (float)(GetDepth(mRoot) * FLAMEGRAPH_ROW_HEIGHT));
+}
+
+const Profiler::Node* FlameGraphView::FindNode(const Profiler::Node& rNode, const std::vector<nglString>& rPath, int32 index) const
+{
+  if (index == rPath.size())
+    return &rNode;
+
+  auto it = rNode.mChildren.find(rPath[index]);
+  if (it == rNode.mChildren.end())
+    return NULL;
+  return FindNode(it->second, rPath, index + 1);
+}
+
+bool FlameGraphView::Draw(nuiDrawContext* pContext)
+{
+  XSPRAY_TRACE("FlameGraphView::Draw");
+  mBoxes.clear();
+
+  // The zoomed function may have vanished with a Clear:
+  const Profiler::Node* pRoot = FindNode(mRoot, mFocus, 0);
+  if (!pRoot)
+  {
+    mFocus.clear();
+    pRoot = &mRoot;
+  }
+
+  if (pRoot->mTotal)
+  {
+    nuiFont* pFont = nuiFont::GetFont(8);
+    pContext->SetFont(pFont);
+    DrawNode(pContext, *pRoot, 0, mRect.GetWidth(), 0, -1);
+    pContext->SetTextColor("black");
+    pFont->Release();
+  }
+
+  return nuiSimpleContainer::Draw(pContext);
+}
+
+void FlameGraphView::DrawNode(nuiDrawContext* pContext, const Profiler::Node& rNode, float x, float width, int32 depth, int32 parent)
+{
+  if (width < FLAMEGRAPH_MIN_WIDTH)
+    return;
+
+  float y = mRect.GetHeight() - (depth + 1) * FLAMEGRAPH_ROW_HEIGHT;
+  nuiRect r(x, y, width, (float)FLAMEGRAPH_ROW_HEIGHT);
+  Box box = { r, &rNode, parent };
+  int32 index = mBoxes.size();
+  mBoxes.push_back(box);
+
+  // Warm colors, stable for a given function:
+  uint32 hash = 0;
+  for (const char* pChar = rNode.mFunction.GetChars(); *pChar; pChar++)
+    hash = hash * 31 + *pChar;
+  pContext->SetFillColor(nuiColor(205 + hash % 50, 80 + (hash >> 8) % 150, 40 + (hash >> 16) % 40));
+  pContext->SetStrokeColor(nuiColor(255, 255, 255));
+  pContext->DrawRect(r, eStrokeAndFillShape);
+
+  int32 chars = (int32)(width / FLAMEGRAPH_CHAR_WIDTH) - 1;
+  if (chars > 2)
+  {
+    nglString label(rNode.mFunction);
+    if (label.GetLength() > chars)
+      label = label.GetLeft(chars - 2) + "..";
+    pContext->SetTextColor("black");
+    pContext->DrawText(x + 2, y + FLAMEGRAPH_ROW_HEIGHT - 4, label);
+  }
+
+  // Children left to right in name order, what is left of the width is the function's own time:
+  for (auto it = rNode.mChildren.begin(); it != rNode.mChildren.end(); ++it)
+  {
+    float w = width * it->second.mTotal / rNode.mTotal;
+    DrawNode(pContext, it->second, x, w, depth + 1, index);
+    x += w;
+  }
+}
+
+bool FlameGraphView::MouseClicked(const nglMouseInfo& rInfo)
+{
+  if (!(rInfo.Buttons & nglMouseInfo::ButtonLeft))
+    return false;
+
+  if (rInfo.Buttons & nglMouseInfo::ButtonDoubleClick)
+  {
+    mFocus.clear();
+    Invalidate();
+    return true;
+  }
+
+  for (int32 i = 0; i < mBoxes.size(); i++)
+  {
+    if (!mBoxes[i].mRect.IsInside(rInfo.X, rInfo.Y))
+      continue;
+
+    // The path to the clicked function, up to the function shown at the bottom:
+    std::vector<nglString> path;
+    for (int32 b = i; mBoxes[b].mParent >= 0; b = mBoxes[b].mParent)
+      path.insert(path.begin(), mBoxes[b].mpNode->mFunction);
+
+    mFocus.insert(mFocus.end(), path.begin(), path.end());
+    Invalidate();
+    return true;
+  }
+  return false;
+}
@@ -0,0 +1,38 @@
+//
+//  FlameGraphView.h
+//  Xspray
+//
+
+#pragma once
+
+// Flame graph of a profiler call tree: callers at the bottom, each function as wide as the samples that went through
+// it. Clicking a function zooms on it, a double click zooms back out.
+class FlameGraphView : public nuiSimpleContainer
+{
+public:
+  FlameGraphView();
+  virtual ~FlameGraphView();
+
+  void SetTree(const Profiler::Node& rRoot);
+
+  nuiRect CalcIdealSize();
+  bool Draw(nuiDrawContext* pContext);
+
+  bool MouseClicked(const nglMouseInfo& rInfo);
+
+private:
+  struct Box
+  {
+    nuiRect mRect;
+    const Profiler::Node* mpNode;
+    int32 mParent; // Index of the caller's box, -1 for the root
+  };
+
+  void DrawNode(nuiDrawContext* pContext, const Profiler::Node& rNode, float x, float width, int32 depth, int32 parent);
+  static int32 GetDepth(const Profiler::Node& rNode);
+  const Profiler::Node* FindNode(const Profiler::Node& rNode, const std::vector<nglString>& rPath, int32 index) const;
+
+  Profiler::Node mRoot;
+  std::vector<nglString> mFocus; // Path from the root to the zoomed function, empty to show everything
+  std::vector<Box> mBoxes; // Drawn last time, for the clicks
+};
@@ -84,6 +84,7 @@ nuiRect GraphView::CalcIdeadSize()
 
 bool GraphView::Draw(nuiDrawContext* pContext)
 {
+  XSPRAY_TRACE("GraphView::Draw");
   float height = mRect.GetHeight();
   auto it = mModels.begin();
   auto end = mModels.end();
@@ -74,9 +74,10 @@ void HomeView::Built()
   mEventSink.Connect(mpRemoveApplication->Activated, &HomeView::RemoveApplication);
   mEventSink.Connect(mpApplicationList->SelectionChanged, &HomeView::OnApplicationSelected);
 
+  // Apps restored from the catalog, don't update the inspector for each of them:
   for (int i = 0; i < AppDescription::GetAppCount(); i++)
   {
-    AddApplication(AppDescription::GetApp(i));
+    AddApplication(AppDescription::GetApp(i), false);
   }
 }
 
@@ -107,7 +108,11 @@ void HomeView::OnApplicationChosen(const ChooseFileParams& params)
 
 void HomeView::AddApplication(const nglPath& rApplication)
 {
+  int count = AppDescription::GetAppCount();
   int index = AppDescription::AddApp(rApplication);
+  if (index >= 0 && index < count)
+    return; // Already registered
+
   if (index >= 0)
   {
     AppDescription* pApp = AppDescription::GetApp(index);
@@ -121,7 +126,7 @@ void HomeView::AddApplication(const nglPath& rApplication)
   }
 }
 
-void HomeView::AddApplication(AppDescription* pApp)
+void HomeView::AddApplication(AppDescription* pApp, bool select)
 {
   nuiWidget* pLine = nuiBuilder::Get().CreateWidget("ListLine");
   pLine->SetToken(new nuiFreeToken<AppDescription*>(pApp));
@@ -131,8 +136,11 @@ void HomeView::AddApplication(AppDescription* pApp)
   pIcon->SetTexture(pApp->GetIcon());
   mpApplicationList->AddChild(pLine);
 
-  mpApplicationList->SelectItem(pLine);
-  mpApplicationList->SelectionChanged();
+  if (select)
+  {
+    mpApplicationList->SelectItem(pLine);
+    mpApplicationList->SelectionChanged();
+  }
 }
 
 void HomeView::OnApplicationSelected(const nuiEvent& rEVent)
@@ -42,7 +42,7 @@ private:
   void AddApplication(const nuiEvent& rEvent);
   void RemoveApplication(const nuiEvent& rEvent);
   void OnApplicationChosen(const ChooseFileParams& params);
-  void AddApplication(AppDescription* pApp);
+  void AddApplication(AppDescription* pApp, bool select = true);
 
   void OnApplicationSelected(const nuiEvent& rEVent);
 };
\ No newline at end of file
@@ -0,0 +1,109 @@
+//
+//  LineTable.cpp
+//  Xspray
+//
+
+#include "Xspray.h"
+
+using namespace Xspray;
+
+static bool CompareEntries(const LineTable::Entry& rA, const LineTable::Entry& rB)
+{
+  if (rA.mLine == rB.mLine)
+    return rA.mAddress < rB.mAddress;
+  return rA.mLine < rB.mLine;
+}
+
+static bool CompareEntryToLine(const LineTable::Entry& rEntry, int32 line)
+{
+  return rEntry.mLine < line;
+}
+
+static bool SameLine(const LineTable::Entry& rA, const LineTable::Entry& rB)
+{
+  return rA.mLine == rB.mLine;
+}
+
+LineTable::LineTable(const nglPath& rPath)
+: mPath(rPath), mSorted(true)
+{
+}
+
+LineTable::~LineTable()
+{
+}
+
+const nglPath& LineTable::GetPath() const
+{
+  return mPath;
+}
+
+void LineTable::AddEntry(const Entry& rEntry)
+{
+  // Line 0 is used by the compiler for code that has no source location:
+  if (rEntry.mLine <= 0)
+    return;
+
+  if (!mEntries.empty() && CompareEntries(rEntry, mEntries.back()))
+    mSorted = false;
+  mEntries.push_back(rEntry);
+}
+
+void LineTable::AddEntries(const Entry* pEntries, uint32 count)
+{
+  for (uint32 i = 0; i < count; i++)
+    AddEntry(pEntries[i]);
+}
+
+void LineTable::Finalize()
+{
+  if (!mSorted)
+    std::sort(mEntries.begin(), mEntries.end(), CompareEntries);
+
+  // Keep only the lowest address of each line:
+  mEntries.erase(std::unique(mEntries.begin(), mEntries.end(), SameLine), mEntries.end());
+  std::vector<Entry>(mEntries).swap(mEntries);
+  mSorted = true;
+}
+
+std::vector<LineTable::Entry>::const_iterator LineTable::Find(int32 line) const
+{
+  NGL_ASSERT(mSorted);
+  return std::lower_bound(mEntries.begin(), mEntries.end(), line, CompareEntryToLine);
+}
+
+bool LineTable::IsExecutable(int32 line) const
+{
+  auto it = Find(line);
+  return it != mEntries.end() && it->mLine == line;
+}
+
+int32 LineTable::GetExecutableLine(int32 line) const
+{
+  auto it = Find(line);
+  if (it == mEntries.end())
+    return -1;
+  return it->mLine;
+}
+
+lldb::addr_t LineTable::GetAddress(int32 line) const
+{
+  auto it = Find(line);
+  if (it == mEntries.end() || it->mLine != line)
+    return LLDB_INVALID_ADDRESS;
+  return it->mAddress;
+}
+
+int32 LineTable::GetFunctionLine(int32 line) const
+{
+  auto it = Find(line);
+  if (it == mEntries.end() || it->mLine != line)
+    return -1;
+  return it->mFunctionLine;
+}
+
+const std::vector<LineTable::Entry>& LineTable::GetEntries() const
+{
+  return mEntries;
+}
+
@@ -0,0 +1,42 @@
+//
+//  LineTable.h
+//  Xspray
+//
+
+#pragma once
+
+// Sorted line -> address map for one source file, built from the line entries of the compile units that reference it.
+class LineTable
+{
+public:
+  struct Entry
+  {
+    int32 mLine;
+    int32 mFunctionLine;   // First line of the function, inlined or not, this code belongs to, -1 if unknown
+    lldb::addr_t mAddress; // Lowest file address generated for this line
+  };
+
+  LineTable(const nglPath& rPath);
+  ~LineTable();
+
+  const nglPath& GetPath() const;
+
+  void AddEntry(const Entry& rEntry);
+  void AddEntries(const Entry* pEntries, uint32 count);
+  void Finalize();
+
+  bool IsExecutable(int32 line) const;
+  int32 GetExecutableLine(int32 line) const; // First line >= line that has code, or -1
+  lldb::addr_t GetAddress(int32 line) const;
+  int32 GetFunctionLine(int32 line) const; // First line of the function whose code is on that line, or -1
+
+  const std::vector<Entry>& GetEntries() const;
+
+private:
+  std::vector<Entry>::const_iterator Find(int32 line) const;
+
+  nglPath mPath;
+  std::vector<Entry> mEntries;
+  bool mSorted;
+};
+
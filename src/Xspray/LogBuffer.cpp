@@ -0,0 +1,62 @@
+//
+//  LogBuffer.cpp
+//  Xspray
+//
+
+#include "Xspray.h"
+
+using namespace Xspray;
+
+LogBuffer::LogBuffer(uint32 capacity)
+: mCapacity(capacity), mWrite(0), mRead(0), mDropped(0)
+{
+}
+
+LogBuffer::~LogBuffer()
+{
+}
+
+void LogBuffer::Allocate()
+{
+  if (mEntries.empty())
+    mEntries.resize(mCapacity);
+}
+
+LogBuffer::Entry* LogBuffer::BeginWrite()
+{
+  uint64 write = mWrite.load(std::memory_order_relaxed);
+  if (write - mRead.load(std::memory_order_acquire) >= mEntries.size())
+  {
+    mDropped.fetch_add(1, std::memory_order_relaxed);
+    return NULL;
+  }
+  return &mEntries[write % mEntries.size()];
+}
+
+void LogBuffer::EndWrite()
+{
+  mWrite.store(mWrite.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+uint32 LogBuffer::Read(std::vector<Entry>& rEntries, uint32 max)
+{
+  uint64 read = mRead.load(std::memory_order_relaxed);
+  uint64 write = mWrite.load(std::memory_order_acquire);
+  uint32 count = MIN(write - read, (uint64)max); // Nothing was written before Allocate
+  for (uint32 i = 0; i < count; i++)
+    rEntries.push_back(mEntries[(read + i) % mEntries.size()]);
+
+  // Hand the slots back to the writer:
+  mRead.store(read + count, std::memory_order_release);
+  return count;
+}
+
+uint64 LogBuffer::GetDropped() const
+{
+  return mDropped.load(std::memory_order_relaxed);
+}
+
+uint64 LogBuffer::GetWritten() const
+{
+  return mWrite.load(std::memory_order_relaxed);
+}
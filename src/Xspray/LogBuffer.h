@@ -0,0 +1,45 @@
+//
+//  LogBuffer.h
+//  Xspray
+//
+
+#pragma once
+
+#define LOGBUFFER_TEXT_SIZE 240
+
+// Lines written by the logpoints. The breakpoint callbacks all run on the debugger's private thread and the UI drains
+// the buffer in batches, so one writer and one reader share it without a lock. When the reader falls behind, new lines
+// are dropped and counted rather than overwriting the ones being read. The entries are only allocated when the first
+// logpoint is armed, most contexts never get one.
+class LogBuffer
+{
+public:
+  struct Entry
+  {
+    double mTime;
+    uint64 mThreadID;
+    int32 mBreakpointID;
+    char mText[LOGBUFFER_TEXT_SIZE]; // Truncated, always zero terminated
+  };
+
+  LogBuffer(uint32 capacity = 64 * 1024);
+  ~LogBuffer();
+
+  void Allocate(); // Call from the reader's thread before arming a logpoint, does nothing once allocated
+
+  // Writer side:
+  Entry* BeginWrite(); // NULL if the buffer is full
+  void EndWrite();
+
+  // Reader side:
+  uint32 Read(std::vector<Entry>& rEntries, uint32 max); // Appends at most max entries, returns how many
+  uint64 GetDropped() const;
+  uint64 GetWritten() const;
+
+private:
+  uint32 mCapacity;
+  std::vector<Entry> mEntries; // Empty until Allocate, every write is dropped until then
+  std::atomic<uint64> mWrite;
+  std::atomic<uint64> mRead;
+  std::atomic<uint64> mDropped;
+};
@@ -0,0 +1,582 @@
+//
+//  ModuleCache.cpp
+//  Xspray
+//
+
+#include "Xspray.h"
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace Xspray;
+
+#define MODULE_CACHE_VERSION 5
+
+ModuleCache::ModuleCache(lldb::SBModule module)
+: mModule(module), mpMapping(NULL), mMappingSize(0), mpHeader(NULL)
+{
+  const char* uuid = mModule.GetUUIDString();
+  if (uuid)
+    mUUID = uuid;
+}
+
+ModuleCache::~ModuleCache()
+{
+  if (mpMapping)
+    munmap(mpMapping, mMappingSize);
+}
+
+lldb::SBModule ModuleCache::GetModule() const
+{
+  return mModule;
+}
+
+const nglString& ModuleCache::GetUUID() const
+{
+  return mUUID;
+}
+
+bool ModuleCache::IsMapped() const
+{
+  return mpHeader != NULL;
+}
+
+nglPath ModuleCache::GetCacheFolder()
+{
+  nglPath p(ePathUserAppSettings);
+  p += nglString("Xspray");
+  p += nglString("ModuleCache");
+  return p;
+}
+
+nglPath ModuleCache::GetPath() const
+{
+  nglString name(mUUID);
+  name.Add(".cache");
+  nglPath p(GetCacheFolder());
+  p += name;
+  return p;
+}
+
+bool ModuleCache::Map()
+{
+  NGL_ASSERT(!mpMapping);
+  if (mUUID.IsEmpty() || mUUID.GetLength() >= sizeof(Header().mUUID))
+    return false;
+
+  int fd = open(GetPath().GetChars(), O_RDONLY);
+  if (fd < 0)
+    return false;
+
+  struct stat st;
+  if (fstat(fd, &st) || st.st_size < sizeof(Header))
+  {
+    close(fd);
+    return false;
+  }
+
+  void* pMapping = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (pMapping == MAP_FAILED)
+    return false;
+
+  const Header* pHeader = (const Header*)pMapping;
+  bool valid = !memcmp(pHeader->mMagic, "XSMC", 4) && pHeader->mVersion == MODULE_CACHE_VERSION && !strcmp(pHeader->mUUID, mUUID.GetChars());
+  for (int32 i = 0; valid && i < eSectionCount; i++)
+  {
+    uint64 offset = pHeader->mOffsets[i];
+    uint64 size = pHeader->mSizes[i];
+    valid = !(offset & 7) && offset >= sizeof(Header) && offset <= st.st_size && size <= st.st_size - offset;
+  }
+
+  if (valid)
+  {
+    mpMapping = pMapping;
+    mMappingSize = st.st_size;
+    mpHeader = pHeader;
+    valid = Validate();
+  }
+
+  if (!valid)
+  {
+    NGL_OUT("Ignoring stale module cache %s\n", GetPath().GetChars());
+    munmap(pMapping, st.st_size);
+    mpMapping = NULL;
+    mMappingSize = 0;
+    mpHeader = NULL;
+    return false;
+  }
+
+  return true;
+}
+
+// The offsets and indices of a mapped cache are used as is, so a damaged file is rejected here rather than read out of
+// bounds later:
+bool ModuleCache::Validate() const
+{
+  static const uint32 sizes[eSectionCount] =
+  {
+    sizeof(SymbolIndex::Symbol), sizeof(uint64), sizeof(uint32), sizeof(uint32), sizeof(uint32), 1, 1, 1,
+    sizeof(uint32), sizeof(File), sizeof(LineTable::Entry), sizeof(Type), sizeof(TypeField), sizeof(TypeMember),
+    sizeof(Enumerator)
+  };
+  for (int32 i = 0; i < eSectionCount; i++)
+  {
+    if (mpHeader->mSizes[i] % sizes[i] || mpHeader->mSizes[i] / sizes[i] > 0xffffffff)
+      return false;
+  }
+
+  uint32 strings;
+  const char* pStrings = (const char*)GetSection(eStrings, 1, strings);
+  if (pStrings && pStrings[strings - 1])
+    return false;
+
+  uint32 count;
+  const uint32* pUnits = (const uint32*)GetSection(eCompileUnits, sizeof(uint32), count);
+  for (uint32 i = 0; i < count; i++)
+  {
+    if (pUnits[i] >= strings)
+      return false;
+  }
+
+  uint32 entries;
+  GetSection(eLineEntries, sizeof(LineTable::Entry), entries);
+  const File* pFiles = (const File*)GetSection(eFiles, sizeof(File), count);
+  for (uint32 i = 0; i < count; i++)
+  {
+    const File& rFile(pFiles[i]);
+    if (rFile.mPath >= strings || rFile.mFirstEntry > entries || rFile.mEntryCount > entries - rFile.mFirstEntry)
+      return false;
+  }
+
+  // The type layouts, their decoded fields are read from the object's bytes:
+  uint32 fields, members, enumerators;
+  const TypeField* pFields = (const TypeField*)GetSection(eTypeFields, sizeof(TypeField), fields);
+  const TypeMember* pMembers = (const TypeMember*)GetSection(eTypeMembers, sizeof(TypeMember), members);
+  const Enumerator* pEnumerators = (const Enumerator*)GetSection(eEnumerators, sizeof(Enumerator), enumerators);
+  for (uint32 i = 0; i < enumerators; i++)
+  {
+    if (pEnumerators[i].mName >= strings)
+      return false;
+  }
+
+  for (uint32 i = 0; i < fields; i++)
+  {
+    const TypeField& rField(pFields[i]);
+    if (rField.mName >= strings || rField.mTypeName >= strings || rField.mKind > TypeLayout::eOther
+        || rField.mFirstEnumerator > enumerators || rField.mEnumeratorCount > enumerators - rField.mFirstEnumerator)
+      return false;
+  }
+
+  const Type* pTypes = (const Type*)GetSection(eTypes, sizeof(Type), count);
+  for (uint32 i = 0; i < count; i++)
+  {
+    const Type& rType(pTypes[i]);
+    if (rType.mName >= strings || rType.mFirstField > fields || rType.mFieldCount > fields - rType.mFirstField
+        || rType.mFirstMember > members || rType.mMemberCount > members - rType.mFirstMember)
+      return false;
+
+    for (uint32 j = 0; j < rType.mFieldCount; j++)
+    {
+      const TypeField& rField(pFields[rType.mFirstField + j]);
+      if (rField.mKind != TypeLayout::eOther && (!rField.mByteSize || rField.mByteSize > 8 || rField.mOffset > rType.mByteSize
+          || rField.mByteSize > rType.mByteSize - rField.mOffset))
+        return false;
+    }
+
+    for (uint32 j = 0; j < rType.mMemberCount; j++)
+    {
+      const TypeMember& rMember(pMembers[rType.mFirstMember + j]);
+      if (rMember.mName >= strings || rMember.mField < -1 || rMember.mField >= (int32)rType.mFieldCount)
+        return false;
+    }
+  }
+
+  // The symbol tables, SymbolIndex::Module::Load checks that their counts agree:
+  uint32 names, folded, symbols;
+  const char* pNames = GetNames(names);
+  const char* pFolded = GetFoldedNames(folded);
+  const SymbolIndex::Symbol* pSymbols = GetSymbols(symbols);
+  if (names != folded)
+    return false;
+  for (uint32 i = 0; i < symbols; i++)
+  {
+    const SymbolIndex::Symbol& rSymbol(pSymbols[i]);
+    if (rSymbol.mName >= names || rSymbol.mLength >= names - rSymbol.mName || pNames[rSymbol.mName + rSymbol.mLength] || pFolded[rSymbol.mName + rSymbol.mLength])
+      return false;
+  }
+
+  const uint32* pSorted = GetSorted(count);
+  for (uint32 i = 0; i < count; i++)
+  {
+    if (pSorted[i] >= symbols)
+      return false;
+  }
+
+  uint32 postings;
+  const uint32* pPostings = GetTrigramSymbols(postings);
+  for (uint32 i = 0; i < postings; i++)
+  {
+    if (pPostings[i] >= symbols)
+      return false;
+  }
+
+  const uint32* pOffsets = GetTrigramOffsets(count);
+  for (uint32 i = 0; i < count; i++)
+  {
+    if (pOffsets[i] > postings || (i && pOffsets[i] < pOffsets[i - 1]))
+      return false;
+  }
+
+  return !count || pOffsets[count - 1] == postings;
+}
+
+const void* ModuleCache::GetSection(Section section, uint32 elementsize, uint32& rCount) const
+{
+  NGL_ASSERT(mpHeader);
+  rCount = mpHeader->mSizes[section] / elementsize;
+  if (!rCount)
+    return NULL;
+  return (const char*)mpMapping + mpHeader->mOffsets[section];
+}
+
+uint32 ModuleCache::GetCompileUnitCount() const
+{
+  if (!mpHeader)
+    return mCompileUnits.size();
+  return mpHeader->mSizes[eCompileUnits] / sizeof(uint32);
+}
+
+const char* ModuleCache::GetCompileUnit(uint32 index) const
+{
+  NGL_ASSERT(index < GetCompileUnitCount());
+  if (!mpHeader)
+    return GetString(mCompileUnits[index]);
+
+  uint32 count;
+  const uint32* pUnits = (const uint32*)GetSection(eCompileUnits, sizeof(uint32), count);
+  return GetString(pUnits[index]);
+}
+
+uint32 ModuleCache::GetFileCount() const
+{
+  if (!mpHeader)
+    return mFiles.size();
+  return mpHeader->mSizes[eFiles] / sizeof(File);
+}
+
+const ModuleCache::File& ModuleCache::GetFile(uint32 index) const
+{
+  NGL_ASSERT(index < GetFileCount());
+  if (!mpHeader)
+    return mFiles[index];
+
+  uint32 count;
+  const File* pFiles = (const File*)GetSection(eFiles, sizeof(File), count);
+  return pFiles[index];
+}
+
+const LineTable::Entry* ModuleCache::GetLineEntries(const File& rFile) const
+{
+  if (!rFile.mEntryCount)
+    return NULL;
+
+  if (!mpHeader)
+    return &mLineEntries[rFile.mFirstEntry];
+
+  uint32 count;
+  const LineTable::Entry* pEntries = (const LineTable::Entry*)GetSection(eLineEntries, sizeof(LineTable::Entry), count);
+  NGL_ASSERT(rFile.mFirstEntry + rFile.mEntryCount <= count);
+  return pEntries + rFile.mFirstEntry;
+}
+
+const char* ModuleCache::GetString(uint32 offset) const
+{
+  if (!mpHeader)
+    return mStrings.Get(offset);
+
+  uint32 size;
+  const char* pStrings = (const char*)GetSection(eStrings, 1, size);
+  NGL_ASSERT(offset < size);
+  return pStrings + offset;
+}
+
+const ModuleCache::Type* ModuleCache::FindType(const char* pName) const
+{
+  uint32 count;
+  const Type* pTypes;
+  if (!mpHeader)
+  {
+    count = mTypes.size();
+    pTypes = count ? &mTypes[0] : NULL;
+  }
+  else
+  {
+    pTypes = (const Type*)GetSection(eTypes, sizeof(Type), count);
+  }
+
+  uint32 first = 0;
+  uint32 last = count;
+  while (first < last)
+  {
+    uint32 middle = first + (last - first) / 2;
+    int res = strcmp(GetString(pTypes[middle].mName), pName);
+    if (!res)
+      return &pTypes[middle];
+    if (res < 0)
+      first = middle + 1;
+    else
+      last = middle;
+  }
+  return NULL;
+}
+
+const ModuleCache::TypeField* ModuleCache::GetTypeFields(const Type& rType) const
+{
+  if (!rType.mFieldCount)
+    return NULL;
+
+  if (!mpHeader)
+    return &mTypeFields[rType.mFirstField];
+
+  uint32 count;
+  const TypeField* pFields = (const TypeField*)GetSection(eTypeFields, sizeof(TypeField), count);
+  NGL_ASSERT(rType.mFirstField + rType.mFieldCount <= count);
+  return pFields + rType.mFirstField;
+}
+
+const ModuleCache::TypeMember* ModuleCache::GetTypeMembers(const Type& rType) const
+{
+  if (!rType.mMemberCount)
+    return NULL;
+
+  if (!mpHeader)
+    return &mTypeMembers[rType.mFirstMember];
+
+  uint32 count;
+  const TypeMember* pMembers = (const TypeMember*)GetSection(eTypeMembers, sizeof(TypeMember), count);
+  NGL_ASSERT(rType.mFirstMember + rType.mMemberCount <= count);
+  return pMembers + rType.mFirstMember;
+}
+
+const ModuleCache::Enumerator* ModuleCache::GetEnumerators(const TypeField& rField) const
+{
+  if (!rField.mEnumeratorCount)
+    return NULL;
+
+  if (!mpHeader)
+    return &mEnumerators[rField.mFirstEnumerator];
+
+  uint32 count;
+  const Enumerator* pEnumerators = (const Enumerator*)GetSection(eEnumerators, sizeof(Enumerator), count);
+  NGL_ASSERT(rField.mFirstEnumerator + rField.mEnumeratorCount <= count);
+  return pEnumerators + rField.mFirstEnumerator;
+}
+
+const SymbolIndex::Symbol* ModuleCache::GetSymbols(uint32& rCount) const
+{
+  return (const SymbolIndex::Symbol*)GetSection(eSymbols, sizeof(SymbolIndex::Symbol), rCount);
+}
+
+const uint64* ModuleCache::GetMasks(uint32& rCount) const
+{
+  return (const uint64*)GetSection(eMasks, sizeof(uint64), rCount);
+}
+
+const uint32* ModuleCache::GetSorted(uint32& rCount) const
+{
+  return (const uint32*)GetSection(eSorted, sizeof(uint32), rCount);
+}
+
+const uint32* ModuleCache::GetTrigramOffsets(uint32& rCount) const
+{
+  return (const uint32*)GetSection(eTrigramOffsets, sizeof(uint32), rCount);
+}
+
+const uint32* ModuleCache::GetTrigramSymbols(uint32& rCount) const
+{
+  return (const uint32*)GetSection(eTrigramSymbols, sizeof(uint32), rCount);
+}
+
+const char* ModuleCache::GetNames(uint32& rSize) const
+{
+  return (const char*)GetSection(eNames, 1, rSize);
+}
+
+const char* ModuleCache::GetFoldedNames(uint32& rSize) const
+{
+  return (const char*)GetSection(eFoldedNames, 1, rSize);
+}
+
+void ModuleCache::AddCompileUnit(const nglPath& rPath)
+{
+  NGL_ASSERT(!mpHeader);
+  mCompileUnits.push_back(mStrings.Intern(rPath.GetChars()));
+}
+
+void ModuleCache::AddFile(const nglPath& rPath, const std::vector<LineTable::Entry>& rEntries)
+{
+  NGL_ASSERT(!mpHeader);
+  File file;
+  file.mPath = mStrings.Intern(rPath.GetChars());
+  file.mFirstEntry = mLineEntries.size();
+  file.mEntryCount = rEntries.size();
+  mFiles.push_back(file);
+  mLineEntries.insert(mLineEntries.end(), rEntries.begin(), rEntries.end());
+}
+
+void ModuleCache::AddTypes()
+{
+  NGL_ASSERT(!mpHeader);
+
+  // By canonical name so that the table comes out ordered, the same type can be listed more than once:
+  std::map<std::string, TypeLayout*> layouts;
+  lldb::SBTypeList types = mModule.GetTypes(lldb::eTypeClassClass | lldb::eTypeClassStruct);
+  uint32 count = types.GetSize();
+  for (uint32 i = 0; i < count; i++)
+  {
+    lldb::SBType type = types.GetTypeAtIndex(i).GetCanonicalType();
+    const char* name = type.GetName();
+    if (!name || !*name || layouts.find(name) != layouts.end())
+      continue;
+    layouts[name] = TypeLayout::Create(type);
+  }
+
+  for (auto it = layouts.begin(); it != layouts.end(); ++it)
+  {
+    const TypeLayout* pLayout = it->second;
+    if (!pLayout)
+      continue;
+
+    Type type;
+    type.mName = mStrings.Intern(it->first.c_str());
+    type.mByteSize = pLayout->GetByteSize();
+    type.mFirstField = mTypeFields.size();
+    type.mFieldCount = pLayout->GetFieldCount();
+    type.mFirstMember = mTypeMembers.size();
+    type.mMemberCount = pLayout->GetMemberCount();
+    mTypes.push_back(type);
+
+    for (int32 i = 0; i < pLayout->GetFieldCount(); i++)
+    {
+      const TypeLayout::Field& rField(pLayout->GetField(i));
+      TypeField field;
+      field.mName = mStrings.Intern(rField.mName.GetChars());
+      field.mTypeName = mStrings.Intern(rField.mTypeName.GetChars());
+      field.mOffset = rField.mOffset;
+      field.mByteSize = rField.mByteSize;
+      field.mBitOffset = rField.mBitOffset;
+      field.mBitSize = rField.mBitSize;
+      field.mKind = rField.mKind;
+      field.mFirstEnumerator = mEnumerators.size();
+      field.mEnumeratorCount = rField.mEnumerators.size();
+      mTypeFields.push_back(field);
+
+      for (int32 j = 0; j < rField.mEnumerators.size(); j++)
+      {
+        Enumerator enumerator;
+        enumerator.mValue = rField.mEnumerators[j].first;
+        enumerator.mName = mStrings.Intern(rField.mEnumerators[j].second.GetChars());
+        enumerator.mPadding = 0;
+        mEnumerators.push_back(enumerator);
+      }
+    }
+
+    for (int32 i = 0; i < pLayout->GetMemberCount(); i++)
+    {
+      const TypeLayout::Member& rMember(pLayout->GetMember(i));
+      TypeMember member;
+      member.mName = mStrings.Intern(rMember.mName.GetChars());
+      member.mChild = rMember.mChild;
+      member.mBase = rMember.mBase;
+      member.mField = rMember.mField;
+      mTypeMembers.push_back(member);
+    }
+
+    delete pLayout;
+  }
+}
+
+template <class T>
+static void AddSection(std::vector<char>& rData, uint64& rOffset, uint64& rSize, const T* pData, size_t count)
+{
+  // Keep every section 8 bytes aligned so that it can be used in place once mapped:
+  rData.resize((rData.size() + 7) & ~7);
+  rOffset = rData.size();
+  rSize = count * sizeof(T);
+  if (count)
+    rData.insert(rData.end(), (const char*)pData, (const char*)(pData + count));
+}
+
+template <class T>
+static void AddSection(std::vector<char>& rData, uint64& rOffset, uint64& rSize, const std::vector<T>& rVector)
+{
+  AddSection(rData, rOffset, rSize, rVector.empty() ? (const T*)NULL : &rVector[0], rVector.size());
+}
+
+bool ModuleCache::Save(const SymbolIndex::Module& rSymbols)
+{
+  NGL_ASSERT(!mpHeader);
+  if (mUUID.IsEmpty() || mUUID.GetLength() >= sizeof(Header().mUUID))
+    return false;
+
+  Header header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.mMagic, "XSMC", 4);
+  header.mVersion = MODULE_CACHE_VERSION;
+  strcpy(header.mUUID, mUUID.GetChars());
+
+  std::vector<char> data(sizeof(Header));
+  AddSection(data, header.mOffsets[eSymbols], header.mSizes[eSymbols], rSymbols.mSymbols);
+  AddSection(data, header.mOffsets[eMasks], header.mSizes[eMasks], rSymbols.mMasks);
+  AddSection(data, header.mOffsets[eSorted], header.mSizes[eSorted], rSymbols.mSorted);
+  AddSection(data, header.mOffsets[eTrigramOffsets], header.mSizes[eTrigramOffsets], rSymbols.mTrigramOffsets);
+  AddSection(data, header.mOffsets[eTrigramSymbols], header.mSizes[eTrigramSymbols], rSymbols.mTrigramSymbols);
+  AddSection(data, header.mOffsets[eNames], header.mSizes[eNames], rSymbols.mNames.GetData(), rSymbols.mNames.GetSize());
+  AddSection(data, header.mOffsets[eFoldedNames], header.mSizes[eFoldedNames], rSymbols.mNames.GetFoldedData(), rSymbols.mNames.GetSize());
+  AddSection(data, header.mOffsets[eStrings], header.mSizes[eStrings], mStrings.GetData(), mStrings.GetSize());
+  AddSection(data, header.mOffsets[eCompileUnits], header.mSizes[eCompileUnits], mCompileUnits);
+  AddSection(data, header.mOffsets[eFiles], header.mSizes[eFiles], mFiles);
+  AddSection(data, header.mOffsets[eLineEntries], header.mSizes[eLineEntries], mLineEntries);
+  AddSection(data, header.mOffsets[eTypes], header.mSizes[eTypes], mTypes);
+  AddSection(data, header.mOffsets[eTypeFields], header.mSizes[eTypeFields], mTypeFields);
+  AddSection(data, header.mOffsets[eTypeMembers], header.mSizes[eTypeMembers], mTypeMembers);
+  AddSection(data, header.mOffsets[eEnumerators], header.mSizes[eEnumerators], mEnumerators);
+  memcpy(&data[0], &header, sizeof(header));
+
+  nglPath folder(GetCacheFolder());
+  folder.Create(true);
+
+  // Write to a temporary file of our own first so that a concurrent session never maps a partial cache nor writes
+  // into the same temporary file:
+  nglPath path(GetPath());
+  nglString name(path.GetPathName());
+  name.Add(".XXXXXX");
+  std::vector<char> tmp(name.GetChars(), name.GetChars() + strlen(name.GetChars()) + 1);
+
+  int fd = mkstemp(&tmp[0]);
+  if (fd < 0)
+    return false;
+  fchmod(fd, 0644);
+
+  size_t written = 0;
+  while (written < data.size())
+  {
+    ssize_t res = write(fd, &data[written], data.size() - written);
+    if (res <= 0)
+      break;
+    written += res;
+  }
+  close(fd);
+
+  if (written != data.size() || rename(&tmp[0], path.GetChars()))
+  {
+    unlink(&tmp[0]);
+    return false;
+  }
+
+  return true;
+}
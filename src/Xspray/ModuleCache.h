@@ -0,0 +1,145 @@
+//
+//  ModuleCache.h
+//  Xspray
+//
+
+#pragma once
+
+// Snapshot of the tables extracted from one module, stored on disk under the module's UUID.
+// The file is a header followed by flat arrays so that it can be mapped and read in place on the next session.
+class ModuleCache
+{
+public:
+  struct File
+  {
+    uint32 mPath;       // Offset in the string table
+    uint32 mFirstEntry; // Range of this file in the line entries
+    uint32 mEntryCount;
+  };
+
+  // Struct layouts as computed by TypeLayout, so that values can be decoded without asking LLDB for their type:
+  struct Type
+  {
+    uint32 mName;        // Offset in the string table, canonical type name
+    uint32 mByteSize;
+    uint32 mFirstField;  // Range of this type in the type fields
+    uint32 mFieldCount;
+    uint32 mFirstMember; // Range of this type in the type members
+    uint32 mMemberCount;
+  };
+
+  struct TypeField
+  {
+    uint32 mName;            // Offsets in the string table
+    uint32 mTypeName;
+    uint32 mOffset;
+    uint32 mByteSize;
+    uint32 mBitOffset;
+    uint32 mBitSize;
+    uint32 mKind;            // TypeLayout::Kind
+    uint32 mFirstEnumerator; // Range of this field in the enumerators
+    uint32 mEnumeratorCount;
+  };
+
+  struct TypeMember
+  {
+    uint32 mName;  // Offset in the string table
+    uint32 mChild;
+    uint32 mBase;
+    int32 mField;  // Index from the type's first field, -1 if none
+  };
+
+  struct Enumerator
+  {
+    int64 mValue;
+    uint32 mName;  // Offset in the string table
+    uint32 mPadding;
+  };
+
+  ModuleCache(lldb::SBModule module);
+  ~ModuleCache();
+
+  lldb::SBModule GetModule() const;
+  const nglString& GetUUID() const;
+  bool IsMapped() const;
+
+  // Reading:
+  bool Map(); // Map the cache file of the module, fails if there is none, if it doesn't match or if it is damaged
+
+  uint32 GetCompileUnitCount() const;
+  const char* GetCompileUnit(uint32 index) const;
+  uint32 GetFileCount() const;
+  const File& GetFile(uint32 index) const;
+  const LineTable::Entry* GetLineEntries(const File& rFile) const;
+  const char* GetString(uint32 offset) const;
+  const Type* FindType(const char* pName) const; // NULL if the module has no layout for that canonical type name
+  const TypeField* GetTypeFields(const Type& rType) const;
+  const TypeMember* GetTypeMembers(const Type& rType) const;
+  const Enumerator* GetEnumerators(const TypeField& rField) const;
+
+  const SymbolIndex::Symbol* GetSymbols(uint32& rCount) const;
+  const uint64* GetMasks(uint32& rCount) const;
+  const uint32* GetSorted(uint32& rCount) const;
+  const uint32* GetTrigramOffsets(uint32& rCount) const;
+  const uint32* GetTrigramSymbols(uint32& rCount) const;
+  const char* GetNames(uint32& rSize) const;
+  const char* GetFoldedNames(uint32& rSize) const;
+
+  // Building:
+  void AddCompileUnit(const nglPath& rPath);
+  void AddFile(const nglPath& rPath, const std::vector<LineTable::Entry>& rEntries);
+  void AddTypes(); // Lay out the struct and class types of the module that have fields to decode
+  bool Save(const SymbolIndex::Module& rSymbols);
+
+  static nglPath GetCacheFolder();
+
+private:
+  enum Section
+  {
+    eSymbols,
+    eMasks,
+    eSorted,
+    eTrigramOffsets,
+    eTrigramSymbols,
+    eNames,
+    eFoldedNames,
+    eStrings,
+    eCompileUnits,
+    eFiles,
+    eLineEntries,
+    eTypes,
+    eTypeFields,
+    eTypeMembers,
+    eEnumerators,
+    eSectionCount
+  };
+
+  struct Header
+  {
+    char mMagic[4];
+    uint32 mVersion;
+    char mUUID[64];
+    uint64 mOffsets[eSectionCount];
+    uint64 mSizes[eSectionCount]; // In bytes
+  };
+
+  const void* GetSection(Section section, uint32 elementsize, uint32& rCount) const;
+  bool Validate() const;
+  nglPath GetPath() const;
+
+  lldb::SBModule mModule;
+  nglString mUUID;
+
+  void* mpMapping;
+  size_t mMappingSize;
+  const Header* mpHeader;
+
+  StringArena mStrings;
+  std::vector<uint32> mCompileUnits;
+  std::vector<File> mFiles;
+  std::vector<LineTable::Entry> mLineEntries;
+  std::vector<Type> mTypes; // Ordered by name
+  std::vector<TypeField> mTypeFields;
+  std::vector<TypeMember> mTypeMembers;
+  std::vector<Enumerator> mEnumerators;
+};
@@ -10,151 +10,142 @@
 
 using namespace Xspray;
 
-ModuleTree::ModuleTree(const lldb::SBTarget& rTarget)
-: nuiTreeNode(NULL, false, false, true, false), mTarget(rTarget), mType(eTarget)
+ModuleTree::ModuleTree(DebuggerContext& rContext)
+: mrContext(rContext), mTarget(rContext.mTarget)
 {
-  //SetTrace(true);
+  lldb::SBFileSpec f = mTarget.GetExecutable();
+  Row row;
+  row.mKind = eTarget;
+  row.mExpandable = true;
+  row.mText.CFormat("Target %s", f.GetFilename());
+  AddRoot(row);
 }
 
-ModuleTree::ModuleTree(const lldb::SBModule& rModule, Type type)
-: nuiTreeNode(NULL, false, false, true, false), mModule(rModule), mType(type)
+ModuleTree::~ModuleTree()
 {
-  Update();
+
 }
 
-ModuleTree::ModuleTree(const lldb::SBCompileUnit& rCompileUnit)
-: nuiTreeNode(NULL, false, false, false, false), mCompileUnit(rCompileUnit), mType(eCompileUnit)
+const lldb::SBTarget& ModuleTree::GetTarget() const
 {
-  Update();
+  return mTarget;
 }
 
-ModuleTree::~ModuleTree()
+ModuleTree::Type ModuleTree::GetType(const Row& rRow) const
 {
-
+  return (Type)rRow.mKind;
 }
 
-bool ModuleTree::IsEmpty() const
+lldb::SBModule ModuleTree::GetModule(const Row& rRow) const
 {
-  if (mType == eCompileUnit)
-    return true;
-  return false;
+  if (rRow.mKind == eTarget)
+    return lldb::SBModule();
+  return mrContext.GetModuleAtSlot(rRow.mData >> 32);
 }
 
-void ModuleTree::Open(bool Opened)
+void ModuleTree::AddModules(const std::vector<uint32>& rSlots)
 {
-  if (Opened && !mOpened)
+  std::vector<Row> rows;
+  for (uint32 i = 0; i < rSlots.size(); i++)
   {
-    Update();
+    Row row;
+    if (GetModuleRow(rSlots[i], row))
+      rows.push_back(row);
   }
-  else
-  {
-    Clear();
-  }
-  nuiTreeNode::Open(Opened);
+  AddChildren(0, rows);
 }
 
-const lldb::SBTarget& ModuleTree::GetTarget() const
+void ModuleTree::RemoveModules(const std::vector<uint32>& rSlots)
 {
-  return mTarget;
-}
-
-const lldb::SBModule& ModuleTree::GetModule() const
-{
-  return mModule;
+  std::set<uint32> slots(rSlots.begin(), rSlots.end());
+  for (int32 i = GetRowCount() - 1; i > 0; i--)
+  {
+    const Row& rRow(GetRow(i));
+    if (rRow.mKind == eModule && slots.find(rRow.mData >> 32) != slots.end())
+      RemoveRow(i);
+  }
 }
 
-void ModuleTree::Update()
+void ModuleTree::Enumerate(const Row& rParent, Enumerator& rEnumerator)
 {
-  switch (mType)
+  switch (rParent.mKind)
   {
     case eTarget:
-      UpdateTarget();
+      EnumerateModules(rEnumerator);
       break;
     case eModule:
-      UpdateModule();
-      break;
-    case eCompileUnit:
-      UpdateCompileUnit();
+      EnumerateCompileUnits(rParent.mData >> 32, rEnumerator);
       break;
     default:
       NGL_ASSERT(0);
   }
 }
 
-void ModuleTree::UpdateTarget()
+void ModuleTree::EnumerateModules(Enumerator& rEnumerator)
 {
-  lldb::SBFileSpec f = mTarget.GetExecutable();
-  nglString str;
-  str.CFormat("Target %s", f.GetFilename());
-  //  NGL_OUT("%s\n", str.GetChars());
-  nglPath p(f.GetDirectory());
-  p += nglString(f.GetFilename());
-  nuiLabel* pLabel = new nuiLabel(str);
-  pLabel->SetToolTip(p.GetChars());
-  SetElement(pLabel);
-
-  int modules = mTarget.GetNumModules();
-  for (int i = 0; i < modules; i++)
+  uint32 slots = mrContext.GetModuleSlotCount();
+  for (uint32 i = 0; i < slots; i++)
   {
-    ModuleTree* pPT = new ModuleTree(mTarget.GetModuleAtIndex(i), eModule);
-    AddChild(pPT);
+    Row row;
+    if (GetModuleRow(i, row) && !rEnumerator.Add(row))
+      return;
   }
 }
 
-void ModuleTree::UpdateModule()
+bool ModuleTree::GetModuleRow(uint32 slot, Row& rRow) const
 {
- lldb::SBFileSpec f = mModule.GetFileSpec();
-  nglString str(f.GetFilename());
-  NGL_OUT("module: %s\n", str.GetChars());
-  nglPath p(f.GetDirectory());
-  p += nglString(f.GetFilename());
-  nuiLabel* pLabel = new nuiLabel(str);
-  pLabel->SetToolTip(p.GetChars());
-  SetElement(pLabel);
+  // Unloaded modules leave an empty slot behind:
+  lldb::SBModule module = mrContext.GetModuleAtSlot(slot);
+  if (!module.IsValid())
+    return false;
+
+  lldb::SBFileSpec f = module.GetFileSpec();
+  rRow.mKind = eModule;
+  rRow.mExpandable = true;
+  rRow.mData = (uint64)slot << 32;
+  rRow.mText = f.GetFilename();
+  return true;
+}
 
-  uint32_t compileunits = mModule.GetNumCompileUnits();
-  for (uint32_t i = 0; i < compileunits; i++)
+void ModuleTree::EnumerateCompileUnits(uint32 module, Enumerator& rEnumerator)
+{
+  lldb::SBModule m = mrContext.GetModuleAtSlot(module);
+
+  // The module cache already knows the compile units, avoid asking LLDB for them again:
+  const ModuleCache* pCache = mrContext.GetModuleCache(m);
+  uint32 count = pCache ? pCache->GetCompileUnitCount() : m.GetNumCompileUnits();
+  for (uint32 i = 0; i < count; i++)
   {
-    ModuleTree* pPT = new ModuleTree(mModule.GetCompileUnitAtIndex(i));
-    AddChild(pPT);
+    Row row;
+    row.mKind = eCompileUnit;
+    row.mData = ((uint64)module << 32) | i;
+    if (pCache)
+    {
+      row.mText = nglPath(pCache->GetCompileUnit(i)).GetNodeName();
+    }
+    else
+    {
+      row.mText = m.GetCompileUnitAtIndex(i).GetFileSpec().GetFilename();
+    }
+
+    if (!rEnumerator.Add(row))
+      return;
   }
 }
 
-void ModuleTree::UpdateCompileUnit()
+nglPath ModuleTree::GetSourcePath(const Row& rRow) const
 {
-  lldb::SBFileSpec f = mCompileUnit.GetFileSpec();
-  nglString str(f.GetFilename());
-  NGL_OUT("  compile unit: %s\n", str.GetChars());
-  nglPath p(f.GetDirectory());
-  p += nglString(f.GetFilename());
-  nuiLabel* pLabel = new nuiLabel(str);
-  pLabel->SetToolTip(p.GetChars());
-  SetElement(pLabel);
+  NGL_ASSERT(rRow.mKind == eCompileUnit);
+  lldb::SBModule m = GetModule(rRow);
+  uint32 index = rRow.mData & 0xffffffff;
 
-//  uint32_t count = mCompileUnit.GetNumLineEntries();
+  const ModuleCache* pCache = mrContext.GetModuleCache(m);
+  if (pCache)
+    return nglPath(pCache->GetCompileUnit(index));
 
-//  for (uint32 i = 0; i < count; i++)
-//  {
-//    lldb::SBLineEntry entry = mCompileUnit.GetLineEntryAtIndex(i);
-//    int32 line = entry.GetLine();
-//    int32 column = entry.GetColumn();
-//    NGL_OUT("    entry %d:%d\n", line, column);
-//  }
-
-}
-
-nglPath ModuleTree::GetSourcePath() const
-{
-  NGL_ASSERT(mType == eCompileUnit);
-  lldb::SBFileSpec f = mCompileUnit.GetFileSpec();
+  lldb::SBFileSpec f = m.GetCompileUnitAtIndex(index).GetFileSpec();
   nglPath p(f.GetDirectory());
-  p += f.GetFilename();
-
+  p += nglString(f.GetFilename());
   return p;
 }
 
-ModuleTree::Type ModuleTree::GetType() const
-{
-  return mType;
-}
-
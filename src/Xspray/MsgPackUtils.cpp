@@ -0,0 +1,55 @@
+//
+//  MsgPackUtils.cpp
+//  Xspray
+//
+
+#include "Xspray.h"
+
+using namespace Xspray;
+
+nglString Xspray::UnpackString(const msgpack_object& rObject)
+{
+  if (rObject.type != MSGPACK_OBJECT_RAW)
+    return nglString::Null;
+  std::string str(rObject.via.raw.ptr, rObject.via.raw.size);
+  return nglString(str.c_str());
+}
+
+bool Xspray::UnpackInt(const msgpack_object& rObject, int64& rValue)
+{
+  if (rObject.type == MSGPACK_OBJECT_POSITIVE_INTEGER)
+    rValue = (int64)rObject.via.u64;
+  else if (rObject.type == MSGPACK_OBJECT_NEGATIVE_INTEGER)
+    rValue = rObject.via.i64;
+  else
+    return false;
+  return true;
+}
+
+uint64 Xspray::UnpackUInt(const msgpack_object& rObject)
+{
+  if (rObject.type == MSGPACK_OBJECT_POSITIVE_INTEGER)
+    return rObject.via.u64;
+  if (rObject.type == MSGPACK_OBJECT_NEGATIVE_INTEGER)
+    return (uint64)rObject.via.i64;
+  return 0;
+}
+
+bool Xspray::IsArray(const msgpack_object& rObject, uint32 size)
+{
+  return rObject.type == MSGPACK_OBJECT_ARRAY && rObject.via.array.size >= size;
+}
+
+void Xspray::PackString(msgpack_packer& rPacker, const char* pString)
+{
+  size_t size = pString ? strlen(pString) : 0;
+  msgpack_pack_raw(&rPacker, size);
+  msgpack_pack_raw_body(&rPacker, pString, size);
+}
+
+void Xspray::PackString(msgpack_packer& rPacker, const nglString& rString)
+{
+  std::string str(rString.GetStdString());
+  msgpack_pack_raw(&rPacker, str.size());
+  msgpack_pack_raw_body(&rPacker, str.c_str(), str.size());
+}
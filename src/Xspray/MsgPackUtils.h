@@ -0,0 +1,15 @@
+//
+//  MsgPackUtils.h
+//  Xspray
+//
+
+#pragma once
+
+// Conversions shared by the msgpack readers and writers: the app catalog, the session logs and the RPC server.
+nglString UnpackString(const msgpack_object& rObject); // Null if the object is not a raw
+bool UnpackInt(const msgpack_object& rObject, int64& rValue); // False if the object is not an integer
+uint64 UnpackUInt(const msgpack_object& rObject); // 0 if the object is not an integer
+bool IsArray(const msgpack_object& rObject, uint32 size); // An array of at least size elements
+
+void PackString(msgpack_packer& rPacker, const char* pString); // NULL is packed as an empty string
+void PackString(msgpack_packer& rPacker, const nglString& rString);
@@ -11,26 +11,47 @@
 using namespace Xspray;
 
 ProcessTree::ProcessTree(const lldb::SBProcess& rProcess)
-: nuiTreeNode(NULL, false, false, true, false), mProcess(rProcess), mType(eProcess)
+: nuiTreeNode(NULL, false, false, true, false), mProcess(rProcess), mType(eProcess),
+  mpRecordedStop(NULL), mpRecordedThread(NULL), mpRecordedFrame(NULL)
 {
   //SetTrace(true);
 //  NGL_OUT("ProcessTree process\n");
 }
 
 ProcessTree::ProcessTree(const lldb::SBThread& rThread)
-: nuiTreeNode(NULL, false, false, true, false), mThread(rThread), mType(eThread)
+: nuiTreeNode(NULL, false, false, true, false), mThread(rThread), mType(eThread),
+  mpRecordedStop(NULL), mpRecordedThread(NULL), mpRecordedFrame(NULL)
 {
   //SetTrace(true);
 //  NGL_OUT("ProcessTree thread\n");
 }
 
-ProcessTree::ProcessTree(const lldb::SBFrame& rFrame)
-: nuiTreeNode(NULL, false, false, true, false), mFrame(rFrame), mType(eFrame)
+ProcessTree::ProcessTree(const AddressIndex::Frame& rFrame)
+: nuiTreeNode(NULL, false, false, true, false), mFrame(rFrame.mFrame), mSymbolicated(rFrame), mType(eFrame),
+  mpRecordedStop(NULL), mpRecordedThread(NULL), mpRecordedFrame(NULL)
 {
   //SetTrace(true);
 //  NGL_OUT("ProcessTree frame\n");
 }
 
+ProcessTree::ProcessTree(const SessionStop& rStop)
+: nuiTreeNode(NULL, false, false, true, false), mType(eProcess),
+  mpRecordedStop(&rStop), mpRecordedThread(NULL), mpRecordedFrame(NULL)
+{
+}
+
+ProcessTree::ProcessTree(const SessionStop::Thread& rThread)
+: nuiTreeNode(NULL, false, false, true, false), mType(eThread),
+  mpRecordedStop(NULL), mpRecordedThread(&rThread), mpRecordedFrame(NULL)
+{
+}
+
+ProcessTree::ProcessTree(const SessionStop::Frame& rFrame)
+: nuiTreeNode(NULL, false, false, true, false), mType(eFrame),
+  mpRecordedStop(NULL), mpRecordedThread(NULL), mpRecordedFrame(&rFrame)
+{
+}
+
 ProcessTree::~ProcessTree()
 {
 
@@ -72,18 +93,32 @@ const lldb::SBFrame& ProcessTree::GetFrame() const
   return mFrame;
 }
 
+const SessionStop::Frame* ProcessTree::GetRecordedFrame() const
+{
+  return mpRecordedFrame;
+}
+
 void ProcessTree::Update()
 {
   switch (mType)
   {
     case eProcess:
-      UpdateProcess();
+      if (mpRecordedStop)
+        UpdateRecordedProcess();
+      else
+        UpdateProcess();
       break;
     case eThread:
-      UpdateThread();
+      if (mpRecordedThread)
+        UpdateRecordedThread();
+      else
+        UpdateThread();
       break;
     case eFrame:
-      UpdateFrame();
+      if (mpRecordedFrame)
+        UpdateRecordedFrame();
+      else
+        UpdateFrame();
       break;
     default:
       NGL_ASSERT(0);
@@ -92,6 +127,7 @@ void ProcessTree::Update()
 
 void ProcessTree::UpdateProcess()
 {
+  XSPRAY_TRACE("ProcessTree::UpdateProcess");
   lldb::SBTarget target = mProcess.GetTarget();
   lldb::SBFileSpec f = target.GetExecutable();
   nglString str;
@@ -114,6 +150,7 @@ void ProcessTree::UpdateProcess()
 
 void ProcessTree::UpdateThread()
 {
+  XSPRAY_TRACE("ProcessTree::UpdateThread");
   nglString str;
   str.CFormat("Thread 0x%x", mThread.GetThreadID ());
 //  NGL_OUT("\t%s\n", str.GetChars());
@@ -126,10 +163,13 @@ void ProcessTree::UpdateThread()
     select = true;
   }
 
-  int frames = mThread.GetNumFrames();
-  for (int i = 0; i < frames; i++)
+  // Symbolicate the whole stack at once:
+  std::vector<AddressIndex::Frame> frames;
+  GetDebuggerContext().mAddressIndex.Symbolicate(mThread.GetProcess(), mThread, frames);
+
+  for (int i = 0; i < frames.size(); i++)
   {
-    ProcessTree* pPT = new ProcessTree(mThread.GetFrameAtIndex(i));
+    ProcessTree* pPT = new ProcessTree(frames[i]);
     AddChild(pPT);
     pPT->Open(true);
 
@@ -143,24 +183,61 @@ void ProcessTree::UpdateThread()
 }
 
 void ProcessTree::UpdateFrame()
+{
+  nuiLabel* pLabel = new nuiLabel(mSymbolicated.mFunction);
+
+  nglPath file;
+  if (!GetDebuggerContext().mSourceResolver.Resolve(nglPath(mSymbolicated.mPath), file))
+    pLabel->SetEnabled(false);
+
+  SetElement(pLabel);
+}
+
+void ProcessTree::UpdateRecordedProcess()
 {
   nglString str;
-  str.CFormat("%s", mFrame.GetFunctionName());
-//  NGL_OUT("\t\t%s\n", str.GetChars());
+  str.CFormat("Process %llu (recorded)", mpRecordedStop->mProcessID);
+  SetElement(new nuiLabel(str));
+
+  for (int32 i = 0; i < mpRecordedStop->mThreads.size(); i++)
+  {
+    ProcessTree* pPT = new ProcessTree(mpRecordedStop->mThreads[i]);
+    AddChild(pPT);
+    pPT->Open(true);
+  }
+}
+
+void ProcessTree::UpdateRecordedThread()
+{
+  nglString str;
+  str.CFormat("Thread 0x%llx", mpRecordedThread->mID);
   nuiLabel* pLabel = new nuiLabel(str);
+  if (!mpRecordedThread->mStopReason.IsEmpty())
+    pLabel->SetToolTip(mpRecordedThread->mStopReason);
+  SetElement(pLabel);
 
+  bool select = !mpRecordedThread->mStopReason.IsEmpty();
+  for (int32 i = 0; i < mpRecordedThread->mFrames.size(); i++)
   {
-    lldb::SBSymbolContext context = mFrame.GetSymbolContext(1);
-    lldb::SBLineEntry lineentry = mFrame.GetLineEntry();
-    lldb::SBFileSpec file =  lineentry.GetFileSpec();
-
-    const char * dir = file.GetDirectory();
-    const char * fname = file.GetFilename();
-    nglPath p(dir);
-    p += fname;
-    if (!p.Exists() || !p.IsLeaf())
-      pLabel->SetEnabled(false);
+    ProcessTree* pPT = new ProcessTree(mpRecordedThread->mFrames[i]);
+    AddChild(pPT);
+    pPT->Open(true);
+
+    if (select)
+    {
+      pPT->Select(true);
+      select = false;
+    }
   }
+}
+
+void ProcessTree::UpdateRecordedFrame()
+{
+  nuiLabel* pLabel = new nuiLabel(mpRecordedFrame->mFunction);
+
+  nglPath file;
+  if (!GetDebuggerContext().mSourceResolver.Resolve(mpRecordedFrame->mPath, file))
+    pLabel->SetEnabled(false);
 
   SetElement(pLabel);
 }
@@ -169,5 +246,3 @@ ProcessTree::Type ProcessTree::GetType() const
 {
   return mType;
 }
-
-
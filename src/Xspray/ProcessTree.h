@@ -20,7 +20,12 @@ public:
 
   ProcessTree(const lldb::SBProcess& rProcess);
   ProcessTree(const lldb::SBThread& rThread);
-  ProcessTree(const lldb::SBFrame& rFrame);
+  ProcessTree(const AddressIndex::Frame& rFrame); // Symbolicated by its thread
+
+  // Replayed from a session log, rStop must outlive the tree:
+  ProcessTree(const SessionStop& rStop);
+  ProcessTree(const SessionStop::Thread& rThread);
+  ProcessTree(const SessionStop::Frame& rFrame);
   virtual ~ProcessTree();
 
   virtual void Open(bool Opened);
@@ -29,11 +34,15 @@ public:
   const lldb::SBProcess& GetProcess() const;
   const lldb::SBThread& GetThread() const;
   const lldb::SBFrame& GetFrame() const;
+  const SessionStop::Frame* GetRecordedFrame() const; // NULL unless replayed
 
   void Update();
   void UpdateProcess();
   void UpdateThread();
   void UpdateFrame();
+  void UpdateRecordedProcess();
+  void UpdateRecordedThread();
+  void UpdateRecordedFrame();
 
   Type GetType() const;
 private:
@@ -41,6 +50,10 @@ private:
   lldb::SBProcess mProcess;
   lldb::SBThread mThread;
   lldb::SBFrame mFrame;
+  AddressIndex::Frame mSymbolicated; // Symbolicated by the thread
+  const SessionStop* mpRecordedStop;
+  const SessionStop::Thread* mpRecordedThread;
+  const SessionStop::Frame* mpRecordedFrame;
 };
 
 
@@ -0,0 +1,312 @@
+//
+//  Profiler.cpp
+//  Xspray
+//
+
+#include "Xspray.h"
+
+#include <signal.h>
+#include <unistd.h>
+
+using namespace Xspray;
+using namespace lldb;
+
+#define PROFILER_STOP_TIMEOUT 1.0 // Seconds to wait for the process to stop before giving up on a sample
+
+Profiler::Node::Node()
+: mSelf(0), mTotal(0)
+{
+}
+
+Profiler::Profiler(DebuggerContext& rContext)
+: mrContext(rContext), mpThread(NULL), mSampling(false), mPendingStop(false), mOwnStop(false), mResuming(false), mRate(100), mMaxDepth(128), mPending(0), mStart(0), mStopped(0), mElapsed(0)
+{
+  mRoot.mFunction = "All";
+}
+
+Profiler::~Profiler()
+{
+  Stop();
+}
+
+void Profiler::SetRate(double hz)
+{
+  mRate = MAX(hz, 0.1);
+}
+
+double Profiler::GetRate() const
+{
+  return mRate;
+}
+
+void Profiler::SetMaxDepth(int32 frames)
+{
+  mMaxDepth = MAX(frames, 1);
+}
+
+int32 Profiler::GetMaxDepth() const
+{
+  return mMaxDepth;
+}
+
+bool Profiler::Start(SBProcess process)
+{
+  Stop();
+  if (!process.IsValid() || process.GetState() != eStateRunning)
+    return false;
+
+  // Modules loaded after this point are sampled by address only:
+  mrContext.mAddressIndex.Rebase(process.GetTarget());
+
+  mProcess = process;
+  {
+    nglCriticalSectionGuard guard(mTreeCS);
+    mStart = nglTime();
+  }
+  mQuit.Reset();
+  mPendingStop = false;
+  mResuming = false;
+  mSampling = true;
+  mpThread = new nglThreadDelegate(nuiMakeDelegate(this, &Profiler::Sampler));
+  mpThread->Start();
+  return true;
+}
+
+void Profiler::Stop()
+{
+  if (!mpThread)
+    return;
+
+  mQuit.Set();
+  mpThread->Join();
+  delete mpThread;
+  mpThread = NULL;
+
+  while (mPending > 0)
+    usleep(1000);
+
+  nglCriticalSectionGuard guard(mTreeCS);
+  mElapsed += nglTime() - mStart;
+  mSampling = false;
+}
+
+bool Profiler::IsSampling() const
+{
+  return mSampling;
+}
+
+bool Profiler::FilterEvent(const SBEvent& rEvent)
+{
+  if (!SBProcess::EventIsProcessEvent(rEvent) || !(rEvent.GetType() & SBProcess::eBroadcastBitStateChanged))
+    return false;
+
+  StateType state = SBProcess::GetStateFromEvent(rEvent);
+  if (state == eStateRunning)
+  {
+    bool resuming = mResuming;
+    mResuming = false;
+    return resuming;
+  }
+
+  if (state == eStateStopped && mPendingStop.exchange(false))
+  {
+    // The sampler tells whether it got the process to itself before resuming it:
+    if (mStopChecked.Wait((int32)(PROFILER_STOP_TIMEOUT * 1000)) && mOwnStop)
+    {
+      mResuming = true;
+      return true;
+    }
+    return false;
+  }
+
+  // A breakpoint, a crash or an exit between two samples, the process stays as it is:
+  mSampling = false;
+  mQuit.Set();
+  return false;
+}
+
+void Profiler::Clear()
+{
+  nglCriticalSectionGuard guard(mTreeCS);
+  mRoot.mChildren.clear();
+  mRoot.mSelf = 0;
+  mRoot.mTotal = 0;
+  mStart = nglTime();
+  mStopped = 0;
+  mElapsed = 0;
+}
+
+void Profiler::GetTree(Node& rRoot) const
+{
+  nglCriticalSectionGuard guard(mTreeCS);
+  rRoot = mRoot;
+}
+
+uint32 Profiler::GetSampleCount() const
+{
+  nglCriticalSectionGuard guard(mTreeCS);
+  return mRoot.mTotal;
+}
+
+double Profiler::GetOverhead() const
+{
+  nglCriticalSectionGuard guard(mTreeCS);
+  double elapsed = mElapsed + (mpThread ? nglTime() - mStart : 0);
+  return elapsed > 0 ? mStopped / elapsed : 0;
+}
+
+void Profiler::Sampler()
+{
+  Tracer::SetThreadName("Profiler");
+  int32 interval = MAX((int32)(1000.0 / mRate), 1);
+
+  while (!mQuit.Wait(interval))
+  {
+    std::vector<Sample> samples;
+    if (!TakeSamples(samples))
+      break;
+
+    mPending++;
+    mrContext.mThreadPool.Post(nuiMakeTask(this, &Profiler::Merge, samples), &mrContext);
+  }
+
+  // The process is gone or could not be resumed, its events are the UI's again:
+  mSampling = false;
+}
+
+bool Profiler::TakeSamples(std::vector<Sample>& rSamples)
+{
+  XSPRAY_TRACE("Profiler::TakeSamples");
+  double start = nglTime();
+  mOwnStop = false;
+  mStopChecked.Reset();
+  mPendingStop = true;
+  mProcess.Stop();
+
+  // Stop may return before the state changed:
+  StateType state = mProcess.GetState();
+  while (!SBDebugger::StateIsStoppedState(state) && nglTime() - start < PROFILER_STOP_TIMEOUT)
+  {
+    usleep(100);
+    state = mProcess.GetState();
+  }
+
+  // A stop with a reason of its own (breakpoint, watchpoint, crash) is left to the UI and ends sampling:
+  mOwnStop = state == eStateStopped && IsInterruption(mProcess);
+  mStopChecked.Set();
+  if (!mOwnStop)
+    return false;
+
+  int32 threads = mProcess.GetNumThreads();
+  rSamples.resize(threads);
+  for (int32 i = 0; i < threads; i++)
+  {
+    SBThread thread = mProcess.GetThreadAtIndex(i);
+    int32 frames = MIN((int32)thread.GetNumFrames(), mMaxDepth);
+    Sample& rSample(rSamples[i]);
+    rSample.mPCs.resize(frames);
+    for (int32 f = 0; f < frames; f++)
+      rSample.mPCs[f] = thread.GetFrameAtIndex(f).GetPC();
+  }
+
+  bool res = mProcess.Continue().Success();
+
+  nglCriticalSectionGuard guard(mTreeCS);
+  mStopped += nglTime() - start;
+  return res;
+}
+
+bool Profiler::IsInterruption(SBProcess process)
+{
+  int32 threads = process.GetNumThreads();
+  for (int32 i = 0; i < threads; i++)
+  {
+    SBThread thread = process.GetThreadAtIndex(i);
+    StopReason reason = thread.GetStopReason();
+    if (reason == eStopReasonNone || reason == eStopReasonInvalid)
+      continue;
+    if (reason == eStopReasonSignal && thread.GetStopReasonDataAtIndex(0) == SIGSTOP)
+      continue;
+    return false;
+  }
+  return true;
+}
+
+void Profiler::Merge(std::vector<Sample> samples)
+{
+  XSPRAY_TRACE("Profiler::Merge");
+
+  // Symbolicate every frame at once, callers by their call instruction:
+  std::vector<addr_t> pcs;
+  for (int32 i = 0; i < samples.size(); i++)
+  {
+    const std::vector<addr_t>& rPCs(samples[i].mPCs);
+    for (int32 f = 0; f < rPCs.size(); f++)
+      pcs.push_back(f && rPCs[f] ? rPCs[f] - 1 : rPCs[f]);
+  }
+
+  std::vector<AddressIndex::Location> locations;
+  mrContext.mAddressIndex.Lookup(pcs, locations);
+
+  std::vector<nglString> names(pcs.size());
+  for (int32 i = 0; i < pcs.size(); i++)
+  {
+    if (!locations[i].mFunction.IsEmpty())
+      names[i] = locations[i].mFunction;
+    else
+      names[i].CFormat("0x%llx", (uint64)pcs[i]);
+  }
+
+  nglCriticalSectionGuard guard(mTreeCS);
+  int32 index = 0;
+  for (int32 i = 0; i < samples.size(); i++)
+  {
+    int32 frames = samples[i].mPCs.size();
+    if (!frames)
+      continue;
+
+    // Walk down from the outermost frame:
+    Node* pNode = &mRoot;
+    pNode->mTotal++;
+    for (int32 f = frames - 1; f >= 0; f--)
+    {
+      const nglString& rName(names[index + f]);
+      Node& rChild(pNode->mChildren[rName]);
+      if (rChild.mFunction.IsEmpty())
+        rChild.mFunction = rName;
+      rChild.mTotal++;
+      pNode = &rChild;
+    }
+    pNode->mSelf++;
+    index += frames;
+  }
+
+  mPending--;
+}
+
+bool Profiler::ExportFolded(const nglPath& rPath) const
+{
+  FILE* pFile = fopen(rPath.GetChars(), "w");
+  if (!pFile)
+    return false;
+
+  nglCriticalSectionGuard guard(mTreeCS);
+  for (auto it = mRoot.mChildren.begin(); it != mRoot.mChildren.end(); ++it)
+    ExportFolded(pFile, it->second, it->first);
+
+  fclose(pFile);
+  return true;
+}
+
+void Profiler::ExportFolded(FILE* pFile, const Node& rNode, const nglString& rStack)
+{
+  if (rNode.mSelf)
+    fprintf(pFile, "%s %u\n", rStack.GetChars(), rNode.mSelf);
+
+  for (auto it = rNode.mChildren.begin(); it != rNode.mChildren.end(); ++it)
+  {
+    nglString stack(rStack);
+    stack.Add(";").Add(it->first);
+    ExportFolded(pFile, it->second, stack);
+  }
+}
@@ -0,0 +1,77 @@
+//
+//  Profiler.h
+//  Xspray
+//
+
+#pragma once
+
+// Statistical profiler over the debugger connection. A sampling thread interrupts the process at a fixed rate, grabs
+// the PCs of every thread and resumes it; the stacks are symbolicated and merged into a call tree on the thread pool.
+// LLDB can only read thread state from a stopped process, so each sample is a full stop: the overhead is reported so
+// the rate and depth can be tuned.
+class DebuggerContext;
+
+class Profiler
+{
+public:
+  struct Node
+  {
+    Node();
+
+    nglString mFunction;
+    uint32 mSelf; // Samples with this node at the top of the stack
+    uint32 mTotal; // Samples going through this node
+    std::map<nglString, Node> mChildren;
+  };
+
+  Profiler(DebuggerContext& rContext); // Symbolicates with the context's index, merges on its thread pool
+  ~Profiler();
+
+  void SetRate(double hz); // 100 Hz by default
+  double GetRate() const;
+  void SetMaxDepth(int32 frames); // Deeper frames are ignored, 128 by default
+  int32 GetMaxDepth() const;
+
+  bool Start(lldb::SBProcess process); // The process must be running
+  void Stop(); // Waits for the samples being merged
+  bool IsSampling() const;
+  bool FilterEvent(const lldb::SBEvent& rEvent); // For the event thread while sampling: true for the stops and resumes of the samples, any other stop or exit ends sampling
+
+  void Clear();
+  void GetTree(Node& rRoot) const; // Copy of the call tree, the root counts every sample
+  uint32 GetSampleCount() const;
+  double GetOverhead() const; // Fraction of the wall time the process spent stopped by the profiler
+
+  bool ExportFolded(const nglPath& rPath) const; // One "a;b;c count" line per stack, for flamegraph.pl and friends
+
+private:
+  struct Sample
+  {
+    std::vector<lldb::addr_t> mPCs; // Innermost frame first
+  };
+
+  void Sampler();
+  bool TakeSamples(std::vector<Sample>& rSamples);
+  static bool IsInterruption(lldb::SBProcess process);
+  void Merge(std::vector<Sample> samples);
+  static void ExportFolded(FILE* pFile, const Node& rNode, const nglString& rStack);
+
+  DebuggerContext& mrContext;
+  lldb::SBProcess mProcess;
+  nglThreadDelegate* mpThread;
+  nglSyncEvent mQuit;
+  volatile bool mSampling;
+  std::atomic<bool> mPendingStop; // Set by the sampler before it interrupts the process, taken by the event thread
+  nglSyncEvent mStopChecked; // The sampler looked at its stop, mOwnStop is valid
+  volatile bool mOwnStop; // The stop was only the sampler's interruption, it resumes the process
+  bool mResuming; // The next running event is the sampler's, only used by the event thread
+  double mRate;
+  int32 mMaxDepth;
+  std::atomic<int32> mPending; // Merge tasks posted but not run yet
+
+  mutable nglCriticalSection mTreeCS; // Protects everything below against the merge tasks
+  Node mRoot;
+  double mStart;
+  double mStopped; // Seconds the process spent stopped for the samples
+  double mElapsed; // Seconds of sampling before the current session
+};
@@ -0,0 +1,263 @@
+//
+//  ResourceMonitor.cpp
+//  Xspray
+//
+
+#include "Xspray.h"
+
+#include <dirent.h>
+#include <unistd.h>
+
+#ifdef __APPLE__
+#include <libproc.h>
+#endif
+
+extern "C"
+{
+#include "libtop.h"
+}
+
+using namespace Xspray;
+using namespace lldb;
+
+#define RESOURCE_HISTORY 1200 // Samples kept, 5 minutes at the default rate
+
+ResourceMonitor::Sample::Sample()
+: mTime(0), mStopped(false), mCPU(0), mResident(0), mVirtual(0), mFaults(0), mSwitches(0), mFiles(0)
+{
+}
+
+ResourceMonitor::ResourceMonitor()
+: mPid(0), mpThread(NULL), mSampling(false), mRate(4), mLastTime(0), mCount(0)
+{
+}
+
+ResourceMonitor::~ResourceMonitor()
+{
+  Stop();
+}
+
+void ResourceMonitor::SetRate(double hz)
+{
+  mRate = MAX(hz, 0.1);
+}
+
+double ResourceMonitor::GetRate() const
+{
+  return mRate;
+}
+
+bool ResourceMonitor::Start(::pid_t pid)
+{
+  Stop();
+  if (pid <= 0)
+    return false;
+
+  mPid = pid;
+  mLastTime = 0;
+  mThreadTimes.clear();
+  {
+    nglCriticalSectionGuard guard(mCS);
+    mSamples.clear();
+    mSamples.resize(RESOURCE_HISTORY);
+    mCount = 0;
+  }
+
+  mQuit.Reset();
+  mSampling = true;
+  mpThread = new nglThreadDelegate(nuiMakeDelegate(this, &ResourceMonitor::Sampler));
+  mpThread->Start();
+  return true;
+}
+
+void ResourceMonitor::Stop()
+{
+  if (!mpThread)
+    return;
+
+  mQuit.Set();
+  mpThread->Join();
+  delete mpThread;
+  mpThread = NULL;
+  mSampling = false;
+  mPid = 0;
+}
+
+bool ResourceMonitor::IsSampling() const
+{
+  return mSampling;
+}
+
+::pid_t ResourceMonitor::GetPid() const
+{
+  return mPid;
+}
+
+uint64 ResourceMonitor::Read(std::vector<Sample>& rSamples, uint64 since) const
+{
+  nglCriticalSectionGuard guard(mCS);
+
+  // The oldest samples may have been overwritten already:
+  uint64 first = MAX(since, mCount > mSamples.size() ? mCount - mSamples.size() : 0);
+  for (uint64 i = first; i < mCount; i++)
+    rSamples.push_back(mSamples[i % mSamples.size()]);
+  return mCount;
+}
+
+void ResourceMonitor::Sampler()
+{
+  Tracer::SetThreadName("ResourceMonitor");
+  if (libtop_init(NULL, NULL))
+  {
+    mSampling = false;
+    return;
+  }
+
+  int32 interval = MAX((int32)(1000.0 / mRate), 1);
+  do
+  {
+    Sample sample;
+    if (!TakeSample(sample))
+      break; // The process is gone
+
+    nglCriticalSectionGuard guard(mCS);
+    mSamples[mCount % mSamples.size()] = sample;
+    mCount++;
+  }
+  while (!mQuit.Wait(interval));
+
+  libtop_fini();
+  mSampling = false;
+}
+
+bool ResourceMonitor::TakeSample(Sample& rSample)
+{
+  XSPRAY_TRACE("ResourceMonitor::TakeSample");
+
+  // libtop samples every process, its Linux backend only parses the ones that ran since the last sample:
+  if (libtop_sample(FALSE, FALSE))
+    return false;
+
+  const libtop_psamp_t* pProcess = NULL;
+  const libtop_psamp_t* pIt;
+  while ((pIt = libtop_piterate()))
+  {
+    if (pIt->pid == mPid)
+    {
+      pProcess = pIt;
+      break;
+    }
+  }
+  if (!pProcess)
+    return false;
+
+  const libtop_tsamp_t* pSystem = libtop_tsamp();
+  double elapsed = (pSystem->time.tv_sec - pSystem->p_time.tv_sec) + (pSystem->time.tv_usec - pSystem->p_time.tv_usec) / 1000000.0;
+  double cpu = (pProcess->total_time.tv_sec - pProcess->p_total_time.tv_sec) + (pProcess->total_time.tv_usec - pProcess->p_total_time.tv_usec) / 1000000.0;
+
+  rSample.mTime = nglTime();
+  rSample.mStopped = pProcess->state == LIBTOP_STATE_STOP;
+  rSample.mResident = pProcess->rsize;
+  rSample.mVirtual = pProcess->vsize;
+  rSample.mFiles = CountFiles();
+
+  // The first sample of a process only sets the counters up:
+  if (mLastTime && elapsed > 0)
+  {
+    rSample.mCPU = cpu * 100.0 / elapsed;
+    rSample.mFaults = (pProcess->faults.now - pProcess->faults.previous) / elapsed;
+    rSample.mSwitches = (pProcess->csw.now - pProcess->csw.previous) / elapsed;
+  }
+  SampleThreads(rSample, mLastTime ? rSample.mTime - mLastTime : 0);
+  mLastTime = rSample.mTime;
+  return true;
+}
+
+void ResourceMonitor::SampleThreads(Sample& rSample, double elapsed)
+{
+  // CPU time of every thread, in nanoseconds:
+  std::map<uint64, uint64> times;
+#ifdef __APPLE__
+  std::vector<uint64_t> threads(256);
+  int bytes;
+  while ((bytes = proc_pidinfo(mPid, PROC_PIDLISTTHREADS, 0, &threads[0], threads.size() * sizeof(uint64_t))) >= threads.size() * sizeof(uint64_t))
+    threads.resize(threads.size() * 2);
+
+  for (int32 i = 0; i < bytes / sizeof(uint64_t); i++)
+  {
+    struct proc_threadinfo info;
+    if (proc_pidinfo(mPid, PROC_PIDTHREADINFO, threads[i], &info, sizeof(info)) == sizeof(info))
+      times[threads[i]] = info.pth_user_time + info.pth_system_time;
+  }
+#else
+  nglString path;
+  path.CFormat("/proc/%d/task", mPid);
+  DIR* pDir = opendir(path.GetChars());
+  if (!pDir)
+    return;
+
+  uint64 hz = sysconf(_SC_CLK_TCK);
+  struct dirent* pEntry;
+  while ((pEntry = readdir(pDir)))
+  {
+    if (pEntry->d_name[0] < '0' || pEntry->d_name[0] > '9')
+      continue;
+
+    path.CFormat("/proc/%d/task/%s/stat", mPid, pEntry->d_name);
+    FILE* pFile = fopen(path.GetChars(), "r");
+    if (!pFile)
+      continue;
+
+    // utime and stime are the 14th and 15th fields, after the command which can hold spaces:
+    char line[1024];
+    size_t len = fread(line, 1, sizeof(line) - 1, pFile);
+    fclose(pFile);
+    line[len] = 0;
+    const char* pFields = strrchr(line, ')');
+    unsigned long long utime, stime;
+    if (pFields && sscanf(pFields + 2, "%*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %llu %llu", &utime, &stime) == 2)
+      times[strtoull(pEntry->d_name, NULL, 10)] = (utime + stime) * 1000000000ULL / hz;
+  }
+  closedir(pDir);
+#endif
+
+  for (auto it = times.begin(); it != times.end(); ++it)
+  {
+    float cpu = 0;
+    auto previous = mThreadTimes.find(it->first);
+    if (elapsed > 0 && previous != mThreadTimes.end() && it->second >= previous->second)
+      cpu = (it->second - previous->second) * 100.0 / (elapsed * 1000000000.0);
+    rSample.mThreads.push_back(std::make_pair(it->first, cpu));
+  }
+  mThreadTimes.swap(times);
+}
+
+int32 ResourceMonitor::CountFiles() const
+{
+#ifdef __APPLE__
+  int bytes = proc_pidinfo(mPid, PROC_PIDLISTFDS, 0, NULL, 0);
+  if (bytes <= 0)
+    return 0;
+
+  // The first call only gives an upper bound:
+  std::vector<struct proc_fdinfo> files(bytes / PROC_PIDLISTFD_SIZE);
+  bytes = proc_pidinfo(mPid, PROC_PIDLISTFDS, 0, &files[0], files.size() * PROC_PIDLISTFD_SIZE);
+  return MAX(bytes, 0) / PROC_PIDLISTFD_SIZE;
+#else
+  nglString path;
+  path.CFormat("/proc/%d/fd", mPid);
+  DIR* pDir = opendir(path.GetChars());
+  if (!pDir)
+    return 0;
+
+  int32 count = 0;
+  struct dirent* pEntry;
+  while ((pEntry = readdir(pDir)))
+  {
+    if (pEntry->d_name[0] != '.')
+      count++;
+  }
+  closedir(pDir);
+  return count;
+#endif
+}
@@ -0,0 +1,60 @@
+//
+//  ResourceMonitor.h
+//  Xspray
+//
+
+#pragma once
+
+// Samples the resources of a debuggee from outside of the debugger: CPU, memory, faults and context switches come from
+// libtop (deps/top), the CPU of each thread and the open files from the system. The samples are kept in a ring, so the
+// process keeps its history while it runs, steps or sits at a breakpoint. libtop keeps its state in globals: only one
+// monitor can sample at a time.
+class ResourceMonitor
+{
+public:
+  struct Sample
+  {
+    Sample();
+
+    double mTime;
+    bool mStopped; // Suspended or traced, by the debugger for instance
+    float mCPU; // Percent of one core, every thread
+    uint64 mResident; // Bytes
+    uint64 mVirtual; // Bytes
+    float mFaults; // Per second
+    float mSwitches; // Per second
+    int32 mFiles; // Open file descriptors
+    std::vector<std::pair<uint64, float> > mThreads; // System thread id, percent of one core
+  };
+
+  ResourceMonitor();
+  ~ResourceMonitor();
+
+  void SetRate(double hz); // 4 Hz by default
+  double GetRate() const;
+
+  bool Start(pid_t pid); // Clears the history
+  void Stop(); // Keeps the history
+  bool IsSampling() const; // False once stopped or when the process is gone
+  pid_t GetPid() const; // 0 once stopped
+
+  uint64 Read(std::vector<Sample>& rSamples, uint64 since) const; // The samples taken since the given count, returns the new count
+
+private:
+  void Sampler();
+  bool TakeSample(Sample& rSample);
+  void SampleThreads(Sample& rSample, double elapsed);
+  int32 CountFiles() const;
+
+  pid_t mPid;
+  nglThreadDelegate* mpThread;
+  nglSyncEvent mQuit;
+  volatile bool mSampling;
+  double mRate;
+  double mLastTime;
+  std::map<uint64, uint64> mThreadTimes; // Nanoseconds of CPU of each thread at the previous sample
+
+  mutable nglCriticalSection mCS; // Protects the ring
+  std::vector<Sample> mSamples;
+  uint64 mCount; // Samples taken since Start, the last one is at (mCount - 1) % size
+};
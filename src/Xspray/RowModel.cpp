@@ -0,0 +1,274 @@
+//
+//  RowModel.cpp
+//  Xspray
+//
+
+#include "Xspray.h"
+
+using namespace Xspray;
+
+#define ROW_CHUNK_SIZE 256
+
+// Enumerations get their own workers so that opening a node never waits behind the module indexing tasks:
+static ThreadPool& GetEnumeratorPool()
+{
+  static ThreadPool pool(2);
+  return pool;
+}
+
+//////// RowModel::Row
+RowModel::Row::Row()
+: mId(0), mDepth(0), mExpandable(false), mOpened(false), mLoading(false), mKind(0), mData(0)
+{
+}
+
+//////// RowModel::Enumerator
+RowModel::Enumerator::Enumerator(RowModel* pModel, uint32 parent, uint32 request)
+: mpModel(pModel), mParent(parent), mRequest(request)
+{
+  mRows.reserve(ROW_CHUNK_SIZE);
+}
+
+bool RowModel::Enumerator::Add(const Row& rRow)
+{
+  mRows.push_back(rRow);
+  if (mRows.size() < ROW_CHUNK_SIZE)
+    return true;
+  return Flush(false);
+}
+
+bool RowModel::Enumerator::Flush(bool done)
+{
+  Chunk* pChunk = new Chunk();
+  pChunk->mParent = mParent;
+  pChunk->mRequest = mRequest;
+  pChunk->mDone = done;
+  pChunk->mRows.swap(mRows);
+  mRows.reserve(ROW_CHUNK_SIZE);
+  return mpModel->Post(pChunk);
+}
+
+//////// RowModel
+RowModel::RowModel()
+: mNextId(1), mNextRequest(0), mChanged(false)
+{
+}
+
+RowModel::~RowModel()
+{
+  // Enumeration tasks hold a reference on the model so none can be running by now.
+  Clear();
+}
+
+int32 RowModel::GetRowCount() const
+{
+  return mRows.size();
+}
+
+const RowModel::Row& RowModel::GetRow(int32 index) const
+{
+  NGL_ASSERT(index >= 0 && index < mRows.size());
+  return mRows[index];
+}
+
+int32 RowModel::GetIndex(uint32 id) const
+{
+  for (int32 i = 0; i < mRows.size(); i++)
+  {
+    if (mRows[i].mId == id)
+      return i;
+  }
+  return -1;
+}
+
+void RowModel::AddRoot(const Row& rRow)
+{
+  Row row(rRow);
+  row.mId = mNextId++;
+  row.mDepth = 0;
+  row.mOpened = false;
+  row.mLoading = false;
+  mRows.push_back(row);
+}
+
+void RowModel::SetOpened(int32 index, bool opened)
+{
+  NGL_ASSERT(index >= 0 && index < mRows.size());
+  Row& rRow(mRows[index]);
+  if (!rRow.mExpandable || rRow.mOpened == opened)
+    return;
+
+  rRow.mOpened = opened;
+  if (opened)
+  {
+    rRow.mLoading = true;
+    uint32 request = ++mNextRequest;
+    {
+      nglCriticalSectionGuard guard(mCS);
+      mRequests[rRow.mId] = request;
+    }
+
+    Acquire();
+    GetEnumeratorPool().Post(nuiMakeTask(this, &RowModel::Run, rRow, request));
+    return;
+  }
+
+  // Drop the descendants and cancel their pending enumerations:
+  rRow.mLoading = false;
+  int32 end = GetEnd(index);
+
+  {
+    nglCriticalSectionGuard guard(mCS);
+    for (int32 i = index; i < end; i++)
+      mRequests.erase(mRows[i].mId);
+  }
+
+  mRows.erase(mRows.begin() + index + 1, mRows.begin() + end);
+  mChanged = true;
+}
+
+void RowModel::AddChildren(int32 index, const std::vector<Row>& rRows)
+{
+  NGL_ASSERT(index >= 0 && index < mRows.size());
+  if (!mRows[index].mOpened || rRows.empty())
+    return;
+
+  // The running enumeration may or may not list the new rows already:
+  if (mRows[index].mLoading)
+  {
+    Reload(index);
+    return;
+  }
+
+  std::vector<Row> rows(rRows);
+  InsertChildren(index, rows);
+}
+
+void RowModel::RemoveRow(int32 index)
+{
+  NGL_ASSERT(index >= 0 && index < mRows.size());
+  int32 parent = index - 1;
+  while (parent >= 0 && mRows[parent].mDepth >= mRows[index].mDepth)
+    parent--;
+
+  // A chunk of the running enumeration could bring the row back:
+  if (parent >= 0 && mRows[parent].mLoading)
+  {
+    Reload(parent);
+    return;
+  }
+
+  int32 end = GetEnd(index);
+  {
+    nglCriticalSectionGuard guard(mCS);
+    for (int32 i = index; i < end; i++)
+      mRequests.erase(mRows[i].mId);
+  }
+
+  mRows.erase(mRows.begin() + index, mRows.begin() + end);
+  mChanged = true;
+}
+
+void RowModel::Reload(int32 index)
+{
+  SetOpened(index, false);
+  SetOpened(index, true);
+}
+
+int32 RowModel::GetEnd(int32 index) const
+{
+  int32 end = index + 1;
+  while (end < mRows.size() && mRows[end].mDepth > mRows[index].mDepth)
+    end++;
+  return end;
+}
+
+void RowModel::InsertChildren(int32 index, std::vector<Row>& rRows)
+{
+  // Append after the children that were already inserted:
+  int32 depth = mRows[index].mDepth;
+  int32 pos = GetEnd(index);
+
+  for (auto r = rRows.begin(); r != rRows.end(); ++r)
+  {
+    r->mId = mNextId++;
+    r->mDepth = depth + 1;
+    r->mOpened = false;
+    r->mLoading = false;
+  }
+
+  mRows.insert(mRows.begin() + pos, rRows.begin(), rRows.end());
+  mChanged = true;
+}
+
+void RowModel::Clear()
+{
+  nglCriticalSectionGuard guard(mCS);
+  mRequests.clear();
+  for (auto it = mChunks.begin(); it != mChunks.end(); ++it)
+    delete *it;
+  mChunks.clear();
+  mRows.clear();
+}
+
+bool RowModel::IsCurrent(uint32 parent, uint32 request) const
+{
+  auto it = mRequests.find(parent);
+  return it != mRequests.end() && it->second == request;
+}
+
+bool RowModel::Post(Chunk* pChunk)
+{
+  nglCriticalSectionGuard guard(mCS);
+  if (!IsCurrent(pChunk->mParent, pChunk->mRequest))
+  {
+    delete pChunk;
+    return false;
+  }
+
+  mChunks.push_back(pChunk);
+  return true;
+}
+
+void RowModel::Run(Row parent, uint32 request)
+{
+  Enumerator enumerator(this, parent.mId, request);
+  Enumerate(parent, enumerator);
+  enumerator.Flush(true);
+  Release();
+}
+
+bool RowModel::Flush()
+{
+  std::deque<Chunk*> chunks;
+  {
+    nglCriticalSectionGuard guard(mCS);
+    chunks.swap(mChunks);
+  }
+
+  bool changed = mChanged;
+  mChanged = false;
+  for (auto it = chunks.begin(); it != chunks.end(); ++it)
+  {
+    Chunk* pChunk = *it;
+    bool current;
+    {
+      nglCriticalSectionGuard guard(mCS);
+      current = IsCurrent(pChunk->mParent, pChunk->mRequest);
+    }
+
+    int32 index = current ? GetIndex(pChunk->mParent) : -1;
+    if (index >= 0)
+    {
+      if (pChunk->mDone)
+        mRows[index].mLoading = false;
+
+      InsertChildren(index, pChunk->mRows);
+      changed = true;
+    }
+
+    delete pChunk;
+  }
+
+  return changed;
+}
@@ -0,0 +1,88 @@
+//
+//  RowModel.h
+//  Xspray
+//
+
+#pragma once
+
+// Flat list of the visible rows of a lazily expanded tree. Only the children of opened rows exist: they are enumerated
+// by a background task and inserted in chunks on the main thread as they arrive.
+class RowModel : public nuiRefCount
+{
+public:
+  struct Row
+  {
+    Row();
+
+    uint32 mId;        // Stable identifier, set when the row is inserted
+    int32 mDepth;
+    bool mExpandable;
+    bool mOpened;
+    bool mLoading;     // Children are still being enumerated
+    int32 mKind;       // Meaning defined by the model
+    uint64 mData;      // Meaning defined by the model
+    nglString mText;
+  };
+
+  // Handed to Enumerate to publish the children of a row.
+  class Enumerator
+  {
+  public:
+    bool Add(const Row& rRow); // Returns false once the enumeration has been cancelled
+
+  private:
+    friend class RowModel;
+    Enumerator(RowModel* pModel, uint32 parent, uint32 request);
+    bool Flush(bool done);
+
+    RowModel* mpModel;
+    uint32 mParent;
+    uint32 mRequest;
+    std::vector<Row> mRows;
+  };
+
+  RowModel();
+  virtual ~RowModel();
+
+  int32 GetRowCount() const;
+  const Row& GetRow(int32 index) const;
+  int32 GetIndex(uint32 id) const; // -1 if the row doesn't exist anymore
+
+  void AddRoot(const Row& rRow);
+  void SetOpened(int32 index, bool opened);
+  void Clear();
+
+  // Apply changes to the children of opened rows without enumerating them again. Main thread only.
+  void AddChildren(int32 index, const std::vector<Row>& rRows); // Appended after the current children
+  void RemoveRow(int32 index); // Together with its descendants
+
+  bool Flush(); // Insert the chunks produced by the enumerators, returns true if the rows changed. Main thread only.
+
+protected:
+  virtual void Enumerate(const Row& rParent, Enumerator& rEnumerator) = 0; // Runs on a worker thread
+
+private:
+  struct Chunk
+  {
+    uint32 mParent;
+    uint32 mRequest;
+    bool mDone;
+    std::vector<Row> mRows;
+  };
+
+  void Run(Row parent, uint32 request);
+  bool Post(Chunk* pChunk);
+  bool IsCurrent(uint32 parent, uint32 request) const; // Must be called with mCS held
+  int32 GetEnd(int32 index) const; // Index after the last descendant of the row
+  void InsertChildren(int32 index, std::vector<Row>& rRows);
+  void Reload(int32 index); // Restart the enumeration of the children of an opened row
+
+  std::vector<Row> mRows;
+  uint32 mNextId;
+  uint32 mNextRequest;
+  bool mChanged;
+
+  mutable nglCriticalSection mCS;
+  std::map<uint32, uint32> mRequests; // Row id -> enumeration of its children in progress or done
+  std::deque<Chunk*> mChunks;
+};
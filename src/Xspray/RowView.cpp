@@ -0,0 +1,179 @@
+//
+//  RowView.cpp
+//  Xspray
+//
+
+#include "Xspray.h"
+
+using namespace Xspray;
+
+RowView::RowView()
+: mEventSink(this), mpModel(NULL), mSelected(0), mWidth(0), mIndent(14)
+{
+  if (SetObjectClass("RowView"))
+  {
+    // Attributes
+  }
+
+  mStyle.SetFont(nuiFont::GetFont(12));
+  mEventSink.Connect(nuiAnimation::GetTimer()->Tick, &RowView::OnTick);
+}
+
+RowView::~RowView()
+{
+  SetModel(NULL);
+}
+
+void RowView::SetModel(RowModel* pModel)
+{
+  if (pModel)
+    pModel->Acquire();
+  if (mpModel)
+    mpModel->Release();
+  mpModel = pModel;
+
+  for (auto it = mLayouts.begin(); it != mLayouts.end(); ++it)
+    delete it->second;
+  mLayouts.clear();
+  mSelected = 0;
+  mWidth = 0;
+  InvalidateLayout();
+}
+
+RowModel* RowView::GetModel() const
+{
+  return mpModel;
+}
+
+const RowModel::Row* RowView::GetSelectedRow() const
+{
+  if (!mpModel || !mSelected)
+    return NULL;
+
+  int32 index = mpModel->GetIndex(mSelected);
+  if (index < 0)
+    return NULL;
+  return &mpModel->GetRow(index);
+}
+
+float RowView::GetRowHeight() const
+{
+  return ToAbove(mStyle.GetFont()->GetHeight());
+}
+
+void RowView::OnTick(const nuiEvent& rEvent)
+{
+  // Pick up the rows the background enumerators have produced since the last frame:
+  if (mpModel && mpModel->Flush())
+    InvalidateLayout();
+}
+
+nuiRect RowView::CalcIdealSize()
+{
+  int32 count = mpModel ? mpModel->GetRowCount() : 0;
+  return nuiRect(0.0f, 0.0f, mWidth, GetRowHeight() * count);
+}
+
+bool RowView::Draw(nuiDrawContext* pContext)
+{
+  if (!mpModel)
+    return true;
+
+  float h = GetRowHeight();
+  int32 count = mpModel->GetRowCount();
+
+  nuiRect visible(GetVisibleRect());
+  if (visible.GetHeight() <= 0)
+    visible = GetRect().Size();
+  int32 first = MAX(0, (int32)(visible.Top() / h));
+  int32 last = MIN(count, (int32)(visible.Bottom() / h) + 1);
+
+  pContext->EnableBlending(true);
+  pContext->SetBlendFunc(nuiBlendTransp);
+
+  nuiFont* pFontAwesome = nuiFont::GetFont("FontAwesome10");
+  const nglString& rClosed(nuiObject::GetGlobalProperty("fontawesome_caret_right"));
+  const nglString& rOpened(nuiObject::GetGlobalProperty("fontawesome_caret_down"));
+
+  std::map<uint32, nuiTextLayout*> layouts;
+  float width = mWidth;
+  for (int32 i = first; i < last; i++)
+  {
+    const RowModel::Row& rRow(mpModel->GetRow(i));
+    float x = rRow.mDepth * mIndent;
+    float y = (float)(i + 1) * h;
+
+    if (rRow.mId == mSelected)
+    {
+      pContext->SetFillColor(nuiColor(230, 230, 250));
+      pContext->DrawRect(nuiRect(0.0f, y - h, GetRect().GetWidth(), h), eFillShape);
+    }
+
+    if (rRow.mExpandable)
+    {
+      pContext->SetFont(pFontAwesome);
+      pContext->SetTextColor(rRow.mLoading ? nuiColor(160, 160, 160) : nuiColor(0, 0, 0));
+      pContext->DrawText(x + 2, y - 3, rRow.mOpened ? rOpened : rClosed);
+    }
+
+    // Reuse the layouts of the rows that were already visible and only create the new ones:
+    nuiTextLayout* pLayout = NULL;
+    auto it = mLayouts.find(rRow.mId);
+    if (it != mLayouts.end())
+    {
+      pLayout = it->second;
+      mLayouts.erase(it);
+    }
+    else
+    {
+      pLayout = new nuiTextLayout(mStyle);
+      pLayout->Layout(rRow.mText);
+    }
+    layouts[rRow.mId] = pLayout;
+
+    pContext->SetTextColor(nuiColor(0, 0, 0));
+    pContext->DrawText(x + mIndent, y, *pLayout);
+    width = MAX(width, x + mIndent + pLayout->GetRect().GetWidth());
+  }
+
+  pFontAwesome->Release();
+
+  for (auto it = mLayouts.begin(); it != mLayouts.end(); ++it)
+    delete it->second;
+  mLayouts.swap(layouts);
+
+  if (width > mWidth)
+  {
+    mWidth = ToAbove(width);
+    InvalidateLayout();
+  }
+
+  return true;
+}
+
+bool RowView::MouseClicked(nuiSize X, nuiSize Y, nglMouseInfo::Flags Button)
+{
+  if (!(Button & nglMouseInfo::ButtonLeft) || !mpModel)
+    return false;
+
+  int32 index = (int32)(Y / GetRowHeight());
+  if (index < 0 || index >= mpModel->GetRowCount())
+    return true;
+
+  const RowModel::Row& rRow(mpModel->GetRow(index));
+  float x = rRow.mDepth * mIndent;
+  if (rRow.mExpandable && ((X >= x && X < x + mIndent) || (Button & nglMouseInfo::ButtonDoubleClick)))
+  {
+    mpModel->SetOpened(index, !rRow.mOpened);
+    InvalidateLayout();
+    return true;
+  }
+
+  if (rRow.mId != mSelected)
+  {
+    mSelected = rRow.mId;
+    Invalidate();
+    SelectionChanged();
+  }
+  return true;
+}
@@ -0,0 +1,38 @@
+//
+//  RowView.h
+//  Xspray
+//
+
+#pragma once
+
+// Displays a RowModel as a tree. Nothing is created per row: text layouts only exist for the rows in the visible part of the view.
+class RowView : public nuiSimpleContainer
+{
+public:
+  RowView();
+  virtual ~RowView();
+
+  void SetModel(RowModel* pModel);
+  RowModel* GetModel() const;
+
+  const RowModel::Row* GetSelectedRow() const;
+
+  virtual nuiRect CalcIdealSize();
+  virtual bool Draw(nuiDrawContext* pContext);
+
+  virtual bool MouseClicked(nuiSize X, nuiSize Y, nglMouseInfo::Flags Button);
+
+  nuiSimpleEventSource<nuiWidgetSelected> SelectionChanged;
+
+private:
+  void OnTick(const nuiEvent& rEvent);
+  float GetRowHeight() const;
+
+  nuiEventSink<RowView> mEventSink;
+  RowModel* mpModel;
+  uint32 mSelected; // Row id
+  float mWidth;
+  float mIndent;
+  nuiTextStyle mStyle;
+  std::map<uint32, nuiTextLayout*> mLayouts; // Row id -> layout, for the visible rows only
+};
@@ -0,0 +1,1109 @@
+//
+//  RpcServer.cpp
+//  Xspray
+//
+
+#include "Xspray.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using namespace Xspray;
+using namespace lldb;
+
+#define RPC_REQUEST 0
+#define RPC_RESPONSE 1
+#define RPC_NOTIFICATION 2
+#define RPC_READ_SIZE (64 * 1024)
+#define RPC_MAX_READ (16 * 1024 * 1024) // memory.read
+#define RPC_WAIT_TIMEOUT 30.0 // process.wait, seconds
+#define RPC_POLL_INTERVAL 10000 // process.wait on a context with an event thread, microseconds
+#define RPC_WAIT_SLICE 1.0 // process.wait pulling the events itself checks for a shutdown that often, seconds
+#define RPC_CALL_WAIT 100 // A call waiting for the main thread checks for a shutdown that often, milliseconds
+#define RPC_ZONE_POOL (1024 * 1024) // Zones of the unpacked messages recycled by the server thread
+
+static const msgpack_object* GetParam(const msgpack_object& rParams, uint32 index)
+{
+  if (!IsArray(rParams, index + 1))
+    return NULL;
+  return &rParams.via.array.ptr[index];
+}
+
+static void PackState(msgpack_packer& rPacker, StateType state)
+{
+  PackString(rPacker, SBDebugger::StateAsCString(state));
+}
+
+nuiSignal1<DebuggerContext*> RpcServer::TargetAdded;
+
+// A call handed to the main thread. The client's thread gives up on it if the server stops meanwhile, the main thread
+// may be the one stopping it:
+struct RpcServer::MainThreadCall
+{
+  MainThreadCall(RpcServer* pServer, Method method, const msgpack_object& rParams, msgpack_packer& rResult)
+  : mpServer(pServer), mMethod(method), mrParams(rParams), mrResult(rResult), mRefs(2), mRan(false), mCancelled(false), mRes(false)
+  {
+  }
+
+  void Release() // Once by each thread
+  {
+    if (--mRefs == 0)
+      delete this;
+  }
+
+  void Run()
+  {
+    {
+      nglCriticalSectionGuard guard(mCS);
+      if (!mCancelled)
+      {
+        mRes = (mpServer->*mMethod)(mrParams, mrResult, mError);
+        mRan = true;
+      }
+    }
+    mDone.Set();
+    Release();
+  }
+
+  RpcServer* mpServer;
+  Method mMethod;
+  const msgpack_object& mrParams;
+  msgpack_packer& mrResult;
+  std::atomic<int32> mRefs;
+  nglCriticalSection mCS; // Held while running, the call can't be given up meanwhile
+  nglSyncEvent mDone;
+  bool mRan;
+  bool mCancelled;
+  bool mRes;
+  nglString mError;
+};
+
+static int32 GetContextIndex(DebuggerContext* pContext)
+{
+  for (int32 i = 0; i < DebuggerContext::GetContextCount(); i++)
+  {
+    if (DebuggerContext::GetContext(i) == pContext)
+      return i;
+  }
+  return -1;
+}
+
+RpcServer::RpcServer()
+: mListener(-1), mpThread(NULL), mRunning(false), mShutdown(false), mClientCount(0), mCalls(0)
+{
+  mWake[0] = mWake[1] = -1;
+
+  mMethods["targets"] = &RpcServer::Targets;
+  mMethods["target.create"] = &RpcServer::TargetCreate;
+  mMethods["target.core"] = &RpcServer::TargetCore;
+  mMethods["breakpoint.add"] = &RpcServer::BreakpointAdd;
+  mMethods["breakpoint.list"] = &RpcServer::BreakpointList;
+  mMethods["breakpoint.remove"] = &RpcServer::BreakpointRemove;
+  mMethods["process.launch"] = &RpcServer::ProcessLaunch;
+  mMethods["process.continue"] = &RpcServer::ProcessContinue;
+  mMethods["process.stop"] = &RpcServer::ProcessStop;
+  mMethods["process.kill"] = &RpcServer::ProcessKill;
+  mMethods["process.step"] = &RpcServer::ProcessStep;
+  mMethods["process.wait"] = &RpcServer::ProcessWait;
+  mMethods["process.state"] = &RpcServer::ProcessState;
+  mMethods["threads"] = &RpcServer::Threads;
+  mMethods["stack"] = &RpcServer::Stack;
+  mMethods["variables"] = &RpcServer::Variables;
+  mMethods["memory.read"] = &RpcServer::MemoryRead;
+  mMethods["shutdown"] = &RpcServer::Shutdown;
+}
+
+RpcServer::~RpcServer()
+{
+  Stop();
+
+  // The ones closed from the UI are deleted there:
+  for (int32 i = 0; i < mContexts.size(); i++)
+  {
+    if (DebuggerContext::HasContext(mContexts[i]))
+      delete mContexts[i];
+  }
+}
+
+bool RpcServer::Start(const nglPath& rSocket)
+{
+  Stop();
+
+  std::string path(rSocket.GetPathName().GetStdString());
+  struct sockaddr_un address;
+  memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  if (path.size() >= sizeof(address.sun_path))
+    return false;
+  strcpy(address.sun_path, path.c_str());
+
+  // Only a stale socket is replaced, never a file that happens to be there:
+  struct stat st;
+  if (!lstat(path.c_str(), &st))
+  {
+    if (!S_ISSOCK(st.st_mode))
+      return false;
+    unlink(path.c_str());
+  }
+
+  mListener = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (mListener < 0)
+    return false;
+
+  // Whoever can connect can run programs as the user, the socket is created private:
+  mode_t mask = umask(0077);
+  int res = bind(mListener, (struct sockaddr*)&address, sizeof(address));
+  umask(mask);
+  if (res || chmod(path.c_str(), 0600) || listen(mListener, SOMAXCONN) || pipe(mWake))
+  {
+    if (!res)
+      unlink(path.c_str());
+    close(mListener);
+    mListener = -1;
+    return false;
+  }
+  fcntl(mListener, F_SETFL, O_NONBLOCK);
+
+  mSocketPath = rSocket;
+  mShutdown = false;
+  mRunning = true;
+  mpThread = new nglThreadDelegate(nuiMakeDelegate(this, &RpcServer::Serve));
+  mpThread->Start();
+  return true;
+}
+
+void RpcServer::Stop()
+{
+  if (!mpThread)
+    return;
+
+  mShutdown = true;
+  char c = 0;
+  write(mWake[1], &c, 1);
+  mpThread->Join();
+  delete mpThread;
+  mpThread = NULL;
+
+  while (!mClients.empty())
+    CloseClient(mClients.back());
+
+  close(mListener);
+  close(mWake[0]);
+  close(mWake[1]);
+  mListener = -1;
+  mWake[0] = mWake[1] = -1;
+  unlink(mSocketPath.GetChars());
+  mRunning = false;
+}
+
+bool RpcServer::IsRunning() const
+{
+  return mRunning;
+}
+
+int32 RpcServer::GetClientCount() const
+{
+  return mClientCount;
+}
+
+uint64 RpcServer::GetCallCount() const
+{
+  return mCalls;
+}
+
+void RpcServer::Serve()
+{
+  Tracer::SetThreadName("RPC server");
+  struct pollfd fds[2];
+  while (!mShutdown)
+  {
+    fds[0].fd = mWake[0];
+    fds[0].events = POLLIN;
+    fds[0].revents = 0;
+    fds[1].fd = mListener;
+    fds[1].events = POLLIN;
+    fds[1].revents = 0;
+
+    if (poll(fds, 2, -1) < 0)
+    {
+      if (errno == EINTR)
+        continue;
+      break;
+    }
+
+    if (fds[0].revents)
+      break;
+
+    // The clients gone since the last connection are closed with the next one:
+    for (int32 i = mClients.size() - 1; i >= 0; i--)
+    {
+      if (mClients[i]->mDone)
+        CloseClient(mClients[i]);
+    }
+    if (fds[1].revents & POLLIN)
+      Accept();
+  }
+  mRunning = false;
+}
+
+void RpcServer::Accept()
+{
+  int s = accept(mListener, NULL, NULL);
+  if (s < 0)
+    return;
+
+  fcntl(s, F_SETFL, O_NONBLOCK);
+  Client* pClient = new Client();
+  pClient->mpServer = this;
+  pClient->mSocket = s;
+  pClient->mDone = false;
+  msgpack_unpacker_init(&pClient->mUnpacker, RPC_READ_SIZE);
+  msgpack_sbuffer_init(&pClient->mOutput);
+  pClient->mWritten = 0;
+  msgpack_sbuffer_init(&pClient->mResult);
+  msgpack_packer_init(&pClient->mResultPacker, &pClient->mResult, msgpack_sbuffer_write);
+  mClients.push_back(pClient);
+  mClientCount = mClients.size();
+
+  pClient->mpThread = new nglThreadDelegate(nuiMakeDelegate(pClient, &Client::Serve));
+  pClient->mpThread->Start();
+}
+
+void RpcServer::Client::Serve()
+{
+  mpServer->ServeClient(this);
+}
+
+void RpcServer::ServeClient(Client* pClient)
+{
+  Tracer::SetThreadName("RPC client");
+  msgpack_zone_pool_set_limit(RPC_ZONE_POOL);
+  struct pollfd fds[2];
+  while (!mShutdown)
+  {
+    fds[0].fd = mWake[0];
+    fds[0].events = POLLIN;
+    fds[0].revents = 0;
+    fds[1].fd = pClient->mSocket;
+    fds[1].events = POLLIN;
+    fds[1].revents = 0;
+
+    if (poll(fds, 2, -1) < 0)
+    {
+      if (errno == EINTR)
+        continue;
+      break;
+    }
+
+    if (fds[0].revents)
+      break;
+
+    // A shutdown request gets its answer before the connection closes:
+    if (!Read(pClient) || !Write(pClient))
+      break;
+  }
+  msgpack_zone_pool_set_limit(0);
+  pClient->mDone = true;
+}
+
+bool RpcServer::Read(Client* pClient)
+{
+  msgpack_unpacker& rUnpacker(pClient->mUnpacker);
+  while (true)
+  {
+    if (!msgpack_unpacker_reserve_buffer(&rUnpacker, RPC_READ_SIZE))
+      return false;
+
+    ssize_t size = read(pClient->mSocket, msgpack_unpacker_buffer(&rUnpacker), msgpack_unpacker_buffer_capacity(&rUnpacker));
+    if (size < 0)
+      return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+    if (size == 0)
+      return false;
+    msgpack_unpacker_buffer_consumed(&rUnpacker, size);
+
+    // Every complete message is handled now, the responses pile up and are written together:
+    msgpack_unpacked message;
+    msgpack_unpacked_init(&message);
+    while (msgpack_unpacker_next(&rUnpacker, &message))
+      HandleMessage(pClient, message.data);
+    msgpack_unpacked_destroy(&message);
+
+    if (mShutdown)
+      return true;
+  }
+}
+
+bool RpcServer::Write(Client* pClient)
+{
+  msgpack_sbuffer& rOutput(pClient->mOutput);
+  while (pClient->mWritten < rOutput.size)
+  {
+    ssize_t size = write(pClient->mSocket, rOutput.data + pClient->mWritten, rOutput.size - pClient->mWritten);
+    if (size < 0 && errno == EINTR)
+      continue;
+    if (size < 0 && errno != EAGAIN && errno != EWOULDBLOCK)
+      return false;
+    if (size >= 0)
+    {
+      pClient->mWritten += size;
+      continue;
+    }
+
+    // The client reads slowly, wait for room unless the server is stopping:
+    struct pollfd fds[2];
+    fds[0].fd = mWake[0];
+    fds[0].events = POLLIN;
+    fds[0].revents = 0;
+    fds[1].fd = pClient->mSocket;
+    fds[1].events = POLLOUT;
+    fds[1].revents = 0;
+    if (poll(fds, 2, -1) < 0 && errno != EINTR)
+      return false;
+    if (fds[0].revents)
+      return false;
+  }
+
+  pClient->mWritten = 0;
+  rOutput.size = 0;
+  return true;
+}
+
+void RpcServer::CloseClient(Client* pClient)
+{
+  auto it = std::find(mClients.begin(), mClients.end(), pClient);
+  if (it != mClients.end())
+    mClients.erase(it);
+  mClientCount = mClients.size();
+
+  pClient->mpThread->Join();
+  delete pClient->mpThread;
+  close(pClient->mSocket);
+  msgpack_unpacker_destroy(&pClient->mUnpacker);
+  msgpack_sbuffer_destroy(&pClient->mOutput);
+  msgpack_sbuffer_destroy(&pClient->mResult);
+  delete pClient;
+}
+
+void RpcServer::HandleMessage(Client* pClient, const msgpack_object& rMessage)
+{
+  msgpack_sbuffer& rOutput(pClient->mOutput);
+  if (!IsArray(rMessage, 1))
+    return;
+
+  const msgpack_object* pItems = rMessage.via.array.ptr;
+  if (pItems[0].type != MSGPACK_OBJECT_ARRAY)
+  {
+    HandleRequest(pClient, rMessage, &rOutput);
+    return;
+  }
+
+  // A batch, only the requests are answered:
+  uint32 count = 0;
+  for (uint32 i = 0; i < rMessage.via.array.size; i++)
+  {
+    int64 type;
+    if (IsArray(pItems[i], 4) && UnpackInt(pItems[i].via.array.ptr[0], type) && type == RPC_REQUEST)
+      count++;
+  }
+
+  msgpack_packer packer;
+  msgpack_packer_init(&packer, &rOutput, msgpack_sbuffer_write);
+  msgpack_pack_array(&packer, count);
+  for (uint32 i = 0; i < rMessage.via.array.size; i++)
+  {
+    int64 type;
+    if (IsArray(pItems[i], 3) && UnpackInt(pItems[i].via.array.ptr[0], type))
+      HandleRequest(pClient, pItems[i], type == RPC_REQUEST ? &rOutput : NULL);
+  }
+}
+
+void RpcServer::HandleRequest(Client* pClient, const msgpack_object& rRequest, msgpack_sbuffer* pOutput)
+{
+  int64 type;
+  if (!IsArray(rRequest, 3) || !UnpackInt(rRequest.via.array.ptr[0], type))
+    return;
+
+  // [0, id, method, params] or [2, method, params]:
+  const msgpack_object* pItems = rRequest.via.array.ptr;
+  const msgpack_object* pMethod = NULL;
+  const msgpack_object* pParams = NULL;
+  if (type == RPC_REQUEST && rRequest.via.array.size >= 4)
+  {
+    pMethod = &pItems[2];
+    pParams = &pItems[3];
+  }
+  else if (type == RPC_NOTIFICATION)
+  {
+    pMethod = &pItems[1];
+    pParams = &pItems[2];
+    pOutput = NULL;
+  }
+  else
+  {
+    return;
+  }
+
+  XSPRAY_TRACE("RpcServer::HandleRequest");
+  mCalls++;
+  msgpack_sbuffer& rResult(pClient->mResult);
+  rResult.size = 0;
+  nglString error;
+  bool res = false;
+  auto it = mMethods.find(UnpackString(*pMethod));
+  if (it == mMethods.end())
+    error = "Unknown method " + UnpackString(*pMethod);
+  else if (pParams->type != MSGPACK_OBJECT_ARRAY && pParams->type != MSGPACK_OBJECT_NIL)
+    error = "The parameters must be an array";
+  else
+    res = Call(pClient, it->second, *pParams, error);
+
+  if (!pOutput)
+    return;
+
+  msgpack_packer packer;
+  msgpack_packer_init(&packer, pOutput, msgpack_sbuffer_write);
+  msgpack_pack_array(&packer, 4);
+  msgpack_pack_int(&packer, RPC_RESPONSE);
+  msgpack_pack_object(&packer, pItems[1]);
+  if (res)
+  {
+    msgpack_pack_nil(&packer);
+    if (rResult.size)
+      msgpack_sbuffer_write(pOutput, rResult.data, rResult.size);
+    else
+      msgpack_pack_nil(&packer);
+  }
+  else
+  {
+    PackString(packer, error.IsEmpty() ? nglString("Failed") : error);
+    msgpack_pack_nil(&packer);
+  }
+}
+
+bool RpcServer::Call(Client* pClient, Method method, const msgpack_object& rParams, nglString& rError)
+{
+  // Waits without touching the context's state, running it anywhere else would hold up every other call:
+  if (method == &RpcServer::ProcessWait)
+    return (this->*method)(rParams, pClient->mResultPacker, rError);
+
+#ifdef XSPRAY_HEADLESS
+  nglCriticalSectionGuard guard(mCallCS);
+  return (this->*method)(rParams, pClient->mResultPacker, rError);
+#else
+  // The contexts, their breakpoints and the views showing them belong to the main thread:
+  MainThreadCall* pCall = new MainThreadCall(this, method, rParams, pClient->mResultPacker);
+  nuiAnimation::RunOnAnimationTick(nuiMakeTask(pCall, &MainThreadCall::Run));
+  while (!pCall->mDone.Wait(RPC_CALL_WAIT) && !mShutdown)
+    ;
+
+  bool res = false;
+  {
+    nglCriticalSectionGuard guard(pCall->mCS);
+    pCall->mCancelled = true; // Too late if it ran already
+    if (pCall->mRan)
+    {
+      res = pCall->mRes;
+      rError = pCall->mError;
+    }
+    else
+    {
+      rError = "The server is stopping";
+    }
+  }
+  pCall->Release();
+  return res;
+#endif
+}
+
+DebuggerContext* RpcServer::GetTarget(const msgpack_object& rParams, nglString& rError) const
+{
+  const msgpack_object* pParam = GetParam(rParams, 0);
+  int64 index;
+  if (!pParam || !UnpackInt(*pParam, index))
+  {
+    rError = "The first parameter must be a target index";
+    return NULL;
+  }
+
+  DebuggerContext* pContext = DebuggerContext::GetContext(index);
+  if (!pContext)
+  {
+    rError.CFormat("No target %lld", index);
+    return NULL;
+  }
+  return pContext;
+}
+
+SBThread RpcServer::GetThread(DebuggerContext* pContext, const msgpack_object& rParams, nglString& rError) const
+{
+  SBProcess process = pContext->mProcess;
+  if (!process.IsValid() || !SBDebugger::StateIsStoppedState(process.GetState()))
+  {
+    rError = "The process is not stopped";
+    return SBThread();
+  }
+
+  const msgpack_object* pParam = GetParam(rParams, 1);
+  int64 id;
+  if (!pParam || !UnpackInt(*pParam, id))
+  {
+    rError = "The second parameter must be a thread id";
+    return SBThread();
+  }
+
+  SBThread thread = process.GetThreadByID(id);
+  if (!thread.IsValid())
+    rError.CFormat("No thread %lld", id);
+  return thread;
+}
+
+void RpcServer::PackValue(msgpack_packer& rPacker, SBValue value, int32 depth)
+{
+  uint32 children = value.GetNumChildren();
+  bool members = children && depth > 0;
+
+  msgpack_pack_map(&rPacker, 5 + (members ? 1 : 0));
+  PackString(rPacker, "name");
+  PackString(rPacker, value.GetName());
+  PackString(rPacker, "type");
+  PackString(rPacker, value.GetTypeName());
+  PackString(rPacker, "value");
+  PackString(rPacker, value.GetValue());
+  PackString(rPacker, "summary");
+  PackString(rPacker, value.GetSummary());
+  PackString(rPacker, "children");
+  msgpack_pack_uint32(&rPacker, children);
+
+  if (members)
+  {
+    PackString(rPacker, "members");
+    msgpack_pack_array(&rPacker, children);
+    for (uint32 i = 0; i < children; i++)
+      PackValue(rPacker, value.GetChildAtIndex(i), depth - 1);
+  }
+}
+
+bool RpcServer::Targets(const msgpack_object& rParams, msgpack_packer& rResult, nglString& rError)
+{
+  int32 count = DebuggerContext::GetContextCount();
+  msgpack_pack_array(&rResult, count);
+  for (int32 i = 0; i < count; i++)
+  {
+    DebuggerContext* pContext = DebuggerContext::GetContext(i);
+    SBProcess process = pContext->mProcess;
+    msgpack_pack_map(&rResult, 4);
+    PackString(rResult, "index");
+    msgpack_pack_int32(&rResult, i);
+    PackString(rResult, "name");
+    PackString(rResult, pContext->GetName());
+    PackString(rResult, "pid");
+    msgpack_pack_uint64(&rResult, process.IsValid() ? process.GetProcessID() : 0);
+    PackString(rResult, "state");
+    PackState(rResult, process.IsValid() ? process.GetState() : eStateInvalid);
+  }
+  return true;
+}
+
+bool RpcServer::TargetCreate(const msgpack_object& rParams, msgpack_packer& rResult, nglString& rError)
+{
+  const msgpack_object* pPath = GetParam(rParams, 0);
+  const msgpack_object* pArch = GetParam(rParams, 1);
+  if (!pPath || pPath->type != MSGPACK_OBJECT_RAW)
+  {
+    rError = "Usage: target.create <path> [arch]";
+    return false;
+  }
+
+  nglPath path(UnpackString(*pPath));
+  nglString arch(pArch ? UnpackString(*pArch) : nglString::Null);
+  DebuggerContext* pContext = new DebuggerContext();
+#ifndef XSPRAY_HEADLESS
+  // Like the targets added from the UI, so that it can be started from there too:
+  AppDescription* pApp = AppDescription::GetApp(AppDescription::AddApp(path));
+  if (!pApp || !pApp->IsValid())
+  {
+    delete pContext;
+    rError = "Unable to read the application";
+    return false;
+  }
+  pContext->mpAppDescription = pApp;
+  path = pApp->GetLocalPath();
+  if (arch.IsEmpty())
+    arch = pApp->GetArchitecture();
+#endif
+  if (!pContext->LoadTarget(path, arch))
+  {
+    delete pContext;
+    rError = "Unable to create the target";
+    return false;
+  }
+
+  mContexts.push_back(pContext);
+  TargetAdded(pContext);
+  msgpack_pack_int32(&rResult, GetContextIndex(pContext));
+  return true;
+}
+
+bool RpcServer::TargetCore(const msgpack_object& rParams, msgpack_packer& rResult, nglString& rError)
+{
+  const msgpack_object* pCore = GetParam(rParams, 0);
+  const msgpack_object* pExecutable = GetParam(rParams, 1);
+  if (!pCore || pCore->type != MSGPACK_OBJECT_RAW)
+  {
+    rError = "Usage: target.core <core> [executable]";
+    return false;
+  }
+
+  nglPath executable;
+  if (pExecutable)
+    executable = nglPath(UnpackString(*pExecutable));
+
+  DebuggerContext* pContext = new DebuggerContext();
+#ifndef XSPRAY_HEADLESS
+  if (!executable.GetPathName().IsEmpty())
+  {
+    AppDescription* pApp = AppDescription::GetApp(AppDescription::AddApp(executable));
+    if (pApp && pApp->IsValid())
+    {
+      pContext->mpAppDescription = pApp;
+      executable = pApp->GetLocalPath();
+    }
+  }
+#endif
+  if (!pContext->LoadCore(nglPath(UnpackString(*pCore)), executable))
+  {
+    delete pContext;
+    rError = "Unable to load the core file";
+    return false;
+  }
+
+  mContexts.push_back(pContext);
+  TargetAdded(pContext);
+  msgpack_pack_int32(&rResult, GetContextIndex(pContext));
+  return true;
+}
+
+bool RpcServer::BreakpointAdd(const msgpack_object& rParams, msgpack_packer& rResult, nglString& rError)
+{
+  DebuggerContext* pContext = GetTarget(rParams, rError);
+  if (!pContext)
+    return false;
+
+  const msgpack_object* pLocation = GetParam(rParams, 1);
+  if (!pLocation || pLocation->type != MSGPACK_OBJECT_RAW || !pContext->mTarget.IsValid())
+  {
+    rError = "Usage: breakpoint.add <target> <file:line|symbol>";
+    return false;
+  }
+
+  nglString location(UnpackString(*pLocation));
+  Breakpoint* pBreakpoint = NULL;
+  int32 pos = location.FindLast(':');
+  if (pos > 0 && location.Extract(pos + 1).GetCInt() > 0)
+    pBreakpoint = pContext->CreateBreakpointByLocation(nglPath(location.GetLeft(pos)), location.Extract(pos + 1).GetCInt(), 0);
+  else
+    pBreakpoint = pContext->CreateBreakpointByName(location);
+
+  if (!pBreakpoint || !pBreakpoint->IsValid())
+  {
+    rError = "Unable to create the breakpoint";
+    return false;
+  }
+
+  msgpack_pack_int32(&rResult, pBreakpoint->GetBreakpoint().GetID());
+  return true;
+}
+
+bool RpcServer::BreakpointList(const msgpack_object& rParams, msgpack_packer& rResult, nglString& rError)
+{
+  DebuggerContext* pContext = GetTarget(rParams, rError);
+  if (!pContext)
+    return false;
+
+  std::vector<Breakpoint*> breakpoints;
+  pContext->GetBreakpointsForFiles(breakpoints);
+  pContext->GetBreakpointsForSymbols(breakpoints);
+
+  msgpack_pack_array(&rResult, breakpoints.size());
+  for (int32 i = 0; i < breakpoints.size(); i++)
+  {
+    Breakpoint* pBreakpoint = breakpoints[i];
+    nglString location;
+    if (pBreakpoint->GetType() == Breakpoint::Symbolic)
+      location = pBreakpoint->GetSymbol();
+    else
+      location.CFormat("%s:%d", pBreakpoint->GetPath().GetChars(), pBreakpoint->GetLine());
+
+    msgpack_pack_map(&rResult, 4);
+    PackString(rResult, "id");
+    msgpack_pack_int32(&rResult, pBreakpoint->GetBreakpoint().GetID());
+    PackString(rResult, "type");
+    PackString(rResult, pBreakpoint->IsLogpoint() ? "logpoint" : "breakpoint");
+    PackString(rResult, "location");
+    PackString(rResult, location);
+    PackString(rResult, "resolved");
+    if (pBreakpoint->IsResolved())
+      msgpack_pack_true(&rResult);
+    else
+      msgpack_pack_false(&rResult);
+  }
+  return true;
+}
+
+bool RpcServer::BreakpointRemove(const msgpack_object& rParams, msgpack_packer& rResult, nglString& rError)
+{
+  DebuggerContext* pContext = GetTarget(rParams, rError);
+  if (!pContext)
+    return false;
+
+  const msgpack_object* pID = GetParam(rParams, 1);
+  int64 id;
+  if (!pID || !UnpackInt(*pID, id))
+  {
+    rError = "Usage: breakpoint.remove <target> <id>";
+    return false;
+  }
+
+  for (auto it = pContext->mBreakpoints.begin(); it != pContext->mBreakpoints.end(); ++it)
+  {
+    Breakpoint* pBreakpoint = *it;
+    if (pBreakpoint->GetType() != Breakpoint::Watch && pBreakpoint->GetBreakpoint().GetID() == id)
+    {
+      pContext->DeleteBreakpoint(pBreakpoint);
+      msgpack_pack_true(&rResult);
+      return true;
+    }
+  }
+
+  rError.CFormat("No breakpoint %lld", id);
+  return false;
+}
+
+bool RpcServer::ProcessLaunch(const msgpack_object& rParams, msgpack_packer& rResult, nglString& rError)
+{
+  DebuggerContext* pContext = GetTarget(rParams, rError);
+  if (!pContext)
+    return false;
+  if (!pContext->mTarget.IsValid())
+  {
+    rError = "No target";
+    return false;
+  }
+
+  std::vector<std::string> strings;
+  const msgpack_object* pArgs = GetParam(rParams, 1);
+  if (pArgs && IsArray(*pArgs, 0))
+  {
+    for (uint32 i = 0; i < pArgs->via.array.size; i++)
+      strings.push_back(UnpackString(pArgs->via.array.ptr[i]).GetStdString());
+  }
+  std::vector<const char*> argv;
+  for (int32 i = 0; i < strings.size(); i++)
+    argv.push_back(strings[i].c_str());
+  argv.push_back(NULL);
+
+  SBError error;
+  SBListener listener = pContext->mDebugger.GetListener();
+  pContext->mProcess = pContext->mTarget.Launch(listener, &argv[0], NULL, NULL, NULL, NULL, NULL, 0, false, error);
+  if (!pContext->mProcess.IsValid() || error.Fail())
+  {
+    rError = error.GetCString();
+    return false;
+  }
+
+  msgpack_pack_uint64(&rResult, pContext->mProcess.GetProcessID());
+  return true;
+}
+
+bool RpcServer::ProcessContinue(const msgpack_object& rParams, msgpack_packer& rResult, nglString& rError)
+{
+  DebuggerContext* pContext = GetTarget(rParams, rError);
+  if (!pContext)
+    return false;
+
+  SBError error = pContext->mProcess.Continue();
+  if (error.Fail())
+  {
+    rError = error.GetCString();
+    return false;
+  }
+
+  PackState(rResult, pContext->mProcess.GetState());
+  return true;
+}
+
+bool RpcServer::ProcessStop(const msgpack_object& rParams, msgpack_packer& rResult, nglString& rError)
+{
+  DebuggerContext* pContext = GetTarget(rParams, rError);
+  if (!pContext)
+    return false;
+
+  SBError error = pContext->mProcess.Stop();
+  if (error.Fail())
+  {
+    rError = error.GetCString();
+    return false;
+  }
+
+  PackState(rResult, pContext->mProcess.GetState());
+  return true;
+}
+
+bool RpcServer::ProcessKill(const msgpack_object& rParams, msgpack_packer& rResult, nglString& rError)
+{
+  DebuggerContext* pContext = GetTarget(rParams, rError);
+  if (!pContext)
+    return false;
+
+  if (pContext->mProcess.IsValid())
+  {
+    SBError error = pContext->mProcess.Kill();
+    pContext->mProcess.Clear();
+    if (error.Fail())
+    {
+      rError = error.GetCString();
+      return false;
+    }
+  }
+
+  PackState(rResult, eStateExited);
+  return true;
+}
+
+bool RpcServer::ProcessStep(const msgpack_object& rParams, msgpack_packer& rResult, nglString& rError)
+{
+  DebuggerContext* pContext = GetTarget(rParams, rError);
+  if (!pContext)
+    return false;
+
+  SBThread thread = GetThread(pContext, rParams, rError);
+  if (!thread.IsValid())
+    return false;
+
+  const msgpack_object* pKind = GetParam(rParams, 2);
+  nglString kind(pKind ? UnpackString(*pKind) : nglString::Null);
+  if (kind == "in")
+    thread.StepInto();
+  else if (kind == "over")
+    thread.StepOver();
+  else if (kind == "out")
+    thread.StepOut();
+  else
+  {
+    rError = "Usage: process.step <target> <thread> in|over|out";
+    return false;
+  }
+
+  PackState(rResult, pContext->mProcess.GetState());
+  return true;
+}
+
+bool RpcServer::ProcessWait(const msgpack_object& rParams, msgpack_packer& rResult, nglString& rError)
+{
+  DebuggerContext* pContext = GetTarget(rParams, rError);
+  if (!pContext)
+    return false;
+
+  SBProcess process = pContext->mProcess;
+  if (!process.IsValid())
+  {
+    rError = "No process";
+    return false;
+  }
+
+  double timeout = RPC_WAIT_TIMEOUT;
+  const msgpack_object* pTimeout = GetParam(rParams, 1);
+  if (pTimeout && pTimeout->type == MSGPACK_OBJECT_DOUBLE)
+    timeout = pTimeout->via.dec;
+  else if (pTimeout && pTimeout->type == MSGPACK_OBJECT_POSITIVE_INTEGER)
+    timeout = pTimeout->via.u64;
+
+  // The public state only moves when someone pulls the events: the context's thread if it has one, us otherwise.
+  StateType state = process.GetState();
+  if (!pContext->IsHandlingEvents())
+  {
+    // In slices, a shutdown doesn't have to wait for the timeout:
+    double start = nglTime();
+    while (state != eStateStopped && state != eStateExited && state != eStateCrashed && !mShutdown &&
+           nglTime() - start < timeout)
+    {
+      state = pContext->WaitForStop(MIN(RPC_WAIT_SLICE, timeout - (nglTime() - start)));
+      if (state == eStateInvalid)
+        state = process.GetState();
+    }
+  }
+  else
+  {
+    double start = nglTime();
+    while (state != eStateStopped && state != eStateExited && state != eStateCrashed && !mShutdown &&
+           nglTime() - start < timeout)
+    {
+      usleep(RPC_POLL_INTERVAL);
+      state = process.GetState();
+    }
+  }
+
+  PackState(rResult, state);
+  return true;
+}
+
+bool RpcServer::ProcessState(const msgpack_object& rParams, msgpack_packer& rResult, nglString& rError)
+{
+  DebuggerContext* pContext = GetTarget(rParams, rError);
+  if (!pContext)
+    return false;
+
+  SBProcess process = pContext->mProcess;
+  PackState(rResult, process.IsValid() ? process.GetState() : eStateInvalid);
+  return true;
+}
+
+bool RpcServer::Threads(const msgpack_object& rParams, msgpack_packer& rResult, nglString& rError)
+{
+  DebuggerContext* pContext = GetTarget(rParams, rError);
+  if (!pContext)
+    return false;
+
+  SBProcess process = pContext->mProcess;
+  if (!process.IsValid() || !SBDebugger::StateIsStoppedState(process.GetState()))
+  {
+    rError = "The process is not stopped";
+    return false;
+  }
+
+  int32 threads = process.GetNumThreads();
+  msgpack_pack_array(&rResult, threads);
+  for (int32 t = 0; t < threads; t++)
+  {
+    SBThread thread = process.GetThreadAtIndex(t);
+    char reason[256] = { 0 };
+    thread.GetStopDescription(reason, sizeof(reason));
+
+    msgpack_pack_map(&rResult, 4);
+    PackString(rResult, "id");
+    msgpack_pack_uint64(&rResult, thread.GetThreadID());
+    PackString(rResult, "name");
+    PackString(rResult, thread.GetName());
+    PackString(rResult, "reason");
+    PackString(rResult, reason);
+    PackString(rResult, "frames");
+    msgpack_pack_uint32(&rResult, thread.GetNumFrames());
+  }
+  return true;
+}
+
+bool RpcServer::Stack(const msgpack_object& rParams, msgpack_packer& rResult, nglString& rError)
+{
+  DebuggerContext* pContext = GetTarget(rParams, rError);
+  if (!pContext)
+    return false;
+
+  SBThread thread = GetThread(pContext, rParams, rError);
+  if (!thread.IsValid())
+    return false;
+
+  int64 maxframes = 0;
+  const msgpack_object* pFrames = GetParam(rParams, 2);
+  if (pFrames)
+    UnpackInt(*pFrames, maxframes);
+
+  std::vector<AddressIndex::Frame> frames;
+  pContext->mAddressIndex.Symbolicate(pContext->mProcess, thread, frames, (int32)maxframes);
+
+  msgpack_pack_array(&rResult, frames.size());
+  for (int32 i = 0; i < frames.size(); i++)
+  {
+    const AddressIndex::Frame& rFrame(frames[i]);
+    msgpack_pack_map(&rResult, 4);
+    PackString(rResult, "pc");
+    msgpack_pack_uint64(&rResult, rFrame.mPC);
+    PackString(rResult, "function");
+    PackString(rResult, rFrame.mFunction);
+    PackString(rResult, "file");
+    PackString(rResult, rFrame.mPath);
+    PackString(rResult, "line");
+    msgpack_pack_int32(&rResult, rFrame.mLine);
+  }
+  return true;
+}
+
+bool RpcServer::Variables(const msgpack_object& rParams, msgpack_packer& rResult, nglString& rError)
+{
+  DebuggerContext* pContext = GetTarget(rParams, rError);
+  if (!pContext)
+    return false;
+
+  SBThread thread = GetThread(pContext, rParams, rError);
+  if (!thread.IsValid())
+    return false;
+
+  int64 index = 0;
+  int64 depth = 1;
+  const msgpack_object* pFrame = GetParam(rParams, 2);
+  const msgpack_object* pDepth = GetParam(rParams, 3);
+  if (pFrame)
+    UnpackInt(*pFrame, index);
+  if (pDepth)
+    UnpackInt(*pDepth, depth);
+
+  SBFrame frame = thread.GetFrameAtIndex(index);
+  if (!frame.IsValid())
+  {
+    rError.CFormat("No frame %lld", index);
+    return false;
+  }
+
+  SBValueList values = frame.GetVariables(true, true, true, true);
+  msgpack_pack_array(&rResult, values.GetSize());
+  for (uint32 i = 0; i < values.GetSize(); i++)
+    PackValue(rResult, values.GetValueAtIndex(i), depth);
+  return true;
+}
+
+bool RpcServer::MemoryRead(const msgpack_object& rParams, msgpack_packer& rResult, nglString& rError)
+{
+  DebuggerContext* pContext = GetTarget(rParams, rError);
+  if (!pContext)
+    return false;
+
+  const msgpack_object* pAddress = GetParam(rParams, 1);
+  const msgpack_object* pSize = GetParam(rParams, 2);
+  int64 address;
+  int64 size;
+  if (!pAddress || !pSize || !UnpackInt(*pAddress, address) || !UnpackInt(*pSize, size) || size < 0 || size > RPC_MAX_READ)
+  {
+    rError = "Usage: memory.read <target> <address> <size>, up to 16 MB";
+    return false;
+  }
+
+  std::vector<uint8> bytes(size);
+  if (size && !CoreFile::ReadTarget(pContext->mTarget, address, &bytes[0], size))
+  {
+    SBError error;
+    size_t read = pContext->mProcess.ReadMemory(address, &bytes[0], size, error);
+    if (error.Fail() || read != size)
+    {
+      rError = error.Fail() ? nglString(error.GetCString()) : nglString("Partial read");
+      return false;
+    }
+  }
+
+  msgpack_pack_raw(&rResult, size);
+  msgpack_pack_raw_body(&rResult, size ? &bytes[0] : NULL, size);
+  return true;
+}
+
+bool RpcServer::Shutdown(const msgpack_object& rParams, msgpack_packer& rResult, nglString& rError)
+{
+  // The other connections and the accepting thread wake up and end, this one answers first:
+  mShutdown = true;
+  char c = 0;
+  write(mWake[1], &c, 1);
+  msgpack_pack_true(&rResult);
+  return true;
+}
@@ -0,0 +1,110 @@
+//
+//  RpcServer.h
+//  Xspray
+//
+
+#pragma once
+
+// msgpack-RPC in front of the debugger contexts, on a Unix domain socket. Requests are [0, id, method, [params]] and
+// are answered with [1, id, error, result], notifications [2, method, [params]] are not answered. A client can send
+// requests without waiting for the responses (they come back in order, the responses to one read are written at once)
+// and an array of requests is a batch, answered by one array of responses.
+// Each connection is served by a thread of its own, so process.wait only holds up its own client. In the application
+// the calls are run one at a time on the main thread and the targets created by the clients show in the UI like the
+// others, in the headless tools the connections take turns. Targets are the indices of the contexts of the session:
+//   targets                                        [{index, name, pid, state}]
+//   target.create <path> [arch]                    index
+//   target.core <core> [executable]                index
+//   breakpoint.add <target> <file:line|symbol>     id
+//   breakpoint.list <target>                       [{id, type, location, resolved}]
+//   breakpoint.remove <target> <id>                true
+//   process.launch <target> [args]                 pid
+//   process.continue|stop|kill <target>            state
+//   process.step <target> <thread> in|over|out     state
+//   process.wait <target> [seconds]                state, once stopped or after the timeout (30 s)
+//   process.state <target>                         state
+//   threads <target>                               [{id, name, reason, frames}]
+//   stack <target> <thread> [frames]               [{pc, function, file, line}]
+//   variables <target> <thread> <frame> [depth]    [{name, type, value, summary, children, members}]
+//   memory.read <target> <address> <size>          bytes
+//   shutdown                                       true, the server stops after answering
+class RpcServer
+{
+public:
+  RpcServer();
+  ~RpcServer();
+
+  bool Start(const nglPath& rSocket); // Replaces a stale socket at that path, the new one is only open to the user
+  void Stop();
+  bool IsRunning() const; // False once stopped or shut down by a client
+
+  int32 GetClientCount() const;
+  uint64 GetCallCount() const;
+
+  static nuiSignal1<DebuggerContext*> TargetAdded; // On the main thread, for the contexts created by target.create and target.core
+
+private:
+  typedef bool (RpcServer::*Method)(const msgpack_object& rParams, msgpack_packer& rResult, nglString& rError);
+
+  struct Client
+  {
+    void Serve();
+
+    RpcServer* mpServer;
+    int mSocket;
+    nglThreadDelegate* mpThread;
+    std::atomic<bool> mDone; // The thread is over, the client can be closed
+    msgpack_unpacker mUnpacker;
+    msgpack_sbuffer mOutput; // Responses not written yet
+    size_t mWritten; // Bytes of mOutput already written
+    msgpack_sbuffer mResult; // Result of the call being handled, reused
+    msgpack_packer mResultPacker;
+  };
+  struct MainThreadCall;
+
+  void Serve(); // Accepts the connections
+  void Accept();
+  void ServeClient(Client* pClient); // On the client's thread
+  bool Read(Client* pClient); // False once the client is gone
+  bool Write(Client* pClient);
+  void CloseClient(Client* pClient); // Joins its thread
+  void HandleMessage(Client* pClient, const msgpack_object& rMessage);
+  void HandleRequest(Client* pClient, const msgpack_object& rRequest, msgpack_sbuffer* pOutput); // NULL for a notification
+  bool Call(Client* pClient, Method method, const msgpack_object& rParams, nglString& rError);
+
+  DebuggerContext* GetTarget(const msgpack_object& rParams, nglString& rError) const; // From the first parameter
+  lldb::SBThread GetThread(DebuggerContext* pContext, const msgpack_object& rParams, nglString& rError) const; // From the second
+  void PackValue(msgpack_packer& rPacker, lldb::SBValue value, int32 depth);
+
+  bool Targets(const msgpack_object& rParams, msgpack_packer& rResult, nglString& rError);
+  bool TargetCreate(const msgpack_object& rParams, msgpack_packer& rResult, nglString& rError);
+  bool TargetCore(const msgpack_object& rParams, msgpack_packer& rResult, nglString& rError);
+  bool BreakpointAdd(const msgpack_object& rParams, msgpack_packer& rResult, nglString& rError);
+  bool BreakpointList(const msgpack_object& rParams, msgpack_packer& rResult, nglString& rError);
+  bool BreakpointRemove(const msgpack_object& rParams, msgpack_packer& rResult, nglString& rError);
+  bool ProcessLaunch(const msgpack_object& rParams, msgpack_packer& rResult, nglString& rError);
+  bool ProcessContinue(const msgpack_object& rParams, msgpack_packer& rResult, nglString& rError);
+  bool ProcessStop(const msgpack_object& rParams, msgpack_packer& rResult, nglString& rError);
+  bool ProcessKill(const msgpack_object& rParams, msgpack_packer& rResult, nglString& rError);
+  bool ProcessStep(const msgpack_object& rParams, msgpack_packer& rResult, nglString& rError);
+  bool ProcessWait(const msgpack_object& rParams, msgpack_packer& rResult, nglString& rError);
+  bool ProcessState(const msgpack_object& rParams, msgpack_packer& rResult, nglString& rError);
+  bool Threads(const msgpack_object& rParams, msgpack_packer& rResult, nglString& rError);
+  bool Stack(const msgpack_object& rParams, msgpack_packer& rResult, nglString& rError);
+  bool Variables(const msgpack_object& rParams, msgpack_packer& rResult, nglString& rError);
+  bool MemoryRead(const msgpack_object& rParams, msgpack_packer& rResult, nglString& rError);
+  bool Shutdown(const msgpack_object& rParams, msgpack_packer& rResult, nglString& rError);
+
+  std::map<nglString, Method> mMethods;
+  nglPath mSocketPath;
+  int mListener;
+  int mWake[2]; // Written by Stop to get the server out of poll
+  nglThreadDelegate* mpThread;
+  std::atomic<bool> mRunning;
+  std::atomic<bool> mShutdown;
+  std::vector<Client*> mClients; // Only changed by the accepting thread, or by Stop once it is gone
+  std::atomic<int32> mClientCount;
+  nglCriticalSection mCallCS; // The calls of the connections take turns in the headless tools
+  std::vector<DebuggerContext*> mContexts; // Created by the clients, deleted with the server unless closed before
+  std::atomic<uint64> mCalls;
+};
@@ -0,0 +1,519 @@
+//
+//  SessionLog.cpp
+//  Xspray
+//
+
+#include "Xspray.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+using namespace Xspray;
+using namespace lldb;
+
+#define SESSION_LOG_VERSION 1
+#define SESSION_REF_SIZE 1024 // Bodies from this size on are referenced by the vrefbuffer instead of being copied
+#define SESSION_MAX_CHILDREN 256
+#define SESSION_INDEX_INTERVAL 64 // Records between two entries of the reader's index
+
+// The log is a plain sequence of records:
+//   Header:   [eRecordHeader, version, executable, time]
+//   Stop:     [eRecordStop, time, process id, selected thread id, [threads], [memory]]
+//   Thread:   [id, name, stop reason, [frames]]
+//   Frame:    [pc, function, path, line, column, [variables] or nil]
+//   Variable: [name, type, value, summary, address, [children]]
+//   Memory:   [address, bytes]
+enum
+{
+  eRecordHeader,
+  eRecordStop
+};
+
+//////// SessionStop
+SessionStop::Variable::Variable()
+: mAddress(LLDB_INVALID_ADDRESS)
+{
+}
+
+SessionStop::Frame::Frame()
+: mPC(0), mLine(0), mColumn(0), mHasVariables(false)
+{
+}
+
+SessionStop::Thread::Thread()
+: mID(0)
+{
+}
+
+SessionStop::SessionStop()
+: mTime(0), mProcessID(0), mSelectedThread(0)
+{
+}
+
+SessionStop::~SessionStop()
+{
+}
+
+bool SessionStop::ReadMemory(uint64 address, uint8* pData, uint32 size) const
+{
+  for (int32 i = 0; i < mMemory.size(); i++)
+  {
+    const Memory& rMemory(mMemory[i]);
+    if (address >= rMemory.mAddress && address + size <= rMemory.mAddress + rMemory.mData.size())
+    {
+      memcpy(pData, &rMemory.mData[address - rMemory.mAddress], size);
+      return true;
+    }
+  }
+  return false;
+}
+
+static void UnpackVariable(const msgpack_object& rObject, SessionStop::Variable& rVariable)
+{
+  if (!IsArray(rObject, 6))
+    return;
+
+  const msgpack_object* pFields = rObject.via.array.ptr;
+  rVariable.mName = UnpackString(pFields[0]);
+  rVariable.mType = UnpackString(pFields[1]);
+  rVariable.mValue = UnpackString(pFields[2]);
+  rVariable.mSummary = UnpackString(pFields[3]);
+  rVariable.mAddress = UnpackUInt(pFields[4]);
+
+  if (IsArray(pFields[5], 0))
+  {
+    const msgpack_object_array& rChildren(pFields[5].via.array);
+    rVariable.mChildren.resize(rChildren.size);
+    for (uint32 i = 0; i < rChildren.size; i++)
+      UnpackVariable(rChildren.ptr[i], rVariable.mChildren[i]);
+  }
+}
+
+static void UnpackFrame(const msgpack_object& rObject, SessionStop::Frame& rFrame)
+{
+  if (!IsArray(rObject, 6))
+    return;
+
+  const msgpack_object* pFields = rObject.via.array.ptr;
+  rFrame.mPC = UnpackUInt(pFields[0]);
+  rFrame.mFunction = UnpackString(pFields[1]);
+  rFrame.mPath = UnpackString(pFields[2]);
+  rFrame.mLine = UnpackUInt(pFields[3]);
+  rFrame.mColumn = UnpackUInt(pFields[4]);
+
+  rFrame.mHasVariables = IsArray(pFields[5], 0);
+  if (rFrame.mHasVariables)
+  {
+    const msgpack_object_array& rVariables(pFields[5].via.array);
+    rFrame.mVariables.resize(rVariables.size);
+    for (uint32 i = 0; i < rVariables.size; i++)
+      UnpackVariable(rVariables.ptr[i], rFrame.mVariables[i]);
+  }
+}
+
+static void UnpackThread(const msgpack_object& rObject, SessionStop::Thread& rThread)
+{
+  if (!IsArray(rObject, 4) || !IsArray(rObject.via.array.ptr[3], 0))
+    return;
+
+  const msgpack_object* pFields = rObject.via.array.ptr;
+  rThread.mID = UnpackUInt(pFields[0]);
+  rThread.mName = UnpackString(pFields[1]);
+  rThread.mStopReason = UnpackString(pFields[2]);
+
+  const msgpack_object_array& rFrames(pFields[3].via.array);
+  rThread.mFrames.resize(rFrames.size);
+  for (uint32 i = 0; i < rFrames.size; i++)
+    UnpackFrame(rFrames.ptr[i], rThread.mFrames[i]);
+}
+
+//////// SessionRecorder
+SessionRecorder::SessionRecorder(AddressIndex& rAddressIndex)
+: mrAddressIndex(rAddressIndex), mFile(-1), mVariableDepth(2), mMemoryLimit(0), mStops(0), mBytesWritten(0)
+{
+  msgpack_vrefbuffer_init(&mBuffer, SESSION_REF_SIZE, MSGPACK_VREFBUFFER_CHUNK_SIZE);
+  msgpack_packer_init(&mPacker, &mBuffer, msgpack_vrefbuffer_write);
+}
+
+SessionRecorder::~SessionRecorder()
+{
+  Close();
+  msgpack_vrefbuffer_destroy(&mBuffer);
+}
+
+bool SessionRecorder::Open(const nglPath& rPath, const nglPath& rExecutable)
+{
+  Close();
+
+  mFile = open(rPath.GetChars(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+  if (mFile < 0)
+    return false;
+
+  mStops = 0;
+  mBytesWritten = 0;
+
+  struct stat st;
+  if (fstat(mFile, &st) || st.st_size)
+    return true;
+
+  // New log:
+  msgpack_pack_array(&mPacker, 4);
+  msgpack_pack_uint32(&mPacker, eRecordHeader);
+  msgpack_pack_uint32(&mPacker, SESSION_LOG_VERSION);
+  PackString(rExecutable.GetPathName());
+  msgpack_pack_double(&mPacker, nglTime());
+  return Flush();
+}
+
+void SessionRecorder::Close()
+{
+  if (mFile >= 0)
+    close(mFile);
+  mFile = -1;
+}
+
+bool SessionRecorder::IsOpen() const
+{
+  return mFile >= 0;
+}
+
+void SessionRecorder::SetVariableDepth(int32 depth)
+{
+  mVariableDepth = depth;
+}
+
+void SessionRecorder::SetMemoryLimit(uint32 bytes)
+{
+  mMemoryLimit = bytes;
+}
+
+int32 SessionRecorder::GetStopCount() const
+{
+  return mStops;
+}
+
+uint64 SessionRecorder::GetBytesWritten() const
+{
+  return mBytesWritten;
+}
+
+void SessionRecorder::PackString(const nglString& rString)
+{
+  std::string str(rString.GetStdString());
+  msgpack_pack_raw(&mPacker, str.size());
+  if (str.size() < SESSION_REF_SIZE)
+  {
+    msgpack_pack_raw_body(&mPacker, str.c_str(), str.size());
+    return;
+  }
+
+  // Referenced, must live until the flush:
+  mStrings.push_back(str);
+  msgpack_pack_raw_body(&mPacker, mStrings.back().c_str(), str.size());
+}
+
+bool SessionRecorder::RecordStop(SBProcess process)
+{
+  if (!IsOpen() || !process.IsValid())
+    return false;
+
+  XSPRAY_TRACE("SessionRecorder::RecordStop");
+  SBThread selected = process.GetSelectedThread();
+  uint32 threads = process.GetNumThreads();
+
+  msgpack_pack_array(&mPacker, 6);
+  msgpack_pack_uint32(&mPacker, eRecordStop);
+  msgpack_pack_double(&mPacker, nglTime());
+  msgpack_pack_uint64(&mPacker, process.GetProcessID());
+  msgpack_pack_uint64(&mPacker, selected.GetThreadID());
+
+  msgpack_pack_array(&mPacker, threads);
+  for (uint32 i = 0; i < threads; i++)
+  {
+    SBThread thread = process.GetThreadAtIndex(i);
+    PackThread(thread, thread.GetThreadID() == selected.GetThreadID());
+  }
+
+  // Gathered while packing the variables:
+  msgpack_pack_array(&mPacker, mMemory.size());
+  for (auto it = mMemory.begin(); it != mMemory.end(); ++it)
+  {
+    msgpack_pack_array(&mPacker, 2);
+    msgpack_pack_uint64(&mPacker, it->mAddress);
+    msgpack_pack_raw(&mPacker, it->mData.size());
+    msgpack_pack_raw_body(&mPacker, &it->mData[0], it->mData.size());
+  }
+
+  if (!Flush())
+    return false;
+  mStops++;
+  return true;
+}
+
+void SessionRecorder::PackThread(SBThread thread, bool selected)
+{
+  nglString reason;
+  if (thread.GetStopReason() != eStopReasonNone)
+  {
+    char description[256] = { 0 };
+    thread.GetStopDescription(description, sizeof(description));
+    reason = description[0] ? description : "stopped";
+  }
+
+  msgpack_pack_array(&mPacker, 4);
+  msgpack_pack_uint64(&mPacker, thread.GetThreadID());
+  PackString(thread.GetName() ? thread.GetName() : "");
+  PackString(reason);
+
+  // Variables are only worth their cost in the frames the user will look at first:
+  bool variables = selected || !reason.IsEmpty();
+  uint32 current = thread.GetSelectedFrame().GetFrameID();
+
+  std::vector<AddressIndex::Frame> frames;
+  mrAddressIndex.Symbolicate(thread.GetProcess(), thread, frames);
+  msgpack_pack_array(&mPacker, frames.size());
+  for (uint32 i = 0; i < frames.size(); i++)
+    PackFrame(frames[i], variables && i == current);
+}
+
+void SessionRecorder::PackFrame(const AddressIndex::Frame& rFrame, bool variables)
+{
+  msgpack_pack_array(&mPacker, 6);
+  msgpack_pack_uint64(&mPacker, rFrame.mPC);
+  PackString(rFrame.mFunction);
+  PackString(rFrame.mPath);
+  msgpack_pack_int32(&mPacker, rFrame.mLine);
+  msgpack_pack_int32(&mPacker, rFrame.mColumn);
+
+  if (!variables)
+  {
+    msgpack_pack_nil(&mPacker);
+    return;
+  }
+
+  SBFrame frame(rFrame.mFrame);
+  SBValueList values = frame.GetVariables(true, true, false, true);
+  msgpack_pack_array(&mPacker, values.GetSize());
+  for (uint32 i = 0; i < values.GetSize(); i++)
+  {
+    SBValue value = values.GetValueAtIndex(i);
+    PackValue(value, mVariableDepth);
+    AddMemory(value);
+  }
+}
+
+void SessionRecorder::PackValue(SBValue value, int32 depth)
+{
+  msgpack_pack_array(&mPacker, 6);
+  PackString(value.GetName() ? value.GetName() : "");
+  PackString(value.GetTypeName() ? value.GetTypeName() : "");
+  PackString(value.GetValue() ? value.GetValue() : "");
+  PackString(value.GetSummary() ? value.GetSummary() : "");
+  msgpack_pack_uint64(&mPacker, value.GetLoadAddress());
+
+  uint32 children = 0;
+  if (depth > 0 && value.MightHaveChildren())
+    children = MIN(value.GetNumChildren(), SESSION_MAX_CHILDREN);
+
+  msgpack_pack_array(&mPacker, children);
+  for (uint32 i = 0; i < children; i++)
+    PackValue(value.GetChildAtIndex(i), depth - 1);
+}
+
+void SessionRecorder::AddMemory(SBValue value)
+{
+  if (!mMemoryLimit)
+    return;
+
+  // The variable itself and what it points to:
+  SBValue values[2] = { value, value.GetType().IsPointerType() ? value.Dereference() : SBValue() };
+  for (int32 i = 0; i < 2; i++)
+  {
+    if (!values[i].IsValid())
+      continue;
+
+    uint32 size = MIN((uint32)values[i].GetByteSize(), mMemoryLimit);
+    SessionStop::Memory memory;
+    memory.mAddress = values[i].GetLoadAddress();
+    if (!ReadValueMemory(values[i], size, memory.mData))
+      continue;
+    mMemory.push_back(memory);
+  }
+}
+
+bool SessionRecorder::Flush()
+{
+  const struct iovec* pVec = msgpack_vrefbuffer_vec(&mBuffer);
+  size_t count = msgpack_vrefbuffer_veclen(&mBuffer);
+  std::vector<struct iovec> vec(pVec, pVec + count);
+
+  // Short writes are resumed, a failed one cuts the log back to where the record started so no partial record stays:
+  struct stat st;
+  bool res = !fstat(mFile, &st);
+  uint64 written = 0;
+  size_t index = 0;
+  while (res && index < count)
+  {
+    ssize_t bytes = writev(mFile, &vec[index], MIN(count - index, (size_t)IOV_MAX));
+    if (bytes < 0 && errno == EINTR)
+      continue;
+    if (bytes <= 0)
+    {
+      if (written && ftruncate(mFile, st.st_size))
+      {
+        // Records appended after the partial one could not be read, stop recording:
+        NGL_OUT("Unable to remove the partial record at the end of the session log\n");
+        close(mFile);
+        mFile = -1;
+      }
+      res = false;
+      break;
+    }
+
+    written += bytes;
+    while (index < count && bytes >= (ssize_t)vec[index].iov_len)
+    {
+      bytes -= vec[index].iov_len;
+      index++;
+    }
+    if (bytes > 0)
+    {
+      vec[index].iov_base = (char*)vec[index].iov_base + bytes;
+      vec[index].iov_len -= bytes;
+    }
+  }
+  if (res)
+    mBytesWritten += written;
+
+  msgpack_vrefbuffer_clear(&mBuffer);
+  mStrings.clear();
+  mMemory.clear();
+  return res;
+}
+
+//////// SessionLog
+SessionLog::SessionLog()
+: mOpen(false), mObjects(0)
+{
+}
+
+SessionLog::~SessionLog()
+{
+  Close();
+}
+
+bool SessionLog::Open(const nglPath& rPath)
+{
+  Close();
+
+  mPath = rPath;
+  if (!msgpack_mapped_reader_open(&mReader, rPath.GetChars(), SESSION_INDEX_INTERVAL))
+    return false;
+
+  mOpen = true;
+  Refresh();
+  return true;
+}
+
+void SessionLog::Close()
+{
+  if (mOpen)
+    msgpack_mapped_reader_destroy(&mReader);
+
+  mOpen = false;
+  mObjects = 0;
+  mStops.clear();
+  mExecutable = nglPath();
+}
+
+bool SessionLog::IsOpen() const
+{
+  return mOpen;
+}
+
+bool SessionLog::Refresh()
+{
+  if (!IsOpen())
+    return false;
+
+  // Loading a stop moved the reader, the scan goes on after the last record it indexed:
+  msgpack_mapped_reader_refresh(&mReader);
+  if (!msgpack_mapped_reader_seek(&mReader, mObjects))
+    return false;
+
+  // A record that is still being written fails to unpack, it is picked up by the next refresh:
+  int32 stops = mStops.size();
+  msgpack_object record;
+  while (msgpack_mapped_reader_next(&mReader, &record))
+  {
+    if (IsArray(record, 1))
+    {
+      uint64 kind = UnpackUInt(record.via.array.ptr[0]);
+      if (kind == eRecordHeader && IsArray(record, 3))
+        mExecutable = UnpackString(record.via.array.ptr[2]);
+      else if (kind == eRecordStop)
+        mStops.push_back(mObjects);
+    }
+    mObjects++;
+  }
+
+  return mStops.size() != stops;
+}
+
+const nglPath& SessionLog::GetExecutable() const
+{
+  return mExecutable;
+}
+
+int32 SessionLog::GetStopCount() const
+{
+  return mStops.size();
+}
+
+bool SessionLog::LoadStop(int32 index, SessionStop& rStop) const
+{
+  if (index < 0 || index >= mStops.size())
+    return false;
+
+  // The strings and bytes of the record are read in place, they are copied to the stop:
+  msgpack_object record;
+  bool res = msgpack_mapped_reader_seek(&mReader, mStops[index]) && msgpack_mapped_reader_next(&mReader, &record) && IsArray(record, 6);
+  if (res)
+  {
+    const msgpack_object* pFields = record.via.array.ptr;
+    rStop.mTime = pFields[1].type == MSGPACK_OBJECT_DOUBLE ? pFields[1].via.dec : 0;
+    rStop.mProcessID = UnpackUInt(pFields[2]);
+    rStop.mSelectedThread = UnpackUInt(pFields[3]);
+
+    if (IsArray(pFields[4], 0))
+    {
+      const msgpack_object_array& rThreads(pFields[4].via.array);
+      rStop.mThreads.resize(rThreads.size);
+      for (uint32 i = 0; i < rThreads.size; i++)
+        UnpackThread(rThreads.ptr[i], rStop.mThreads[i]);
+    }
+
+    if (IsArray(pFields[5], 0))
+    {
+      const msgpack_object_array& rMemory(pFields[5].via.array);
+      for (uint32 i = 0; i < rMemory.size; i++)
+      {
+        const msgpack_object& rRange(rMemory.ptr[i]);
+        if (!IsArray(rRange, 2) || rRange.via.array.ptr[1].type != MSGPACK_OBJECT_RAW)
+          continue;
+
+        const msgpack_object_raw& rBytes(rRange.via.array.ptr[1].via.raw);
+        SessionStop::Memory memory;
+        memory.mAddress = UnpackUInt(rRange.via.array.ptr[0]);
+        memory.mData.assign((const uint8*)rBytes.ptr, (const uint8*)rBytes.ptr + rBytes.size);
+        rStop.mMemory.push_back(memory);
+      }
+    }
+  }
+
+  return res;
+}
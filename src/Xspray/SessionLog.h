@@ -0,0 +1,130 @@
+//
+//  SessionLog.h
+//  Xspray
+//
+
+#pragma once
+
+// State of the process at one stop, as recorded in a session log.
+class SessionStop
+{
+public:
+  struct Variable
+  {
+    Variable();
+
+    nglString mName;
+    nglString mType;
+    nglString mValue;
+    nglString mSummary;
+    uint64 mAddress; // LLDB_INVALID_ADDRESS if the value doesn't live in memory
+    std::vector<Variable> mChildren; // Only down to the recorded depth
+  };
+
+  struct Frame
+  {
+    Frame();
+
+    uint64 mPC;
+    nglString mFunction;
+    nglString mPath; // As found in the debug info
+    int32 mLine;
+    int32 mColumn;
+    bool mHasVariables; // Variables are only recorded for the frames that stopped
+    std::vector<Variable> mVariables;
+  };
+
+  struct Thread
+  {
+    Thread();
+
+    uint64 mID;
+    nglString mName;
+    nglString mStopReason; // Empty for the threads that didn't cause the stop
+    std::vector<Frame> mFrames;
+  };
+
+  struct Memory
+  {
+    uint64 mAddress;
+    std::vector<uint8> mData;
+  };
+
+  SessionStop();
+  ~SessionStop();
+
+  bool ReadMemory(uint64 address, uint8* pData, uint32 size) const; // False unless the whole range was recorded
+
+  double mTime;
+  uint64 mProcessID;
+  uint64 mSelectedThread;
+  std::vector<Thread> mThreads;
+  std::vector<Memory> mMemory;
+};
+
+// Writes every stop of a session to an append only log. Each stop is one self contained msgpack record appended in one
+// go, so a log can be read while it grows and a crash loses at most the stop being written. Memory blobs and long strings
+// are referenced by the vrefbuffer instead of being copied.
+class SessionRecorder
+{
+public:
+  SessionRecorder(AddressIndex& rAddressIndex); // Symbolicates the frames
+  ~SessionRecorder();
+
+  bool Open(const nglPath& rPath, const nglPath& rExecutable); // Appends if the log exists
+  void Close();
+  bool IsOpen() const;
+
+  void SetVariableDepth(int32 depth); // Levels of children recorded under each variable, 2 by default
+  void SetMemoryLimit(uint32 bytes); // Per variable, 0 (the default) records no memory
+
+  bool RecordStop(lldb::SBProcess process);
+
+  int32 GetStopCount() const; // Recorded since Open
+  uint64 GetBytesWritten() const;
+
+private:
+  void PackString(const nglString& rString);
+  void PackThread(lldb::SBThread thread, bool selected);
+  void PackFrame(const AddressIndex::Frame& rFrame, bool variables);
+  void PackValue(lldb::SBValue value, int32 depth);
+  void AddMemory(lldb::SBValue value);
+  bool Flush();
+
+  AddressIndex& mrAddressIndex;
+  int mFile;
+  msgpack_vrefbuffer mBuffer;
+  msgpack_packer mPacker;
+  std::deque<std::string> mStrings; // Long strings referenced by mBuffer until the next flush
+  std::deque<SessionStop::Memory> mMemory;  // Memory ranges of the stop being packed
+  int32 mVariableDepth;
+  uint32 mMemoryLimit;
+  int32 mStops;
+  uint64 mBytesWritten;
+};
+
+// Read side of a session log. The log is mapped and indexed in one pass, Refresh picks up the stops appended since.
+// The records are read in place and the pages already scanned are released, so a log larger than the memory is fine.
+class SessionLog
+{
+public:
+  SessionLog();
+  ~SessionLog();
+
+  bool Open(const nglPath& rPath);
+  void Close();
+  bool IsOpen() const;
+  bool Refresh(); // True if new stops were found
+
+  const nglPath& GetExecutable() const;
+  int32 GetStopCount() const;
+  bool LoadStop(int32 index, SessionStop& rStop) const;
+
+private:
+  nglPath mPath;
+  nglPath mExecutable;
+  mutable msgpack_mapped_reader mReader; // Loading a stop seeks
+  bool mOpen;
+  uint64 mObjects; // Complete records read so far
+  std::vector<uint64> mStops; // Record numbers
+};
@@ -0,0 +1,168 @@
+//
+//  SourceResolver.cpp
+//  Xspray
+//
+
+#include "Xspray.h"
+
+using namespace Xspray;
+
+SourceResolver::SourceResolver(double ttl)
+: mTTL(ttl), mHits(0), mMisses(0), mStats(0)
+{
+}
+
+SourceResolver::~SourceResolver()
+{
+}
+
+void SourceResolver::AddRule(const nglString& rFrom, const nglString& rTo)
+{
+  Rule rule;
+  rule.mFrom = rFrom;
+  rule.mTo = rTo;
+
+  nglCriticalSectionGuard guard(mCS);
+  mRules.push_back(rule);
+  mEntries.clear();
+}
+
+void SourceResolver::ClearRules()
+{
+  nglCriticalSectionGuard guard(mCS);
+  mRules.clear();
+  mEntries.clear();
+}
+
+bool SourceResolver::LoadRules(const nglPath& rPath)
+{
+  nglIStream* pStream = rPath.OpenRead();
+  if (!pStream)
+    return false;
+
+  nglString line;
+  while (pStream->ReadLine(line))
+  {
+    line.Trim("\n\r");
+    line.Trim();
+    if (line.IsEmpty() || line[0] == '#')
+      continue;
+
+    int32 pos = line.Find('=');
+    if (pos <= 0)
+    {
+      NGL_OUT("Invalid source path rule: %s\n", line.GetChars());
+      continue;
+    }
+
+    nglString from(line.GetLeft(pos));
+    nglString to(line.Extract(pos + 1));
+    from.Trim();
+    to.Trim();
+    AddRule(from, to);
+  }
+
+  delete pStream;
+  return true;
+}
+
+nglPath SourceResolver::GetRulesPath()
+{
+  nglPath p(ePathUserAppSettings);
+  p += "Xspray";
+  p += "SourceMap.txt";
+  return p;
+}
+
+bool SourceResolver::Resolve(const nglPath& rPath, nglPath& rFile)
+{
+  nglString path(rPath.GetPathName());
+  double now = nglTime();
+
+  std::vector<nglPath> candidates;
+  {
+    nglCriticalSectionGuard guard(mCS);
+    auto it = mEntries.find(path);
+    if (it != mEntries.end() && now - it->second.mTime < mTTL)
+    {
+      mHits++;
+      rFile = it->second.mFile;
+      return it->second.mFound;
+    }
+    mMisses++;
+
+    for (int32 i = 0; i < mRules.size(); i++)
+    {
+      const Rule& rRule(mRules[i]);
+      if (path.CompareLeft(rRule.mFrom) == 0)
+      {
+        nglString remapped(rRule.mTo);
+        remapped.Add(path.Extract(rRule.mFrom.GetLength()));
+        candidates.push_back(nglPath(remapped));
+      }
+    }
+  }
+  candidates.push_back(rPath);
+
+  // One stat per candidate, done without holding the lock:
+  Entry entry;
+  entry.mFound = false;
+  entry.mTime = now;
+  for (int32 i = 0; i < candidates.size() && !entry.mFound; i++)
+  {
+    nglPathInfo info;
+    bool found = candidates[i].GetInfo(info) && info.Exists && info.IsLeaf;
+    if (found)
+    {
+      entry.mFile = candidates[i];
+      entry.mFound = true;
+    }
+  }
+
+  {
+    nglCriticalSectionGuard guard(mCS);
+    mStats += candidates.size();
+    mEntries[path] = entry;
+  }
+
+  rFile = entry.mFile;
+  return entry.mFound;
+}
+
+void SourceResolver::Invalidate(const nglPath& rPath)
+{
+  nglCriticalSectionGuard guard(mCS);
+  mEntries.erase(rPath.GetPathName());
+}
+
+void SourceResolver::Invalidate()
+{
+  nglCriticalSectionGuard guard(mCS);
+  mEntries.clear();
+}
+
+uint64 SourceResolver::GetHits() const
+{
+  nglCriticalSectionGuard guard(mCS);
+  return mHits;
+}
+
+uint64 SourceResolver::GetMisses() const
+{
+  nglCriticalSectionGuard guard(mCS);
+  return mMisses;
+}
+
+uint64 SourceResolver::GetStats() const
+{
+  nglCriticalSectionGuard guard(mCS);
+  return mStats;
+}
+
+void SourceResolver::ResetCounters()
+{
+  nglCriticalSectionGuard guard(mCS);
+  mHits = 0;
+  mMisses = 0;
+  mStats = 0;
+}
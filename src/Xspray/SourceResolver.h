@@ -0,0 +1,53 @@
+//
+//  SourceResolver.h
+//  Xspray
+//
+
+#pragma once
+
+// Finds the file on disk for a source path from the debug info. Paths are remapped by prefix rules (for binaries built
+// on another machine or in another folder) and the outcome is cached for a while so that stops don't stat the same
+// files over and over.
+class SourceResolver
+{
+public:
+  SourceResolver(double ttl = 5.0);
+  ~SourceResolver();
+
+  void AddRule(const nglString& rFrom, const nglString& rTo); // Paths starting with rFrom are looked for under rTo first
+  void ClearRules();
+  bool LoadRules(const nglPath& rPath); // One "from=to" rule per line, # starts a comment
+  static nglPath GetRulesPath();
+
+  bool Resolve(const nglPath& rPath, nglPath& rFile); // False if no file was found, may be called from any thread
+  void Invalidate(const nglPath& rPath);
+  void Invalidate();
+
+  // Cache counters, for the stats of whoever wants them rather than the log:
+  uint64 GetHits() const;
+  uint64 GetMisses() const;
+  uint64 GetStats() const; // Files looked up on disk
+  void ResetCounters();
+
+private:
+  struct Rule
+  {
+    nglString mFrom;
+    nglString mTo;
+  };
+
+  struct Entry
+  {
+    nglPath mFile;
+    bool mFound;
+    double mTime;
+  };
+
+  mutable nglCriticalSection mCS;
+  std::vector<Rule> mRules;
+  std::map<nglString, Entry> mEntries; // By debug info path, found or not
+  double mTTL;
+  uint64 mHits;
+  uint64 mMisses;
+  uint64 mStats;
+};
@@ -127,7 +127,7 @@ enum CXChildVisitResult SourceView::CursorVisitor(CXCursor cursor, CXCursor pare
         line--;
         column--;
         const char* f = clang_getCString(clang_getFileName(file));
-        if (f && (pView->mPath == nglPath(f)))
+        if (f && (pView->mFile == nglPath(f)))
         {
           printf("decl: %s(%d:%d / %d) %s %s\n",
                  f,
@@ -145,14 +145,16 @@ enum CXChildVisitResult SourceView::CursorVisitor(CXCursor cursor, CXCursor pare
 }
 
 
-bool SourceView::Load(const nglPath& rPath)
+bool SourceView::Load(const nglPath& rPath, const nglPath& rFile)
 {
-  nglIStream* pStream = rPath.OpenRead();
+  XSPRAY_TRACE("SourceView::Load");
+  nglIStream* pStream = rFile.OpenRead();
   if (!pStream)
     return false;
 
   int32 size = pStream->Available();
   mPath = rPath;
+  mFile = rFile;
 
   mIndex = clang_createIndex(1, 0);
   int argc = 1;
@@ -160,7 +162,10 @@ bool SourceView::Load(const nglPath& rPath)
 
   //unsigned flags = CXTranslationUnit_None;
   unsigned flags = CXTranslationUnit_SkipFunctionBodies | CXTranslationUnit_Incomplete;
-  mTranslationUnit = clang_parseTranslationUnit(mIndex, rPath.GetChars(), argv, argc, 0, 0, flags);
+  {
+    XSPRAY_TRACE("clang_parseTranslationUnit");
+    mTranslationUnit = clang_parseTranslationUnit(mIndex, rFile.GetChars(), argv, argc, 0, 0, flags);
+  }
 
   for (unsigned I = 0, N = clang_getNumDiagnostics(mTranslationUnit); I != N; ++I)
   {
@@ -176,7 +181,7 @@ bool SourceView::Load(const nglPath& rPath)
 //    unsigned end_int_data;
 //  } CXSourceRange;
 
-  CXFile f = clang_getFile (mTranslationUnit, rPath.GetChars());
+  CXFile f = clang_getFile (mTranslationUnit, rFile.GetChars());
   CXSourceLocation ls = clang_getLocationForOffset(mTranslationUnit, f, 0);
   CXSourceLocation le = clang_getLocationForOffset(mTranslationUnit, f, size);
   CXSourceRange range = clang_getRange (ls, le);
@@ -366,8 +371,14 @@ bool SourceView::Draw(nuiDrawContext* pContext)
 {
   pContext->SetClearColor(nuiColor(255, 255, 255, 255));
   pContext->Clear();
-  std::set<int32> breakpoints;
-  GetDebuggerContext().GetBreakpointsLinesForFile(mPath, breakpoints);
+  std::map<int32, bool> breakpoints; // Line -> resolved
+  {
+    std::vector<Breakpoint*> bps;
+    GetDebuggerContext().GetBreakpointsForFile(mPath, bps);
+    for (int32 i = 0; i < bps.size(); i++)
+      breakpoints[bps[i]->GetLine()] |= bps[i]->IsResolved();
+  }
+  const LineTable* pLineTable = GetDebuggerContext().GetLineTable(mPath);
 
   pContext->SetStrokeColor("grey");
   pContext->SetLineWidth(0.025f);
@@ -393,7 +404,15 @@ bool SourceView::Draw(nuiDrawContext* pContext)
 
     y = ToAbove((float)(i+1) * h);
 
-    if (breakpoints.find(i+1) != breakpoints.end())
+    if (pLineTable && pLineTable->IsExecutable(i+1))
+    {
+      // Mark the lines that can take a breakpoint:
+      pContext->SetFillColor(nuiColor(180, 180, 230));
+      pContext->DrawRect(nuiRect(x - 3, y - h, 2.0f, h), eFillShape);
+    }
+
+    auto bp = breakpoints.find(i+1);
+    if (bp != breakpoints.end())
     {
 //      pContext->SetFillColor("blue");
 //      pContext->SetStrokeColor("black");
@@ -403,7 +422,8 @@ bool SourceView::Draw(nuiDrawContext* pContext)
 
       nuiFont* pFontAwesome = nuiFont::GetFont("FontAwesome10");
       pContext->SetFont(pFontAwesome);
-      pContext->SetTextColor("blue");
+      // Breakpoints that no loaded module resolves yet are greyed out:
+      pContext->SetTextColor(bp->second ? "blue" : "grey");
       nglString str("fontawesome_chevron_sign_right");
       if (i == mLine)
         str = "fontawesome_circle_arrow_right";
@@ -438,6 +458,7 @@ bool SourceView::Clear()
   mLine = -1;
   mCol = -1;
   mPath = nglPath();
+  mFile = nglPath();
   return nuiSimpleContainer::Clear();
 }
 
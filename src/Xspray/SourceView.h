@@ -34,7 +34,7 @@ public:
   SourceView();
   virtual ~SourceView();
 
-  bool Load(const nglPath& rPath);
+  bool Load(const nglPath& rPath, const nglPath& rFile); // rPath as found in the debug info, rFile where it was found on disk
   void ShowText(int line, int col);
 
   virtual nuiRect CalcIdealSize();
@@ -53,6 +53,7 @@ public:
   nuiSignal5<const nglPath&, float, float, int32, bool> LineSelected;
 private:
   nglPath mPath;
+  nglPath mFile;
   nuiRect GetSelectionRect();
   std::vector<std::pair<nuiTextLayout*, SourceLine*> > mLines;
   int32 mLine;
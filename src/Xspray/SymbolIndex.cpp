@@ -0,0 +1,653 @@
+//
+//  SymbolIndex.cpp
+//  Xspray
+//
+
+#include "Xspray.h"
+
+using namespace Xspray;
+
+#define TRIGRAM_ALPHABET 40
+#define TRIGRAM_COUNT (TRIGRAM_ALPHABET * TRIGRAM_ALPHABET * TRIGRAM_ALPHABET)
+#define TRIGRAM_MIN_SYMBOLS 4096 // Smaller modules are scanned linearly
+
+//////// StringArena
+StringArena::StringArena()
+{
+}
+
+StringArena::~StringArena()
+{
+}
+
+char StringArena::Fold(char c)
+{
+  if (c >= 'A' && c <= 'Z')
+    return c - 'A' + 'a';
+  return c;
+}
+
+uint32 StringArena::Intern(const char* pString)
+{
+  auto it = mInterned.find(pString);
+  if (it != mInterned.end())
+    return it->second;
+
+  uint32 offset = mData.size();
+  for (const char* p = pString; *p; p++)
+  {
+    mData.push_back(*p);
+    mFolded.push_back(Fold(*p));
+  }
+  mData.push_back(0);
+  mFolded.push_back(0);
+
+  mInterned[pString] = offset;
+  return offset;
+}
+
+const char* StringArena::Get(uint32 offset) const
+{
+  NGL_ASSERT(offset < mData.size());
+  return &mData[offset];
+}
+
+const char* StringArena::GetFolded(uint32 offset) const
+{
+  NGL_ASSERT(offset < mFolded.size());
+  return &mFolded[offset];
+}
+
+uint32 StringArena::GetSize() const
+{
+  return mData.size();
+}
+
+const char* StringArena::GetData() const
+{
+  return mData.empty() ? NULL : &mData[0];
+}
+
+const char* StringArena::GetFoldedData() const
+{
+  return mFolded.empty() ? NULL : &mFolded[0];
+}
+
+void StringArena::Assign(const char* pData, const char* pFolded, uint32 size)
+{
+  mInterned.clear();
+  mData.assign(pData, pData + size);
+  mFolded.assign(pFolded, pFolded + size);
+}
+
+void StringArena::Compact()
+{
+  mInterned.clear();
+  std::vector<char>(mData).swap(mData);
+  std::vector<char>(mFolded).swap(mFolded);
+}
+
+//////// SymbolIndex::Module
+static int32 GetTrigramCode(char c)
+{
+  if (c >= 'a' && c <= 'z')
+    return c - 'a';
+  if (c >= '0' && c <= '9')
+    return 26 + c - '0';
+  if (c == '_')
+    return 36;
+  if (c == ':')
+    return 37;
+  if (c == ' ')
+    return 38;
+  return 39;
+}
+
+static int32 GetTrigram(const char* pFolded)
+{
+  return (GetTrigramCode(pFolded[0]) * TRIGRAM_ALPHABET + GetTrigramCode(pFolded[1])) * TRIGRAM_ALPHABET + GetTrigramCode(pFolded[2]);
+}
+
+static void GetTrigrams(const char* pFolded, uint32 length, std::vector<int32>& rTrigrams)
+{
+  rTrigrams.clear();
+  for (uint32 i = 0; i + 2 < length; i++)
+    rTrigrams.push_back(GetTrigram(pFolded + i));
+  std::sort(rTrigrams.begin(), rTrigrams.end());
+  rTrigrams.erase(std::unique(rTrigrams.begin(), rTrigrams.end()), rTrigrams.end());
+}
+
+class CompareFoldedNames
+{
+public:
+  CompareFoldedNames(const SymbolIndex::Module& rModule)
+  : mrModule(rModule)
+  {
+  }
+
+  bool operator()(uint32 a, uint32 b) const
+  {
+    return strcmp(GetName(a), GetName(b)) < 0;
+  }
+
+  bool operator()(uint32 a, const char* pQuery) const
+  {
+    return strcmp(GetName(a), pQuery) < 0;
+  }
+
+  const char* GetName(uint32 index) const
+  {
+    return mrModule.mNames.GetFolded(mrModule.mSymbols[index].mName);
+  }
+
+private:
+  const SymbolIndex::Module& mrModule;
+};
+
+bool Xspray::IsBrowsableSymbol(lldb::SBSymbol& rSymbol)
+{
+  switch (rSymbol.GetType())
+  {
+    case lldb::eSymbolTypeCode:
+    case lldb::eSymbolTypeAbsolute:
+    case lldb::eSymbolTypeException:
+    case lldb::eSymbolTypeVariable:
+    case lldb::eSymbolTypeObjCClass:
+    case lldb::eSymbolTypeObjCMetaClass:
+    case lldb::eSymbolTypeObjCIVar:
+      break;
+    case lldb::eSymbolTypeTrampoline:
+    case lldb::eSymbolTypeData:
+    case lldb::eSymbolTypeVariableType:
+    case lldb::eSymbolTypeLocal:
+    case lldb::eSymbolTypeAdditional: // When symbols take more than one entry: the extra entries get this type
+    case lldb::eSymbolTypeParam:
+    case lldb::eSymbolTypeRuntime:
+    case lldb::eSymbolTypeResolver:
+    case lldb::eSymbolTypeCompiler:
+    case lldb::eSymbolTypeInstrumentation:
+    case lldb::eSymbolTypeUndefined:
+    case lldb::eSymbolTypeInvalid:
+    case lldb::eSymbolTypeSourceFile:
+    case lldb::eSymbolTypeHeaderFile:
+    case lldb::eSymbolTypeObjectFile:
+    case lldb::eSymbolTypeCommonBlock:
+    case lldb::eSymbolTypeBlock:
+    case lldb::eSymbolTypeLineEntry:
+    case lldb::eSymbolTypeLineHeader:
+    case lldb::eSymbolTypeScopeBegin:
+    case lldb::eSymbolTypeScopeEnd:
+      return false;
+  };
+
+  if (rSymbol.IsSynthetic())
+    return false;
+
+  return true;
+}
+
+SymbolIndex::Module::Module(lldb::SBModule module)
+: mModule(module), mId(0)
+{
+}
+
+void SymbolIndex::Module::Build()
+{
+  uint32_t count = mModule.GetNumSymbols();
+  for (uint32_t i = 0; i < count; i++)
+  {
+    lldb::SBSymbol symbol = mModule.GetSymbolAtIndex(i);
+    if (!IsBrowsableSymbol(symbol))
+      continue;
+
+    const char* name = symbol.GetName();
+    if (!name || !*name)
+      continue;
+
+    lldb::addr_t start = symbol.GetStartAddress().GetFileAddress();
+    lldb::addr_t end = symbol.GetEndAddress().GetFileAddress();
+    uint32 size = 0;
+    if (start != LLDB_INVALID_ADDRESS && end != LLDB_INVALID_ADDRESS && end > start && end - start <= 0xffffffffULL)
+      size = end - start;
+    AddSymbol(name, start, size, symbol.GetType());
+  }
+  Finalize();
+}
+
+template <class T>
+static void AssignSection(std::vector<T>& rVector, const T* pData, uint32 count)
+{
+  if (pData)
+    rVector.assign(pData, pData + count);
+  else
+    rVector.clear();
+}
+
+bool SymbolIndex::Module::Load(const ModuleCache& rCache)
+{
+  // The cache holds the exact arrays Finalize produced so this is a handful of block copies:
+  uint32 symbols, masks, sorted, offsets, postings, size, foldedsize;
+  const Symbol* pSymbols = rCache.GetSymbols(symbols);
+  const uint64* pMasks = rCache.GetMasks(masks);
+  const uint32* pSorted = rCache.GetSorted(sorted);
+  const uint32* pOffsets = rCache.GetTrigramOffsets(offsets);
+  const uint32* pPostings = rCache.GetTrigramSymbols(postings);
+  const char* pNames = rCache.GetNames(size);
+  const char* pFolded = rCache.GetFoldedNames(foldedsize);
+
+  if (masks != symbols || sorted != symbols || size != foldedsize || (offsets && offsets != TRIGRAM_COUNT + 1))
+    return false;
+
+  AssignSection(mSymbols, pSymbols, symbols);
+  AssignSection(mMasks, pMasks, masks);
+  AssignSection(mSorted, pSorted, sorted);
+  AssignSection(mTrigramOffsets, pOffsets, offsets);
+  AssignSection(mTrigramSymbols, pPostings, postings);
+  if (size)
+    mNames.Assign(pNames, pFolded, size);
+  return true;
+}
+
+void SymbolIndex::Module::AddSymbol(const char* pName, lldb::addr_t address, uint32 size, uint32 type)
+{
+  Symbol symbol;
+  symbol.mName = mNames.Intern(pName);
+  symbol.mLength = strlen(pName);
+  symbol.mAddress = address;
+  symbol.mType = type;
+  symbol.mSize = size;
+  mSymbols.push_back(symbol);
+  mMasks.push_back(SymbolIndex::GetMask(mNames.GetFolded(symbol.mName)));
+}
+
+void SymbolIndex::Module::Finalize()
+{
+  mNames.Compact();
+
+  uint32 count = mSymbols.size();
+  mSorted.resize(count);
+  for (uint32 i = 0; i < count; i++)
+    mSorted[i] = i;
+  std::sort(mSorted.begin(), mSorted.end(), CompareFoldedNames(*this));
+
+  mTrigramOffsets.clear();
+  mTrigramSymbols.clear();
+  if (count < TRIGRAM_MIN_SYMBOLS)
+    return;
+
+  // Two passes: count the postings of each trigram, then fill them in place.
+  std::vector<int32> trigrams;
+  mTrigramOffsets.resize(TRIGRAM_COUNT + 1, 0);
+  for (uint32 i = 0; i < count; i++)
+  {
+    const Symbol& rSymbol(mSymbols[i]);
+    GetTrigrams(mNames.GetFolded(rSymbol.mName), rSymbol.mLength, trigrams);
+    for (uint32 j = 0; j < trigrams.size(); j++)
+      mTrigramOffsets[trigrams[j] + 1]++;
+  }
+
+  for (uint32 i = 0; i < TRIGRAM_COUNT; i++)
+    mTrigramOffsets[i + 1] += mTrigramOffsets[i];
+
+  std::vector<uint32> fill(mTrigramOffsets.begin(), mTrigramOffsets.end() - 1);
+  mTrigramSymbols.resize(mTrigramOffsets.back());
+  for (uint32 i = 0; i < count; i++)
+  {
+    const Symbol& rSymbol(mSymbols[i]);
+    GetTrigrams(mNames.GetFolded(rSymbol.mName), rSymbol.mLength, trigrams);
+    for (uint32 j = 0; j < trigrams.size(); j++)
+      mTrigramSymbols[fill[trigrams[j]]++] = i;
+  }
+}
+
+//////// SymbolIndex
+static bool CompareMatches(const SymbolIndex::Match& rA, const SymbolIndex::Match& rB)
+{
+  return rA.mScore > rB.mScore;
+}
+
+static void FoldQuery(const nglString& rQuery, std::string& rFolded)
+{
+  rFolded.clear();
+  for (const char* p = rQuery.GetChars(); *p; p++)
+    rFolded.push_back(StringArena::Fold(*p));
+}
+
+static void KeepBest(std::vector<SymbolIndex::Match>& rMatches, int32 max)
+{
+  if (rMatches.size() <= max)
+  {
+    std::sort(rMatches.begin(), rMatches.end(), CompareMatches);
+    return;
+  }
+  std::partial_sort(rMatches.begin(), rMatches.begin() + max, rMatches.end(), CompareMatches);
+  rMatches.resize(max);
+}
+
+SymbolIndex::SymbolIndex()
+: mNextId(0)
+{
+}
+
+SymbolIndex::~SymbolIndex()
+{
+  Clear();
+}
+
+uint64 SymbolIndex::GetMask(const char* pFolded)
+{
+  uint64 mask = 0;
+  for (const char* p = pFolded; *p; p++)
+    mask |= 1ULL << GetTrigramCode(*p);
+  return mask;
+}
+
+int32 SymbolIndex::GetFuzzyScore(const char* pFolded, const char* pName, const char* pQuery)
+{
+  // Greedy subsequence match, rewarding runs of consecutive characters and matches on word starts.
+  int32 score = 0;
+  int32 consecutive = 0;
+  int32 last = -1;
+  const char* q = pQuery;
+  int32 i = 0;
+  for (; pFolded[i] && *q; i++)
+  {
+    if (pFolded[i] != *q)
+    {
+      consecutive = 0;
+      continue;
+    }
+
+    int32 bonus = 1;
+    char previous = i ? pName[i - 1] : 0;
+    if (!i || previous == ':' || previous == '_' || previous == ' ' || previous == '(' || (islower((unsigned char)previous) && isupper((unsigned char)pName[i])))
+      bonus += 8;
+    if (last >= 0)
+    {
+      if (last == i - 1)
+        bonus += 4 * ++consecutive;
+      else
+        score -= MIN(i - last - 1, 8);
+    }
+
+    score += bonus;
+    last = i;
+    q++;
+  }
+
+  if (*q)
+    return 0;
+
+  while (pFolded[i])
+    i++;
+  return MAX(1, score - i / 8);
+}
+
+void SymbolIndex::AddModule(Module* pModule)
+{
+  {
+    nglCriticalSectionGuard guard(mCS);
+    pModule->mId = mNextId++;
+    mModules.push_back(pModule);
+  }
+
+  nuiAnimation::RunOnAnimationTick(nuiMakeTask(&Changed, &nuiSignal0<>::operator()));
+}
+
+bool SymbolIndex::RemoveModule(lldb::SBModule module)
+{
+  nglCriticalSectionGuard guard(mCS);
+  for (int32 i = 0; i < mModules.size(); i++)
+  {
+    if (mModules[i]->mModule == module)
+    {
+      delete mModules[i];
+      mModules.erase(mModules.begin() + i);
+      return true;
+    }
+  }
+  return false;
+}
+
+void SymbolIndex::Clear()
+{
+  nglCriticalSectionGuard guard(mCS);
+  for (int32 i = 0; i < mModules.size(); i++)
+    delete mModules[i];
+  mModules.clear();
+}
+
+int32 SymbolIndex::GetModuleCount() const
+{
+  nglCriticalSectionGuard guard(mCS);
+  return mModules.size();
+}
+
+int32 SymbolIndex::GetSymbolCount() const
+{
+  nglCriticalSectionGuard guard(mCS);
+  int32 count = 0;
+  for (int32 i = 0; i < mModules.size(); i++)
+    count += mModules[i]->mSymbols.size();
+  return count;
+}
+
+void SymbolIndex::FindPrefix(const nglString& rQuery, std::vector<Match>& rMatches, int32 max) const
+{
+  std::string query;
+  FoldQuery(rQuery, query);
+  if (query.empty())
+    return;
+
+  nglCriticalSectionGuard guard(mCS);
+  for (int32 m = 0; m < mModules.size(); m++)
+  {
+    const Module& rModule(*mModules[m]);
+    CompareFoldedNames compare(rModule);
+    auto it = std::lower_bound(rModule.mSorted.begin(), rModule.mSorted.end(), query.c_str(), compare);
+
+    // The shortest names score best and they are not the first ones alphabetically, score every name with the prefix:
+    for (; it != rModule.mSorted.end(); ++it)
+    {
+      const Symbol& rSymbol(rModule.mSymbols[*it]);
+      if (strncmp(rModule.mNames.GetFolded(rSymbol.mName), query.c_str(), query.size()))
+        break;
+
+      Match match;
+      match.mModule = rModule.mId;
+      match.mSymbol = *it;
+      match.mScore = 3000 - MIN(rSymbol.mLength, 999);
+      rMatches.push_back(match);
+
+      if (rMatches.size() >= max * 16)
+        KeepBest(rMatches, max);
+    }
+  }
+
+  KeepBest(rMatches, max);
+}
+
+void SymbolIndex::FindSubstring(const nglString& rQuery, std::vector<Match>& rMatches, int32 max) const
+{
+  std::string query;
+  FoldQuery(rQuery, query);
+  if (query.empty())
+    return;
+
+  std::vector<int32> trigrams;
+  GetTrigrams(query.c_str(), query.size(), trigrams);
+
+  nglCriticalSectionGuard guard(mCS);
+  for (int32 m = 0; m < mModules.size(); m++)
+  {
+    const Module& rModule(*mModules[m]);
+    const uint32* pCandidates = NULL;
+    uint32 candidates = rModule.mSymbols.size();
+
+    if (!trigrams.empty() && !rModule.mTrigramOffsets.empty())
+    {
+      // Only verify the symbols that contain the rarest trigram of the query:
+      for (uint32 i = 0; i < trigrams.size(); i++)
+      {
+        uint32 begin = rModule.mTrigramOffsets[trigrams[i]];
+        uint32 count = rModule.mTrigramOffsets[trigrams[i] + 1] - begin;
+        if (!count)
+        {
+          // No symbol of the module has this trigram, none can contain the query:
+          candidates = 0;
+          break;
+        }
+
+        if (!pCandidates || count < candidates)
+        {
+          pCandidates = &rModule.mTrigramSymbols[begin];
+          candidates = count;
+        }
+      }
+    }
+
+    for (uint32 i = 0; i < candidates; i++)
+    {
+      uint32 index = pCandidates ? pCandidates[i] : i;
+      const Symbol& rSymbol(rModule.mSymbols[index]);
+      const char* pFolded = rModule.mNames.GetFolded(rSymbol.mName);
+      const char* pFound = strstr(pFolded, query.c_str());
+      if (!pFound)
+        continue;
+
+      Match match;
+      match.mModule = rModule.mId;
+      match.mSymbol = index;
+      match.mScore = 2000 - MIN((int32)(pFound - pFolded) + (int32)rSymbol.mLength / 4, 999);
+      rMatches.push_back(match);
+
+      if (rMatches.size() >= max * 16)
+        KeepBest(rMatches, max);
+    }
+  }
+
+  KeepBest(rMatches, max);
+}
+
+void SymbolIndex::FindFuzzy(const nglString& rQuery, std::vector<Match>& rMatches, int32 max) const
+{
+  std::string query;
+  FoldQuery(rQuery, query);
+  if (query.empty())
+    return;
+
+  uint64 mask = GetMask(query.c_str());
+
+  nglCriticalSectionGuard guard(mCS);
+  for (int32 m = 0; m < mModules.size(); m++)
+  {
+    const Module& rModule(*mModules[m]);
+    uint32 count = rModule.mSymbols.size();
+    const uint64* pMasks = count ? &rModule.mMasks[0] : NULL;
+    for (uint32 i = 0; i < count; i++)
+    {
+      if ((pMasks[i] & mask) != mask)
+        continue;
+
+      const Symbol& rSymbol(rModule.mSymbols[i]);
+      if (rSymbol.mLength < query.size())
+        continue;
+
+      int32 score = GetFuzzyScore(rModule.mNames.GetFolded(rSymbol.mName), rModule.mNames.Get(rSymbol.mName), query.c_str());
+      if (!score)
+        continue;
+
+      Match match;
+      match.mModule = rModule.mId;
+      match.mSymbol = i;
+      match.mScore = MIN(score, 999);
+      rMatches.push_back(match);
+
+      if (rMatches.size() >= max * 16)
+        KeepBest(rMatches, max);
+    }
+  }
+
+  KeepBest(rMatches, max);
+}
+
+void SymbolIndex::AddMatches(const std::vector<Match>& rSource, std::vector<Match>& rMatches, std::set<uint64>& rSeen, int32 max) const
+{
+  for (uint32 i = 0; i < rSource.size() && rMatches.size() < max; i++)
+  {
+    uint64 key = ((uint64)rSource[i].mModule << 32) | rSource[i].mSymbol;
+    if (rSeen.insert(key).second)
+      rMatches.push_back(rSource[i]);
+  }
+}
+
+void SymbolIndex::Search(const nglString& rQuery, std::vector<Match>& rMatches, int32 max) const
+{
+  std::set<uint64> seen;
+  std::vector<Match> matches;
+
+  FindPrefix(rQuery, matches, max);
+  AddMatches(matches, rMatches, seen, max);
+
+  if (rMatches.size() < max)
+  {
+    matches.clear();
+    FindSubstring(rQuery, matches, max);
+    AddMatches(matches, rMatches, seen, max);
+  }
+
+  if (rMatches.size() < max)
+  {
+    matches.clear();
+    FindFuzzy(rQuery, matches, max);
+    AddMatches(matches, rMatches, seen, max);
+  }
+}
+
+const SymbolIndex::Module* SymbolIndex::FindModule(uint32 id) const
+{
+  for (int32 i = 0; i < mModules.size(); i++)
+  {
+    if (mModules[i]->mId == id)
+      return mModules[i];
+  }
+  return NULL;
+}
+
+bool SymbolIndex::GetSymbol(const Match& rMatch, Symbol& rSymbol) const
+{
+  nglCriticalSectionGuard guard(mCS);
+  const Module* pModule = FindModule(rMatch.mModule);
+  if (!pModule)
+    return false;
+  rSymbol = pModule->mSymbols[rMatch.mSymbol];
+  return true;
+}
+
+nglString SymbolIndex::GetName(const Match& rMatch) const
+{
+  // Copied under the lock, the module may be removed as soon as it is released:
+  nglCriticalSectionGuard guard(mCS);
+  const Module* pModule = FindModule(rMatch.mModule);
+  if (!pModule)
+    return nglString::Null;
+  return nglString(pModule->mNames.Get(pModule->mSymbols[rMatch.mSymbol].mName));
+}
+
+lldb::SBModule SymbolIndex::GetModule(const Match& rMatch) const
+{
+  nglCriticalSectionGuard guard(mCS);
+  const Module* pModule = FindModule(rMatch.mModule);
+  if (!pModule)
+    return lldb::SBModule();
+  return pModule->mModule;
+}
+
+lldb::SBAddress SymbolIndex::GetAddress(const Match& rMatch) const
+{
+  nglCriticalSectionGuard guard(mCS);
+  const Module* pModule = FindModule(rMatch.mModule);
+  if (!pModule)
+    return lldb::SBAddress();
+  return const_cast<lldb::SBModule&>(pModule->mModule).ResolveFileAddress(pModule->mSymbols[rMatch.mSymbol].mAddress);
+}
@@ -0,0 +1,111 @@
+//
+//  SymbolIndex.h
+//  Xspray
+//
+
+#pragma once
+
+class ModuleCache;
+
+// Append only storage for NUL terminated strings. Each string is stored twice at the same offset: as is and case folded.
+class StringArena
+{
+public:
+  StringArena();
+  ~StringArena();
+
+  uint32 Intern(const char* pString);
+  const char* Get(uint32 offset) const;
+  const char* GetFolded(uint32 offset) const;
+  uint32 GetSize() const;
+  const char* GetData() const;
+  const char* GetFoldedData() const;
+
+  void Assign(const char* pData, const char* pFolded, uint32 size); // Replace the contents with already interned strings
+  void Compact(); // Forget the interning table once no more strings will be added
+
+  static char Fold(char c);
+
+private:
+  std::vector<char> mData;
+  std::vector<char> mFolded;
+  std::map<std::string, uint32> mInterned;
+};
+
+// Global symbol search index. Each module is indexed by its own task on a ThreadPool and becomes searchable as soon as it is done.
+class SymbolIndex
+{
+public:
+  struct Symbol
+  {
+    uint32 mName;          // Offset in the module's arena
+    uint32 mLength;
+    lldb::addr_t mAddress; // File address
+    uint32 mType;          // lldb::SymbolType
+    uint32 mSize;          // Bytes covered by the symbol, 0 if LLDB does not know its end
+  };
+
+  struct Match
+  {
+    uint32 mModule; // Id of the module, a removed module's id is never reused
+    uint32 mSymbol;
+    int32 mScore;
+  };
+
+  class Module
+  {
+  public:
+    Module(lldb::SBModule module);
+
+    void Build(); // Enumerate the symbols of the module through LLDB
+    bool Load(const ModuleCache& rCache); // Copy the tables of a mapped cache instead
+
+    void AddSymbol(const char* pName, lldb::addr_t address, uint32 size, uint32 type);
+    void Finalize();
+
+    lldb::SBModule mModule;
+    uint32 mId;                          // Given by AddModule
+    StringArena mNames;
+    std::vector<Symbol> mSymbols;
+    std::vector<uint64> mMasks;          // Characters present in each name, packed apart so fuzzy searches can reject candidates quickly
+    std::vector<uint32> mSorted;         // Symbols ordered by folded name, for prefix searches
+    std::vector<uint32> mTrigramOffsets; // CSR index of folded trigrams -> symbols, for substring searches
+    std::vector<uint32> mTrigramSymbols;
+  };
+
+  SymbolIndex();
+  ~SymbolIndex();
+
+  void AddModule(Module* pModule); // Make an indexed module searchable, may be called from any thread
+  bool RemoveModule(lldb::SBModule module); // The matches found so far become invalid, the caller fires Changed
+  void Clear();
+
+  int32 GetModuleCount() const;
+  int32 GetSymbolCount() const;
+
+  void FindPrefix(const nglString& rQuery, std::vector<Match>& rMatches, int32 max) const;
+  void FindSubstring(const nglString& rQuery, std::vector<Match>& rMatches, int32 max) const;
+  void FindFuzzy(const nglString& rQuery, std::vector<Match>& rMatches, int32 max) const;
+  void Search(const nglString& rQuery, std::vector<Match>& rMatches, int32 max) const; // Prefix, then substring, then fuzzy matches
+
+  // The module of a match may have been removed since the search, these then fail or return empty values:
+  bool GetSymbol(const Match& rMatch, Symbol& rSymbol) const;
+  nglString GetName(const Match& rMatch) const;
+  lldb::SBModule GetModule(const Match& rMatch) const;
+  lldb::SBAddress GetAddress(const Match& rMatch) const;
+
+  nuiSignal0<> Changed; // Fired on the main thread each time a module becomes searchable
+
+  static uint64 GetMask(const char* pFolded);
+  static int32 GetFuzzyScore(const char* pFolded, const char* pName, const char* pQuery);
+
+private:
+  void AddMatches(const std::vector<Match>& rSource, std::vector<Match>& rMatches, std::set<uint64>& rSeen, int32 max) const;
+  const Module* FindModule(uint32 id) const; // With mCS held
+
+  mutable nglCriticalSection mCS;
+  std::vector<Module*> mModules;
+  uint32 mNextId;
+};
+
+bool IsBrowsableSymbol(lldb::SBSymbol& rSymbol); // Code and data symbols a user may look for, shared with SymbolTree
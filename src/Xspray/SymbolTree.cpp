@@ -10,182 +10,108 @@
 
 using namespace Xspray;
 
-SymbolTree::SymbolTree(const lldb::SBTarget& rTarget)
-: nuiTreeNode(NULL, false, false, true, false), mTarget(rTarget), mType(eTarget)
+SymbolTree::SymbolTree(DebuggerContext& rContext)
+: mrContext(rContext), mTarget(rContext.mTarget)
 {
-  //SetTrace(true);
+  lldb::SBFileSpec f = mTarget.GetExecutable();
+  Row row;
+  row.mKind = eTarget;
+  row.mExpandable = true;
+  row.mText.CFormat("Target %s", f.GetFilename());
+  AddRoot(row);
 }
 
-SymbolTree::SymbolTree(const lldb::SBModule& rModule)
-: nuiTreeNode(NULL, false, false, true, false), mModule(rModule), mType(eModule)
+SymbolTree::~SymbolTree()
 {
-  lldb::SBFileSpec f = mModule.GetFileSpec();
-  nglString str(f.GetFilename());
-  NGL_OUT("module: %s\n", str.GetChars());
-  nglPath p(f.GetDirectory());
-  p += nglString(f.GetFilename());
-  nuiLabel* pLabel = new nuiLabel(str);
-  pLabel->SetToolTip(p.GetChars());
-  SetElement(pLabel);
+
 }
 
-SymbolTree::SymbolTree(const lldb::SBSymbol& rSymbol)
-: nuiTreeNode(NULL, false, false, false, false), mSymbol(rSymbol), mType(eSymbol)
+const lldb::SBTarget& SymbolTree::GetTarget() const
 {
-  Update();
+  return mTarget;
 }
 
-SymbolTree::~SymbolTree()
+SymbolTree::Type SymbolTree::GetType(const Row& rRow) const
 {
-
+  return (Type)rRow.mKind;
 }
 
-bool SymbolTree::IsEmpty() const
+lldb::SBModule SymbolTree::GetModule(const Row& rRow) const
 {
-  if (mType == eSymbol)
-    return true;
-
-  return false;
+  if (rRow.mKind == eTarget)
+    return lldb::SBModule();
+  return mrContext.GetModuleAtSlot(rRow.mData >> 32);
 }
 
-void SymbolTree::Open(bool Opened)
+void SymbolTree::AddModules(const std::vector<uint32>& rSlots)
 {
-  if (Opened && !mOpened)
-  {
-    Update();
-  }
-  else
+  std::vector<Row> rows;
+  for (uint32 i = 0; i < rSlots.size(); i++)
   {
-    Clear();
+    Row row;
+    if (GetModuleRow(rSlots[i], row))
+      rows.push_back(row);
   }
-  nuiTreeNode::Open(Opened);
+  AddChildren(0, rows);
 }
 
-const lldb::SBTarget& SymbolTree::GetTarget() const
+void SymbolTree::RemoveModules(const std::vector<uint32>& rSlots)
 {
-  return mTarget;
+  std::set<uint32> slots(rSlots.begin(), rSlots.end());
+  for (int32 i = GetRowCount() - 1; i > 0; i--)
+  {
+    const Row& rRow(GetRow(i));
+    if (rRow.mKind == eModule && slots.find(rRow.mData >> 32) != slots.end())
+      RemoveRow(i);
+  }
 }
 
-const lldb::SBModule& SymbolTree::GetModule() const
+lldb::SBSymbol SymbolTree::GetSymbol(const Row& rRow) const
 {
-  return mModule;
+  if (rRow.mKind != eSymbol)
+    return lldb::SBSymbol();
+  return GetModule(rRow).GetSymbolAtIndex(rRow.mData & 0xffffffff);
 }
 
-void SymbolTree::Update()
+void SymbolTree::Enumerate(const Row& rParent, Enumerator& rEnumerator)
 {
-  switch (mType)
+  switch (rParent.mKind)
   {
     case eTarget:
-      UpdateTarget();
+      EnumerateModules(rEnumerator);
       break;
     case eModule:
-      UpdateModule();
-      break;
-    case eSymbol:
-      UpdateSymbol();
+      EnumerateSymbols(rParent.mData >> 32, rEnumerator);
       break;
     default:
       NGL_ASSERT(0);
   }
 }
 
-void SymbolTree::UpdateTarget()
+void SymbolTree::EnumerateModules(Enumerator& rEnumerator)
 {
-  lldb::SBFileSpec f = mTarget.GetExecutable();
-  nglString str;
-  str.CFormat("Target %s", f.GetFilename());
-  //  NGL_OUT("%s\n", str.GetChars());
-  nglPath p(f.GetDirectory());
-  p += nglString(f.GetFilename());
-  nuiLabel* pLabel = new nuiLabel(str);
-  pLabel->SetToolTip(p.GetChars());
-  SetElement(pLabel);
-
-  int modules = mTarget.GetNumModules();
-  for (int i = 0; i < modules; i++)
+  uint32 slots = mrContext.GetModuleSlotCount();
+  for (uint32 i = 0; i < slots; i++)
   {
-    SymbolTree* pPT = new SymbolTree(mTarget.GetModuleAtIndex(i));
-    AddChild(pPT);
+    Row row;
+    if (GetModuleRow(i, row) && !rEnumerator.Add(row))
+      return;
   }
 }
 
-void SymbolTree::UpdateModule()
+bool SymbolTree::GetModuleRow(uint32 slot, Row& rRow) const
 {
-  if (0)
-  {
-    uint32_t symbols = mModule.GetNumSymbols();
-    int skipped = 0;
-    for (uint32_t i = 0; i < symbols; i++)
-    {
-      lldb::SBSymbol symbol = mModule.GetSymbolAtIndex(i);
-    }
-  }
-
-  lldb::SBTypeList types = mModule.GetTypes(lldb::eTypeClassClass);
-  for (int i = 0; i < types.GetSize(); i++)
-  {
-    lldb::SBType t = types.GetTypeAtIndex(i);
-
-    //printf("Type %d: %s\n", i, t.GetName());
-  }
-
-  uint32_t symbols = mModule.GetNumSymbols();
-  int skipped = 0;
-  for (uint32_t i = 0; i < symbols; i++)
-  {
-    lldb::SBSymbol symbol = mModule.GetSymbolAtIndex(i);
-
-    bool skip = false;
-    switch (symbol.GetType())
-    {
-      case lldb::eSymbolTypeCode:
-      case lldb::eSymbolTypeAbsolute:
-      case lldb::eSymbolTypeException:
-      case lldb::eSymbolTypeVariable:
-      case lldb::eSymbolTypeObjCClass:
-      case lldb::eSymbolTypeObjCMetaClass:
-      case lldb::eSymbolTypeObjCIVar:
-        skip = false;
-        break;
-      case lldb::eSymbolTypeTrampoline:
-      case lldb::eSymbolTypeData:
-      case lldb::eSymbolTypeVariableType:
-      case lldb::eSymbolTypeLocal:
-      case lldb::eSymbolTypeAdditional: // When symbols take more than one entry: the extra entries get this type
-      case lldb::eSymbolTypeParam:
-      case lldb::eSymbolTypeRuntime:
-      case lldb::eSymbolTypeResolver:
-      case lldb::eSymbolTypeCompiler:
-      case lldb::eSymbolTypeInstrumentation:
-      case lldb::eSymbolTypeUndefined:
-      case lldb::eSymbolTypeInvalid:
-      case lldb::eSymbolTypeSourceFile:
-      case lldb::eSymbolTypeHeaderFile:
-      case lldb::eSymbolTypeObjectFile:
-      case lldb::eSymbolTypeCommonBlock:
-      case lldb::eSymbolTypeBlock:
-      case lldb::eSymbolTypeLineEntry:
-      case lldb::eSymbolTypeLineHeader:
-      case lldb::eSymbolTypeScopeBegin:
-      case lldb::eSymbolTypeScopeEnd:
-        skip = true;
-        skipped++;
-        break;
-    };
-
-    if (mSymbol.IsSynthetic())
-    {
-      skip = true;
-      skipped++;
-    }
-
-    if (!skip)
-    {
-      SymbolTree* pPT = new SymbolTree(symbol);
-      AddChild(pPT);
-    }
-  }
-  NGL_OUT("Symbols %d (%d skipped)\n", symbols, skipped);
+  // Unloaded modules leave an empty slot behind:
+  lldb::SBModule module = mrContext.GetModuleAtSlot(slot);
+  if (!module.IsValid())
+    return false;
+
+  lldb::SBFileSpec f = module.GetFileSpec();
+  rRow.mKind = eModule;
+  rRow.mExpandable = true;
+  rRow.mData = (uint64)slot << 32;
+  rRow.mText = f.GetFilename();
+  return true;
 }
 
 const char* GetSymbolTypeName(lldb::SymbolType t)
@@ -305,27 +231,22 @@ const char* GetTypeClassName(lldb::TypeClass cls)
   }
 }
 
-void SymbolTree::UpdateSymbol()
+void SymbolTree::EnumerateSymbols(uint32 module, Enumerator& rEnumerator)
 {
-#if 0
-  lldb::TypeClass cls = mSymbol.GetTypeClass();
-
-  nglString str;
-  str.Add("(").Add(GetSymbolTypeName(mSymbol.GetType())).Add("/").Add(GetTypeClassName(cls)).Add(") - ").Add(mSymbol.GetName());
-  //NGL_OUT("  symbol: %s\n", str.GetChars());
-  nuiLabel* pLabel = new nuiLabel(str);
-  SetElement(pLabel);
-#else
-  nglString str;
-  str.Add("(").Add(GetSymbolTypeName(mSymbol.GetType())).Add(") - ").Add(mSymbol.GetName());
-  //NGL_OUT("  symbol: %s\n", str.GetChars());
-  nuiLabel* pLabel = new nuiLabel(str);
-  SetElement(pLabel);
-#endif
-}
-
-SymbolTree::Type SymbolTree::GetType() const
-{
-  return mType;
+  lldb::SBModule m = mrContext.GetModuleAtSlot(module);
+  uint32_t symbols = m.GetNumSymbols();
+  for (uint32_t i = 0; i < symbols; i++)
+  {
+    lldb::SBSymbol symbol = m.GetSymbolAtIndex(i);
+    if (!IsBrowsableSymbol(symbol))
+      continue;
+
+    Row row;
+    row.mKind = eSymbol;
+    row.mData = ((uint64)module << 32) | i;
+    row.mText.Add("(").Add(GetSymbolTypeName(symbol.GetType())).Add(") - ").Add(symbol.GetName());
+    if (!rEnumerator.Add(row))
+      return;
+  }
 }
 
@@ -8,7 +8,10 @@
 
 #pragma once
 
-class SymbolTree : public nuiTreeNode
+class DebuggerContext;
+
+// Target -> modules -> symbols. Children are enumerated in the background when a row is opened.
+class SymbolTree : public RowModel
 {
 public:
   enum Type
@@ -18,31 +21,27 @@ public:
     eSymbol
   };
 
-  SymbolTree(const lldb::SBTarget& rTarget);
-  SymbolTree(const lldb::SBModule& rModule);
-  SymbolTree(const lldb::SBSymbol& rSymbol);
-
+  SymbolTree(DebuggerContext& rContext); // The enumerations run on other threads, they use this context rather than the current one
   virtual ~SymbolTree();
 
-  virtual void Open(bool Opened);
-  bool IsEmpty() const;
+  Type GetType(const Row& rRow) const;
 
-  void Update();
-  void UpdateTarget();
-  void UpdateModule();
-  void UpdateSymbol();
+  const lldb::SBTarget& GetTarget() const;
+  lldb::SBModule GetModule(const Row& rRow) const;
 
-  Type GetType() const;
+  // Module rows are identified by their slot in the debugger context:
+  void AddModules(const std::vector<uint32>& rSlots);
+  void RemoveModules(const std::vector<uint32>& rSlots);
+  lldb::SBSymbol GetSymbol(const Row& rRow) const;
 
-  nglPath GetSourcePath() const;
+protected:
+  virtual void Enumerate(const Row& rParent, Enumerator& rEnumerator);
 
-  const lldb::SBTarget& GetTarget() const;
-  const lldb::SBModule& GetModule() const;
 private:
-  lldb::SBTarget mTarget;
-  mutable lldb::SBModule mModule;
-  lldb::SBSymbol mSymbol;
-  Type mType;
-};
-
+  void EnumerateModules(Enumerator& rEnumerator);
+  bool GetModuleRow(uint32 slot, Row& rRow) const;
+  void EnumerateSymbols(uint32 module, Enumerator& rEnumerator);
 
+  DebuggerContext& mrContext;
+  mutable lldb::SBTarget mTarget;
+};
@@ -0,0 +1,122 @@
+//
+//  ThreadPool.cpp
+//  Xspray
+//
+
+#include "Xspray.h"
+
+#include <unistd.h>
+
+using namespace Xspray;
+
+ThreadPool::ThreadPool(int32 threads)
+: mPending(0), mQuit(false)
+{
+  if (threads <= 0)
+    threads = MAX(1, (int32)sysconf(_SC_NPROCESSORS_ONLN));
+
+  for (int32 i = 0; i < threads; i++)
+  {
+    nglThreadDelegate* pThread = new nglThreadDelegate(nuiMakeDelegate(this, &ThreadPool::Worker));
+    mThreads.push_back(pThread);
+    pThread->Start();
+  }
+}
+
+ThreadPool::~ThreadPool()
+{
+  {
+    nglCriticalSectionGuard guard(mCS);
+    mQuit = true;
+    mWork.Set();
+  }
+
+  for (int32 i = 0; i < mThreads.size(); i++)
+  {
+    mThreads[i]->Join();
+    delete mThreads[i];
+  }
+
+  for (auto it = mTasks.begin(); it != mTasks.end(); ++it)
+    it->first->Release();
+}
+
+void ThreadPool::Post(nuiTask* pTask, const void* pOwner)
+{
+  nglCriticalSectionGuard guard(mCS);
+  mTasks.push_back(std::make_pair(pTask, pOwner));
+  mPending++;
+  if (pOwner)
+    mOwnerPending[pOwner]++;
+  mIdle.Reset();
+  mWork.Set();
+}
+
+void ThreadPool::Wait(const void* pOwner)
+{
+  // mIdle is also set when an owner's last task completes, the timeout covers the waiters of the other owners:
+  while (GetPendingCount(pOwner) > 0)
+    mIdle.Wait(10);
+}
+
+int32 ThreadPool::GetPendingCount(const void* pOwner) const
+{
+  nglCriticalSectionGuard guard(mCS);
+  if (!pOwner)
+    return mPending;
+
+  auto it = mOwnerPending.find(pOwner);
+  return it == mOwnerPending.end() ? 0 : it->second;
+}
+
+int32 ThreadPool::GetThreadCount() const
+{
+  return mThreads.size();
+}
+
+void ThreadPool::Worker()
+{
+  Tracer::SetThreadName("ThreadPool");
+  while (true)
+  {
+    nuiTask* pTask = NULL;
+    const void* pOwner = NULL;
+    {
+      nglCriticalSectionGuard guard(mCS);
+      if (mQuit)
+        return;
+
+      if (mTasks.empty())
+      {
+        // Re-arm the event while holding the lock so a concurrent Post can't be missed:
+        mWork.Reset();
+      }
+      else
+      {
+        pTask = mTasks.front().first;
+        pOwner = mTasks.front().second;
+        mTasks.pop_front();
+      }
+    }
+
+    if (!pTask)
+    {
+      mWork.Wait(50);
+      continue;
+    }
+
+    pTask->Run();
+    pTask->Release();
+
+    nglCriticalSectionGuard guard(mCS);
+    mPending--;
+    if (pOwner && !--mOwnerPending[pOwner])
+    {
+      mOwnerPending.erase(pOwner);
+      mIdle.Set();
+    }
+    if (!mPending)
+      mIdle.Set();
+  }
+}
+
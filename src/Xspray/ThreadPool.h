@@ -0,0 +1,33 @@
+//
+//  ThreadPool.h
+//  Xspray
+//
+
+#pragma once
+
+// Fixed set of worker threads running nuiTasks in FIFO order. Tasks are released once they have run.
+// A pool can be shared: each task may be posted on behalf of an owner, which can then wait for its own tasks only.
+class ThreadPool
+{
+public:
+  ThreadPool(int32 threads = 0); // 0 = one thread per core
+  ~ThreadPool();
+
+  void Post(nuiTask* pTask, const void* pOwner = NULL);
+  void Wait(const void* pOwner = NULL); // Block until every task posted by that owner, or every task if NULL, has completed
+  int32 GetPendingCount(const void* pOwner = NULL) const;
+  int32 GetThreadCount() const;
+
+private:
+  void Worker();
+
+  std::deque<std::pair<nuiTask*, const void*> > mTasks;
+  std::map<const void*, int32> mOwnerPending;
+  std::vector<nglThreadDelegate*> mThreads;
+  mutable nglCriticalSection mCS;
+  nglSyncEvent mWork;
+  nglSyncEvent mIdle;
+  int32 mPending;
+  bool mQuit;
+};
+
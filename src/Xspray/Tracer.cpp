@@ -0,0 +1,185 @@
+//
+//  Tracer.cpp
+//  Xspray
+//
+
+#include "Xspray.h"
+
+#include <atomic>
+
+using namespace Xspray;
+
+#define TRACER_BUFFER_SIZE (64 * 1024) // Spans per thread, the oldest ones are overwritten
+
+struct TraceEvent
+{
+  const char* mpName;
+  double mStart;
+  double mDuration;
+};
+
+struct Tracer::Buffer
+{
+  Buffer(int32 id)
+  : mID(id), mCount(0), mFree(false)
+  {
+    mEvents.resize(TRACER_BUFFER_SIZE);
+  }
+
+  int32 mID;
+  nglString mName; // Protected by gTracerCS
+  std::atomic<uint64> mCount; // Spans written since the last Clear, only the owner thread writes
+  std::vector<TraceEvent> mEvents;
+  bool mFree; // The owner thread exited, its spans are kept until another thread takes the buffer. Protected by gTracerCS
+};
+
+// Per thread state, its destructor hands the buffer back when the thread exits:
+struct TracerThread
+{
+  TracerThread()
+  : mpBuffer(NULL)
+  {
+  }
+
+  ~TracerThread();
+
+  Tracer::Buffer* mpBuffer; // NULL until the thread records its first span
+  nglString mName;
+};
+
+volatile bool Tracer::mEnabled = false;
+
+static nglCriticalSection gTracerCS; // Protects the list of buffers, never taken while recording
+static std::vector<Tracer::Buffer*> gTracerBuffers;
+static int32 gTracerLastID = 0;
+static thread_local TracerThread gTracerThread;
+static double gTracerOrigin = 0;
+
+TracerThread::~TracerThread()
+{
+  if (!mpBuffer)
+    return;
+
+  nglCriticalSectionGuard guard(gTracerCS);
+  mpBuffer->mFree = true;
+}
+
+void Tracer::Enable(bool set)
+{
+  if (set && !gTracerOrigin)
+    gTracerOrigin = GetTime();
+  mEnabled = set;
+}
+
+double Tracer::GetTime()
+{
+  return nglTime();
+}
+
+Tracer::Buffer* Tracer::GetBuffer()
+{
+  TracerThread& rThread(gTracerThread);
+  if (!rThread.mpBuffer)
+  {
+    // Once per thread, the buffer of an exited thread is taken over before a new one is allocated:
+    nglCriticalSectionGuard guard(gTracerCS);
+    for (int32 i = 0; i < gTracerBuffers.size() && !rThread.mpBuffer; i++)
+    {
+      Buffer* pBuffer = gTracerBuffers[i];
+      if (!pBuffer->mFree)
+        continue;
+
+      pBuffer->mFree = false;
+      pBuffer->mID = ++gTracerLastID;
+      pBuffer->mCount.store(0, std::memory_order_release);
+      rThread.mpBuffer = pBuffer;
+    }
+
+    if (!rThread.mpBuffer)
+    {
+      rThread.mpBuffer = new Buffer(++gTracerLastID);
+      gTracerBuffers.push_back(rThread.mpBuffer);
+    }
+    rThread.mpBuffer->mName = rThread.mName;
+  }
+  return rThread.mpBuffer;
+}
+
+void Tracer::SetThreadName(const char* pName)
+{
+  // Only remembered, the buffer is allocated if the thread records something:
+  TracerThread& rThread(gTracerThread);
+  rThread.mName = pName;
+  if (rThread.mpBuffer)
+  {
+    nglCriticalSectionGuard guard(gTracerCS);
+    rThread.mpBuffer->mName = pName;
+  }
+}
+
+void Tracer::Record(const char* pName, double start)
+{
+  double end = GetTime();
+  Buffer* pBuffer = GetBuffer();
+
+  uint64 index = pBuffer->mCount.load(std::memory_order_relaxed);
+  TraceEvent& rEvent(pBuffer->mEvents[index % TRACER_BUFFER_SIZE]);
+  rEvent.mpName = pName;
+  rEvent.mStart = start;
+  rEvent.mDuration = end - start;
+  pBuffer->mCount.store(index + 1, std::memory_order_release);
+}
+
+void Tracer::Clear()
+{
+  nglCriticalSectionGuard guard(gTracerCS);
+  int32 count = 0;
+  for (int32 i = 0; i < gTracerBuffers.size(); i++)
+  {
+    Buffer* pBuffer = gTracerBuffers[i];
+    if (pBuffer->mFree)
+    {
+      delete pBuffer;
+      continue;
+    }
+
+    pBuffer->mCount.store(0, std::memory_order_release);
+    gTracerBuffers[count++] = pBuffer;
+  }
+  gTracerBuffers.resize(count);
+}
+
+bool Tracer::Export(const nglPath& rPath)
+{
+  FILE* pFile = fopen(rPath.GetChars(), "w");
+  if (!pFile)
+    return false;
+
+  nglCriticalSectionGuard guard(gTracerCS);
+  fprintf(pFile, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+  fprintf(pFile, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"Xspray\"}}");
+
+  for (int32 i = 0; i < gTracerBuffers.size(); i++)
+  {
+    const Buffer* pBuffer = gTracerBuffers[i];
+    if (!pBuffer->mName.IsEmpty())
+    {
+      fprintf(pFile, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":%s}}",
+              pBuffer->mID, JSONQuote(pBuffer->mName).GetChars());
+    }
+
+    uint64 count = pBuffer->mCount.load(std::memory_order_acquire);
+    uint64 first = count > TRACER_BUFFER_SIZE ? count - TRACER_BUFFER_SIZE : 0;
+    for (uint64 e = first; e < count; e++)
+    {
+      const TraceEvent& rEvent(pBuffer->mEvents[e % TRACER_BUFFER_SIZE]);
+      fprintf(pFile, ",\n{\"name\":%s,\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+              JSONQuote(rEvent.mpName).GetChars(), pBuffer->mID, (rEvent.mStart - gTracerOrigin) * 1000000.0,
+              rEvent.mDuration * 1000000.0);
+    }
+  }
+
+  fprintf(pFile, "\n]}\n");
+  fclose(pFile);
+  return true;
+}
@@ -0,0 +1,62 @@
+//
+//  Tracer.h
+//  Xspray
+//
+
+#pragma once
+
+// Scoped spans recorded into one ring buffer per thread and exported in the Chrome trace format (chrome://tracing or
+// ui.perfetto.dev). A thread only ever writes to its own buffer, so recording takes no lock. While tracing is disabled a
+// span costs one flag test, and defining XSPRAY_NO_TRACE compiles them out. A thread gets its buffer with its first
+// span and leaves it to the next thread when it exits.
+class Tracer
+{
+public:
+  static void Enable(bool set);
+  static bool IsEnabled()
+  {
+    return mEnabled;
+  }
+
+  static void SetThreadName(const char* pName); // Shown for the calling thread in the trace
+  static void Clear(); // Drop the spans recorded so far and the buffers of the exited threads, best called while tracing is disabled
+  static bool Export(const nglPath& rPath); // The oldest spans of a buffer that wraps during the export may be garbled
+
+  static double GetTime(); // Seconds
+  static void Record(const char* pName, double start); // pName must outlive the tracer, string literals are expected
+
+  struct Buffer;
+
+private:
+  static Buffer* GetBuffer();
+
+  static volatile bool mEnabled;
+};
+
+class TraceSpan
+{
+public:
+  TraceSpan(const char* pName)
+  : mpName(Tracer::IsEnabled() ? pName : NULL), mStart(mpName ? Tracer::GetTime() : 0)
+  {
+  }
+
+  ~TraceSpan()
+  {
+    if (mpName)
+      Tracer::Record(mpName, mStart);
+  }
+
+private:
+  const char* mpName; // NULL if tracing was disabled when the span started
+  double mStart;
+};
+
+#define XSPRAY_TRACE_CONCAT2(A, B) A##B
+#define XSPRAY_TRACE_CONCAT(A, B) XSPRAY_TRACE_CONCAT2(A, B)
+
+#ifdef XSPRAY_NO_TRACE
+#define XSPRAY_TRACE(NAME)
+#else
+#define XSPRAY_TRACE(NAME) Xspray::TraceSpan XSPRAY_TRACE_CONCAT(__trace_span_, __LINE__)(NAME)
+#endif
@@ -0,0 +1,474 @@
+//
+//  TypeCatalog.cpp
+//  Xspray
+//
+
+#include "Xspray.h"
+
+using namespace Xspray;
+using namespace lldb;
+
+#define TYPE_LAYOUT_MAX_DEPTH 8
+
+static TypeLayout::Kind GetBasicKind(BasicType type)
+{
+  switch (type)
+  {
+    case eBasicTypeChar:
+    case eBasicTypeSignedChar:
+      return TypeLayout::eChar;
+
+    case eBasicTypeWChar:
+    case eBasicTypeSignedWChar:
+    case eBasicTypeShort:
+    case eBasicTypeInt:
+    case eBasicTypeLong:
+    case eBasicTypeLongLong:
+      return TypeLayout::eSigned;
+
+    case eBasicTypeUnsignedChar:
+    case eBasicTypeUnsignedWChar:
+    case eBasicTypeChar16:
+    case eBasicTypeChar32:
+    case eBasicTypeUnsignedShort:
+    case eBasicTypeUnsignedInt:
+    case eBasicTypeUnsignedLong:
+    case eBasicTypeUnsignedLongLong:
+      return TypeLayout::eUnsigned;
+
+    case eBasicTypeFloat:
+    case eBasicTypeDouble:
+      return TypeLayout::eFloat;
+
+    case eBasicTypeBool:
+      return TypeLayout::eBool;
+
+    default:
+      return TypeLayout::eOther;
+  }
+}
+
+//////// TypeLayout::Field
+TypeLayout::Field::Field()
+: mOffset(0), mByteSize(0), mBitOffset(0), mBitSize(0), mKind(eOther)
+{
+}
+
+//////// TypeLayout
+TypeLayout::TypeLayout(SBType type)
+: mName(type.GetName()), mByteSize(type.GetByteSize()), mDecodedFields(0), mValid(true)
+{
+  AddFields(type, 0, nglString::Null, 0);
+
+  for (int32 i = 0; i < mFields.size(); i++)
+  {
+    if (IsDecoded(mFields[i]))
+      mDecodedFields++;
+  }
+}
+
+TypeLayout::TypeLayout(const ModuleCache& rCache, const ModuleCache::Type& rType)
+: mName(rCache.GetString(rType.mName)), mByteSize(rType.mByteSize), mDecodedFields(0), mValid(true)
+{
+  const ModuleCache::TypeField* pFields = rCache.GetTypeFields(rType);
+  mFields.resize(rType.mFieldCount);
+  for (uint32 i = 0; i < rType.mFieldCount; i++)
+  {
+    const ModuleCache::TypeField& rSaved(pFields[i]);
+    Field& rField(mFields[i]);
+    rField.mName = rCache.GetString(rSaved.mName);
+    rField.mTypeName = rCache.GetString(rSaved.mTypeName);
+    rField.mOffset = rSaved.mOffset;
+    rField.mByteSize = rSaved.mByteSize;
+    rField.mBitOffset = rSaved.mBitOffset;
+    rField.mBitSize = rSaved.mBitSize;
+    rField.mKind = (Kind)rSaved.mKind;
+
+    const ModuleCache::Enumerator* pEnumerators = rCache.GetEnumerators(rSaved);
+    for (uint32 j = 0; j < rSaved.mEnumeratorCount; j++)
+      rField.mEnumerators.push_back(std::make_pair(pEnumerators[j].mValue, nglString(rCache.GetString(pEnumerators[j].mName))));
+
+    if (IsDecoded(rField))
+      mDecodedFields++;
+  }
+
+  const ModuleCache::TypeMember* pMembers = rCache.GetTypeMembers(rType);
+  mMembers.resize(rType.mMemberCount);
+  for (uint32 i = 0; i < rType.mMemberCount; i++)
+  {
+    Member& rMember(mMembers[i]);
+    rMember.mName = rCache.GetString(pMembers[i].mName);
+    rMember.mChild = pMembers[i].mChild;
+    rMember.mBase = pMembers[i].mBase != 0;
+    rMember.mField = pMembers[i].mField;
+  }
+}
+
+TypeLayout::~TypeLayout()
+{
+}
+
+TypeLayout* TypeLayout::Create(SBType type)
+{
+  TypeClass typeclass = type.GetTypeClass();
+  if ((typeclass != eTypeClassStruct && typeclass != eTypeClassClass) || !type.GetByteSize())
+    return NULL;
+
+  TypeLayout* pLayout = new TypeLayout(type);
+  if (!pLayout->IsValid() || !pLayout->GetDecodedFieldCount())
+  {
+    delete pLayout;
+    return NULL;
+  }
+  return pLayout;
+}
+
+void TypeLayout::AddFields(SBType type, uint32 offset, const nglString& rPath, int32 depth)
+{
+  // Virtual bases live at an offset that depends on the most derived class:
+  if (type.GetNumberOfVirtualBaseClasses())
+  {
+    mValid = false;
+    return;
+  }
+
+  uint32 bases = type.GetNumberOfDirectBaseClasses();
+  for (uint32 i = 0; i < bases; i++)
+  {
+    SBTypeMember base = type.GetDirectBaseClassAtIndex(i);
+    AddFields(base.GetType().GetCanonicalType(), offset + base.GetOffsetInBytes(), rPath, depth + 1);
+
+    if (!depth)
+    {
+      Member member;
+      member.mName = base.GetType().GetName();
+      member.mChild = i;
+      member.mBase = true;
+      member.mField = -1;
+      mMembers.push_back(member);
+    }
+  }
+
+  uint32 fields = type.GetNumberOfFields();
+  for (uint32 i = 0; i < fields; i++)
+  {
+    SBTypeMember field = type.GetFieldAtIndex(i);
+    int32 index = mFields.size();
+    AddField(field, offset, rPath, depth);
+
+    if (!depth)
+    {
+      // Nested structs don't produce a field of their own but the ones they contain:
+      TypeClass typeclass = field.GetType().GetCanonicalType().GetTypeClass();
+      bool nested = (typeclass == eTypeClassStruct || typeclass == eTypeClassClass) && !field.IsBitfield();
+
+      Member member;
+      member.mName = field.GetName();
+      member.mChild = bases + i;
+      member.mBase = false;
+      member.mField = nested ? -1 : index;
+      mMembers.push_back(member);
+    }
+  }
+}
+
+void TypeLayout::AddField(SBTypeMember member, uint32 offset, const nglString& rPath, int32 depth)
+{
+  SBType type = member.GetType();
+  SBType canonical = type.GetCanonicalType();
+  TypeClass typeclass = canonical.GetTypeClass();
+
+  nglString path(rPath);
+  const char* name = member.GetName();
+  if (name && name[0])
+  {
+    if (!path.IsEmpty())
+      path.Add('.');
+    path.Add(name);
+  }
+
+  if ((typeclass == eTypeClassStruct || typeclass == eTypeClassClass) && !member.IsBitfield())
+  {
+    if (depth >= TYPE_LAYOUT_MAX_DEPTH)
+    {
+      mValid = false;
+      return;
+    }
+    AddFields(canonical, offset + member.GetOffsetInBytes(), path, depth + 1);
+    return;
+  }
+
+  Field field;
+  field.mName = path;
+  field.mTypeName = type.GetName();
+  field.mOffset = offset + member.GetOffsetInBytes();
+  field.mByteSize = canonical.GetByteSize();
+
+  if (typeclass == eTypeClassBuiltin)
+  {
+    field.mKind = GetBasicKind(canonical.GetBasicType());
+  }
+  else if (typeclass == eTypeClassEnumeration)
+  {
+    // The underlying integer type gives the signedness, an unknown one is read as int:
+    field.mKind = GetBasicKind(canonical.GetEnumerationIntegerType().GetCanonicalType().GetBasicType());
+    if (field.mKind != eUnsigned)
+      field.mKind = eSigned;
+
+    SBTypeEnumMemberList enumerators = canonical.GetEnumMembers();
+    uint32 count = enumerators.IsValid() ? enumerators.GetSize() : 0;
+    for (uint32 i = 0; i < count; i++)
+    {
+      SBTypeEnumMember enumerator = enumerators.GetTypeEnumMemberAtIndex(i);
+      int64 value = field.mKind == eUnsigned ? (int64)enumerator.GetValueAsUnsigned() : enumerator.GetValueAsSigned();
+      field.mEnumerators.push_back(std::make_pair(value, nglString(enumerator.GetName())));
+    }
+  }
+
+  if (member.IsBitfield())
+  {
+    uint32 bit = offset * 8 + member.GetOffsetInBits();
+    field.mOffset = bit / 8;
+    field.mBitOffset = bit % 8;
+    field.mBitSize = member.GetBitfieldSizeInBits();
+    field.mByteSize = (field.mBitOffset + field.mBitSize + 7) / 8;
+    if (field.mKind == eFloat || field.mByteSize > 8)
+      field.mKind = eOther;
+  }
+
+  if (field.mKind != eOther && (field.mByteSize == 0 || field.mByteSize > 8 || field.mOffset + field.mByteSize > mByteSize))
+    field.mKind = eOther;
+
+  // Members that LLDB has to fetch are found back by name, anonymous ones can't be:
+  if (field.mKind == eOther && path.IsEmpty())
+    mValid = false;
+
+  mFields.push_back(field);
+}
+
+const nglString& TypeLayout::GetName() const
+{
+  return mName;
+}
+
+uint32 TypeLayout::GetByteSize() const
+{
+  return mByteSize;
+}
+
+int32 TypeLayout::GetFieldCount() const
+{
+  return mFields.size();
+}
+
+const TypeLayout::Field& TypeLayout::GetField(int32 index) const
+{
+  NGL_ASSERT(index >= 0 && index < mFields.size());
+  return mFields[index];
+}
+
+int32 TypeLayout::GetMemberCount() const
+{
+  return mMembers.size();
+}
+
+const TypeLayout::Member& TypeLayout::GetMember(int32 index) const
+{
+  NGL_ASSERT(index >= 0 && index < mMembers.size());
+  return mMembers[index];
+}
+
+int32 TypeLayout::GetDecodedFieldCount() const
+{
+  return mDecodedFields;
+}
+
+bool TypeLayout::IsValid() const
+{
+  return mValid;
+}
+
+bool TypeLayout::IsDecoded(const Field& rField)
+{
+  return rField.mKind != eOther;
+}
+
+static uint64 ReadUnsigned(const TypeLayout::Field& rField, const uint8* pData)
+{
+  uint64 value = 0;
+  memcpy(&value, pData + rField.mOffset, rField.mByteSize); // Little endian only
+  if (rField.mBitSize)
+  {
+    value >>= rField.mBitOffset;
+    if (rField.mBitSize < 64)
+      value &= (1ULL << rField.mBitSize) - 1;
+  }
+  return value;
+}
+
+static int64 ReadSigned(const TypeLayout::Field& rField, const uint8* pData)
+{
+  uint64 value = ReadUnsigned(rField, pData);
+  uint32 bits = rField.mBitSize ? rField.mBitSize : rField.mByteSize * 8;
+  if (bits < 64 && (value & (1ULL << (bits - 1))))
+    value |= ~((1ULL << bits) - 1);
+  return (int64)value;
+}
+
+double TypeLayout::Decode(const Field& rField, const uint8* pData)
+{
+  switch (rField.mKind)
+  {
+    case eChar:
+    case eSigned:
+      return (double)ReadSigned(rField, pData);
+
+    case eUnsigned:
+    case eBool:
+      return (double)ReadUnsigned(rField, pData);
+
+    case eFloat:
+      if (rField.mByteSize == sizeof(float))
+      {
+        float value;
+        memcpy(&value, pData + rField.mOffset, sizeof(value));
+        return value;
+      }
+      else
+      {
+        double value;
+        memcpy(&value, pData + rField.mOffset, sizeof(value));
+        return value;
+      }
+
+    default:
+      return 0;
+  }
+}
+
+nglString TypeLayout::Format(const Field& rField, const uint8* pData)
+{
+  nglString str;
+  if (!rField.mEnumerators.empty())
+  {
+    int64 value = rField.mKind == eUnsigned ? (int64)ReadUnsigned(rField, pData) : ReadSigned(rField, pData);
+    for (int32 i = 0; i < rField.mEnumerators.size(); i++)
+    {
+      if (rField.mEnumerators[i].first == value)
+        return rField.mEnumerators[i].second;
+    }
+  }
+
+  switch (rField.mKind)
+  {
+    case eChar:
+      {
+        int64 value = ReadSigned(rField, pData);
+        if (value >= 32 && value < 127)
+          str.CFormat("%lld '%c'", value, (char)value);
+        else
+          str.CFormat("%lld", value);
+      }
+      break;
+
+    case eSigned:
+      str.CFormat("%lld", ReadSigned(rField, pData));
+      break;
+
+    case eUnsigned:
+      str.CFormat("%llu", ReadUnsigned(rField, pData));
+      break;
+
+    case eFloat:
+      str.CFormat("%g", Decode(rField, pData));
+      break;
+
+    case eBool:
+      str = ReadUnsigned(rField, pData) ? "true" : "false";
+      break;
+
+    default:
+      break;
+  }
+  return str;
+}
+
+//////// TypeCatalog
+TypeCatalog::TypeCatalog(DebuggerContext& rContext)
+: mrContext(rContext)
+{
+}
+
+TypeCatalog::~TypeCatalog()
+{
+  Clear();
+}
+
+// The module whose debug information describes the value: the one of its frame, or the one it lives in for globals
+static SBModule GetValueModule(SBValue value)
+{
+  SBModule module(value.GetFrame().GetModule());
+  if (!module.IsValid())
+    module = value.GetAddress().GetModule();
+  return module;
+}
+
+static nglString GetModuleKey(SBModule module)
+{
+  if (!module.IsValid())
+    return nglString::Null;
+
+  SBFileSpec f = module.GetFileSpec();
+  nglPath p(f.GetDirectory());
+  p += nglString(f.GetFilename());
+  return p.GetPathName();
+}
+
+const TypeLayout* TypeCatalog::GetLayout(SBValue value)
+{
+  SBType type = value.GetType().GetCanonicalType();
+  if (!type.IsValid())
+    return NULL;
+
+  SBModule module(GetValueModule(value));
+  std::pair<nglString, nglString> name(GetModuleKey(module), nglString(type.GetName()));
+  auto it = mLayouts.find(name);
+  if (it != mLayouts.end())
+    return it->second;
+
+  // The module's cache has the layouts of the types it defines, LLDB is only asked for the other ones:
+  TypeLayout* pLayout = NULL;
+  const ModuleCache* pCache = module.IsValid() ? mrContext.GetModuleCache(module) : NULL;
+  const ModuleCache::Type* pType = pCache ? pCache->FindType(type.GetName()) : NULL;
+  if (pType)
+    pLayout = new TypeLayout(*pCache, *pType);
+  else
+    pLayout = TypeLayout::Create(type);
+
+  mLayouts[name] = pLayout;
+  return pLayout;
+}
+
+void TypeCatalog::Clear()
+{
+  for (auto it = mLayouts.begin(); it != mLayouts.end(); ++it)
+    delete it->second;
+  mLayouts.clear();
+}
+
+bool Xspray::ReadValueMemory(SBValue value, uint32 size, std::vector<uint8>& rData)
+{
+  addr_t address = value.GetLoadAddress();
+  SBProcess process = value.GetProcess();
+  if (address == LLDB_INVALID_ADDRESS || !process.IsValid() || !size)
+    return false;
+
+  rData.resize(size);
+
+  // Straight from the mapping of a core file, LLDB would copy the whole region first:
+  if (CoreFile::ReadTarget(value.GetTarget(), address, &rData[0], size))
+    return true;
+
+  SBError error;
+  return process.ReadMemory(address, &rData[0], size, error) == size && error.Success();
+}
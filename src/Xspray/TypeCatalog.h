@@ -0,0 +1,98 @@
+//
+//  TypeCatalog.h
+//  Xspray
+//
+
+#pragma once
+
+// Flattened memory layout of a struct or class: every scalar member, including the ones of nested structs and base
+// classes, with its offset from the start of the object. Lets a whole object be decoded from a single memory read.
+// The direct members are also listed on their own so the object can be shown with its hierarchy.
+class TypeLayout
+{
+public:
+  enum Kind
+  {
+    eChar,
+    eSigned,
+    eUnsigned,
+    eFloat,
+    eBool,
+    eOther // Not decoded from memory, go through LLDB
+  };
+
+  struct Field
+  {
+    Field();
+
+    nglString mName;     // Path from the object, "a.b.c"
+    nglString mTypeName;
+    uint32 mOffset;      // Bytes
+    uint32 mByteSize;
+    uint32 mBitOffset;   // Bit field position in the bytes at mOffset, 0 if mBitSize is 0
+    uint32 mBitSize;
+    Kind mKind;
+    std::vector<std::pair<int64, nglString> > mEnumerators; // Value -> name, for enums only
+  };
+
+  struct Member
+  {
+    nglString mName;
+    uint32 mChild; // LLDB child index, base classes come first
+    bool mBase;
+    int32 mField;  // Index of the field of a scalar member, -1 for base classes and nested structs
+  };
+
+  TypeLayout(lldb::SBType type);
+  TypeLayout(const ModuleCache& rCache, const ModuleCache::Type& rType); // A layout saved by ModuleCache::AddTypes
+  ~TypeLayout();
+
+  static TypeLayout* Create(lldb::SBType type); // NULL if the type is not a struct or class that has fields that can be decoded from memory
+
+  const nglString& GetName() const;
+  uint32 GetByteSize() const;
+  int32 GetFieldCount() const;
+  const Field& GetField(int32 index) const;
+  int32 GetMemberCount() const;
+  const Member& GetMember(int32 index) const;
+  int32 GetDecodedFieldCount() const; // Fields that do not need LLDB
+  bool IsValid() const; // False if some members could not be placed, the whole object must then go through LLDB
+
+  static bool IsDecoded(const Field& rField);
+  // pData points to the start of the object, in the target's byte order (which must be the host's):
+  static double Decode(const Field& rField, const uint8* pData);
+  static nglString Format(const Field& rField, const uint8* pData);
+
+private:
+  void AddFields(lldb::SBType type, uint32 offset, const nglString& rPath, int32 depth);
+  void AddField(lldb::SBTypeMember member, uint32 offset, const nglString& rPath, int32 depth);
+
+  nglString mName;
+  uint32 mByteSize;
+  std::vector<Field> mFields;
+  std::vector<Member> mMembers;
+  int32 mDecodedFields;
+  bool mValid;
+};
+
+class DebuggerContext;
+
+// Layouts of the struct types met so far, computed once per type and shared by every value of that type.
+class TypeCatalog
+{
+public:
+  TypeCatalog(DebuggerContext& rContext); // Takes the layouts from the context's module caches when they have them
+  ~TypeCatalog();
+
+  // NULL if the value's type is not a struct or class that has fields that can be decoded from memory:
+  const TypeLayout* GetLayout(lldb::SBValue value);
+  void Clear();
+
+private:
+  // By module and canonical type name, two modules can define different types with the same name. NULL for the types without a layout:
+  std::map<std::pair<nglString, nglString>, TypeLayout*> mLayouts;
+  DebuggerContext& mrContext;
+};
+
+// One memory read of a value that lives in the target's memory. Returns false if the value has no address or the read fails.
+bool ReadValueMemory(lldb::SBValue value, uint32 size, std::vector<uint8>& rData);
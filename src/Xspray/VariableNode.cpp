@@ -13,17 +13,39 @@ using namespace lldb;
 
 VariableNode::VariableNode(SBValue value)
 : nuiTreeNode(NULL),
-  mValue(value)
+  mValue(value),
+  mpRecorded(NULL)
+{
+  Init(value.GetName(), value.GetTypeName(), value.GetValue());
+
+  //NGL_OUT("%s (%s) = %s\n", value.GetName(), value.GetTypeName(), value.GetValue());
+}
+
+VariableNode::VariableNode(SBValue object, const TypeLayout::Field& rField, const nglString& rName, const uint8* pData)
+: nuiTreeNode(NULL),
+  mObject(object),
+  mPath(rField.mName),
+  mpRecorded(NULL)
+{
+  Init(rName, rField.mTypeName, TypeLayout::Format(rField, pData));
+}
+
+VariableNode::VariableNode(const SessionStop::Variable& rVariable)
+: nuiTreeNode(NULL),
+  mpRecorded(&rVariable)
+{
+  Init(rVariable.mName, rVariable.mType, rVariable.mSummary.IsEmpty() ? rVariable.mValue : rVariable.mSummary);
+}
+
+void VariableNode::Init(const nglString& rName, const nglString& rType, const nglString& rValue)
 {
   std::map<nglString, nglString> dico;
 
-  dico["VariableName"] = value.GetName();
-  dico["VariableType"] = value.GetTypeName();
-  dico["VariableValue"] = value.GetValue();
+  dico["VariableName"] = rName;
+  dico["VariableType"] = rType;
+  dico["VariableValue"] = rValue;
   nuiWidget* pElement = nuiBuilder::Get().CreateWidget("VariableView", dico);
   SetElement(pElement);
-
-  //NGL_OUT("%s (%s) = %s\n", value.GetName(), value.GetTypeName(), value.GetValue());
 }
 
 VariableNode::~VariableNode()
@@ -32,10 +54,21 @@ VariableNode::~VariableNode()
 
 void VariableNode::Open(bool Opened)
 {
+  XSPRAY_TRACE("VariableNode::Open");
   nuiTreeNode::Open(Opened);
 
   if (Opened)
   {
+    if (mpRecorded)
+    {
+      for (int32 i = 0; i < mpRecorded->mChildren.size(); i++)
+        AddChild(new VariableNode(mpRecorded->mChildren[i]));
+      return;
+    }
+
+    if (OpenFromLayout())
+      return;
+
     uint32_t count = mValue.GetNumChildren();
 
     for (auto i = 0; i < count; i++)
@@ -52,15 +85,84 @@ void VariableNode::Open(bool Opened)
   }
 }
 
+// Values LLDB presents through a synthetic children provider (std::string, std::map, std::optional...) don't look like
+// their raw memory, they must go through LLDB:
+static bool HasSyntheticChildren(SBValue value)
+{
+  if (value.IsSynthetic())
+    return true;
+
+  SBDebugger debugger(value.GetTarget().GetDebugger());
+  SBType type(value.GetType());
+  return debugger.GetSyntheticForType(SBTypeNameSpecifier(type)).IsValid()
+      || debugger.GetSyntheticForType(SBTypeNameSpecifier(type.GetCanonicalType())).IsValid();
+}
+
+// Read the whole struct at once and decode its scalar members, base classes and nested structs get their own nodes and
+// the remaining members are asked to LLDB. Only plain aggregates take this path:
+bool VariableNode::OpenFromLayout()
+{
+  if (HasSyntheticChildren(mValue))
+    return false;
+
+  SBValue object(mValue);
+  if (object.GetType().GetCanonicalType().IsPointerType())
+  {
+    object = object.Dereference();
+    if (HasSyntheticChildren(object))
+      return false;
+  }
+
+  const TypeLayout* pLayout = GetDebuggerContext().mTypeCatalog.GetLayout(object);
+  if (!pLayout)
+    return false;
+
+  std::vector<uint8> data;
+  if (!ReadValueMemory(object, pLayout->GetByteSize(), data))
+    return false;
+
+  int32 count = pLayout->GetMemberCount();
+  for (int32 i = 0; i < count; i++)
+  {
+    const TypeLayout::Member& rMember(pLayout->GetMember(i));
+    if (rMember.mField >= 0 && TypeLayout::IsDecoded(pLayout->GetField(rMember.mField)))
+    {
+      AddChild(new VariableNode(object, pLayout->GetField(rMember.mField), rMember.mName, &data[0]));
+      continue;
+    }
+
+    SBValue child;
+    if (rMember.mBase || rMember.mName.IsEmpty())
+      child = object.GetChildAtIndex(rMember.mChild, eDynamicCanRunTarget, true);
+    else
+      child = object.GetChildMemberWithName(rMember.mName.GetChars());
+    if (child.IsValid())
+      AddChild(new VariableNode(child));
+  }
+
+  return true;
+}
+
 bool VariableNode::IsEmpty() const
 {
-  return !const_cast<SBValue&>(mValue).MightHaveChildren();
+  if (mpRecorded)
+    return mpRecorded->mChildren.empty();
+
+  SBValue& rValue(const_cast<SBValue&>(mValue));
+  return !rValue.IsValid() || !rValue.MightHaveChildren();
 }
 
 
 lldb::SBValue VariableNode::GetValue() const
 {
-  return mValue;
+  SBValue value(mValue);
+  if (value.IsValid() || mPath.IsEmpty())
+    return value;
+
+  nglString path(".");
+  path.Add(mPath);
+  SBValue object(mObject);
+  return object.GetValueForExpressionPath(path.GetChars());
 }
 
 
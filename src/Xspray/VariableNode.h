@@ -12,13 +12,21 @@ class VariableNode : public nuiTreeNode
 {
 public:
   VariableNode(lldb::SBValue value);
+  VariableNode(lldb::SBValue object, const TypeLayout::Field& rField, const nglString& rName, const uint8* pData); // Member decoded from memory
+  VariableNode(const SessionStop::Variable& rVariable); // Replayed, rVariable must outlive the node
   virtual ~VariableNode();
 
   void Open(bool Opened);
   bool IsEmpty() const;
 
-  lldb::SBValue GetValue() const;
+  lldb::SBValue GetValue() const; // Members decoded from memory only ask LLDB for their value here
 
 private:
+  void Init(const nglString& rName, const nglString& rType, const nglString& rValue);
+  bool OpenFromLayout();
+
   lldb::SBValue mValue;
+  lldb::SBValue mObject; // Owner of a member decoded from memory, with the member's expression path
+  nglString mPath;
+  const SessionStop::Variable* mpRecorded;
 };
\ No newline at end of file
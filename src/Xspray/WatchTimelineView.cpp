@@ -0,0 +1,204 @@
+//
+//  WatchTimelineView.cpp
+//  Xspray
+//
+
+#include "Xspray.h"
+
+using namespace Xspray;
+
+#define TIMELINE_MARGIN 4.0f
+#define TIMELINE_TICK_HEIGHT 8.0f
+
+WatchTimelineView::WatchTimelineView()
+: mpWatchpoint(NULL), mHitCount(0), mCursor(-1), mFollow(true)
+{
+  if (SetObjectClass("WatchTimelineView"))
+  {
+    // Add Attributes
+  }
+}
+
+WatchTimelineView::~WatchTimelineView()
+{
+}
+
+void WatchTimelineView::SetWatchpoint(const Breakpoint* pWatchpoint)
+{
+  mpWatchpoint = pWatchpoint;
+  mHits.clear();
+  mHitCount = 0;
+  mCursor = -1;
+  mFollow = true;
+  Update();
+  Invalidate();
+}
+
+void WatchTimelineView::Update()
+{
+  if (!mpWatchpoint)
+    return;
+
+  uint64 count = mpWatchpoint->GetWatchHits(mHits, mHitCount);
+  if (count == mHitCount)
+    return;
+  mHitCount = count;
+
+  // Drop the hits the watchpoint doesn't keep anymore either, the cursor stays on its hit while it is there:
+  int32 extra = (int32)mHits.size() - BREAKPOINT_WATCH_HISTORY;
+  if (extra > 0)
+  {
+    mHits.erase(mHits.begin(), mHits.begin() + extra);
+    if (!mFollow)
+    {
+      mCursor = MAX(mCursor - extra, 0);
+      CursorMoved(mCursor);
+    }
+  }
+
+  if (mFollow)
+  {
+    mCursor = mHits.size() - 1;
+    CursorMoved(mCursor);
+  }
+  Invalidate();
+}
+
+int32 WatchTimelineView::GetCursor() const
+{
+  return mCursor;
+}
+
+const Breakpoint::WatchHit* WatchTimelineView::GetHit(int32 index) const
+{
+  if (index < 0 || index >= mHits.size())
+    return NULL;
+  return &mHits[index];
+}
+
+nuiRect WatchTimelineView::CalcIdealSize()
+{
+  return nuiRect(200, 80);
+}
+
+float WatchTimelineView::GetX(double time) const
+{
+  double first = mHits.front().mTime;
+  double duration = mHits.back().mTime - first;
+  float width = mRect.GetWidth() - 2 * TIMELINE_MARGIN;
+  if (duration <= 0)
+    return TIMELINE_MARGIN + width / 2;
+  return TIMELINE_MARGIN + (float)((time - first) / duration) * width;
+}
+
+bool WatchTimelineView::Draw(nuiDrawContext* pContext)
+{
+  XSPRAY_TRACE("WatchTimelineView::Draw");
+  if (mHits.empty())
+    return nuiSimpleContainer::Draw(pContext);
+
+  float height = mRect.GetHeight();
+  float bottom = height - TIMELINE_TICK_HEIGHT;
+
+  // The written values are shown as signed integers of the watched size:
+  int32 shift = 64 - mpWatchpoint->GetWatchSize() * 8;
+  double min = (double)((int64)(mHits[0].mNewValue << shift) >> shift);
+  double max = min;
+  for (int32 i = 0; i < mHits.size(); i++)
+  {
+    double v = (double)((int64)(mHits[i].mNewValue << shift) >> shift);
+    min = MIN(min, v);
+    max = MAX(max, v);
+  }
+  double range = max > min ? max - min : 1;
+
+  nuiShape* pShape = new nuiShape();
+  for (int32 i = 0; i < mHits.size(); i++)
+  {
+    double v = (double)((int64)(mHits[i].mNewValue << shift) >> shift);
+    float x = GetX(mHits[i].mTime);
+    float y = bottom - TIMELINE_MARGIN - (float)((v - min) / range) * (bottom - 2 * TIMELINE_MARGIN);
+    if (i)
+      pShape->LineTo(nuiPoint(x, y));
+    else
+      pShape->MoveTo(nuiPoint(x, y));
+  }
+  pContext->SetLineWidth(1.5);
+  pContext->SetStrokeColor("blue");
+  pContext->DrawShape(pShape, eStrokeShape);
+  delete pShape;
+
+  // One tick per write, the cursor on top:
+  pContext->SetLineWidth(1);
+  pContext->SetStrokeColor("grey");
+  for (int32 i = 0; i < mHits.size(); i++)
+  {
+    float x = ToNearest(GetX(mHits[i].mTime));
+    pContext->DrawLine(x, bottom, x, height);
+  }
+
+  if (mCursor >= 0)
+  {
+    float x = ToNearest(GetX(mHits[mCursor].mTime));
+    pContext->SetStrokeColor("red");
+    pContext->DrawLine(x, 0, x, height);
+  }
+
+  return nuiSimpleContainer::Draw(pContext);
+}
+
+void WatchTimelineView::MoveCursor(float x)
+{
+  if (mHits.empty())
+    return;
+
+  // The hits are in time order:
+  int32 lo = 0;
+  int32 hi = mHits.size() - 1;
+  while (lo < hi)
+  {
+    int32 mid = (lo + hi) / 2;
+    if (GetX(mHits[mid].mTime) < x)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  if (lo > 0 && x - GetX(mHits[lo - 1].mTime) < GetX(mHits[lo].mTime) - x)
+    lo--;
+
+  mFollow = (lo == mHits.size() - 1);
+  if (lo != mCursor)
+  {
+    mCursor = lo;
+    CursorMoved(mCursor);
+    Invalidate();
+  }
+}
+
+bool WatchTimelineView::MouseClicked(const nglMouseInfo& rInfo)
+{
+  if (!(rInfo.Buttons & nglMouseInfo::ButtonLeft))
+    return false;
+
+  Grab();
+  MoveCursor(rInfo.X);
+  return true;
+}
+
+bool WatchTimelineView::MouseUnclicked(const nglMouseInfo& rInfo)
+{
+  if (!(rInfo.Buttons & nglMouseInfo::ButtonLeft))
+    return false;
+
+  Ungrab();
+  return true;
+}
+
+bool WatchTimelineView::MouseMoved(const nglMouseInfo& rInfo)
+{
+  if (!HasGrab())
+    return false;
+
+  MoveCursor(rInfo.X);
+  return true;
+}
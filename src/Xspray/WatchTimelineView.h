@@ -0,0 +1,40 @@
+//
+//  WatchTimelineView.h
+//  Xspray
+//
+
+#pragma once
+
+// The writes recorded by a watchpoint along time: one tick per write under the curve of the written values. Clicking
+// or dragging moves the cursor to the nearest write.
+class WatchTimelineView : public nuiSimpleContainer
+{
+public:
+  WatchTimelineView();
+  virtual ~WatchTimelineView();
+
+  void SetWatchpoint(const Breakpoint* pWatchpoint); // NULL to show nothing
+  void Update(); // Pick up the writes recorded since the last call
+
+  int32 GetCursor() const; // -1 if there are no writes
+  const Breakpoint::WatchHit* GetHit(int32 index) const;
+
+  nuiSignal1<int32> CursorMoved;
+
+  nuiRect CalcIdealSize();
+  bool Draw(nuiDrawContext* pContext);
+
+  bool MouseClicked(const nglMouseInfo& rInfo);
+  bool MouseUnclicked(const nglMouseInfo& rInfo);
+  bool MouseMoved(const nglMouseInfo& rInfo);
+
+private:
+  float GetX(double time) const;
+  void MoveCursor(float x);
+
+  const Breakpoint* mpWatchpoint;
+  std::vector<Breakpoint::WatchHit> mHits; // At most the watchpoint's history
+  uint64 mHitCount; // Hits of the watchpoint picked up so far
+  int32 mCursor;
+  bool mFollow; // Keep the cursor on the last write until the user moves it
+};
@@ -10,22 +10,48 @@
 
 #include "nui.h"
 
+#ifdef __APPLE__
 #include <LLDB/LLDB.h>
 #include <LLDB/SBStream.h>
 #include <LLDB/SBTypeCategory.h>
 #include <LLDB/SBModuleSpec.h>
 #include <LLDB/SBBreakpoint.h>
 #include <LLDB/lldb-enumerations.h>
+#else
+#include <lldb/API/LLDB.h>
+#endif
 
+// XSPRAY_HEADLESS leaves out the application views, the file dialogs and the iOS device support. What remains runs
+// without a window:
+#ifndef XSPRAY_HEADLESS
 #include "iOSRemoteDebug.h"
 #include "NativeFileDialog.h"
+#endif
 
 #include "msgpack.h"
 
+#include <atomic>
+
 namespace Xspray
 {
+#include "Tracer.h"
+#include "MsgPackUtils.h"
+#include "LogBuffer.h"
 #include "AppDescription.h"
 #include "Breakpoint.h"
+#include "LineTable.h"
+#include "SourceResolver.h"
+#include "ThreadPool.h"
+#include "Profiler.h"
+#include "ResourceMonitor.h"
+#include "SymbolIndex.h"
+#include "ModuleCache.h"
+#include "AddressIndex.h"
+#include "CoreFile.h"
+#include "TypeCatalog.h"
+#include "SessionLog.h"
+#include "RowModel.h"
+#include "RowView.h"
 #include "ModuleTree.h"
 #include "ArrayModel.h"
 #include "SymbolTree.h"
@@ -33,9 +59,16 @@ namespace Xspray
 #include "VariableNode.h"
 #include "ProcessTree.h"
 #include "DebuggerContext.h"
-#include "HomeView.h"
 #include "GraphView.h"
+#include "FlameGraphView.h"
+#include "WatchTimelineView.h"
+#include "BatchRunner.h"
+#include "Benchmark.h"
+#include "RpcServer.h"
+#ifndef XSPRAY_HEADLESS
+#include "HomeView.h"
 #include "BreakpointsView.h"
 #include "DebugView.h"
+#endif
 }
 
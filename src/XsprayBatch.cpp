@@ -0,0 +1,90 @@
+/*
+  NUI3 - C++ cross-platform GUI framework for OpenGL based applications
+  Copyright (C) 2002-2003 Sebastien Metrot
+
+  licence: see nui3/LICENCE.TXT
+*/
+
+// Headless Xspray: runs the debugger commands of a file (or of stdin) and writes JSON lines to stdout.
+// Usage: xspray-batch [commands.txt] [-- command...]
+//        xspray-batch --serve <socket> [commands.txt]: run the commands, then answer msgpack-RPC calls until shutdown
+
+#include "Xspray/Xspray.h"
+
+#include <unistd.h>
+
+using namespace lldb;
+
+int main(int argc, const char** argv)
+{
+  nuiInit(NULL);
+  SBDebugger::Initialize();
+
+  int res = 0;
+  {
+    Xspray::DebuggerContext context;
+    Xspray::BatchRunner runner(context, stdout);
+
+    Xspray::RpcServer server;
+    nglPath socket;
+    bool commands = false;
+    for (int i = 1; i < argc; i++)
+    {
+      if (!strcmp(argv[i], "--serve") && i + 1 < argc)
+      {
+        socket = nglPath(argv[++i]);
+      }
+      else if (!strcmp(argv[i], "--"))
+      {
+        // The remaining arguments form one command:
+        nglString line;
+        for (i++; i < argc; i++)
+        {
+          line.Add(argv[i]);
+          line.Add(' ');
+        }
+        runner.RunCommand(line);
+        commands = true;
+      }
+      else
+      {
+        runner.RunFile(nglPath(argv[i]));
+        commands = true;
+      }
+    }
+
+    if (!socket.GetPathName().IsEmpty())
+    {
+      if (!server.Start(socket))
+      {
+        fprintf(stderr, "Unable to listen on %s\n", socket.GetChars());
+        res = 1;
+      }
+      while (server.IsRunning())
+        usleep(100000);
+      server.Stop();
+    }
+    else if (!commands)
+    {
+      char buffer[4096];
+      while (fgets(buffer, sizeof(buffer), stdin))
+        runner.RunCommand(nglString(buffer));
+    }
+
+    // Don't leave the debuggees behind:
+    for (int32 i = 0; i < Xspray::DebuggerContext::GetContextCount(); i++)
+    {
+      Xspray::DebuggerContext* pContext = Xspray::DebuggerContext::GetContext(i);
+      if (pContext->mProcess.IsValid())
+        pContext->mProcess.Kill();
+    }
+
+    runner.WriteSummary();
+    if (runner.GetErrorCount())
+      res = 1;
+  }
+
+  SBDebugger::Terminate();
+  nuiUninit();
+  return res;
+}
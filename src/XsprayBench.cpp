@@ -0,0 +1,45 @@
+/*
+  NUI3 - C++ cross-platform GUI framework for OpenGL based applications
+  Copyright (C) 2002-2003 Sebastien Metrot
+
+  licence: see nui3/LICENCE.TXT
+*/
+
+// Xspray benchmarks: builds the fixture programs in a work folder, debugs them and writes the timings as JSON.
+// Usage: xspray-bench [results.json] [work folder] [iterations]
+
+#include "Xspray/Xspray.h"
+
+using namespace lldb;
+
+int main(int argc, const char** argv)
+{
+  nuiInit(NULL);
+  SBDebugger::Initialize();
+
+  nglPath results(argc > 1 ? argv[1] : "xspray-bench.json");
+  nglPath folder(argc > 2 ? argv[2] : "/tmp/xspray-bench");
+  int iterations = argc > 3 ? atoi(argv[3]) : 5;
+
+  int res = 0;
+  {
+    Xspray::DebuggerContext context;
+    Xspray::Benchmark benchmark(context, folder, iterations);
+
+    if (!benchmark.Run())
+    {
+      NGL_OUT("Benchmark aborted, partial results are written\n");
+      res = 1;
+    }
+
+    if (!benchmark.WriteResults(results))
+    {
+      NGL_OUT("Unable to write %s\n", results.GetChars());
+      res = 1;
+    }
+  }
+
+  SBDebugger::Terminate();
+  nuiUninit();
+  return res;
+}